@@ -0,0 +1,275 @@
+// Capstone Host Tools - ADC Decode Benchmark
+// Checks the lane decoder bit for bit against synthetic streams and measures its throughput per core and across threads
+
+/*
+*  Usage: adc_bench [options]
+*      --variant <name>    ddr14, ddr16, sdr14 or all (default all)
+*      --isa <name>        scalar, sse4.1, avx2 or all (default all the CPU supports)
+*      --tone <f[:dBFS]>   Test tone, repeatable (default 10.1e6:-1)
+*      --noise <lsb>       Gaussian noise (default 0.5 LSB rms)
+*      --frames <n>        Frames in each thread's buffer (default 131072, one million samples)
+*      --threads <n>       Largest thread count of the scaling run (default: one per core)
+*      --seconds <t>       Length of each measurement (default 0.5)
+*      --json <file>       Write the results as JSON ("-" for stdout)
+*
+*  Every thread decodes its own buffer over and over, so the scaling run shows where memory bandwidth, not the
+*  kernel, becomes the limit. A channel needs 250 MS/s to keep up with the converters.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "adc_decode.hpp"
+#include "adc_synth.hpp"
+
+/* Types */
+
+struct bench_point {
+    unsigned threads = 0;
+    double gsps = 0.0;                                      // Samples decoded per second over all threads (in GS/s)
+};
+
+struct bench_result {
+    std::string variant;
+    adc_isa isa = adc_isa::scalar;
+    bool bit_exact = false;
+    size_t mismatches = 0;
+    std::vector<bench_point> scaling;                       // scaling[0] is the single thread figure
+};
+
+/* Parameters */
+static const double CHANNEL_RATE_SPS            = 250e6;    // Converter sample rate every channel has to keep up with
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s [--variant ddr14|ddr16|sdr14|all] [--isa scalar|sse4.1|avx2|all] [--tone f[:dBFS]] [--noise lsb]\n"
+                "       [--frames n] [--threads n] [--seconds t] [--json file]\n", program);
+}
+
+// Decode the buffer on threads threads for about seconds
+static double measure(const adc_lane_format &format, const std::vector<uint8_t> &raw, const size_t num_frames, const adc_isa isa,
+                      const unsigned threads, const double seconds) {
+
+    std::atomic<bool> go {false};
+    std::atomic<bool> stop {false};
+    std::vector<uint64_t> passes(threads, 0);
+    std::vector<std::thread> workers;
+
+    for (unsigned thread = 0; thread < threads; thread++) {
+        workers.emplace_back([&, thread]() {
+            // Private copies, so threads never share cache lines
+            std::vector<uint8_t> input(raw);
+            std::vector<int16_t> samples(num_frames * ADC_FRAME_SAMPLES);
+            std::vector<uint8_t> ovr(num_frames * ADC_FRAME_SAMPLES);
+            while (!go.load()) {
+                std::this_thread::yield();
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                adc_decode(format, input.data(), num_frames, samples.data(), ovr.data(), isa);
+                passes[thread]++;
+            }
+        });
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true);
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    stop.store(true);
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total = 0;
+    for (const uint64_t count : passes) {
+        total += count;
+    }
+
+    return ((double) total * num_frames * ADC_FRAME_SAMPLES / elapsed_s / 1e9);
+}
+
+static void write_json(std::FILE *file, const std::vector<bench_result> &results, const size_t frames, const unsigned cores) {
+
+    std::fprintf(file, "{\n  \"cores\": %u,\n  \"best_isa\": \"%s\",\n  \"frames_per_buffer\": %zu,\n  \"channel_rate_sps\": %.0f,\n  \"results\": [\n",
+                 cores, adc_isa_name(adc_best_isa()), frames, CHANNEL_RATE_SPS);
+
+    for (size_t index = 0; index < results.size(); index++) {
+        const bench_result &result = results[index];
+        const double per_core = result.scaling.empty() ? 0.0 : result.scaling.front().gsps;
+        const double best = result.scaling.empty() ? 0.0 : result.scaling.back().gsps;
+
+        std::fprintf(file, "    {\"variant\": \"%s\", \"isa\": \"%s\", \"bit_exact\": %s, \"mismatches\": %zu, \"gsps_per_core\": %.4f, "
+                     "\"channels_per_core\": %.2f, \"channels_total\": %.2f, \"scaling\": [", result.variant.c_str(), adc_isa_name(result.isa),
+                     result.bit_exact ? "true" : "false", result.mismatches, per_core, per_core * 1e9 / CHANNEL_RATE_SPS,
+                     best * 1e9 / CHANNEL_RATE_SPS);
+        for (size_t point = 0; point < result.scaling.size(); point++) {
+            std::fprintf(file, "%s{\"threads\": %u, \"gsps\": %.4f, \"efficiency\": %.3f}", (point > 0) ? ", " : "",
+                         result.scaling[point].threads, result.scaling[point].gsps,
+                         result.scaling[point].gsps / (per_core * result.scaling[point].threads));
+        }
+        std::fprintf(file, "]}%s\n", (index + 1 < results.size()) ? "," : "");
+    }
+
+    std::fprintf(file, "  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+
+    std::vector<std::string> variants = { "ddr14", "ddr16", "sdr14" };
+    std::vector<adc_isa> isas;
+    synth_options options;
+    size_t frames = 131072;
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    double seconds = 0.5;
+    std::string json_path;
+    std::string error;
+    std::vector<bench_result> results;
+    bool failed = false;
+
+    for (int arg = 1; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--variant") == 0) && has_value) {
+            const std::string name = argv[++arg];
+            if (name != "all") {
+                variants = { name };
+            }
+        }
+        else if ((std::strcmp(argv[arg], "--isa") == 0) && has_value) {
+            const std::string name = argv[++arg];
+            if (name == "scalar") {
+                isas = { adc_isa::scalar };
+            }
+            else if (name == "sse4.1") {
+                isas = { adc_isa::sse41 };
+            }
+            else if (name == "avx2") {
+                isas = { adc_isa::avx2 };
+            }
+            else if (name != "all") {
+                usage(argv[0]);
+                return (1);
+            }
+        }
+        else if ((std::strcmp(argv[arg], "--tone") == 0) && has_value) {
+            synth_tone tone;
+            if (!parse_synth_tone(argv[++arg], tone)) {
+                usage(argv[0]);
+                return (1);
+            }
+            options.tones.push_back(tone);
+        }
+        else if ((std::strcmp(argv[arg], "--noise") == 0) && has_value) {
+            options.noise_lsb = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--frames") == 0) && has_value) {
+            frames = std::max<size_t>(1, (size_t) std::strtoull(argv[++arg], nullptr, 10));
+        }
+        else if ((std::strcmp(argv[arg], "--threads") == 0) && has_value) {
+            max_threads = std::max(1u, (unsigned) std::strtoul(argv[++arg], nullptr, 10));
+        }
+        else if ((std::strcmp(argv[arg], "--seconds") == 0) && has_value) {
+            seconds = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--json") == 0) && has_value) {
+            json_path = argv[++arg];
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (options.tones.empty()) {
+        options.tones.push_back(synth_tone { 10.1e6, -1.0, 0.0 });
+    }
+
+    // Only kernels this CPU can run
+    if (isas.empty()) {
+        isas.push_back(adc_isa::scalar);
+        if (adc_best_isa() != adc_isa::scalar) {
+            isas.push_back(adc_isa::sse41);
+        }
+        if (adc_best_isa() == adc_isa::avx2) {
+            isas.push_back(adc_isa::avx2);
+        }
+    }
+
+    // 1, 2, 4, ... threads, always ending on max_threads
+    std::vector<unsigned> thread_counts;
+    for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    std::printf("Variant\tKernel\tBit exact\tGS/s/core\tChannels/core\tGS/s at %u threads\n", max_threads);
+    for (const std::string &name : variants) {
+
+        adc_bus_variant variant;
+        if (!adc_variant_lookup(name, true, variant, error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return (1);
+        }
+
+        // Reference stream: lane frames plus the samples and OVR flags they carry
+        const size_t num_samples = frames * ADC_FRAME_SAMPLES;
+        std::vector<uint8_t> raw(frames * variant.format.frame_bytes());
+        std::vector<int16_t> expected(num_samples);
+        std::vector<uint8_t> expected_ovr(num_samples);
+        adc_synth synth(variant, options);
+        synth.generate(frames, raw.data(), expected.data(), expected_ovr.data());
+
+        for (const adc_isa isa : isas) {
+
+            bench_result result;
+            std::vector<int16_t> decoded(num_samples);
+            std::vector<uint8_t> decoded_ovr(num_samples);
+
+            result.variant = name;
+            result.isa = isa;
+            adc_decode(variant.format, raw.data(), frames, decoded.data(), decoded_ovr.data(), isa);
+            for (size_t index = 0; index < num_samples; index++) {
+                if ((decoded[index] != expected[index]) || (decoded_ovr[index] != expected_ovr[index])) {
+                    result.mismatches++;
+                }
+            }
+            result.bit_exact = (result.mismatches == 0);
+            failed = failed || !result.bit_exact;
+
+            for (const unsigned threads : thread_counts) {
+                result.scaling.push_back(bench_point { threads, measure(variant.format, raw, frames, isa, threads, seconds) });
+            }
+
+            std::printf("%s\t%s\t%s\t\t%.3f\t\t%.1f\t\t%.3f\n", name.c_str(), adc_isa_name(isa), result.bit_exact ? "yes" : "NO",
+                        result.scaling.front().gsps, result.scaling.front().gsps * 1e9 / CHANNEL_RATE_SPS, result.scaling.back().gsps);
+            results.push_back(result);
+        }
+    }
+
+    if (json_path == "-") {
+        write_json(stdout, results, frames, std::thread::hardware_concurrency());
+    }
+    else if (!json_path.empty()) {
+        std::FILE *file = std::fopen(json_path.c_str(), "w");
+        if (file == nullptr) {
+            std::fprintf(stderr, "ERROR: cannot write %s\n", json_path.c_str());
+            return (1);
+        }
+        write_json(file, results, frames, std::thread::hardware_concurrency());
+        std::fclose(file);
+    }
+
+    if (failed) {
+        std::fprintf(stderr, "ERROR: decoder output does not match the synthetic stream\n");
+        return (1);
+    }
+
+    return (0);
+}
@@ -0,0 +1,307 @@
+// Capstone Host Tools - ADC Lane Decoder
+// Turns captured DDR LVDS lane words into sign extended samples and out-of-range flags
+
+/*
+*  Decoding a frame is a transpose of 2-bit cells: data_lanes rows (lane words) of 8 cells (samples) become 8 rows
+*  (samples) of data_lanes cells.
+*
+*  SIMD kernels: a frame's lane words fill one 128-bit register, one 16-bit row per lane. Three delta swaps
+*  (4x4, 2x2 then 1x1 blocks of cells, each a shift/xor/mask between rows 4, 2 and 1 apart) transpose it in place, so
+*  row s ends up holding sample s. Sign extension is a shift pair and the 8 samples go out in one store. AVX2 runs
+*  two frames at once, one per 128-bit half.
+*
+*  Scalar kernel: a 256 entry table spreads one lane byte into four 16-bit fields (one per sample), so a frame is
+*  2 * data_lanes lookups, shifts and ORs into two 64-bit words.
+*
+*  The SIMD kernels are compiled with function target attributes and picked at run time, so the binary still runs
+*  on CPUs without AVX2.
+*/
+
+/* Libraries */
+#include <array>
+#include <cstring>
+#include "adc_decode.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ADC_DECODE_X86 1
+#include <immintrin.h>
+#endif
+
+/* Functions */
+
+// Lane byte -> its four 2-bit cells, one per 16-bit field
+static const std::array<uint64_t, 256> &spread_table() {
+
+    static const std::array<uint64_t, 256> table = []() {
+        std::array<uint64_t, 256> entries {};
+        for (unsigned byte = 0; byte < 256; byte++) {
+            for (unsigned sample = 0; sample < 4; sample++) {
+                entries[byte] |= (uint64_t)((byte >> (2 * sample)) & 0x3) << (16 * sample);
+            }
+        }
+        return (entries);
+    }();
+
+    return (table);
+}
+
+// Raw sample bits to a sign extended value
+static inline int16_t finish_sample(const uint32_t bits, const uint16_t flip, const unsigned shift) {
+    return ((int16_t)((int16_t)(uint16_t)(((bits & 0xFFFF) ^ flip) << shift) >> shift));
+}
+
+// OVR lane byte (4 samples, rising edge bits) -> four 0/1 bytes
+static const std::array<uint32_t, 256> &ovr_table() {
+
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> entries {};
+        for (unsigned byte = 0; byte < 256; byte++) {
+            uint8_t flags[4];
+            for (unsigned sample = 0; sample < 4; sample++) {
+                flags[sample] = (uint8_t)((byte >> (2 * sample)) & 0x1);
+            }
+            std::memcpy(&entries[byte], flags, sizeof(flags));
+        }
+        return (entries);
+    }();
+
+    return (table);
+}
+
+static inline void decode_ovr(const uint8_t *word, uint8_t *ovr) {
+
+    const std::array<uint32_t, 256> &table = ovr_table();
+
+    std::memcpy(ovr, &table[word[0]], 4);
+    std::memcpy(ovr + 4, &table[word[1]], 4);
+}
+
+static void decode_scalar(const adc_lane_format &format, const uint8_t *raw, const size_t num_frames, int16_t *samples, uint8_t *ovr) {
+
+    const std::array<uint64_t, 256> &table = spread_table();
+    const size_t frame_bytes = format.frame_bytes();
+    const unsigned shift = 16 - format.sample_bits();
+    const uint16_t flip = format.offset_binary ? (uint16_t)(1u << (format.sample_bits() - 1)) : 0;
+
+    for (size_t frame = 0; frame < num_frames; frame++) {
+
+        const uint8_t *words = raw + (frame * frame_bytes);
+        int16_t *out = samples + (frame * ADC_FRAME_SAMPLES);
+        uint64_t first = 0;                                 // Samples 0-3, one per 16-bit field
+        uint64_t second = 0;                                // Samples 4-7
+
+        for (unsigned lane = 0; lane < format.data_lanes; lane++) {
+            first |= table[words[2 * lane]] << (2 * lane);
+            second |= table[words[(2 * lane) + 1]] << (2 * lane);
+        }
+
+        for (unsigned sample = 0; sample < 4; sample++) {
+            out[sample] = finish_sample((uint32_t)(first >> (16 * sample)), flip, shift);
+            out[sample + 4] = finish_sample((uint32_t)(second >> (16 * sample)), flip, shift);
+        }
+
+        if (format.has_ovr && (ovr != nullptr)) {
+            decode_ovr(words + (2 * format.data_lanes), ovr + (frame * ADC_FRAME_SAMPLES));
+        }
+    }
+}
+
+#ifdef ADC_DECODE_X86
+
+// Per-row masks of the three transpose stages (rows exchanging with a row d below them, cells moving)
+#define TRANSPOSE_MASKS(set) \
+    set(0x00FF, 0x00FF, 0x00FF, 0x00FF, 0x0000, 0x0000, 0x0000, 0x0000), \
+    set(0x0F0F, 0x0F0F, 0x0000, 0x0000, 0x0F0F, 0x0F0F, 0x0000, 0x0000), \
+    set(0x3333, 0x0000, 0x3333, 0x0000, 0x3333, 0x0000, 0x3333, 0x0000)
+
+// Elements below data_lanes kept, the rest (OVR word, next frame) cleared
+static uint16_t lane_keep(const unsigned data_lanes, const unsigned lane) {
+    return ((lane < data_lanes) ? 0xFFFF : 0x0000);
+}
+
+__attribute__((target("sse4.1")))
+static inline __m128i delta_swap_128(const __m128i rows, const __m128i mask, const int rows_apart, const int bits) {
+
+    // Only immediates are allowed for the byte shifts, the three call sites pass constants
+    __m128i below = (rows_apart == 4) ? _mm_srli_si128(rows, 8) : (rows_apart == 2) ? _mm_srli_si128(rows, 4) : _mm_srli_si128(rows, 2);
+    __m128i swap = _mm_and_si128(_mm_xor_si128(_mm_srli_epi16(rows, bits), below), mask);
+    __m128i back = (rows_apart == 4) ? _mm_slli_si128(swap, 8) : (rows_apart == 2) ? _mm_slli_si128(swap, 4) : _mm_slli_si128(swap, 2);
+
+    return (_mm_xor_si128(rows, _mm_or_si128(_mm_slli_epi16(swap, bits), back)));
+}
+
+__attribute__((target("sse4.1")))
+static size_t decode_sse41(const adc_lane_format &format, const uint8_t *raw, const size_t num_frames, int16_t *samples, uint8_t *ovr) {
+
+    const size_t frame_bytes = format.frame_bytes();
+    const size_t total_bytes = num_frames * frame_bytes;
+    const unsigned lanes = format.data_lanes;
+    const __m128i shift = _mm_cvtsi32_si128((int)(16 - format.sample_bits()));
+    const __m128i flip = _mm_set1_epi16(format.offset_binary ? (short)(1u << (format.sample_bits() - 1)) : 0);
+    const __m128i keep = _mm_setr_epi16((short) lane_keep(lanes, 0), (short) lane_keep(lanes, 1), (short) lane_keep(lanes, 2), (short) lane_keep(lanes, 3),
+                                        (short) lane_keep(lanes, 4), (short) lane_keep(lanes, 5), (short) lane_keep(lanes, 6), (short) lane_keep(lanes, 7));
+    const __m128i masks[3] = { TRANSPOSE_MASKS(_mm_setr_epi16) };
+    size_t frame = 0;
+
+    // Every load reads 16 bytes, the last frames may be shorter than that and are left to the scalar kernel
+    for (; (frame < num_frames) && ((frame * frame_bytes) + 16 <= total_bytes); frame++) {
+
+        const uint8_t *words = raw + (frame * frame_bytes);
+        __m128i rows = _mm_and_si128(_mm_loadu_si128((const __m128i *) words), keep);
+
+        // Lane rows of sample cells -> sample rows of lane cells
+        rows = delta_swap_128(rows, masks[0], 4, 8);
+        rows = delta_swap_128(rows, masks[1], 2, 4);
+        rows = delta_swap_128(rows, masks[2], 1, 2);
+
+        rows = _mm_sra_epi16(_mm_sll_epi16(_mm_xor_si128(rows, flip), shift), shift);
+        _mm_storeu_si128((__m128i *)(samples + (frame * ADC_FRAME_SAMPLES)), rows);
+
+        if (format.has_ovr && (ovr != nullptr)) {
+            decode_ovr(words + (2 * lanes), ovr + (frame * ADC_FRAME_SAMPLES));
+        }
+    }
+
+    return (frame);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i delta_swap_256(const __m256i rows, const __m256i mask, const int rows_apart, const int bits) {
+
+    // Byte shifts stay inside each 128-bit half, which is one frame
+    __m256i below = (rows_apart == 4) ? _mm256_srli_si256(rows, 8) : (rows_apart == 2) ? _mm256_srli_si256(rows, 4) : _mm256_srli_si256(rows, 2);
+    __m256i swap = _mm256_and_si256(_mm256_xor_si256(_mm256_srli_epi16(rows, bits), below), mask);
+    __m256i back = (rows_apart == 4) ? _mm256_slli_si256(swap, 8) : (rows_apart == 2) ? _mm256_slli_si256(swap, 4) : _mm256_slli_si256(swap, 2);
+
+    return (_mm256_xor_si256(rows, _mm256_or_si256(_mm256_slli_epi16(swap, bits), back)));
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const adc_lane_format &format, const uint8_t *raw, const size_t num_frames, int16_t *samples, uint8_t *ovr) {
+
+    const size_t frame_bytes = format.frame_bytes();
+    const size_t total_bytes = num_frames * frame_bytes;
+    const unsigned lanes = format.data_lanes;
+    const __m128i shift = _mm_cvtsi32_si128((int)(16 - format.sample_bits()));
+    const __m256i flip = _mm256_set1_epi16(format.offset_binary ? (short)(1u << (format.sample_bits() - 1)) : 0);
+    const __m256i keep = _mm256_broadcastsi128_si256(
+        _mm_setr_epi16((short) lane_keep(lanes, 0), (short) lane_keep(lanes, 1), (short) lane_keep(lanes, 2), (short) lane_keep(lanes, 3),
+                       (short) lane_keep(lanes, 4), (short) lane_keep(lanes, 5), (short) lane_keep(lanes, 6), (short) lane_keep(lanes, 7)));
+    const __m128i half_masks[3] = { TRANSPOSE_MASKS(_mm_setr_epi16) };
+    const __m256i masks[3] = { _mm256_broadcastsi128_si256(half_masks[0]), _mm256_broadcastsi128_si256(half_masks[1]),
+                               _mm256_broadcastsi128_si256(half_masks[2]) };
+    size_t frame = 0;
+
+    // Two frames per iteration, frame A in the low half and frame B in the high half. Their samples are contiguous
+    for (; (frame + 1 < num_frames) && (((frame + 1) * frame_bytes) + 16 <= total_bytes); frame += 2) {
+
+        const uint8_t *words = raw + (frame * frame_bytes);
+        __m256i rows = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) words)),
+                                               _mm_loadu_si128((const __m128i *)(words + frame_bytes)), 1);
+
+        rows = _mm256_and_si256(rows, keep);
+        rows = delta_swap_256(rows, masks[0], 4, 8);
+        rows = delta_swap_256(rows, masks[1], 2, 4);
+        rows = delta_swap_256(rows, masks[2], 1, 2);
+
+        rows = _mm256_sra_epi16(_mm256_sll_epi16(_mm256_xor_si256(rows, flip), shift), shift);
+        _mm256_storeu_si256((__m256i *)(samples + (frame * ADC_FRAME_SAMPLES)), rows);
+
+        if (format.has_ovr && (ovr != nullptr)) {
+            decode_ovr(words + (2 * lanes), ovr + (frame * ADC_FRAME_SAMPLES));
+            decode_ovr(words + frame_bytes + (2 * lanes), ovr + ((frame + 1) * ADC_FRAME_SAMPLES));
+        }
+    }
+
+    return (frame);
+}
+
+#endif
+
+adc_isa adc_best_isa() {
+
+#ifdef ADC_DECODE_X86
+    if (__builtin_cpu_supports("avx2")) {
+        return (adc_isa::avx2);
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return (adc_isa::sse41);
+    }
+#endif
+
+    return (adc_isa::scalar);
+}
+
+const char *adc_isa_name(const adc_isa isa) {
+
+    switch (isa) {
+        case adc_isa::avx2:
+            return ("avx2");
+        case adc_isa::sse41:
+            return ("sse4.1");
+        default:
+            return ("scalar");
+    }
+}
+
+void adc_decode(const adc_lane_format &format, const uint8_t *raw, const size_t num_frames, int16_t *samples, uint8_t *ovr, adc_isa isa) {
+
+    size_t done = 0;
+
+    if ((format.data_lanes == 0) || (format.data_lanes > ADC_MAX_DATA_LANES)) {
+        return;
+    }
+
+#ifdef ADC_DECODE_X86
+    // Never run a kernel the CPU cannot execute
+    if ((isa == adc_isa::avx2) && !__builtin_cpu_supports("avx2")) {
+        isa = adc_isa::sse41;
+    }
+    if ((isa == adc_isa::sse41) && !__builtin_cpu_supports("sse4.1")) {
+        isa = adc_isa::scalar;
+    }
+
+    if (isa == adc_isa::avx2) {
+        done = decode_avx2(format, raw, num_frames, samples, ovr);
+    }
+    else if (isa == adc_isa::sse41) {
+        done = decode_sse41(format, raw, num_frames, samples, ovr);
+    }
+#else
+    (void) isa;
+#endif
+
+    // Whatever the SIMD kernel left (short tail frames)
+    decode_scalar(format, raw + (done * format.frame_bytes()), num_frames - done, samples + (done * ADC_FRAME_SAMPLES),
+                  (ovr == nullptr) ? nullptr : ovr + (done * ADC_FRAME_SAMPLES));
+}
+
+void adc_encode(const adc_lane_format &format, const int16_t *samples, const uint8_t *ovr, const size_t num_frames, uint8_t *raw) {
+
+    const size_t frame_bytes = format.frame_bytes();
+    const uint16_t mask = (uint16_t)((1u << format.sample_bits()) - 1);
+    const uint16_t flip = format.offset_binary ? (uint16_t)(1u << (format.sample_bits() - 1)) : 0;
+
+    for (size_t frame = 0; frame < num_frames; frame++) {
+
+        uint16_t words[ADC_MAX_DATA_LANES + 1] = {};
+        uint8_t *out = raw + (frame * frame_bytes);
+
+        for (unsigned sample = 0; sample < ADC_FRAME_SAMPLES; sample++) {
+            const size_t index = (frame * ADC_FRAME_SAMPLES) + sample;
+            const uint16_t bits = (uint16_t)(((uint16_t) samples[index] & mask) ^ flip);
+            for (unsigned lane = 0; lane < format.data_lanes; lane++) {
+                words[lane] |= (uint16_t)(((bits >> (2 * lane)) & 0x3) << (2 * sample));
+            }
+            // OVR is held for the whole sample, so both edges carry it
+            if ((ovr != nullptr) && ovr[index]) {
+                words[format.data_lanes] |= (uint16_t)(0x3 << (2 * sample));
+            }
+        }
+
+        for (unsigned lane = 0; lane < (format.data_lanes + (format.has_ovr ? 1 : 0)); lane++) {
+            out[2 * lane] = (uint8_t)(words[lane] & 0xFF);
+            out[(2 * lane) + 1] = (uint8_t)(words[lane] >> 8);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+// Capstone Host Tools - ADC Lane Decoder
+// Turns captured DDR LVDS lane words into sign extended samples and out-of-range flags
+
+#ifndef ADC_DECODE_HPP
+#define ADC_DECODE_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+
+/*
+*  Raw capture format (what the FPGA writes for one ADC):
+*  A frame holds ADC_FRAME_SAMPLES consecutive samples. Every lane contributes one little-endian 16-bit word per frame
+*  with its bits in arrival order: bit 2s is the bit latched on the rising edge of sample s, bit 2s+1 the one on the
+*  falling edge. Lane k carries sample bits 2k (rising) and 2k+1 (falling), the usual AD/TI DDR LVDS bit pairing.
+*  The frame is the data lane words 0..data_lanes-1 followed by the OVR lane word when the bus has one (OVR is
+*  sampled on the rising edge only).
+*/
+
+/* Format parameters */
+static const unsigned ADC_FRAME_SAMPLES         = 8;        // Samples per frame (16 DDR bits per lane word)
+static const unsigned ADC_MAX_DATA_LANES        = 8;        // 16 bit converters use 8 DDR pairs
+
+/* Types */
+
+// Lane layout of one ADC bus
+struct adc_lane_format {
+    unsigned data_lanes = 7;                                // DDR data pairs: 7 for 14 bit, 8 for 16 bit converters
+    bool has_ovr = true;                                    // Frame ends with an OVR lane word
+    bool offset_binary = false;                             // ADC outputs offset binary instead of two's complement
+
+    unsigned sample_bits() const { return (2 * data_lanes); }
+    size_t frame_bytes() const { return (2 * (data_lanes + (has_ovr ? 1 : 0))); }
+};
+
+// Kernel selection
+enum class adc_isa {
+    scalar,                                                 // Portable table driven decoder
+    sse41,                                                  // 128-bit shuffle/movemask transpose
+    avx2                                                    // Two frames per 256-bit register
+};
+
+/* Functions */
+
+// Best kernel the running CPU supports
+adc_isa adc_best_isa();
+
+// Printable kernel name
+const char *adc_isa_name(const adc_isa isa);
+
+/* Decode num_frames frames from raw into num_frames * ADC_FRAME_SAMPLES samples (sign extended to 16 bits).
+ovr receives one 0/1 byte per sample and may be nullptr. Falls back to scalar if the CPU lacks the requested kernel */
+void adc_decode(const adc_lane_format &format, const uint8_t *raw, const size_t num_frames, int16_t *samples, uint8_t *ovr,
+                adc_isa isa = adc_best_isa());
+
+/* Inverse of adc_decode() (scalar), for generators and loopback checks. ovr may be nullptr (no overrange) */
+void adc_encode(const adc_lane_format &format, const int16_t *samples, const uint8_t *ovr, const size_t num_frames, uint8_t *raw);
+
+#endif
@@ -0,0 +1,171 @@
+// Capstone Host Tools - Synthetic ADC Capture Generator
+// Writes a capture file of tones plus noise for any mix of ADC bus variants
+
+/*
+*  Usage: adc_gen <capture file> [options]
+*      --channel <variant[+ovr]>   Add a channel (ddr14, ddr16 or sdr14), repeatable (default one ddr14+ovr)
+*      --samples <n>               Samples per channel (default 16M)
+*      --rate <Hz>                 Sample rate (default 250e6)
+*      --tone <f[:dBFS]>           Test tone, repeatable (default 10.1e6:-1)
+*      --noise <lsb>               Gaussian noise (default 0.5 LSB rms)
+*      --seed <n>                  Noise seed of channel 0, later channels count up from it (default 1)
+*      --raw                       Store raw lane frames instead of decoded int16 samples
+*      --chunk <n>                 Samples per chunk (default 1M)
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include "adc_synth.hpp"
+#include "capture_file.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s <capture file> [--channel ddr14|ddr16|sdr14[+ovr]] [--samples n] [--rate Hz] [--tone f[:dBFS]]\n"
+                "       [--noise lsb] [--seed n] [--raw] [--chunk n]\n", program);
+}
+
+int main(int argc, char **argv) {
+
+    std::vector<std::string> channels;
+    synth_options options;
+    uint64_t total_samples = 16 * 1024 * 1024;
+    uint32_t chunk_samples = 1024 * 1024;
+    bool raw_frames = false;
+    std::string error;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--channel") == 0) && has_value) {
+            channels.push_back(argv[++arg]);
+        }
+        else if ((std::strcmp(argv[arg], "--samples") == 0) && has_value) {
+            total_samples = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--rate") == 0) && has_value) {
+            options.sample_rate_hz = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--tone") == 0) && has_value) {
+            synth_tone tone;
+            if (!parse_synth_tone(argv[++arg], tone)) {
+                usage(argv[0]);
+                return (1);
+            }
+            options.tones.push_back(tone);
+        }
+        else if ((std::strcmp(argv[arg], "--noise") == 0) && has_value) {
+            options.noise_lsb = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--seed") == 0) && has_value) {
+            options.seed = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if (std::strcmp(argv[arg], "--raw") == 0) {
+            raw_frames = true;
+        }
+        else if ((std::strcmp(argv[arg], "--chunk") == 0) && has_value) {
+            chunk_samples = (uint32_t) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (channels.empty()) {
+        channels.push_back("ddr14+ovr");
+    }
+    if (options.tones.empty()) {
+        options.tones.push_back(synth_tone { 10.1e6, -1.0, 0.0 });
+    }
+    if ((channels.size() > CAPTURE_MAX_CHANNELS) || (chunk_samples < ADC_FRAME_SAMPLES) || ((chunk_samples % ADC_FRAME_SAMPLES) != 0)) {
+        std::fprintf(stderr, "ERROR: at most %u channels, chunk size a multiple of %u samples\n", CAPTURE_MAX_CHANNELS, ADC_FRAME_SAMPLES);
+        return (1);
+    }
+
+    capture_header header = capture_make_header((uint64_t) options.sample_rate_hz, raw_frames ? CAPTURE_RAW_FRAMES : CAPTURE_SAMPLES_INT16,
+                                                chunk_samples);
+    std::vector<adc_bus_variant> variants(channels.size());
+    std::vector<std::unique_ptr<adc_synth>> sources;
+
+    header.num_channels = (uint32_t) channels.size();
+    std::snprintf(header.description, sizeof(header.description), "adc_gen: %zu tone(s), %.2f LSB noise", options.tones.size(), options.noise_lsb);
+    for (size_t channel = 0; channel < channels.size(); channel++) {
+
+        const std::string &spec = channels[channel];
+        const size_t plus = spec.find('+');
+        const std::string name = spec.substr(0, plus);
+        const bool has_ovr = (plus != std::string::npos) && (spec.substr(plus + 1) == "ovr");
+
+        if (((plus != std::string::npos) && !has_ovr) || !adc_variant_lookup(name, has_ovr, variants[channel], error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.empty() ? ("bad channel '" + spec + "'").c_str() : error.c_str());
+            return (1);
+        }
+
+        capture_channel &info = header.channels[channel];
+        std::snprintf(info.bus, sizeof(info.bus), "ADC%zu", channel);
+        std::snprintf(info.variant, sizeof(info.variant), "%s", name.c_str());
+        info.data_lanes = (uint8_t) variants[channel].format.data_lanes;
+        info.has_ovr = has_ovr ? 1 : 0;
+        info.offset_binary = 0;
+        info.sample_bits = (uint8_t) variants[channel].format.sample_bits();
+
+        synth_options channel_options = options;
+        channel_options.seed = options.seed + channel;
+        sources.emplace_back(new adc_synth(variants[channel], channel_options));
+    }
+
+    capture_writer writer;
+    if (!writer.open(argv[1], header, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    std::vector<std::vector<uint8_t>> raw(channels.size());
+    std::vector<std::vector<int16_t>> samples(channels.size());
+    std::vector<std::vector<uint8_t>> ovr(channels.size());
+    std::vector<const void *> data(channels.size());
+    std::vector<const uint8_t *> flags(channels.size());
+
+    for (uint64_t written = 0; written < total_samples; ) {
+
+        const uint64_t left = total_samples - written;
+        const uint32_t count = (uint32_t)(((left < chunk_samples) ? left : chunk_samples) / ADC_FRAME_SAMPLES * ADC_FRAME_SAMPLES);
+        const uint64_t timestamp_ns = (uint64_t)((double) written * 1e9 / options.sample_rate_hz);
+
+        if (count == 0) {
+            break;
+        }
+
+        for (size_t channel = 0; channel < channels.size(); channel++) {
+            raw[channel].resize((count / ADC_FRAME_SAMPLES) * variants[channel].format.frame_bytes());
+            samples[channel].resize(count);
+            ovr[channel].resize(count);
+            sources[channel]->generate(count / ADC_FRAME_SAMPLES, raw[channel].data(), samples[channel].data(), ovr[channel].data());
+            data[channel] = raw_frames ? (const void *) raw[channel].data() : (const void *) samples[channel].data();
+            flags[channel] = variants[channel].format.has_ovr ? ovr[channel].data() : nullptr;
+        }
+
+        if (!writer.write_chunk(data.data(), flags.data(), count, timestamp_ns, error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return (1);
+        }
+        written += count;
+    }
+
+    if (!writer.close(error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    return (0);
+}
@@ -0,0 +1,117 @@
+// Capstone Host Tools - ADC Spectrum Analyzer
+// Averaged spectrum and SNR/SINAD/SFDR/ENOB of one capture channel
+
+/*
+*  Usage: adc_spectrum <capture file> [options]
+*      --channel <n>       Channel to analyse (default 0)
+*      --fft <n>           FFT size (default 65536)
+*      --overlap <x>       Overlap fraction (default 0.5)
+*      --window <name>     hann or bh4 (default bh4)
+*      --threads <n>       Worker threads (default: one per core)
+*      --start <sample>    First sample to analyse (default 0)
+*      --samples <n>       Samples to analyse (default: all)
+*      --harmonics <n>     Harmonics counted as distortion (default 5)
+*      --out <file>        Spectrum CSV, rewritten with the running average while the analysis runs
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include "capture_file.hpp"
+#include "spectrum.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s <capture file> [--channel n] [--fft n] [--overlap x] [--window hann|bh4] [--threads n]\n"
+                "       [--start sample] [--samples n] [--harmonics n] [--out spectrum.csv]\n", program);
+}
+
+int main(int argc, char **argv) {
+
+    capture_reader reader;
+    spectrum_options options;
+    spectrum_result result;
+    std::string out_path;
+    std::string error;
+    unsigned channel = 0;
+    unsigned harmonics = 5;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--channel") == 0) && has_value) {
+            channel = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--fft") == 0) && has_value) {
+            options.fft_size = (size_t) std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--overlap") == 0) && has_value) {
+            options.overlap = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--window") == 0) && has_value) {
+            if (!parse_spectrum_window(argv[++arg], options.window)) {
+                usage(argv[0]);
+                return (1);
+            }
+        }
+        else if ((std::strcmp(argv[arg], "--threads") == 0) && has_value) {
+            options.threads = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--start") == 0) && has_value) {
+            options.first_sample = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--samples") == 0) && has_value) {
+            options.num_samples = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--harmonics") == 0) && has_value) {
+            harmonics = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--out") == 0) && has_value) {
+            out_path = argv[++arg];
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (!reader.open(argv[1], error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    // Keep the output file current while the pipeline runs
+    auto snapshot = [&out_path](const spectrum_result &partial) {
+        std::string write_error;
+        if (!out_path.empty() && !write_spectrum_csv(out_path, partial, write_error)) {
+            std::fprintf(stderr, "WARNING: %s\n", write_error.c_str());
+        }
+        std::fprintf(stderr, "\r%llu frames", (unsigned long long) partial.frames);
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!compute_spectrum(reader, channel, options, result, error, snapshot)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t analysed = (options.num_samples > 0) ? options.num_samples : (reader.num_samples() - options.first_sample);
+
+    const spectrum_metrics metrics = analyze_spectrum(result, harmonics);
+    std::fprintf(stderr, "\n");
+    std::printf("%llu FFTs of %zu points in %.2f s (%.1f MS/s, %.1f MB/s of capture)\n", (unsigned long long) result.frames,
+                result.fft_size, elapsed_s, analysed / elapsed_s / 1e6, analysed * sizeof(int16_t) / elapsed_s / 1e6);
+    std::printf("Fundamental %.6f MHz at %.2f dBFS\n", metrics.fundamental_hz / 1e6, metrics.fundamental_dbfs);
+    std::printf("SNR %.2f dB, SINAD %.2f dB, SFDR %.2f dBc, ENOB %.2f bits, noise %.2f dBFS\n", metrics.snr_db, metrics.sinad_db,
+                metrics.sfdr_dbc, metrics.enob, metrics.noise_dbfs);
+
+    return (0);
+}
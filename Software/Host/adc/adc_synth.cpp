@@ -0,0 +1,175 @@
+// Capstone Host Tools - Synthetic ADC Streams
+// Tones plus noise, quantized like the converters and serialized lane by lane into raw capture frames
+
+/*
+*  Tones run as complex phasors advanced by one multiply per sample and renormalized once per frame, so a long
+*  stream costs no sin() calls and does not drift in amplitude. The analog value is rounded to the nearest code. Values
+*  past either end of the code range are clamped and flagged on OVR, which is what the converters do.
+*/
+
+/* Libraries */
+#include <cmath>
+#include <cstdlib>
+#include "adc_synth.hpp"
+
+/* Functions */
+
+bool adc_variant_lookup(const std::string &name, const bool has_ovr, adc_bus_variant &variant, std::string &error) {
+
+    variant.name = name;
+    variant.format.has_ovr = has_ovr;
+    variant.format.offset_binary = false;
+
+    if (name == "ddr14") {
+        variant.ddr = true;
+        variant.wire_lanes = 7;
+        variant.format.data_lanes = 7;
+    }
+    else if (name == "ddr16") {
+        variant.ddr = true;
+        variant.wire_lanes = 8;
+        variant.format.data_lanes = 8;
+    }
+    else if (name == "sdr14") {
+        variant.ddr = false;
+        variant.wire_lanes = 14;
+        variant.format.data_lanes = 7;
+    }
+    else {
+        error = "unknown bus variant '" + name + "' (ddr14, ddr16 or sdr14)";
+        return (false);
+    }
+
+    return (true);
+}
+
+bool parse_synth_tone(const std::string &text, synth_tone &tone) {
+
+    char *end = nullptr;
+
+    tone.freq_hz = std::strtod(text.c_str(), &end);
+    if ((end == text.c_str()) || (tone.freq_hz < 0.0)) {
+        return (false);
+    }
+    if (*end == ':') {
+        const char *level = end + 1;
+        tone.dbfs = std::strtod(level, &end);
+        if (end == level) {
+            return (false);
+        }
+    }
+
+    return (*end == '\0');
+}
+
+adc_synth::adc_synth(const adc_bus_variant &variant, const synth_options &options)
+    : bus(variant), rng(options.seed), noise(0.0, options.noise_lsb) {
+
+    const double pi = std::acos(-1.0);
+    const double full_scale = std::ldexp(1.0, (int) bus.format.sample_bits() - 1);
+
+    for (const synth_tone &tone : options.tones) {
+        phasors.push_back(std::polar(1.0, tone.phase_rad));
+        steps.push_back(std::polar(1.0, 2.0 * pi * tone.freq_hz / options.sample_rate_hz));
+        amplitudes.push_back(full_scale * std::pow(10.0, tone.dbfs / 20.0));
+    }
+}
+
+void adc_synth::serialize(const int16_t *samples, const uint8_t *ovr, uint8_t *raw) const {
+
+    const unsigned bits = bus.format.sample_bits();
+    const uint16_t mask = (uint16_t)((1u << bits) - 1);
+    const uint16_t flip = bus.format.offset_binary ? (uint16_t)(1u << (bits - 1)) : 0;
+    uint16_t wire[2 * ADC_MAX_DATA_LANES] = {};             // Bits of every physical lane in arrival order
+    uint16_t ovr_wire = 0;
+    uint16_t words[ADC_MAX_DATA_LANES + 1] = {};
+
+    for (unsigned sample = 0; sample < ADC_FRAME_SAMPLES; sample++) {
+
+        const uint16_t code = (uint16_t)(((uint16_t) samples[sample] & mask) ^ flip);
+        const bool over = (ovr != nullptr) && (ovr[sample] != 0);
+
+        if (bus.ddr) {
+            // Bit 2k goes out on the rising edge, bit 2k+1 on the falling edge, OVR holds for both
+            for (unsigned lane = 0; lane < bus.wire_lanes; lane++) {
+                wire[lane] |= (uint16_t)(((code >> (2 * lane)) & 0x1) << (2 * sample));
+                wire[lane] |= (uint16_t)(((code >> ((2 * lane) + 1)) & 0x1) << ((2 * sample) + 1));
+            }
+            ovr_wire |= (uint16_t)(over ? (0x3 << (2 * sample)) : 0);
+        }
+        else {
+            // One bit per lane per sample clock
+            for (unsigned lane = 0; lane < bus.wire_lanes; lane++) {
+                wire[lane] |= (uint16_t)(((code >> lane) & 0x1) << sample);
+            }
+            ovr_wire |= (uint16_t)(over ? (0x1 << sample) : 0);
+        }
+    }
+
+    // Pack the lanes the way the FPGA capture does
+    for (unsigned word = 0; word < bus.format.data_lanes; word++) {
+        if (bus.ddr) {
+            words[word] = wire[word];
+        }
+        else {
+            for (unsigned sample = 0; sample < ADC_FRAME_SAMPLES; sample++) {
+                words[word] |= (uint16_t)(((wire[2 * word] >> sample) & 0x1) << (2 * sample));
+                words[word] |= (uint16_t)(((wire[(2 * word) + 1] >> sample) & 0x1) << ((2 * sample) + 1));
+            }
+        }
+    }
+    if (bus.ddr) {
+        words[bus.format.data_lanes] = ovr_wire;
+    }
+    else {
+        for (unsigned sample = 0; sample < ADC_FRAME_SAMPLES; sample++) {
+            words[bus.format.data_lanes] |= (uint16_t)(((ovr_wire >> sample) & 0x1) ? (0x3 << (2 * sample)) : 0);
+        }
+    }
+
+    for (unsigned lane = 0; lane < (bus.format.data_lanes + (bus.format.has_ovr ? 1 : 0)); lane++) {
+        raw[2 * lane] = (uint8_t)(words[lane] & 0xFF);
+        raw[(2 * lane) + 1] = (uint8_t)(words[lane] >> 8);
+    }
+}
+
+void adc_synth::generate(const size_t num_frames, uint8_t *raw, int16_t *samples, uint8_t *ovr) {
+
+    const int code_max = (1 << (bus.format.sample_bits() - 1)) - 1;
+    const int code_min = -(1 << (bus.format.sample_bits() - 1));
+    const size_t frame_bytes = bus.format.frame_bytes();
+
+    for (size_t frame = 0; frame < num_frames; frame++) {
+
+        int16_t frame_samples[ADC_FRAME_SAMPLES];
+        uint8_t frame_ovr[ADC_FRAME_SAMPLES];
+
+        for (unsigned sample = 0; sample < ADC_FRAME_SAMPLES; sample++) {
+
+            double value = noise(rng);
+            for (size_t tone = 0; tone < phasors.size(); tone++) {
+                value += amplitudes[tone] * phasors[tone].imag();
+                phasors[tone] *= steps[tone];
+            }
+
+            const long code = std::lround(value);
+            frame_ovr[sample] = ((code > code_max) || (code < code_min)) ? 1 : 0;
+            frame_samples[sample] = (int16_t)((code > code_max) ? code_max : (code < code_min) ? code_min : code);
+        }
+
+        for (std::complex<double> &phasor : phasors) {
+            phasor /= std::abs(phasor);
+        }
+
+        serialize(frame_samples, frame_ovr, raw + (frame * frame_bytes));
+        for (unsigned sample = 0; sample < ADC_FRAME_SAMPLES; sample++) {
+            if (samples != nullptr) {
+                samples[(frame * ADC_FRAME_SAMPLES) + sample] = frame_samples[sample];
+            }
+            if (ovr != nullptr) {
+                ovr[(frame * ADC_FRAME_SAMPLES) + sample] = frame_ovr[sample];
+            }
+        }
+        sample_index += ADC_FRAME_SAMPLES;
+    }
+}
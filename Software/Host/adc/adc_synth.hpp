@@ -0,0 +1,79 @@
+// Capstone Host Tools - Synthetic ADC Streams
+// Tones plus noise, quantized like the converters and serialized lane by lane into raw capture frames
+
+#ifndef ADC_SYNTH_HPP
+#define ADC_SYNTH_HPP
+
+/* Libraries */
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "adc_decode.hpp"
+
+/*
+*  Samples are serialized the way each bus variant in Documentation/FPGA/Kintex_pin_planning.txt puts them on the
+*  wire (bit by bit per lane and clock edge), then packed into lane words the way the FPGA capture does:
+*      ddr14/ddr16: one word per DDR pair, rising edge bit at even positions, falling edge bit at odd positions
+*      sdr14:       SDR pairs 2k and 2k+1 share word k, pair 2k at even positions, pair 2k+1 at odd positions
+*  so every variant ends up in the frame format of adc_decode.hpp without going through adc_encode().
+*/
+
+/* Types */
+
+// Physical bus of one ADC variant
+struct adc_bus_variant {
+    std::string name;                                       // ddr14, ddr16 or sdr14
+    bool ddr = true;                                        // Two bits per lane per sample (false: one)
+    unsigned wire_lanes = 7;                                // Data pairs on the board
+    adc_lane_format format;                                 // Capture frame layout after packing
+};
+
+struct synth_tone {
+    double freq_hz = 10e6;
+    double dbfs = -1.0;                                     // Amplitude relative to full scale (above 0 clips and sets OVR)
+    double phase_rad = 0.0;
+};
+
+struct synth_options {
+    double sample_rate_hz = 250e6;
+    std::vector<synth_tone> tones;                          // Summed, none gives noise only
+    double noise_lsb = 0.5;                                 // Gaussian noise (in LSB rms)
+    uint64_t seed = 1;
+};
+
+/* Functions */
+
+/* Bus variant by name */
+bool adc_variant_lookup(const std::string &name, const bool has_ovr, adc_bus_variant &variant, std::string &error);
+
+// "FREQ_HZ[:DBFS]", e.g. "10.1e6:-1"
+bool parse_synth_tone(const std::string &text, synth_tone &tone);
+
+// Continuous signal source for one ADC
+class adc_synth {
+public:
+    adc_synth(const adc_bus_variant &variant, const synth_options &options);
+
+    /* Produce the next num_frames frames. raw receives the packed lane frames, samples/ovr (either may be nullptr) the
+    values they encode */
+    void generate(const size_t num_frames, uint8_t *raw, int16_t *samples, uint8_t *ovr);
+
+    // Samples produced so far
+    uint64_t position() const { return (sample_index); }
+
+private:
+    void serialize(const int16_t *samples, const uint8_t *ovr, uint8_t *raw) const;
+
+    adc_bus_variant bus;
+    std::mt19937_64 rng;
+    std::normal_distribution<double> noise;
+    std::vector<std::complex<double>> phasors;              // Current phase of every tone
+    std::vector<std::complex<double>> steps;                // Phase advance per sample
+    std::vector<double> amplitudes;                         // Peak of every tone (in codes)
+    uint64_t sample_index = 0;
+};
+
+#endif
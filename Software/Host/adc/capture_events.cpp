@@ -0,0 +1,156 @@
+// Capstone Host Tools - ADC Capture Event Finder
+// Builds (or reuses) the event index of a capture and lists OVR, clipping and high amplitude events
+
+/*
+*  Usage: capture_events <capture file> [options]
+*      --index <file>      Event index file (default: <capture file>.events)
+*      --rebuild           Rebuild the index even if it is current
+*      --high <dBFS>       Region peak that counts as high amplitude (default -6)
+*      --clip-margin <n>   Codes below full scale that still count as clipped (default 0)
+*      --region <n>        High amplitude region size in samples (default 4096)
+*      --gap <n>           Join runs less than n samples apart (default 64)
+*      --threads <n>       Worker threads (default: one per core)
+*      --kind <name>       Only list ovr, clip or high events
+*      --channel <n>       Only list events of one channel
+*      --from <sample>     Only list events overlapping samples from..to
+*      --to <sample>
+*      --limit <n>         List at most n events (default 100, 0 for all)
+*
+*  The index is rebuilt whenever the capture or the options no longer match it.
+*/
+
+/* Libraries */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "capture_file.hpp"
+#include "event_index.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s <capture file> [--index file] [--rebuild] [--high dBFS] [--clip-margin n] [--region n] [--gap n]\n"
+                "       [--threads n] [--kind ovr|clip|high] [--channel n] [--from sample] [--to sample] [--limit n]\n", program);
+}
+
+int main(int argc, char **argv) {
+
+    capture_reader reader;
+    event_index_options options;
+    event_index index;
+    std::string index_path;
+    std::string error;
+    bool rebuild = false;
+    bool filter_kind = false;
+    capture_event_kind kind = capture_event_kind::ovr;
+    int channel = -1;
+    uint64_t from = 0;
+    uint64_t to = UINT64_MAX;
+    size_t limit = 100;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+    index_path = std::string(argv[1]) + ".events";
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--index") == 0) && has_value) {
+            index_path = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--rebuild") == 0) {
+            rebuild = true;
+        }
+        else if ((std::strcmp(argv[arg], "--high") == 0) && has_value) {
+            options.high_dbfs = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--clip-margin") == 0) && has_value) {
+            options.clip_margin = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--region") == 0) && has_value) {
+            options.region_samples = (uint32_t) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--gap") == 0) && has_value) {
+            options.merge_gap = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--threads") == 0) && has_value) {
+            options.threads = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--kind") == 0) && has_value) {
+            if (!parse_capture_event_kind(argv[++arg], kind)) {
+                usage(argv[0]);
+                return (1);
+            }
+            filter_kind = true;
+        }
+        else if ((std::strcmp(argv[arg], "--channel") == 0) && has_value) {
+            channel = std::atoi(argv[++arg]);
+        }
+        else if ((std::strcmp(argv[arg], "--from") == 0) && has_value) {
+            from = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--to") == 0) && has_value) {
+            to = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--limit") == 0) && has_value) {
+            limit = (size_t) std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (!reader.open(argv[1], error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    // Reuse the index on disk while it still describes this capture
+    if (rebuild || !load_event_index(index_path, index, error) || !event_index_current(index, reader, options)) {
+
+        const auto start = std::chrono::steady_clock::now();
+        if (!build_event_index(reader, options, index, error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return (1);
+        }
+        const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double bytes = (double) reader.num_samples() * reader.header().num_channels * sizeof(int16_t);
+
+        std::printf("Indexed %llu samples x %u channel(s) in %.3f s (%.1f MB/s of samples, %s kernels)\n",
+                    (unsigned long long) reader.num_samples(), reader.header().num_channels, elapsed_s, bytes / elapsed_s / 1e6,
+                    adc_isa_name(options.isa));
+        if (!save_event_index(index_path, index, error)) {
+            std::fprintf(stderr, "WARNING: %s\n", error.c_str());
+        }
+    }
+
+    const std::vector<capture_event> found = find_events(index, from, to);
+    const double sample_rate = (double) reader.header().sample_rate_hz;
+    size_t listed = 0;
+    size_t matching = 0;
+
+    std::printf("%llu events in %s\n", (unsigned long long) index.events.size(), index_path.c_str());
+    std::printf("Kind\tChannel\tFirst sample\tSamples\tCount\tPeak\tTime (s)\n");
+    for (const capture_event &event : found) {
+        if ((filter_kind && (event.kind != (uint8_t) kind)) || ((channel >= 0) && (event.channel != channel))) {
+            continue;
+        }
+        matching++;
+        if ((limit != 0) && (listed >= limit)) {
+            continue;
+        }
+        std::printf("%s\t%u\t%llu\t%llu\t%u\t%d\t%.9f\n", capture_event_kind_name((capture_event_kind) event.kind), event.channel,
+                    (unsigned long long) event.first_sample, (unsigned long long) event.num_samples, event.count, event.peak,
+                    (sample_rate > 0.0) ? ((double) event.first_sample / sample_rate) : 0.0);
+        listed++;
+    }
+    if (listed < matching) {
+        std::printf("... %zu more (--limit 0 lists all)\n", matching - listed);
+    }
+
+    return (0);
+}
@@ -0,0 +1,349 @@
+// Capstone Host Tools - ADC Capture File
+// Chunked, memory mappable container for long ADC recordings
+
+/* Libraries */
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "adc_decode.hpp"
+#include "capture_file.hpp"
+
+#if !defined(__BYTE_ORDER__) || (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "capture files are little endian and mapped as is"
+#endif
+
+/* Functions */
+
+static size_t align_up(const size_t value, const size_t alignment) {
+    return (((value + alignment - 1) / alignment) * alignment);
+}
+
+// Raw frame size of a channel
+static size_t channel_frame_bytes(const capture_channel &channel) {
+    return (2 * (channel.data_lanes + (channel.has_ovr ? 1 : 0)));
+}
+
+capture_header capture_make_header(const uint64_t sample_rate_hz, const capture_encoding encoding, const uint32_t chunk_samples) {
+
+    capture_header header;
+
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.header_bytes = CAPTURE_HEADER_BYTES;
+    header.sample_rate_hz = sample_rate_hz;
+    header.encoding = encoding;
+    header.chunk_samples = chunk_samples;
+
+    return (header);
+}
+
+/* Writer */
+
+capture_writer::~capture_writer() {
+
+    std::string error;
+
+    if (file != nullptr) {
+        close(error);
+    }
+}
+
+size_t capture_writer::block_bytes(const uint32_t num_samples) const {
+
+    size_t largest = 0;
+
+    for (uint32_t channel = 0; channel < head.num_channels; channel++) {
+        const size_t bytes = (head.encoding == CAPTURE_RAW_FRAMES)
+                             ? ((num_samples / ADC_FRAME_SAMPLES) * channel_frame_bytes(head.channels[channel]))
+                             : ((num_samples * sizeof(int16_t)) + ((num_samples + 7) / 8));
+        largest = std::max(largest, bytes);
+    }
+
+    return (align_up(largest, CAPTURE_BLOCK_ALIGN));
+}
+
+bool capture_writer::open(const std::string &path, const capture_header &header, std::string &error) {
+
+    std::vector<uint8_t> header_area(CAPTURE_HEADER_BYTES, 0);
+
+    if ((header.num_channels == 0) || (header.num_channels > CAPTURE_MAX_CHANNELS)) {
+        error = "a capture needs 1 to " + std::to_string(CAPTURE_MAX_CHANNELS) + " channels";
+        return (false);
+    }
+    if ((header.encoding == CAPTURE_RAW_FRAMES) && ((header.chunk_samples % ADC_FRAME_SAMPLES) != 0)) {
+        error = "raw frame chunks must hold whole frames";
+        return (false);
+    }
+
+    file = std::fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        error = "cannot create " + path;
+        return (false);
+    }
+
+    head = header;
+    head.index_offset = 0;
+    head.num_chunks = 0;
+    index.clear();
+    next_sample = 0;
+    next_offset = CAPTURE_HEADER_BYTES;
+
+    std::memcpy(header_area.data(), &head, sizeof(head));
+    if (std::fwrite(header_area.data(), 1, header_area.size(), file) != header_area.size()) {
+        error = "cannot write " + path;
+        return (false);
+    }
+
+    return (true);
+}
+
+bool capture_writer::write_chunk(const void *const *data, const uint8_t *const *ovr, const uint32_t num_samples, const uint64_t timestamp_ns,
+                                 std::string &error) {
+
+    const bool raw = (head.encoding == CAPTURE_RAW_FRAMES);
+    const size_t stride = block_bytes(num_samples);
+    const size_t chunk_bytes = align_up(sizeof(capture_chunk_header) + (stride * head.num_channels), CAPTURE_ALIGN);
+    capture_chunk_header chunk;
+
+    if (file == nullptr) {
+        error = "capture file is not open";
+        return (false);
+    }
+    if ((num_samples == 0) || (raw && ((num_samples % ADC_FRAME_SAMPLES) != 0))) {
+        error = "bad chunk length";
+        return (false);
+    }
+
+    std::memset(&chunk, 0, sizeof(chunk));
+    chunk.magic = CAPTURE_CHUNK_MAGIC;
+    chunk.num_samples = num_samples;
+    chunk.sequence = index.size();
+    chunk.first_sample = next_sample;
+    chunk.timestamp_ns = timestamp_ns;
+    chunk.chunk_bytes = chunk_bytes;
+    chunk.block_bytes = (uint32_t) stride;
+
+    // Build the whole chunk in one buffer so it goes out as a single write
+    chunk_buffer.assign(chunk_bytes, 0);
+    for (uint32_t channel = 0; channel < head.num_channels; channel++) {
+
+        uint8_t *block = chunk_buffer.data() + sizeof(capture_chunk_header) + (channel * stride);
+
+        if (raw) {
+            std::memcpy(block, data[channel], (num_samples / ADC_FRAME_SAMPLES) * channel_frame_bytes(head.channels[channel]));
+            continue;
+        }
+
+        std::memcpy(block, data[channel], num_samples * sizeof(int16_t));
+        if ((ovr != nullptr) && (ovr[channel] != nullptr)) {
+            uint8_t *bits = block + (num_samples * sizeof(int16_t));
+            for (uint32_t sample = 0; sample < num_samples; sample++) {
+                if (ovr[channel][sample]) {
+                    bits[sample / 8] |= (uint8_t)(1u << (sample % 8));
+                    chunk.ovr_count++;
+                }
+            }
+        }
+    }
+    std::memcpy(chunk_buffer.data(), &chunk, sizeof(chunk));
+
+    if (std::fwrite(chunk_buffer.data(), 1, chunk_bytes, file) != chunk_bytes) {
+        error = "capture write failed";
+        return (false);
+    }
+
+    index.push_back({ next_offset, next_sample, timestamp_ns, num_samples, chunk.ovr_count });
+    next_offset += chunk_bytes;
+    next_sample += num_samples;
+    return (true);
+}
+
+bool capture_writer::close(std::string &error) {
+
+    bool ok = true;
+
+    if (file == nullptr) {
+        return (true);
+    }
+
+    head.index_offset = next_offset;
+    head.num_chunks = index.size();
+
+    if ((!index.empty() && (std::fwrite(index.data(), sizeof(capture_index_entry), index.size(), file) != index.size())) ||
+        (std::fseek(file, 0, SEEK_SET) != 0) ||
+        (std::fwrite(&head, sizeof(head), 1, file) != 1)) {
+        error = "cannot finalize capture file";
+        ok = false;
+    }
+
+    if (std::fclose(file) != 0) {
+        error = "cannot finalize capture file";
+        ok = false;
+    }
+    file = nullptr;
+
+    return (ok);
+}
+
+/* Reader */
+
+capture_reader::~capture_reader() {
+    close();
+}
+
+void capture_reader::close() {
+
+    if (map != nullptr) {
+        munmap(const_cast<uint8_t *>(map), map_bytes);
+    }
+    map = nullptr;
+    map_bytes = 0;
+    head = nullptr;
+    index.clear();
+}
+
+bool capture_reader::open(const std::string &path, std::string &error) {
+
+    struct stat info;
+    int descriptor = -1;
+
+    close();
+
+    descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        error = "cannot open " + path;
+        return (false);
+    }
+    if ((fstat(descriptor, &info) != 0) || ((size_t) info.st_size < CAPTURE_HEADER_BYTES)) {
+        ::close(descriptor);
+        error = path + " is not a capture file";
+        return (false);
+    }
+
+    map_bytes = (size_t) info.st_size;
+    void *mapping = mmap(nullptr, map_bytes, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if (mapping == MAP_FAILED) {
+        map_bytes = 0;
+        error = "cannot map " + path;
+        return (false);
+    }
+    map = static_cast<const uint8_t *>(mapping);
+    head = reinterpret_cast<const capture_header *>(map);
+
+    if ((std::memcmp(head->magic, CAPTURE_MAGIC, sizeof(head->magic)) != 0) || (head->version != CAPTURE_VERSION) ||
+        (head->num_channels == 0) || (head->num_channels > CAPTURE_MAX_CHANNELS)) {
+        close();
+        error = path + " is not a capture file (or a newer version)";
+        return (false);
+    }
+
+    // Written index if the file was closed, otherwise walk the chunk headers up to the first incomplete one
+    index_rebuilt = (head->index_offset == 0);
+    if (!index_rebuilt && ((head->index_offset + (head->num_chunks * sizeof(capture_index_entry))) <= map_bytes)) {
+        const capture_index_entry *entries = reinterpret_cast<const capture_index_entry *>(map + head->index_offset);
+        index.assign(entries, entries + head->num_chunks);
+    }
+    else {
+        index_rebuilt = true;
+        for (uint64_t offset = CAPTURE_HEADER_BYTES; (offset + sizeof(capture_chunk_header)) <= map_bytes;) {
+            const capture_chunk_header *chunk = reinterpret_cast<const capture_chunk_header *>(map + offset);
+            if ((chunk->magic != CAPTURE_CHUNK_MAGIC) || (chunk->chunk_bytes == 0) || ((offset + chunk->chunk_bytes) > map_bytes)) {
+                break;
+            }
+            index.push_back({ offset, chunk->first_sample, chunk->timestamp_ns, chunk->num_samples, chunk->ovr_count });
+            offset += chunk->chunk_bytes;
+        }
+    }
+
+    return (true);
+}
+
+uint64_t capture_reader::num_samples() const {
+    return (index.empty() ? 0 : (index.back().first_sample + index.back().num_samples));
+}
+
+capture_chunk capture_reader::chunk(const size_t n) const {
+
+    capture_chunk view;
+
+    view.header = reinterpret_cast<const capture_chunk_header *>(map + index[n].offset);
+    view.blocks = map + index[n].offset + sizeof(capture_chunk_header);
+
+    return (view);
+}
+
+size_t capture_reader::find_chunk(const uint64_t sample) const {
+
+    // First chunk starting after the sample, the one before it holds the sample
+    auto after = std::upper_bound(index.begin(), index.end(), sample, [](const uint64_t value, const capture_index_entry &entry) {
+        return (value < entry.first_sample);
+    });
+
+    if ((after == index.begin()) || (sample >= num_samples())) {
+        return (index.size());
+    }
+
+    return ((size_t)(after - index.begin()) - 1);
+}
+
+const int16_t *capture_reader::samples_at(const unsigned channel, const uint64_t first, const size_t count) const {
+
+    const size_t n = find_chunk(first);
+
+    if ((head->encoding != CAPTURE_SAMPLES_INT16) || (channel >= head->num_channels) || (n >= index.size()) ||
+        ((first + count) > (index[n].first_sample + index[n].num_samples))) {
+        return (nullptr);
+    }
+
+    return (chunk(n).samples(channel) + (first - index[n].first_sample));
+}
+
+size_t capture_reader::read_samples(const unsigned channel, const uint64_t first, const size_t count, int16_t *out) const {
+
+    size_t copied = 0;
+    std::vector<int16_t> decoded;
+
+    if (channel >= head->num_channels) {
+        return (0);
+    }
+
+    for (size_t n = find_chunk(first); (copied < count) && (n < index.size()); n++) {
+
+        const capture_chunk view = chunk(n);
+        const uint64_t offset = (first + copied) - view.first_sample();
+        const size_t take = std::min((size_t)(view.num_samples() - offset), count - copied);
+
+        if (head->encoding == CAPTURE_SAMPLES_INT16) {
+            std::memcpy(out + copied, view.samples(channel) + offset, take * sizeof(int16_t));
+        }
+        else {
+            // Decode the whole frames covering the range
+            const capture_channel &info = head->channels[channel];
+            adc_lane_format format;
+            format.data_lanes = info.data_lanes;
+            format.has_ovr = (info.has_ovr != 0);
+            format.offset_binary = (info.offset_binary != 0);
+            const size_t first_frame = offset / ADC_FRAME_SAMPLES;
+            const size_t last_frame = (offset + take + ADC_FRAME_SAMPLES - 1) / ADC_FRAME_SAMPLES;
+            decoded.resize((last_frame - first_frame) * ADC_FRAME_SAMPLES);
+            adc_decode(format, view.frames(channel) + (first_frame * format.frame_bytes()), last_frame - first_frame, decoded.data(), nullptr);
+            std::memcpy(out + copied, decoded.data() + (offset - (first_frame * ADC_FRAME_SAMPLES)), take * sizeof(int16_t));
+        }
+
+        copied += take;
+    }
+
+    return (copied);
+}
+
+void capture_reader::advise_sequential() const {
+
+    if (map != nullptr) {
+        madvise(const_cast<uint8_t *>(map), map_bytes, MADV_SEQUENTIAL);
+    }
+}
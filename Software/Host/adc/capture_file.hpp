@@ -0,0 +1,199 @@
+// Capstone Host Tools - ADC Capture File
+// Chunked, memory mappable container for long ADC recordings
+
+#ifndef CAPTURE_FILE_HPP
+#define CAPTURE_FILE_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+*  File layout (little endian):
+*      [capture_header, padded to CAPTURE_HEADER_BYTES]
+*      [chunk 0][chunk 1]...                each chunk starts on a CAPTURE_ALIGN boundary
+*      [capture_index_entry x num_chunks]   written on close, header.index_offset points at it
+*
+*  A chunk is a capture_chunk_header followed by one block per channel, CAPTURE_BLOCK_ALIGN aligned. A block holds
+*  the channel's samples (int16, or raw lane frames as described in adc_decode.hpp) and, for int16 samples, an OVR
+*  bitmap with one bit per sample. Everything is at a fixed offset in the mapping, so readers hand out pointers
+*  straight into the page cache.
+*
+*  A recording that was cut short has index_offset 0. Readers then rebuild the index by walking the chunk headers.
+*/
+
+/* Format parameters */
+#define CAPTURE_MAX_CHANNELS 8                              // Channels (ADC buses) per file
+#define CAPTURE_MAX_LANES 9                                 // Lane ball names per channel (8 data lanes + OVR)
+
+static const char CAPTURE_MAGIC[8]              = { 'C', 'A', 'P', 'A', 'D', 'C', '1', '\0' };
+static const uint32_t CAPTURE_VERSION           = 1;
+static const uint32_t CAPTURE_CHUNK_MAGIC       = 0x4B4E4843;       // "CHNK"
+static const size_t CAPTURE_HEADER_BYTES        = 4096;             // Header area, the first chunk starts after it
+static const size_t CAPTURE_ALIGN               = 4096;             // Chunk alignment (page size, so chunks map cleanly)
+static const size_t CAPTURE_BLOCK_ALIGN         = 64;               // Channel block alignment inside a chunk (cache line / AVX)
+
+/* Types */
+
+// How channel blocks store samples
+enum capture_encoding : uint32_t {
+    CAPTURE_SAMPLES_INT16 = 0,                              // Decoded, sign extended samples plus an OVR bitmap
+    CAPTURE_RAW_FRAMES = 1                                  // Raw lane frames (adc_decode.hpp), OVR stays inside the frames
+};
+
+// ADC and board lane mapping of one channel
+struct capture_channel {
+    char bus[16];                                           // Bus name from the pin map ("ADC0")
+    char variant[8];                                        // ddr14, ddr16 or sdr14 (Documentation/FPGA/Kintex_pin_planning.txt)
+    char ball_p[CAPTURE_MAX_LANES][8];                      // FPGA ball of each lane's P side, data lanes first then OVR
+    char ball_n[CAPTURE_MAX_LANES][8];                      // FPGA ball of each lane's N side (empty for single ended OVR)
+    uint8_t data_lanes;                                     // DDR data pairs (7 or 8)
+    uint8_t has_ovr;                                        // Bus has an OVR output
+    uint8_t offset_binary;                                  // ADC coding of raw frames
+    uint8_t sample_bits;                                    // Converter resolution (14 or 16)
+    uint8_t reserved[20];
+};
+
+// File header
+struct capture_header {
+    char magic[8];                                          // CAPTURE_MAGIC
+    uint32_t version;                                       // CAPTURE_VERSION
+    uint32_t header_bytes;                                  // CAPTURE_HEADER_BYTES
+    uint64_t sample_rate_hz;                                // Sample rate of every channel
+    uint64_t start_time_ns;                                 // Wall clock of sample 0 (ns since the Unix epoch)
+    uint64_t index_offset;                                  // File offset of the chunk index, 0 until the writer closes
+    uint64_t num_chunks;                                    // Entries in the chunk index
+    uint32_t num_channels;                                  // Valid entries in channels[]
+    uint32_t encoding;                                      // capture_encoding
+    uint32_t chunk_samples;                                 // Nominal samples per channel per chunk (the last chunk may be shorter)
+    uint32_t reserved;
+    char description[192];                                  // Free text (board, test setup)
+    capture_channel channels[CAPTURE_MAX_CHANNELS];
+};
+
+// Start of every chunk
+struct capture_chunk_header {
+    uint32_t magic;                                         // CAPTURE_CHUNK_MAGIC
+    uint32_t num_samples;                                   // Samples per channel in this chunk
+    uint64_t sequence;                                      // Chunk number
+    uint64_t first_sample;                                  // Sample index of the chunk's first sample
+    uint64_t timestamp_ns;                                  // Capture time of the first sample (ns since the Unix epoch)
+    uint64_t chunk_bytes;                                   // Size of the chunk including this header and its padding
+    uint32_t block_bytes;                                   // Distance between channel blocks
+    uint32_t ovr_count;                                     // Samples with OVR set, over all channels (int16 encoding only)
+    uint8_t reserved[16];
+};
+
+// Chunk index entry
+struct capture_index_entry {
+    uint64_t offset;                                        // File offset of the chunk header
+    uint64_t first_sample;                                  // Same as in the chunk header
+    uint64_t timestamp_ns;                                  // Same as in the chunk header
+    uint32_t num_samples;                                   // Same as in the chunk header
+    uint32_t ovr_count;                                     // Same as in the chunk header
+};
+
+static_assert(sizeof(capture_channel) == 192, "capture_channel is part of the file format");
+static_assert(sizeof(capture_header) <= CAPTURE_HEADER_BYTES, "capture_header must fit the header area");
+static_assert(sizeof(capture_chunk_header) == 64, "capture_chunk_header is part of the file format");
+static_assert(sizeof(capture_index_entry) == 32, "capture_index_entry is part of the file format");
+
+// View of one chunk inside the mapping
+struct capture_chunk {
+    const capture_chunk_header *header = nullptr;           // Chunk header in the mapping
+    const uint8_t *blocks = nullptr;                        // First channel block
+
+    uint32_t num_samples() const { return (header->num_samples); }
+    uint64_t first_sample() const { return (header->first_sample); }
+
+    // Samples of a channel (int16 encoding)
+    const int16_t *samples(const unsigned channel) const {
+        return (reinterpret_cast<const int16_t *>(blocks + (channel * header->block_bytes)));
+    }
+
+    // Raw lane frames of a channel (raw encoding)
+    const uint8_t *frames(const unsigned channel) const { return (blocks + (channel * header->block_bytes)); }
+
+    // OVR bitmap of a channel, bit i of byte i/8 belongs to sample i (int16 encoding)
+    const uint8_t *ovr_bits(const unsigned channel) const {
+        return (blocks + (channel * header->block_bytes) + (header->num_samples * sizeof(int16_t)));
+    }
+};
+
+/* Functions */
+
+// Fill a header with the format constants, everything else zeroed
+capture_header capture_make_header(const uint64_t sample_rate_hz, const capture_encoding encoding, const uint32_t chunk_samples);
+
+// Streams chunks to a new capture file
+class capture_writer {
+public:
+    ~capture_writer();
+
+    /* Create path and write the header. Channels, encoding and chunk size come from header */
+    bool open(const std::string &path, const capture_header &header, std::string &error);
+
+    /* Append one chunk. data[c] points at channel c's samples (int16_t) or raw frames, ovr[c] at one 0/1 byte per
+    sample (int16 encoding only, ovr itself or any entry may be nullptr) */
+    bool write_chunk(const void *const *data, const uint8_t *const *ovr, const uint32_t num_samples, const uint64_t timestamp_ns,
+                     std::string &error);
+
+    /* Write the index, finalize the header and close the file */
+    bool close(std::string &error);
+
+private:
+    size_t block_bytes(const uint32_t num_samples) const;
+
+    std::FILE *file = nullptr;
+    capture_header head {};
+    std::vector<capture_index_entry> index;
+    std::vector<uint8_t> chunk_buffer;                      // Reused chunk image
+    uint64_t next_offset = 0;
+    uint64_t next_sample = 0;
+};
+
+// Read-only memory mapped view of a capture file
+class capture_reader {
+public:
+    ~capture_reader();
+
+    /* Map path and load (or rebuild) the chunk index */
+    bool open(const std::string &path, std::string &error);
+    void close();
+
+    const capture_header &header() const { return (*head); }
+    size_t num_chunks() const { return (index.size()); }
+    uint64_t num_samples() const;
+
+    // View of chunk number n
+    capture_chunk chunk(const size_t n) const;
+
+    // Chunk holding a sample index, num_chunks() if it is past the end
+    size_t find_chunk(const uint64_t sample) const;
+
+    /* Pointer to count int16 samples of a channel straight in the mapping, or nullptr if they are not stored
+    contiguously (raw encoding, or the range crosses a chunk boundary) */
+    const int16_t *samples_at(const unsigned channel, const uint64_t first, const size_t count) const;
+
+    /* Copy count samples of a channel starting at first into out, decoding raw frames as needed.
+    Returns the number of samples copied (fewer at the end of the file) */
+    size_t read_samples(const unsigned channel, const uint64_t first, const size_t count, int16_t *out) const;
+
+    // Hint the kernel that the file will be read front to back
+    void advise_sequential() const;
+
+    // True if the index was rebuilt because the writer never closed the file
+    bool recovered() const { return (index_rebuilt); }
+
+private:
+    const uint8_t *map = nullptr;
+    size_t map_bytes = 0;
+    const capture_header *head = nullptr;
+    std::vector<capture_index_entry> index;
+    bool index_rebuilt = false;
+};
+
+#endif
@@ -0,0 +1,66 @@
+// Capstone Host Tools - ADC Capture File Summary
+// Prints the header, lane mapping and chunk index of a capture file
+
+/*
+*  Usage: capture_info <capture file> [--chunks]
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "capture_file.hpp"
+
+/* Functions */
+
+int main(int argc, char **argv) {
+
+    capture_reader reader;
+    std::string error;
+    const bool list_chunks = (argc > 2) && (std::strcmp(argv[2], "--chunks") == 0);
+    uint64_t ovr_total = 0;
+
+    if (argc < 2) {
+        std::printf("Usage: %s <capture file> [--chunks]\n", argv[0]);
+        return (1);
+    }
+    if (!reader.open(argv[1], error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    const capture_header &header = reader.header();
+    const double seconds = (header.sample_rate_hz > 0) ? ((double) reader.num_samples() / (double) header.sample_rate_hz) : 0.0;
+
+    std::printf("%s: %s, %u channel(s) at %.3f MS/s, %zu chunks, %llu samples per channel (%.3f s)%s\n", argv[1],
+                (header.encoding == CAPTURE_RAW_FRAMES) ? "raw lane frames" : "int16 samples", header.num_channels,
+                header.sample_rate_hz / 1e6, reader.num_chunks(), (unsigned long long) reader.num_samples(), seconds,
+                reader.recovered() ? " - not closed, index rebuilt" : "");
+    if (header.description[0] != '\0') {
+        std::printf("Description: %.*s\n", (int) sizeof(header.description), header.description);
+    }
+
+    for (uint32_t channel = 0; channel < header.num_channels; channel++) {
+        const capture_channel &info = header.channels[channel];
+        std::printf("Channel %u: %.*s %.*s, %u bit, %u lanes%s%s\n  Balls:", channel, (int) sizeof(info.bus), info.bus,
+                    (int) sizeof(info.variant), info.variant, info.sample_bits, info.data_lanes, info.has_ovr ? " + OVR" : "",
+                    info.offset_binary ? ", offset binary" : "");
+        for (unsigned lane = 0; lane < (unsigned)(info.data_lanes + (info.has_ovr ? 1 : 0)) && (lane < CAPTURE_MAX_LANES); lane++) {
+            std::printf(" %.*s/%.*s", 8, info.ball_p[lane], 8, info.ball_n[lane]);
+        }
+        std::printf("\n");
+    }
+
+    for (size_t chunk = 0; chunk < reader.num_chunks(); chunk++) {
+        const capture_chunk view = reader.chunk(chunk);
+        ovr_total += view.header->ovr_count;
+        if (list_chunks) {
+            std::printf("  chunk %zu: samples %llu-%llu, t=%llu ns, %u OVR\n", chunk, (unsigned long long) view.first_sample(),
+                        (unsigned long long)(view.first_sample() + view.num_samples() - 1), (unsigned long long) view.header->timestamp_ns,
+                        view.header->ovr_count);
+        }
+    }
+    std::printf("%llu OVR samples\n", (unsigned long long) ovr_total);
+
+    return (0);
+}
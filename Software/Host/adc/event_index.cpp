@@ -0,0 +1,586 @@
+// Capstone Host Tools - ADC Capture Event Index
+// Sorted, compact index of OVR, clipping and high amplitude regions in a capture file
+
+/*
+*  Every chunk is one task on the work pool and writes its events into its own slot, so no locking is needed and the
+*  slots concatenate in file order. Inside a chunk each channel goes through three passes:
+*
+*  OVR: int16 captures already store a bitmap. Chunks whose header says ovr_count is zero skip it entirely, which
+*  is almost all of them. Raw captures get their OVR flags from the lane decoder.
+*
+*  Regions: a vector min/max over every region_samples block gives the block peak. Blocks above the high threshold
+*  become high amplitude events. Blocks whose min/max reaches the clip limits are the only ones scanned again.
+*
+*  Clip: hot blocks are compared against the clip limits 64 samples at a time, the compare masks packed to bytes and
+*  movemasked into one 64-bit word.
+*
+*  All three end up as bitmaps, and runs are pulled out of those a word at a time with count-trailing-zeros. A last
+*  serial pass joins runs that straddle chunk boundaries and sorts the result.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "work_pool.hpp"
+#include "event_index.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define EVENT_INDEX_X86 1
+#include <immintrin.h>
+#endif
+
+/* Types */
+
+// Limits of one channel (in codes)
+struct channel_limits {
+    int16_t clip_lo;                                        // Samples at or below this are clipped
+    int16_t clip_hi;                                        // Samples at or above this are clipped
+    int16_t high;                                           // Region peak that counts as high amplitude
+};
+
+// Scratch of one worker
+struct event_worker {
+    std::vector<int16_t> samples;                           // Decoded raw frames
+    std::vector<uint8_t> ovr;                               // Decoded OVR flags, one byte per sample
+    std::vector<uint64_t> bits;                             // Flag bitmap of the pass being run
+    std::vector<uint64_t> region_bits;                      // One bit per high amplitude region
+    std::vector<int16_t> region_peak;                       // Peak of every region
+};
+
+/* Functions */
+
+const char *capture_event_kind_name(const capture_event_kind kind) {
+
+    switch (kind) {
+        case capture_event_kind::ovr:
+            return ("ovr");
+        case capture_event_kind::clip:
+            return ("clip");
+        default:
+            return ("high");
+    }
+}
+
+bool parse_capture_event_kind(const std::string &name, capture_event_kind &kind) {
+
+    if (name == "ovr") {
+        kind = capture_event_kind::ovr;
+    }
+    else if (name == "clip") {
+        kind = capture_event_kind::clip;
+    }
+    else if (name == "high") {
+        kind = capture_event_kind::high;
+    }
+    else {
+        return (false);
+    }
+
+    return (true);
+}
+
+// Min/max of n samples, folded into lo/hi
+static void range_scalar(const int16_t *samples, const size_t n, int16_t &lo, int16_t &hi) {
+
+    for (size_t index = 0; index < n; index++) {
+        lo = std::min(lo, samples[index]);
+        hi = std::max(hi, samples[index]);
+    }
+}
+
+// Set bit i of bits for every sample i at or below lo or at or above hi (bits must be zeroed)
+static void flag_scalar(const int16_t *samples, const size_t n, const int16_t lo, const int16_t hi, uint64_t *bits) {
+
+    for (size_t index = 0; index < n; index++) {
+        if ((samples[index] <= lo) || (samples[index] >= hi)) {
+            bits[index / 64] |= (uint64_t) 1 << (index % 64);
+        }
+    }
+}
+
+#ifdef EVENT_INDEX_X86
+
+__attribute__((target("sse4.1")))
+static size_t range_sse41(const int16_t *samples, const size_t n, int16_t &lo, int16_t &hi) {
+
+    __m128i low = _mm_set1_epi16(lo);
+    __m128i high = _mm_set1_epi16(hi);
+    int16_t lanes[8];
+    size_t index = 0;
+
+    for (; (index + 16) <= n; index += 16) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + index));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + index + 8));
+        low = _mm_min_epi16(low, _mm_min_epi16(first, second));
+        high = _mm_max_epi16(high, _mm_max_epi16(first, second));
+    }
+
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), low);
+    lo = *std::min_element(lanes, lanes + 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), high);
+    hi = *std::max_element(lanes, lanes + 8);
+
+    return (index);
+}
+
+__attribute__((target("sse4.1")))
+static size_t flag_sse41(const int16_t *samples, const size_t n, const int16_t lo, const int16_t hi, uint64_t *bits) {
+
+    const __m128i below = _mm_set1_epi16((int16_t)(lo + 1));
+    const __m128i above = _mm_set1_epi16((int16_t)(hi - 1));
+    size_t index = 0;
+
+    for (; (index + 64) <= n; index += 64) {
+        uint64_t word = 0;
+        for (unsigned part = 0; part < 4; part++) {
+            const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + index + (16 * part)));
+            const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i *>(samples + index + (16 * part) + 8));
+            const __m128i first_out = _mm_or_si128(_mm_cmpgt_epi16(first, above), _mm_cmpgt_epi16(below, first));
+            const __m128i second_out = _mm_or_si128(_mm_cmpgt_epi16(second, above), _mm_cmpgt_epi16(below, second));
+            word |= (uint64_t)(uint16_t) _mm_movemask_epi8(_mm_packs_epi16(first_out, second_out)) << (16 * part);
+        }
+        bits[index / 64] = word;
+    }
+
+    return (index);
+}
+
+__attribute__((target("avx2")))
+static size_t range_avx2(const int16_t *samples, const size_t n, int16_t &lo, int16_t &hi) {
+
+    __m256i low = _mm256_set1_epi16(lo);
+    __m256i high = _mm256_set1_epi16(hi);
+    int16_t lanes[16];
+    size_t index = 0;
+
+    for (; (index + 32) <= n; index += 32) {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + index));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + index + 16));
+        low = _mm256_min_epi16(low, _mm256_min_epi16(first, second));
+        high = _mm256_max_epi16(high, _mm256_max_epi16(first, second));
+    }
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), low);
+    lo = *std::min_element(lanes, lanes + 16);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), high);
+    hi = *std::max_element(lanes, lanes + 16);
+
+    return (index);
+}
+
+__attribute__((target("avx2")))
+static size_t flag_avx2(const int16_t *samples, const size_t n, const int16_t lo, const int16_t hi, uint64_t *bits) {
+
+    const __m256i below = _mm256_set1_epi16((int16_t)(lo + 1));
+    const __m256i above = _mm256_set1_epi16((int16_t)(hi - 1));
+    size_t index = 0;
+
+    for (; (index + 64) <= n; index += 64) {
+        uint64_t word = 0;
+        for (unsigned part = 0; part < 2; part++) {
+            const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + index + (32 * part)));
+            const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(samples + index + (32 * part) + 16));
+            const __m256i first_out = _mm256_or_si256(_mm256_cmpgt_epi16(first, above), _mm256_cmpgt_epi16(below, first));
+            const __m256i second_out = _mm256_or_si256(_mm256_cmpgt_epi16(second, above), _mm256_cmpgt_epi16(below, second));
+            // packs works per 128-bit half, the permute puts the bytes back in sample order
+            const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(first_out, second_out), 0xD8);
+            word |= (uint64_t)(uint32_t) _mm256_movemask_epi8(packed) << (32 * part);
+        }
+        bits[index / 64] = word;
+    }
+
+    return (index);
+}
+
+#endif
+
+// Kernel the CPU can actually run
+static adc_isa usable_isa(adc_isa isa) {
+
+#ifdef EVENT_INDEX_X86
+    if ((isa == adc_isa::avx2) && !__builtin_cpu_supports("avx2")) {
+        isa = adc_isa::sse41;
+    }
+    if ((isa == adc_isa::sse41) && !__builtin_cpu_supports("sse4.1")) {
+        isa = adc_isa::scalar;
+    }
+#else
+    isa = adc_isa::scalar;
+#endif
+
+    return (isa);
+}
+
+static void sample_range(const adc_isa isa, const int16_t *samples, const size_t n, int16_t &lo, int16_t &hi) {
+
+    size_t done = 0;
+
+    lo = INT16_MAX;
+    hi = INT16_MIN;
+#ifdef EVENT_INDEX_X86
+    if (isa == adc_isa::avx2) {
+        done = range_avx2(samples, n, lo, hi);
+    }
+    else if (isa == adc_isa::sse41) {
+        done = range_sse41(samples, n, lo, hi);
+    }
+#endif
+    range_scalar(samples + done, n - done, lo, hi);
+}
+
+// bits must hold (n + 63) / 64 zeroed words, n a multiple of 64 except at the end of a chunk
+static void flag_samples(const adc_isa isa, const int16_t *samples, const size_t n, const int16_t lo, const int16_t hi, uint64_t *bits) {
+
+    size_t done = 0;
+
+#ifdef EVENT_INDEX_X86
+    if (isa == adc_isa::avx2) {
+        done = flag_avx2(samples, n, lo, hi, bits);
+    }
+    else if (isa == adc_isa::sse41) {
+        done = flag_sse41(samples, n, lo, hi, bits);
+    }
+#endif
+    flag_scalar(samples + done, n - done, lo, hi, bits + (done / 64));
+}
+
+// Calls emit(start, end) for every run of set bits below n, joining runs less than gap apart
+template <typename emit_fn>
+static void for_each_run(const uint64_t *bits, const size_t n, const uint64_t gap, emit_fn emit) {
+
+    const size_t words = (n + 63) / 64;
+    size_t run_start = 0;
+    size_t run_end = 0;
+    bool open = false;
+
+    for (size_t word_index = 0; word_index < words; word_index++) {
+
+        uint64_t word = bits[word_index];
+        if ((word_index == words - 1) && ((n % 64) != 0)) {
+            word &= ((uint64_t) 1 << (n % 64)) - 1;
+        }
+
+        while (word != 0) {
+
+            const unsigned first = (unsigned) __builtin_ctzll(word);
+            const uint64_t clear = ~word & (~(uint64_t) 0 << first);
+            const unsigned last = (clear == 0) ? 64 : (unsigned) __builtin_ctzll(clear);
+            const size_t start = (word_index * 64) + first;
+            const size_t end = (word_index * 64) + last;
+
+            if (open && (start <= run_end + gap)) {
+                run_end = end;
+            }
+            else {
+                if (open) {
+                    emit(run_start, run_end);
+                }
+                run_start = start;
+                run_end = end;
+                open = true;
+            }
+
+            word = (last == 64) ? 0 : (word & (~(uint64_t) 0 << last));
+        }
+    }
+
+    if (open) {
+        emit(run_start, run_end);
+    }
+}
+
+static uint32_t count_bits(const uint64_t *bits, const size_t start, const size_t end) {
+
+    uint32_t count = 0;
+
+    for (size_t index = start; index < end; index++) {
+        count += (uint32_t)((bits[index / 64] >> (index % 64)) & 1);
+    }
+
+    return (count);
+}
+
+static int16_t peak_of(const int16_t *samples, const size_t start, const size_t end) {
+
+    int magnitude = 0;
+
+    for (size_t index = start; index < end; index++) {
+        magnitude = std::max(magnitude, std::abs((int) samples[index]));
+    }
+
+    return ((int16_t) std::min(magnitude, (int) INT16_MAX));
+}
+
+static bool channel_limits_for(const capture_channel &info, const event_index_options &options, channel_limits &limits, std::string &error) {
+
+    const unsigned bits = ((info.sample_bits > 0) && (info.sample_bits <= 16)) ? info.sample_bits : 16;
+    const int full_scale = 1 << (bits - 1);
+
+    if ((int) options.clip_margin >= full_scale) {
+        error = "clip margin is larger than the code range";
+        return (false);
+    }
+
+    limits.clip_lo = (int16_t)(-full_scale + (int) options.clip_margin);
+    limits.clip_hi = (int16_t)((full_scale - 1) - (int) options.clip_margin);
+    limits.high = (int16_t) std::max(1L, std::min((long) INT16_MAX, std::lround(full_scale * std::pow(10.0, options.high_dbfs / 20.0))));
+
+    return (true);
+}
+
+// Everything one channel of one chunk contributes
+static void scan_channel(const capture_reader &reader, const capture_chunk &view, const unsigned channel, const channel_limits &limits,
+                         const event_index_options &options, const adc_isa isa, event_worker &worker, std::vector<capture_event> &events) {
+
+    const capture_header &header = reader.header();
+    const capture_channel &info = header.channels[channel];
+    const size_t n = view.num_samples();
+    const size_t words = (n + 63) / 64;
+    const size_t region = options.region_samples;
+    const size_t regions = (n + region - 1) / region;
+    const int16_t *samples = nullptr;
+    bool any_ovr = false;
+
+    auto add = [&](const capture_event_kind kind, const size_t start, const size_t end, const uint32_t count, const int16_t peak) {
+        capture_event event;
+        event.first_sample = view.first_sample() + start;
+        event.num_samples = end - start;
+        event.count = count;
+        event.peak = peak;
+        event.channel = (uint8_t) channel;
+        event.kind = (uint8_t) kind;
+        events.push_back(event);
+    };
+
+    worker.bits.assign(words, 0);
+
+    if (header.encoding == CAPTURE_SAMPLES_INT16) {
+        samples = view.samples(channel);
+        if (view.header->ovr_count > 0) {
+            std::memcpy(worker.bits.data(), view.ovr_bits(channel), (n + 7) / 8);
+            any_ovr = true;
+        }
+    }
+    else {
+        adc_lane_format format;
+        format.data_lanes = info.data_lanes;
+        format.has_ovr = (info.has_ovr != 0);
+        format.offset_binary = (info.offset_binary != 0);
+        worker.samples.assign(n, 0);
+        worker.ovr.assign(n, 0);
+        adc_decode(format, view.frames(channel), n / ADC_FRAME_SAMPLES, worker.samples.data(), worker.ovr.data(), isa);
+        samples = worker.samples.data();
+        for (size_t index = 0; format.has_ovr && (index < n); index++) {
+            if (worker.ovr[index] != 0) {
+                worker.bits[index / 64] |= (uint64_t) 1 << (index % 64);
+                any_ovr = true;
+            }
+        }
+    }
+
+    if (any_ovr) {
+        for_each_run(worker.bits.data(), n, options.merge_gap, [&](const size_t start, const size_t end) {
+            add(capture_event_kind::ovr, start, end, count_bits(worker.bits.data(), start, end), peak_of(samples, start, end));
+        });
+    }
+
+    // Region peaks, and the clip scan of the blocks that touch the limits
+    bool any_clip = false;
+    worker.bits.assign(words, 0);
+    worker.region_bits.assign((regions + 63) / 64, 0);
+    worker.region_peak.resize(regions);
+    for (size_t block = 0; block < regions; block++) {
+
+        const size_t start = block * region;
+        const size_t length = std::min(region, n - start);
+        int16_t lo = 0;
+        int16_t hi = 0;
+
+        sample_range(isa, samples + start, length, lo, hi);
+        worker.region_peak[block] = (int16_t) std::min(std::max((int) hi, -(int) lo), (int) INT16_MAX);
+        if (worker.region_peak[block] >= limits.high) {
+            worker.region_bits[block / 64] |= (uint64_t) 1 << (block % 64);
+        }
+        if ((lo <= limits.clip_lo) || (hi >= limits.clip_hi)) {
+            flag_samples(isa, samples + start, length, limits.clip_lo, limits.clip_hi, worker.bits.data() + (start / 64));
+            any_clip = true;
+        }
+    }
+
+    if (any_clip) {
+        for_each_run(worker.bits.data(), n, options.merge_gap, [&](const size_t start, const size_t end) {
+            add(capture_event_kind::clip, start, end, count_bits(worker.bits.data(), start, end), peak_of(samples, start, end));
+        });
+    }
+
+    for_each_run(worker.region_bits.data(), regions, options.merge_gap / region, [&](const size_t first, const size_t last) {
+        const int16_t peak = *std::max_element(worker.region_peak.begin() + first, worker.region_peak.begin() + last);
+        add(capture_event_kind::high, first * region, std::min(last * region, n), count_bits(worker.region_bits.data(), first, last), peak);
+    });
+}
+
+bool build_event_index(const capture_reader &reader, const event_index_options &options, event_index &index, std::string &error) {
+
+    const capture_header &header = reader.header();
+    const adc_isa isa = usable_isa(options.isa);
+    std::vector<channel_limits> limits(header.num_channels);
+    std::vector<std::vector<capture_event>> chunk_events(reader.num_chunks());
+
+    if ((options.region_samples < 64) || ((options.region_samples % 64) != 0)) {
+        error = "region size must be a multiple of 64 samples";
+        return (false);
+    }
+    if (options.high_dbfs > 0.0) {
+        error = "high amplitude threshold must be at or below 0 dBFS";
+        return (false);
+    }
+    for (uint32_t channel = 0; channel < header.num_channels; channel++) {
+        if (!channel_limits_for(header.channels[channel], options, limits[channel], error)) {
+            return (false);
+        }
+    }
+
+    {
+        work_pool pool(options.threads);
+        std::vector<event_worker> workers(pool.size());
+
+        reader.advise_sequential();
+        for (size_t chunk = 0; chunk < reader.num_chunks(); chunk++) {
+            pool.submit([&, chunk](unsigned worker) {
+                const capture_chunk view = reader.chunk(chunk);
+                for (uint32_t channel = 0; channel < header.num_channels; channel++) {
+                    scan_channel(reader, view, channel, limits[channel], options, isa, workers[worker], chunk_events[chunk]);
+                }
+            });
+        }
+        pool.wait();
+    }
+
+    // Join runs of one channel and kind across chunk boundaries
+    std::vector<capture_event> events;
+    for (const auto &chunk : chunk_events) {
+        events.insert(events.end(), chunk.begin(), chunk.end());
+    }
+    std::stable_sort(events.begin(), events.end(), [](const capture_event &a, const capture_event &b) {
+        return ((a.channel != b.channel) ? (a.channel < b.channel) : (a.kind != b.kind) ? (a.kind < b.kind) : (a.first_sample < b.first_sample));
+    });
+
+    index.events.clear();
+    for (const capture_event &event : events) {
+        if (!index.events.empty()) {
+            capture_event &last = index.events.back();
+            const uint64_t last_end = last.first_sample + last.num_samples;
+            if ((last.channel == event.channel) && (last.kind == event.kind) && (event.first_sample <= last_end + options.merge_gap)) {
+                last.num_samples = std::max(last_end, event.first_sample + event.num_samples) - last.first_sample;
+                last.count += event.count;
+                last.peak = std::max(last.peak, event.peak);
+                continue;
+            }
+        }
+        index.events.push_back(event);
+    }
+
+    std::sort(index.events.begin(), index.events.end(), [](const capture_event &a, const capture_event &b) {
+        return ((a.first_sample != b.first_sample) ? (a.first_sample < b.first_sample) : (a.channel != b.channel) ? (a.channel < b.channel) : (a.kind < b.kind));
+    });
+
+    std::memset(&index.header, 0, sizeof(index.header));
+    std::memcpy(index.header.magic, EVENT_INDEX_MAGIC, sizeof(EVENT_INDEX_MAGIC));
+    index.header.version = EVENT_INDEX_VERSION;
+    index.header.header_bytes = sizeof(event_index_header);
+    index.header.capture_samples = reader.num_samples();
+    index.header.capture_start_ns = header.start_time_ns;
+    index.header.capture_chunks = reader.num_chunks();
+    index.header.num_events = index.events.size();
+    index.header.merge_gap = options.merge_gap;
+    index.header.region_samples = options.region_samples;
+    index.header.clip_margin = options.clip_margin;
+    index.header.high_centi_dbfs = (int32_t) std::lround(options.high_dbfs * 100.0);
+    for (const capture_event &event : index.events) {
+        index.header.longest_event = std::max(index.header.longest_event, event.num_samples);
+    }
+
+    return (true);
+}
+
+bool event_index_current(const event_index &index, const capture_reader &reader, const event_index_options &options) {
+
+    const event_index_header &header = index.header;
+
+    return ((header.capture_samples == reader.num_samples()) && (header.capture_start_ns == reader.header().start_time_ns) &&
+            (header.capture_chunks == reader.num_chunks()) && (header.merge_gap == options.merge_gap) &&
+            (header.region_samples == options.region_samples) && (header.clip_margin == options.clip_margin) &&
+            (header.high_centi_dbfs == (int32_t) std::lround(options.high_dbfs * 100.0)));
+}
+
+bool save_event_index(const std::string &path, const event_index &index, std::string &error) {
+
+    const std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "wb");
+    bool written = false;
+
+    if (file == nullptr) {
+        error = "cannot write " + temporary;
+        return (false);
+    }
+
+    written = (std::fwrite(&index.header, sizeof(index.header), 1, file) == 1) &&
+              (index.events.empty() || (std::fwrite(index.events.data(), sizeof(capture_event), index.events.size(), file) == index.events.size()));
+
+    if ((std::fclose(file) != 0) || !written || (std::rename(temporary.c_str(), path.c_str()) != 0)) {
+        std::remove(temporary.c_str());
+        error = "cannot write " + path;
+        return (false);
+    }
+
+    return (true);
+}
+
+bool load_event_index(const std::string &path, event_index &index, std::string &error) {
+
+    std::FILE *file = std::fopen(path.c_str(), "rb");
+
+    if (file == nullptr) {
+        error = "cannot open " + path;
+        return (false);
+    }
+
+    if ((std::fread(&index.header, sizeof(index.header), 1, file) != 1) ||
+        (std::memcmp(index.header.magic, EVENT_INDEX_MAGIC, sizeof(EVENT_INDEX_MAGIC)) != 0) ||
+        (index.header.version != EVENT_INDEX_VERSION) || (index.header.header_bytes < sizeof(event_index_header))) {
+        std::fclose(file);
+        error = path + " is not an event index";
+        return (false);
+    }
+
+    index.events.resize(index.header.num_events);
+    if ((std::fseek(file, (long) index.header.header_bytes, SEEK_SET) != 0) ||
+        (std::fread(index.events.data(), sizeof(capture_event), index.events.size(), file) != index.events.size())) {
+        std::fclose(file);
+        error = path + " is truncated";
+        return (false);
+    }
+
+    std::fclose(file);
+    return (true);
+}
+
+std::vector<capture_event> find_events(const event_index &index, const uint64_t first, const uint64_t last) {
+
+    const uint64_t from = (first > index.header.longest_event) ? (first - index.header.longest_event) : 0;
+    std::vector<capture_event> found;
+
+    auto event = std::lower_bound(index.events.begin(), index.events.end(), from, [](const capture_event &a, const uint64_t sample) {
+        return (a.first_sample < sample);
+    });
+    for (; (event != index.events.end()) && (event->first_sample < last); ++event) {
+        if ((event->first_sample + event->num_samples) > first) {
+            found.push_back(*event);
+        }
+    }
+
+    return (found);
+}
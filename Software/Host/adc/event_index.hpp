@@ -0,0 +1,97 @@
+// Capstone Host Tools - ADC Capture Event Index
+// Sorted, compact index of OVR, clipping and high amplitude regions in a capture file
+
+#ifndef EVENT_INDEX_HPP
+#define EVENT_INDEX_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "adc_decode.hpp"
+#include "capture_file.hpp"
+
+/*
+*  Index file layout (little endian): an event_index_header followed by num_events capture_event records sorted by
+*  first sample, then channel, then kind. Events of one channel and kind never overlap, so a range query only has to
+*  look back longest_event samples from its start to find everything that overlaps it.
+*/
+
+/* Format parameters */
+static const char EVENT_INDEX_MAGIC[8]          = { 'C', 'A', 'P', 'E', 'V', 'T', '1', '\0' };
+static const uint32_t EVENT_INDEX_VERSION       = 1;
+
+/* Types */
+
+enum class capture_event_kind : uint8_t {
+    ovr = 0,                                                // ADC out-of-range output was set
+    clip = 1,                                               // Sample at (or within clip_margin codes of) either end of the code range
+    high = 2                                                // Region whose peak is above the high amplitude threshold
+};
+
+// One run of flagged samples
+struct capture_event {
+    uint64_t first_sample;                                  // First flagged sample
+    uint64_t num_samples;                                   // Span from the first to the last flagged sample (gaps up to merge_gap included)
+    uint32_t count;                                         // Flagged samples in the span (flagged regions for high)
+    int16_t peak;                                           // Largest magnitude in the span (in codes)
+    uint8_t channel;
+    uint8_t kind;                                           // capture_event_kind
+};
+
+// How events are found
+struct event_index_options {
+    double high_dbfs = -6.0;                                // Region peak that counts as high amplitude (dBFS)
+    unsigned clip_margin = 0;                               // Codes below full scale that still count as clipped
+    uint32_t region_samples = 4096;                         // Granularity of high amplitude regions (multiple of 64)
+    uint64_t merge_gap = 64;                                // Runs of one channel and kind closer than this become one event
+    unsigned threads = 0;                                   // Worker threads (0: one per core)
+    adc_isa isa = adc_best_isa();                           // Scan kernel
+};
+
+// Index file header
+struct event_index_header {
+    char magic[8];                                          // EVENT_INDEX_MAGIC
+    uint32_t version;                                       // EVENT_INDEX_VERSION
+    uint32_t header_bytes;                                  // Offset of the first event
+    uint64_t capture_samples;                               // Samples per channel of the indexed capture
+    uint64_t capture_start_ns;                              // start_time_ns of the indexed capture
+    uint64_t capture_chunks;                                // Chunks in the indexed capture
+    uint64_t num_events;
+    uint64_t longest_event;                                 // Largest num_samples of any event
+    uint64_t merge_gap;                                     // Options the index was built with
+    uint32_t region_samples;
+    uint32_t clip_margin;
+    int32_t high_centi_dbfs;                                // high_dbfs * 100
+    uint8_t reserved[52];
+};
+
+static_assert(sizeof(capture_event) == 24, "capture_event is part of the index format");
+static_assert(sizeof(event_index_header) == 128, "event_index_header is part of the index format");
+
+// Index in memory
+struct event_index {
+    event_index_header header {};
+    std::vector<capture_event> events;
+};
+
+/* Functions */
+
+// "ovr", "clip" or "high"
+const char *capture_event_kind_name(const capture_event_kind kind);
+bool parse_capture_event_kind(const std::string &name, capture_event_kind &kind);
+
+/* Scan every channel of a capture and build its event index */
+bool build_event_index(const capture_reader &reader, const event_index_options &options, event_index &index, std::string &error);
+
+/* True if index was built from this capture with these options */
+bool event_index_current(const event_index &index, const capture_reader &reader, const event_index_options &options);
+
+bool save_event_index(const std::string &path, const event_index &index, std::string &error);
+bool load_event_index(const std::string &path, event_index &index, std::string &error);
+
+/* Events overlapping samples first to last - 1, in index order */
+std::vector<capture_event> find_events(const event_index &index, const uint64_t first, const uint64_t last);
+
+#endif
@@ -0,0 +1,189 @@
+// Capstone Host Tools - FFT
+// Planned radix-2 FFT for real input
+
+/*
+*  A real transform of n points runs as a complex transform of n/2 points, with the even samples in the real part
+*  and the odd samples in the imaginary part, followed by a split step that separates the two:
+*      X[k] = (Z[k] + conj(Z[n/2-k])) / 2 - i exp(-2 pi i k / n) (Z[k] - conj(Z[n/2-k])) / 2
+*  The complex transform is an iterative decimation in time on separate real/imaginary arrays. The first two stages
+*  are fused (their twiddles are 1 and -i) and the rest go two stages per pass, so the data is swept about half as
+*  often as with plain radix-2. Every stage reads its twiddles from its own contiguous table, so the butterfly loops
+*  are unit stride float arithmetic the compiler vectorizes. Tables are computed in double precision.
+*/
+
+/* Libraries */
+#include <cmath>
+#include "fft.hpp"
+
+/* Functions */
+
+bool fft_plan::valid_size(const size_t n) {
+    return ((n >= 8) && ((n & (n - 1)) == 0) && (n <= (size_t) 1 << 30));
+}
+
+fft_plan::fft_plan(const size_t size) : n(size), half(size / 2) {
+
+    const double pi = std::acos(-1.0);
+    unsigned bits = 0;
+
+    while (((size_t) 1 << bits) < half) {
+        bits++;
+    }
+
+    bit_reverse.resize(half);
+    for (size_t index = 0; index < half; index++) {
+        uint32_t reversed = 0;
+        for (unsigned bit = 0; bit < bits; bit++) {
+            reversed |= (uint32_t)(((index >> bit) & 0x1) << (bits - 1 - bit));
+        }
+        bit_reverse[index] = reversed;
+    }
+
+    // Stage of length L uses exp(-2 pi i j / L) for j < L/2, stored from offset L/2 - 1 (total half - 1 entries)
+    twiddle_re.resize(half);
+    twiddle_im.resize(half);
+    for (size_t length = 2; length <= half; length <<= 1) {
+        for (size_t j = 0; j < length / 2; j++) {
+            twiddle_re[(length / 2) - 1 + j] = (float) std::cos(-2.0 * pi * j / length);
+            twiddle_im[(length / 2) - 1 + j] = (float) std::sin(-2.0 * pi * j / length);
+        }
+    }
+
+    split.resize(half + 1);
+    for (size_t k = 0; k <= half; k++) {
+        split[k] = std::complex<float>((float) std::cos(-2.0 * pi * k / n), (float) std::sin(-2.0 * pi * k / n));
+    }
+}
+
+void fft_plan::forward_complex(float *re, float *im) const {
+
+    // Length 2 and 4 butterflies only multiply by 1 and -i, and are too short to vectorize as a general stage
+    for (size_t start = 0; start < half; start += 4) {
+
+        const float a_re = re[start] + re[start + 1];
+        const float a_im = im[start] + im[start + 1];
+        const float b_re = re[start] - re[start + 1];
+        const float b_im = im[start] - im[start + 1];
+        const float c_re = re[start + 2] + re[start + 3];
+        const float c_im = im[start + 2] + im[start + 3];
+        const float d_re = re[start + 2] - re[start + 3];
+        const float d_im = im[start + 2] - im[start + 3];
+
+        re[start] = a_re + c_re;
+        im[start] = a_im + c_im;
+        re[start + 2] = a_re - c_re;
+        im[start + 2] = a_im - c_im;
+        // d * -i = (d_im, -d_re)
+        re[start + 1] = b_re + d_im;
+        im[start + 1] = b_im - d_re;
+        re[start + 3] = b_re - d_im;
+        im[start + 3] = b_im + d_re;
+    }
+
+    // Two radix-2 stages (L and 2L) per pass over the data while at least two are left
+    size_t length = 8;
+    for (; (2 * length) <= half; length <<= 2) {
+
+        const size_t middle = length / 2;
+        const float *w1_re = twiddle_re.data() + (middle - 1);   // Stage L, index j
+        const float *w1_im = twiddle_im.data() + (middle - 1);
+        const float *w2_re = twiddle_re.data() + (length - 1);   // Stage 2L, index j and j + L/2
+        const float *w2_im = twiddle_im.data() + (length - 1);
+
+        for (size_t start = 0; start < half; start += 2 * length) {
+
+            float *p0_re = re + start;
+            float *p0_im = im + start;
+            float *p1_re = p0_re + middle;
+            float *p1_im = p0_im + middle;
+            float *p2_re = p0_re + length;
+            float *p2_im = p0_im + length;
+            float *p3_re = p2_re + middle;
+            float *p3_im = p2_im + middle;
+
+            for (size_t j = 0; j < middle; j++) {
+
+                // Stage L: (0,1) and (2,3) with w1[j]
+                const float t1_re = (p1_re[j] * w1_re[j]) - (p1_im[j] * w1_im[j]);
+                const float t1_im = (p1_re[j] * w1_im[j]) + (p1_im[j] * w1_re[j]);
+                const float t3_re = (p3_re[j] * w1_re[j]) - (p3_im[j] * w1_im[j]);
+                const float t3_im = (p3_re[j] * w1_im[j]) + (p3_im[j] * w1_re[j]);
+                const float a0_re = p0_re[j] + t1_re;
+                const float a0_im = p0_im[j] + t1_im;
+                const float a1_re = p0_re[j] - t1_re;
+                const float a1_im = p0_im[j] - t1_im;
+                const float a2_re = p2_re[j] + t3_re;
+                const float a2_im = p2_im[j] + t3_im;
+                const float a3_re = p2_re[j] - t3_re;
+                const float a3_im = p2_im[j] - t3_im;
+
+                // Stage 2L: (0,2) with w2[j], (1,3) with w2[j + L/2]
+                const float u2_re = (a2_re * w2_re[j]) - (a2_im * w2_im[j]);
+                const float u2_im = (a2_re * w2_im[j]) + (a2_im * w2_re[j]);
+                const float u3_re = (a3_re * w2_re[j + middle]) - (a3_im * w2_im[j + middle]);
+                const float u3_im = (a3_re * w2_im[j + middle]) + (a3_im * w2_re[j + middle]);
+                p0_re[j] = a0_re + u2_re;
+                p0_im[j] = a0_im + u2_im;
+                p2_re[j] = a0_re - u2_re;
+                p2_im[j] = a0_im - u2_im;
+                p1_re[j] = a1_re + u3_re;
+                p1_im[j] = a1_im + u3_im;
+                p3_re[j] = a1_re - u3_re;
+                p3_im[j] = a1_im - u3_im;
+            }
+        }
+    }
+
+    // Odd stage out
+    for (; length <= half; length <<= 1) {
+
+        const size_t middle = length / 2;
+        const float *w_re = twiddle_re.data() + (middle - 1);
+        const float *w_im = twiddle_im.data() + (middle - 1);
+
+        for (size_t start = 0; start < half; start += length) {
+
+            float *a_re = re + start;
+            float *a_im = im + start;
+            float *b_re = re + start + middle;
+            float *b_im = im + start + middle;
+
+            for (size_t j = 0; j < middle; j++) {
+                const float lower_re = (b_re[j] * w_re[j]) - (b_im[j] * w_im[j]);
+                const float lower_im = (b_re[j] * w_im[j]) + (b_im[j] * w_re[j]);
+                b_re[j] = a_re[j] - lower_re;
+                b_im[j] = a_im[j] - lower_im;
+                a_re[j] = a_re[j] + lower_re;
+                a_im[j] = a_im[j] + lower_im;
+            }
+        }
+    }
+}
+
+void fft_plan::forward_real(const float *in, std::complex<float> *out, std::vector<float> &scratch) const {
+
+    scratch.resize(2 * half);
+    float *re = scratch.data();
+    float *im = scratch.data() + half;
+
+    // Pack even/odd samples as one complex sequence, already in bit reversed order
+    for (size_t index = 0; index < half; index++) {
+        re[bit_reverse[index]] = in[2 * index];
+        im[bit_reverse[index]] = in[(2 * index) + 1];
+    }
+
+    forward_complex(re, im);
+
+    // Split into the spectrum of the real sequence. Z[half] wraps to Z[0]
+    out[0] = std::complex<float>(re[0] + im[0], 0.0f);
+    out[half] = std::complex<float>(re[0] - im[0], 0.0f);
+    for (size_t k = 1; k < half; k++) {
+        const float even_re = 0.5f * (re[k] + re[half - k]);
+        const float even_im = 0.5f * (im[k] - im[half - k]);
+        const float odd_re = 0.5f * (im[k] + im[half - k]);
+        const float odd_im = -0.5f * (re[k] - re[half - k]);
+        const float w_re = split[k].real();
+        const float w_im = split[k].imag();
+        out[k] = std::complex<float>(even_re + (w_re * odd_re) - (w_im * odd_im), even_im + (w_re * odd_im) + (w_im * odd_re));
+    }
+}
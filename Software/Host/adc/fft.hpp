@@ -0,0 +1,41 @@
+// Capstone Host Tools - FFT
+// Planned radix-2 FFT for real input
+
+#ifndef FFT_HPP
+#define FFT_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+#include <complex>
+#include <vector>
+
+/* Types */
+
+// Precomputed tables for one transform size. Shared read-only between threads, each thread brings its own scratch
+class fft_plan {
+public:
+    // True for powers of two from 8 up
+    static bool valid_size(const size_t n);
+
+    // n must pass valid_size()
+    explicit fft_plan(const size_t n);
+
+    size_t size() const { return (n); }
+    size_t bins() const { return ((n / 2) + 1); }
+
+    /* Transform n real samples into n/2 + 1 bins (DC to Nyquist). scratch is resized as needed */
+    void forward_real(const float *in, std::complex<float> *out, std::vector<float> &scratch) const;
+
+private:
+    void forward_complex(float *re, float *im) const;
+
+    size_t n = 0;                                           // Real transform size
+    size_t half = 0;                                        // Complex transform size (n / 2)
+    std::vector<uint32_t> bit_reverse;                      // Permutation of the half size transform
+    std::vector<float> twiddle_re;                          // Per stage twiddles, stage of length L at offset L/2 - 1 (real parts)
+    std::vector<float> twiddle_im;                          // Imaginary parts of the same
+    std::vector<std::complex<float>> split;                 // exp(-2 pi i k / n), k <= half, for the real input split
+};
+
+#endif
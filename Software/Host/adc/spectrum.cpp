@@ -0,0 +1,323 @@
+// Capstone Host Tools - ADC Spectrum Pipeline
+// Windowed, overlapping, averaged FFTs of a capture channel on a work stealing pool, with SNR/SFDR/ENOB
+
+/*
+*  The analysed range is cut into FFT frames hop = fft_size * (1 - overlap) apart, and runs of frames_per_task frames
+*  become one task. Tasks are queued in file order so the page cache streams the capture front to back. Each worker
+*  keeps its own accumulator and only locks it to add a finished task, so the calling thread can take a snapshot of
+*  the running average at any time without stopping the pool.
+*
+*  Frames inside one chunk of an int16 capture are read straight from the mapping. Anything else (raw frames, chunk
+*  boundaries) is copied out through capture_reader::read_samples().
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include "fft.hpp"
+#include "work_pool.hpp"
+#include "spectrum.hpp"
+
+/* Types */
+
+// Everything one worker owns
+struct spectrum_worker {
+    std::mutex lock;                                        // Guards sum/frames against snapshots
+    std::vector<double> sum;                                // Sum of normalized power per bin
+    uint64_t frames = 0;
+    std::vector<double> task_sum;                           // Sum of the task being run
+    std::vector<int16_t> samples;                           // Copy of a frame that is not contiguous in the mapping
+    std::vector<float> windowed;
+    std::vector<std::complex<float>> bins;
+    std::vector<float> scratch;
+};
+
+/* Functions */
+
+bool parse_spectrum_window(const std::string &name, spectrum_window &window) {
+
+    if (name == "hann") {
+        window = spectrum_window::hann;
+    }
+    else if ((name == "bh4") || (name == "blackman-harris")) {
+        window = spectrum_window::blackman_harris;
+    }
+    else {
+        return (false);
+    }
+
+    return (true);
+}
+
+static std::vector<float> make_window(const spectrum_window window, const size_t n) {
+
+    const double pi = std::acos(-1.0);
+    std::vector<float> coefficients(n);
+
+    for (size_t index = 0; index < n; index++) {
+        const double phase = 2.0 * pi * index / n;
+        if (window == spectrum_window::hann) {
+            coefficients[index] = (float)(0.5 - (0.5 * std::cos(phase)));
+        }
+        else {
+            coefficients[index] = (float)(0.35875 - (0.48829 * std::cos(phase)) + (0.14128 * std::cos(2.0 * phase)) - (0.01168 * std::cos(3.0 * phase)));
+        }
+    }
+
+    return (coefficients);
+}
+
+// Half width of the window's main lobe (in bins), used to group signal power
+static size_t lobe_bins(const spectrum_window window) {
+    return ((window == spectrum_window::hann) ? 2 : 4);
+}
+
+// Running average over all workers
+static void collect(std::vector<std::unique_ptr<spectrum_worker>> &workers, spectrum_result &result) {
+
+    uint64_t frames = 0;
+
+    std::fill(result.power.begin(), result.power.end(), 0.0);
+    for (auto &worker : workers) {
+        std::lock_guard<std::mutex> guard(worker->lock);
+        if (worker->sum.empty()) {
+            continue;
+        }
+        for (size_t bin = 0; bin < result.power.size(); bin++) {
+            result.power[bin] += worker->sum[bin];
+        }
+        frames += worker->frames;
+    }
+
+    for (double &power : result.power) {
+        power = (frames > 0) ? (power / frames) : 0.0;
+    }
+    result.frames = frames;
+}
+
+bool compute_spectrum(const capture_reader &reader, const unsigned channel, const spectrum_options &options, spectrum_result &result,
+                      std::string &error, spectrum_snapshot_fn snapshot, const std::chrono::milliseconds snapshot_period) {
+
+    const capture_header &header = reader.header();
+    const size_t n = options.fft_size;
+
+    if (!fft_plan::valid_size(n)) {
+        error = "FFT size must be a power of two from 8 up";
+        return (false);
+    }
+    if ((options.overlap < 0.0) || (options.overlap > 0.9)) {
+        error = "overlap must be between 0 and 0.9";
+        return (false);
+    }
+    if (channel >= header.num_channels) {
+        error = "no channel " + std::to_string(channel) + " in the capture";
+        return (false);
+    }
+
+    const uint64_t available = (options.first_sample < reader.num_samples()) ? (reader.num_samples() - options.first_sample) : 0;
+    const uint64_t length = (options.num_samples == 0) ? available : std::min(options.num_samples, available);
+    const size_t hop = std::max<size_t>(1, (size_t)((double) n * (1.0 - options.overlap)));
+    if (length < n) {
+        error = "range is shorter than one FFT";
+        return (false);
+    }
+    const uint64_t num_frames = ((length - n) / hop) + 1;
+
+    // A full scale sine on a bin centre has |X| = A * sum(w) / 2
+    const fft_plan plan(n);
+    const std::vector<float> window = make_window(options.window, n);
+    const unsigned bits = (header.channels[channel].sample_bits > 0) ? header.channels[channel].sample_bits : 16;
+    double window_sum = 0.0;
+    double window_square_sum = 0.0;
+    for (const float coefficient : window) {
+        window_sum += coefficient;
+        window_square_sum += (double) coefficient * coefficient;
+    }
+    const double full_scale = std::ldexp(1.0, (int) bits - 1) * window_sum / 2.0;
+    const double normalize = 1.0 / (full_scale * full_scale);
+
+    result.power.assign(plan.bins(), 0.0);
+    result.frames = 0;
+    result.sample_rate_hz = (double) header.sample_rate_hz;
+    result.fft_size = n;
+    result.window = options.window;
+    result.enbw_bins = (n * window_square_sum) / (window_sum * window_sum);
+
+    work_pool pool(options.threads);
+    std::vector<std::unique_ptr<spectrum_worker>> workers;
+    for (unsigned worker = 0; worker < pool.size(); worker++) {
+        workers.emplace_back(new spectrum_worker());
+    }
+
+    auto run_frames = [&](const uint64_t first_frame, const uint64_t count, const unsigned worker_index) {
+
+        spectrum_worker &worker = *workers[worker_index];
+
+        worker.task_sum.assign(plan.bins(), 0.0);
+        worker.windowed.resize(n);
+        worker.bins.resize(plan.bins());
+
+        for (uint64_t frame = first_frame; frame < first_frame + count; frame++) {
+
+            const uint64_t start = options.first_sample + (frame * hop);
+            const int16_t *samples = reader.samples_at(channel, start, n);
+
+            if (samples == nullptr) {
+                worker.samples.resize(n);
+                if (reader.read_samples(channel, start, n, worker.samples.data()) != n) {
+                    continue;
+                }
+                samples = worker.samples.data();
+            }
+
+            for (size_t index = 0; index < n; index++) {
+                worker.windowed[index] = (float) samples[index] * window[index];
+            }
+            plan.forward_real(worker.windowed.data(), worker.bins.data(), worker.scratch);
+            for (size_t bin = 0; bin < plan.bins(); bin++) {
+                const double re = worker.bins[bin].real();
+                const double im = worker.bins[bin].imag();
+                worker.task_sum[bin] += ((re * re) + (im * im)) * normalize;
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.sum.empty()) {
+            worker.sum.assign(plan.bins(), 0.0);
+        }
+        for (size_t bin = 0; bin < plan.bins(); bin++) {
+            worker.sum[bin] += worker.task_sum[bin];
+        }
+        worker.frames += count;
+    };
+
+    reader.advise_sequential();
+    const size_t per_task = std::max<size_t>(1, options.frames_per_task);
+    for (uint64_t frame = 0; frame < num_frames; frame += per_task) {
+        const uint64_t count = std::min<uint64_t>(per_task, num_frames - frame);
+        pool.submit([&run_frames, frame, count](unsigned worker) { run_frames(frame, count, worker); });
+    }
+
+    while (!pool.wait_for(snapshot_period)) {
+        if (snapshot) {
+            collect(workers, result);
+            snapshot(result);
+        }
+    }
+
+    collect(workers, result);
+    if (snapshot) {
+        snapshot(result);
+    }
+
+    return (true);
+}
+
+// Harmonic bin folded back into 0..n/2
+static size_t fold_bin(const uint64_t bin, const size_t n) {
+
+    const uint64_t wrapped = bin % n;
+
+    return ((size_t)((wrapped > (n / 2)) ? (n - wrapped) : wrapped));
+}
+
+spectrum_metrics analyze_spectrum(const spectrum_result &result, const unsigned harmonics) {
+
+    spectrum_metrics metrics;
+    const std::vector<double> &power = result.power;
+    const size_t last = power.size() - 1;
+    const size_t lobe = lobe_bins(result.window);
+    std::vector<uint8_t> kind(power.size(), 0);             // 0 noise, 1 DC, 2 fundamental, 3 harmonic
+    size_t fundamental = lobe + 1;
+    double signal = 0.0;
+    double distortion = 0.0;
+    double noise = 0.0;
+    size_t noise_bins = 0;
+    double largest_spur = 0.0;
+
+    if (power.size() <= (2 * lobe) + 2) {
+        return (metrics);
+    }
+
+    // DC and its window leakage
+    for (size_t bin = 0; bin <= lobe; bin++) {
+        kind[bin] = 1;
+    }
+
+    for (size_t bin = lobe + 1; bin <= last; bin++) {
+        if (power[bin] > power[fundamental]) {
+            fundamental = bin;
+        }
+    }
+    for (size_t bin = fundamental - std::min(fundamental, lobe); bin <= std::min(last, fundamental + lobe); bin++) {
+        if (kind[bin] == 0) {
+            kind[bin] = 2;
+            signal += power[bin];
+        }
+    }
+
+    for (unsigned harmonic = 2; harmonic < harmonics + 2; harmonic++) {
+        const size_t centre = fold_bin((uint64_t) fundamental * harmonic, result.fft_size);
+        for (size_t bin = centre - std::min(centre, lobe); bin <= std::min(last, centre + lobe); bin++) {
+            if (kind[bin] == 0) {
+                kind[bin] = 3;
+                distortion += power[bin];
+            }
+        }
+    }
+
+    for (size_t bin = 0; bin <= last; bin++) {
+        if (kind[bin] == 0) {
+            noise += power[bin];
+            noise_bins++;
+        }
+        if ((kind[bin] == 0) || (kind[bin] == 3)) {
+            largest_spur = std::max(largest_spur, power[bin]);
+        }
+    }
+
+    // Noise hidden under the excluded bins is assumed to match the average of the rest
+    const size_t usable_bins = (last + 1) - (lobe + 1);
+    if (noise_bins > 0) {
+        noise *= (double) usable_bins / (double) noise_bins;
+    }
+
+    metrics.fundamental_hz = (double) fundamental * result.sample_rate_hz / (double) result.fft_size;
+    metrics.fundamental_dbfs = 10.0 * std::log10(signal / result.enbw_bins);
+    metrics.noise_dbfs = 10.0 * std::log10(noise / result.enbw_bins);
+    metrics.snr_db = 10.0 * std::log10(signal / noise);
+    metrics.sinad_db = 10.0 * std::log10(signal / (noise + distortion));
+    metrics.sfdr_dbc = 10.0 * std::log10(power[fundamental] / largest_spur);
+    metrics.enob = (metrics.sinad_db - 1.76) / 6.02;
+
+    return (metrics);
+}
+
+bool write_spectrum_csv(const std::string &path, const spectrum_result &result, std::string &error) {
+
+    const std::string temporary = path + ".tmp";
+    std::FILE *file = std::fopen(temporary.c_str(), "w");
+
+    if (file == nullptr) {
+        error = "cannot write " + temporary;
+        return (false);
+    }
+
+    std::fprintf(file, "# %llu frames of %zu points, %s window\n", (unsigned long long) result.frames, result.fft_size,
+                 (result.window == spectrum_window::hann) ? "hann" : "bh4");
+    std::fprintf(file, "bin,frequency_hz,power_dbfs\n");
+    for (size_t bin = 0; bin < result.power.size(); bin++) {
+        std::fprintf(file, "%zu,%.3f,%.2f\n", bin, (double) bin * result.sample_rate_hz / (double) result.fft_size,
+                     10.0 * std::log10(std::max(result.power[bin], 1e-30)));
+    }
+
+    if ((std::fclose(file) != 0) || (std::rename(temporary.c_str(), path.c_str()) != 0)) {
+        error = "cannot write " + path;
+        return (false);
+    }
+
+    return (true);
+}
@@ -0,0 +1,75 @@
+// Capstone Host Tools - ADC Spectrum Pipeline
+// Windowed, overlapping, averaged FFTs of a capture channel on a work stealing pool, with SNR/SFDR/ENOB
+
+#ifndef SPECTRUM_HPP
+#define SPECTRUM_HPP
+
+/* Libraries */
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "capture_file.hpp"
+
+/* Types */
+
+enum class spectrum_window {
+    hann,                                                   // 31 dB sidelobes, +-2 bin main lobe
+    blackman_harris                                         // 4 term, 92 dB sidelobes, +-4 bin main lobe (default for SFDR work)
+};
+
+// What to transform and how
+struct spectrum_options {
+    size_t fft_size = 65536;                                // Points per FFT (power of two)
+    double overlap = 0.5;                                   // Fraction of each FFT shared with the next (0 to 0.9)
+    spectrum_window window = spectrum_window::blackman_harris;
+    unsigned threads = 0;                                   // Worker threads (0: one per core)
+    size_t frames_per_task = 8;                             // FFTs per scheduled task
+    uint64_t first_sample = 0;                              // Start of the analysed range
+    uint64_t num_samples = 0;                               // Length of the analysed range (0: to the end of the capture)
+};
+
+// Averaged power spectrum
+struct spectrum_result {
+    std::vector<double> power;                              // Mean power per bin, a full scale sine on a bin centre reads 1.0 (0 dBFS)
+    uint64_t frames = 0;                                    // FFTs averaged so far
+    double sample_rate_hz = 0.0;
+    size_t fft_size = 0;
+    double enbw_bins = 1.0;                                 // Equivalent noise bandwidth of the window (in bins)
+    spectrum_window window = spectrum_window::blackman_harris;
+};
+
+// Dynamic performance figures from one spectrum
+struct spectrum_metrics {
+    double fundamental_hz = 0.0;                            // Frequency of the largest non-DC bin
+    double fundamental_dbfs = 0.0;                          // Signal power relative to a full scale sine
+    double noise_dbfs = 0.0;                                // Total noise power up to Nyquist relative to a full scale sine
+    double snr_db = 0.0;                                    // Signal to noise (harmonics excluded)
+    double sinad_db = 0.0;                                  // Signal to noise and distortion
+    double sfdr_dbc = 0.0;                                  // Fundamental to the largest other bin
+    double enob = 0.0;                                      // (SINAD - 1.76) / 6.02
+};
+
+// Called from the calling thread with the running average while the pipeline works
+typedef std::function<void(const spectrum_result &partial)> spectrum_snapshot_fn;
+
+/* Functions */
+
+// "hann" or "bh4"
+bool parse_spectrum_window(const std::string &name, spectrum_window &window);
+
+/* Average the spectrum of one capture channel. snapshot (if given) gets the running average every snapshot_period
+and the final result once more at the end */
+bool compute_spectrum(const capture_reader &reader, const unsigned channel, const spectrum_options &options, spectrum_result &result,
+                      std::string &error, spectrum_snapshot_fn snapshot = nullptr,
+                      const std::chrono::milliseconds snapshot_period = std::chrono::milliseconds(1000));
+
+/* SNR, SINAD, SFDR and ENOB with the fundamental found automatically and harmonics 2 to harmonics + 1 folded back */
+spectrum_metrics analyze_spectrum(const spectrum_result &result, const unsigned harmonics = 5);
+
+/* Write bin, frequency and dBFS columns. The file is written beside path and renamed over it, so a viewer polling
+path never sees half a spectrum */
+bool write_spectrum_csv(const std::string &path, const spectrum_result &result, std::string &error);
+
+#endif
@@ -0,0 +1,127 @@
+// Capstone Host Tools - Work Stealing Thread Pool
+// Per-worker task deques, idle workers steal from the others
+
+/*
+*  Each worker works through its own deque from the back (most recently queued, still warm in cache). When it runs
+*  dry it walks the other deques starting from its neighbour and steals the oldest task from the front, which for
+*  in-order capture tasks is the one furthest from what the victim is busy with. Deques are short mutex protected
+*  std::deque, the tasks here are milliseconds long so the lock is never the bottleneck.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include "work_pool.hpp"
+
+/* Functions */
+
+work_pool::work_pool(unsigned threads) {
+
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned worker = 0; worker < threads; worker++) {
+        queues.emplace_back(new worker_queue());
+    }
+    for (unsigned worker = 0; worker < threads; worker++) {
+        workers.emplace_back(&work_pool::run, this, worker);
+    }
+}
+
+work_pool::~work_pool() {
+
+    {
+        std::lock_guard<std::mutex> guard(state_lock);
+        stopping = true;
+    }
+    work_ready.notify_all();
+
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void work_pool::submit(work_task task) {
+
+    worker_queue &queue = *queues[next_queue++ % queues.size()];
+
+    pending++;
+    {
+        std::lock_guard<std::mutex> guard(queue.lock);
+        queue.tasks.push_back(std::move(task));
+    }
+    {
+        // Taking the state lock orders this against a worker about to sleep
+        std::lock_guard<std::mutex> guard(state_lock);
+        queued++;
+    }
+    work_ready.notify_one();
+}
+
+bool work_pool::take(const unsigned worker, work_task &task) {
+
+    // Own deque first, newest task
+    {
+        worker_queue &own = *queues[worker];
+        std::lock_guard<std::mutex> guard(own.lock);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued--;
+            return (true);
+        }
+    }
+
+    // Steal the oldest task of the next busy worker
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        worker_queue &victim = *queues[(worker + offset) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued--;
+            steal_count++;
+            return (true);
+        }
+    }
+
+    return (false);
+}
+
+void work_pool::run(const unsigned worker) {
+
+    work_task task;
+
+    while (true) {
+
+        if (take(worker, task)) {
+            task(worker);
+            task = nullptr;
+            if (--pending == 0) {
+                std::lock_guard<std::mutex> guard(state_lock);
+                all_done.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(state_lock);
+        work_ready.wait(guard, [this]() { return (stopping || (queued > 0)); });
+        if (stopping && (queued == 0)) {
+            return;
+        }
+    }
+}
+
+void work_pool::wait() {
+
+    std::unique_lock<std::mutex> guard(state_lock);
+
+    all_done.wait(guard, [this]() { return (pending == 0); });
+}
+
+bool work_pool::wait_for(const std::chrono::milliseconds timeout) {
+
+    std::unique_lock<std::mutex> guard(state_lock);
+
+    return (all_done.wait_for(guard, timeout, [this]() { return (pending == 0); }));
+}
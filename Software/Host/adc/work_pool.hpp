@@ -0,0 +1,67 @@
+// Capstone Host Tools - Work Stealing Thread Pool
+// Per-worker task deques, idle workers steal from the others
+
+#ifndef WORK_POOL_HPP
+#define WORK_POOL_HPP
+
+/* Libraries */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Types */
+
+// Tasks get the index of the worker running them, for per-worker scratch and accumulators
+typedef std::function<void(unsigned worker)> work_task;
+
+class work_pool {
+public:
+    // threads = 0 starts one worker per core
+    explicit work_pool(unsigned threads = 0);
+    ~work_pool();
+
+    work_pool(const work_pool &) = delete;
+    work_pool &operator=(const work_pool &) = delete;
+
+    unsigned size() const { return ((unsigned) workers.size()); }
+
+    /* Queue a task. Tasks go round robin onto the worker deques, so neighbouring tasks start on different workers */
+    void submit(work_task task);
+
+    // Block until every submitted task has finished
+    void wait();
+
+    // As wait(), but give up after timeout. Returns true if everything finished
+    bool wait_for(const std::chrono::milliseconds timeout);
+
+    // Tasks taken from another worker's deque so far
+    uint64_t steals() const { return (steal_count.load()); }
+
+private:
+    struct worker_queue {
+        std::mutex lock;
+        std::deque<work_task> tasks;
+    };
+
+    bool take(const unsigned worker, work_task &task);
+    void run(const unsigned worker);
+
+    std::vector<std::unique_ptr<worker_queue>> queues;      // One deque per worker: owner pops the back, thieves the front
+    std::vector<std::thread> workers;
+    std::mutex state_lock;                                  // Guards sleeping and completion
+    std::condition_variable work_ready;                     // Signalled on submit and on shutdown
+    std::condition_variable all_done;                       // Signalled when pending drops to zero
+    std::atomic<size_t> pending {0};                        // Submitted and not yet finished
+    std::atomic<size_t> queued {0};                         // Sitting in a deque
+    std::atomic<uint64_t> steal_count {0};
+    std::atomic<unsigned> next_queue {0};
+    bool stopping = false;
+};
+
+#endif
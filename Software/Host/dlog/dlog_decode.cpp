@@ -0,0 +1,97 @@
+// Capstone Host Tools - Deferred Log Decode
+// Turns the mainboard's USB output (text plus dlog frames) back into plain text using the firmware ELF
+
+/*
+*  Usage: dlog_decode <firmware.elf> [options]
+*
+*  Options:
+*      --in <file>         Stream to decode, a capture or the serial device itself (default stdin)
+*      --no-time           Leave out the record timestamps (seconds since reset)
+*      --stats             Print record, drop and error counts to stderr at the end
+*
+*  Live: "stty -F /dev/ttyACM0 raw && dlog_decode build/capstone.elf --in /dev/ttyACM0". The ELF has to be the
+*  one running on the board, the records only carry format string addresses. Host command replies are plain text
+*  and pass straight through.
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "dlog_decoder.hpp"
+#include "elf_image.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s <firmware.elf> [--in file] [--no-time] [--stats]\n", program);
+}
+
+int main(int argc, char **argv) {
+
+    std::string in_path;
+    bool timestamps = true;
+    bool print_stats = false;
+    std::string error;
+    elf_image image;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--in") == 0) && has_value) {
+            in_path = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--no-time") == 0) {
+            timestamps = false;
+        }
+        else if (std::strcmp(argv[arg], "--stats") == 0) {
+            print_stats = true;
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (!image.open(argv[1], error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    std::FILE *file = in_path.empty() ? stdin : std::fopen(in_path.c_str(), "rb");
+    if (file == nullptr) {
+        std::fprintf(stderr, "ERROR: cannot open %s\n", in_path.c_str());
+        return (1);
+    }
+
+    // A byte at a time, so a live stream is printed as it arrives rather than a buffer later
+    dlog_decoder decoder(image, timestamps);
+    int byte = 0;
+    while ((byte = std::getc(file)) != EOF) {
+        const uint8_t value = (uint8_t) byte;
+        const std::string text = decoder.feed(&value, 1);
+        if (!text.empty()) {
+            std::fwrite(text.data(), 1, text.size(), stdout);
+            if (text.back() == '\n') {
+                std::fflush(stdout);
+            }
+        }
+    }
+
+    if (file != stdin) {
+        std::fclose(file);
+    }
+
+    const dlog_stats &stats = decoder.stats();
+    if (print_stats) {
+        std::fprintf(stderr, "%llu records, %llu dropped by the firmware, %llu bad frames, %llu unknown formats, %llu argument mismatches\n",
+                     (unsigned long long) stats.records, (unsigned long long) stats.dropped, (unsigned long long) stats.bad_frames,
+                     (unsigned long long) stats.unknown_formats, (unsigned long long) stats.arg_mismatches);
+    }
+
+    return (((stats.bad_frames == 0) && (stats.unknown_formats == 0) && (stats.arg_mismatches == 0)) ? 0 : 2);
+}
@@ -0,0 +1,240 @@
+// Capstone Host Tools - Deferred Log Decoder
+// Splits the firmware's USB stream into text and dlog frames and rebuilds each record's printf output from the ELF
+
+/* Libraries */
+#include <cstdio>
+#include <cstring>
+#include "dlog_decoder.hpp"
+
+/* Parameters */
+static const size_t DLOG_HEADER_WORDS           = 2;        // Format | count, time
+static const uint32_t DLOG_COUNT_MASK           = 0x7;      // Argument count bits of the first word
+static const size_t MAX_FRAME_BYTES             = 64;       // Longer runs between 0x00 bytes are not frames
+
+/* Functions */
+
+bool cobs_decode(const std::vector<uint8_t> &encoded, std::vector<uint8_t> &decoded) {
+
+    decoded.clear();
+    size_t at = 0;
+
+    while (at < encoded.size()) {
+        const uint8_t code = encoded[at++];
+        if ((code == 0) || ((at + code - 1) > encoded.size())) {
+            return (false);
+        }
+        decoded.insert(decoded.end(), encoded.begin() + (long) at, encoded.begin() + (long)(at + code - 1));
+        at += code - 1;
+        if ((code < 0xFF) && (at < encoded.size())) {
+            decoded.push_back(0);
+        }
+    }
+    return (true);
+}
+
+dlog_decoder::dlog_decoder(const elf_image &image, const bool timestamps) : elf(image), show_time(timestamps) {
+}
+
+std::string dlog_decoder::feed(const uint8_t *data, const size_t size) {
+
+    std::string out;
+
+    for (size_t index = 0; index < size; index++) {
+        const uint8_t byte = data[index];
+
+        if (!in_frame) {
+            if (byte == 0) {
+                in_frame = true;
+                frame.clear();
+            }
+            else {
+                out += (char) byte;
+            }
+        }
+        // A 0x00 right after the opening one is the gap between two frames
+        else if (byte == 0) {
+            if (!frame.empty()) {
+                decode_frame(out);
+                in_frame = false;
+            }
+        }
+        else if (frame.size() >= MAX_FRAME_BYTES) {
+            counts.bad_frames++;
+            in_frame = false;
+        }
+        else {
+            frame.push_back(byte);
+        }
+    }
+
+    return (out);
+}
+
+void dlog_decoder::decode_frame(std::string &out) {
+
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> words;
+    char prefix[40] = "";
+
+    if (!cobs_decode(frame, bytes) || (bytes.size() % 4 != 0) || (bytes.size() < (DLOG_HEADER_WORDS * 4))) {
+        counts.bad_frames++;
+        return;
+    }
+    for (size_t index = 0; index < bytes.size(); index += 4) {
+        words.push_back((uint32_t) bytes[index] | ((uint32_t) bytes[index + 1] << 8) | ((uint32_t) bytes[index + 2] << 16) |
+                        ((uint32_t) bytes[index + 3] << 24));
+    }
+
+    const uint32_t fmt_address = words[0] & ~DLOG_COUNT_MASK;
+    const uint32_t count = words[0] & DLOG_COUNT_MASK;
+    if (words.size() != (DLOG_HEADER_WORDS + count)) {
+        counts.bad_frames++;
+        return;
+    }
+    const std::vector<uint32_t> args(words.begin() + DLOG_HEADER_WORDS, words.end());
+
+    // Drop reports carry the time they were sent, after the records still queued behind them, so they leave the clock alone
+    if (fmt_address == 0) {
+        counts.dropped += (count > 0) ? args[0] : 0;
+        out += "<" + std::to_string((count > 0) ? args[0] : 0) + " log records dropped>\n";
+        return;
+    }
+
+    // Going back by more than half the range is the 32-bit clock wrapping, anything less is the board restarting
+    if (words[1] < last_time_us) {
+        time_epochs = ((last_time_us - words[1]) > 0x80000000u) ? (time_epochs + 1) : 0;
+    }
+    last_time_us = words[1];
+    if (show_time) {
+        std::snprintf(prefix, sizeof(prefix), "[%12.6f] ", (double)((time_epochs << 32) | words[1]) / 1e6);
+    }
+
+    std::string fmt;
+    std::string text;
+    if (!elf.read_string(fmt_address, fmt)) {
+        char unknown[64];
+        std::snprintf(unknown, sizeof(unknown), "<unknown format 0x%08x, %u args>\n", fmt_address, count);
+        out += prefix;
+        out += unknown;
+        counts.unknown_formats++;
+        return;
+    }
+    if (!format(fmt, args, text)) {
+        counts.arg_mismatches++;
+        text += " <argument count mismatch>\n";
+    }
+    out += prefix + text;
+    counts.records++;
+}
+
+bool dlog_decoder::format(const std::string &fmt, const std::vector<uint32_t> &args, std::string &text) const {
+
+    size_t next_arg = 0;
+    bool ok = true;
+    text.clear();
+
+    // Next argument word, 0 (and a mismatch) once they run out
+    auto take = [&]() -> uint32_t {
+        if (next_arg < args.size()) {
+            return (args[next_arg++]);
+        }
+        ok = false;
+        return (0);
+    };
+
+    for (size_t at = 0; at < fmt.size(); at++) {
+
+        if (fmt[at] != '%') {
+            text += fmt[at];
+            continue;
+        }
+        if ((at + 1 < fmt.size()) && (fmt[at + 1] == '%')) {
+            text += '%';
+            at++;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion, rebuilt without the length for the host's printf
+        std::string spec = "%";
+        at++;
+        while ((at < fmt.size()) && std::strchr("-+ #0", fmt[at])) {
+            spec += fmt[at++];
+        }
+        for (int part = 0; part < 2; part++) {
+            if ((part == 1) && ((at >= fmt.size()) || (fmt[at] != '.'))) {
+                break;
+            }
+            if (part == 1) {
+                spec += fmt[at++];
+            }
+            if ((at < fmt.size()) && (fmt[at] == '*')) {
+                spec += std::to_string((int32_t) take());
+                at++;
+            }
+            while ((at < fmt.size()) && (fmt[at] >= '0') && (fmt[at] <= '9')) {
+                spec += fmt[at++];
+            }
+        }
+        std::string length;
+        while ((at < fmt.size()) && std::strchr("hljztL", fmt[at])) {
+            length += fmt[at++];
+        }
+        if (at >= fmt.size()) {
+            ok = false;
+            break;
+        }
+
+        const char conversion = fmt[at];
+        char buffer[128];
+        uint32_t word = 0;
+        std::string value;
+
+        switch (conversion) {
+        case 'd':
+        case 'i':
+            word = take();
+            spec += 'd';
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(),
+                          (length == "hh") ? (int)(int8_t) word : (length == "h") ? (int)(int16_t) word : (int)(int32_t) word);
+            text += buffer;
+            break;
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+            word = take();
+            spec += conversion;
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(),
+                          (length == "hh") ? (unsigned)(uint8_t) word : (length == "h") ? (unsigned)(uint16_t) word : (unsigned) word);
+            text += buffer;
+            break;
+        case 'c':
+            spec += 'c';
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(), (int)(uint8_t) take());
+            text += buffer;
+            break;
+        case 'p':
+            std::snprintf(buffer, sizeof(buffer), "0x%08x", take());
+            text += buffer;
+            break;
+        case 's':
+            word = take();
+            if (!elf.read_string(word, value)) {
+                std::snprintf(buffer, sizeof(buffer), "<str 0x%08x>", word);
+                value = buffer;
+            }
+            spec += 's';
+            std::snprintf(buffer, sizeof(buffer), spec.c_str(), value.c_str());
+            text += buffer;
+            break;
+        default:
+            // Floating point and anything else cannot come through a 32-bit word
+            take();
+            text += "<%" + std::string(1, conversion) + "?>";
+            ok = false;
+            break;
+        }
+    }
+
+    return (ok && (next_arg == args.size()));
+}
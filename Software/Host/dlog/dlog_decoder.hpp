@@ -0,0 +1,60 @@
+// Capstone Host Tools - Deferred Log Decoder
+// Splits the firmware's USB stream into text and dlog frames and rebuilds each record's printf output from the ELF
+
+#ifndef DLOG_DECODER_HPP
+#define DLOG_DECODER_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "elf_image.hpp"
+
+/*
+*  Stream format (Software/RP2040/dlog.h): plain text, and records as COBS frames between 0x00 bytes. A record is
+*  little endian words: format address | argument count (low 3 bits), time_us_32(), then the argument words. Format
+*  address 0 reports records the firmware had to drop (one argument: how many).
+*/
+
+/* Types */
+
+// What the decoder has seen so far
+struct dlog_stats {
+    uint64_t records = 0;                                   // Records decoded
+    uint64_t bad_frames = 0;                                // Frames that were not a valid record
+    uint64_t unknown_formats = 0;                           // Records whose format address is not a string in the ELF
+    uint64_t arg_mismatches = 0;                            // Records whose argument count does not fit their format
+    uint64_t dropped = 0;                                   // Records the firmware reported as dropped
+};
+
+class dlog_decoder {
+public:
+    /* timestamps: put the record time (seconds since reset) in front of each decoded record */
+    dlog_decoder(const elf_image &image, const bool timestamps);
+
+    // Feed stream bytes, returns the text they complete (passed through text and decoded records, in order)
+    std::string feed(const uint8_t *data, const size_t size);
+
+    /* printf output of a format and its argument words, with %s read from the ELF. Returns false (with a best
+    effort text) if the count of words does not match the format */
+    bool format(const std::string &fmt, const std::vector<uint32_t> &args, std::string &text) const;
+
+    const dlog_stats &stats() const { return (counts); }
+
+private:
+    const elf_image &elf;
+    bool show_time;
+    bool in_frame = false;                                  // Between a 0x00 and the next one
+    std::vector<uint8_t> frame;
+    uint32_t last_time_us = 0;
+    uint64_t time_epochs = 0;                               // 32-bit microsecond wraps seen
+    dlog_stats counts;
+
+    void decode_frame(std::string &out);
+};
+
+// COBS decode of one frame (without its delimiters). Returns false if the encoding is broken
+bool cobs_decode(const std::vector<uint8_t> &encoded, std::vector<uint8_t> &decoded);
+
+#endif
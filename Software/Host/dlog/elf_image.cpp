@@ -0,0 +1,115 @@
+// Capstone Host Tools - ELF Image
+// Loadable section contents of a firmware ELF, read by target address
+
+/* Libraries */
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "elf_image.hpp"
+
+/* Parameters */
+static const uint32_t SHF_ALLOC                 = 0x2;      // Section occupies memory on the target
+static const uint32_t SHT_NOBITS                = 8;        // Section has no file contents (.bss)
+
+/* Functions */
+
+// Little endian field of 1 to 8 bytes, 0 if it runs past the end of the file
+static uint64_t field(const std::vector<uint8_t> &file, const uint64_t offset, const size_t bytes) {
+
+    uint64_t value = 0;
+    if ((offset + bytes) > file.size()) {
+        return (0);
+    }
+    for (size_t index = 0; index < bytes; index++) {
+        value |= (uint64_t) file[offset + index] << (8 * index);
+    }
+    return (value);
+}
+
+bool elf_image::open(const std::string &path, std::string &error) {
+
+    std::ifstream stream(path, std::ios::binary);
+    if (!stream) {
+        error = "cannot open " + path;
+        return (false);
+    }
+    file.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    loadable.clear();
+
+    if ((file.size() < 52) || (std::memcmp(file.data(), "\x7F" "ELF", 4) != 0)) {
+        error = path + " is not an ELF file";
+        return (false);
+    }
+    if (file[5] != 1) {
+        error = path + " is not little endian";
+        return (false);
+    }
+
+    // Header layout differs between the classes only in the width of addresses and offsets
+    const bool is64 = (file[4] == 2);
+    const size_t word = is64 ? 8 : 4;
+    const uint64_t sh_offset = field(file, is64 ? 0x28 : 0x20, word);
+    const uint64_t sh_entsize = field(file, is64 ? 0x3A : 0x2E, 2);
+    const uint64_t sh_count = field(file, is64 ? 0x3C : 0x30, 2);
+    const uint64_t sh_strndx = field(file, is64 ? 0x3E : 0x32, 2);
+
+    if ((sh_offset == 0) || ((sh_offset + (sh_entsize * sh_count)) > file.size()) || (sh_strndx >= sh_count)) {
+        error = path + " has no usable section headers";
+        return (false);
+    }
+
+    const uint64_t names_offset = field(file, sh_offset + (sh_entsize * sh_strndx) + (is64 ? 0x18 : 0x10), word);
+
+    for (uint64_t index = 0; index < sh_count; index++) {
+        const uint64_t header = sh_offset + (sh_entsize * index);
+        const uint32_t type = (uint32_t) field(file, header + 4, 4);
+        const uint64_t flags = field(file, header + 8, word);
+        elf_section section;
+
+        section.address = field(file, header + (is64 ? 0x10 : 0x0C), word);
+        section.offset = field(file, header + (is64 ? 0x18 : 0x10), word);
+        section.size = field(file, header + (is64 ? 0x20 : 0x14), word);
+
+        if (!(flags & SHF_ALLOC) || (type == SHT_NOBITS) || (section.size == 0) || ((section.offset + section.size) > file.size())) {
+            continue;
+        }
+        for (uint64_t at = names_offset + field(file, header, 4); (at < file.size()) && (file[at] != 0); at++) {
+            section.name += (char) file[at];
+        }
+        loadable.push_back(section);
+    }
+
+    if (loadable.empty()) {
+        error = path + " has no loadable sections";
+        return (false);
+    }
+    return (true);
+}
+
+const elf_section *elf_image::find_section(const uint64_t address) const {
+
+    for (const elf_section &section : loadable) {
+        if ((address >= section.address) && (address < (section.address + section.size))) {
+            return (&section);
+        }
+    }
+    return (nullptr);
+}
+
+bool elf_image::read_string(const uint64_t address, std::string &text, const size_t max_length) const {
+
+    const elf_section *section = find_section(address);
+    text.clear();
+    if (section == nullptr) {
+        return (false);
+    }
+
+    for (uint64_t at = address; (at < (section->address + section->size)) && (text.size() < max_length); at++) {
+        const uint8_t byte = file[section->offset + (at - section->address)];
+        if (byte == 0) {
+            return (true);
+        }
+        text += (char) byte;
+    }
+    return (false);
+}
@@ -0,0 +1,42 @@
+// Capstone Host Tools - ELF Image
+// Loadable section contents of a firmware ELF, read by target address
+
+#ifndef ELF_IMAGE_HPP
+#define ELF_IMAGE_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* Types */
+
+// One section that is part of the image (SHF_ALLOC with file contents)
+struct elf_section {
+    std::string name;
+    uint64_t address = 0;                                   // Target address of the first byte
+    uint64_t size = 0;
+    uint64_t offset = 0;                                    // Where its bytes are in the file
+};
+
+// Little endian ELF32 (the RP2040 firmware) or ELF64 file
+class elf_image {
+public:
+    bool open(const std::string &path, std::string &error);
+
+    /* NUL terminated string at a target address, max_length bytes at most. Returns false if the address is not in a
+    loadable section or the string runs off its end */
+    bool read_string(const uint64_t address, std::string &text, const size_t max_length = 1024) const;
+
+    // Section holding a target address, nullptr if none does
+    const elf_section *find_section(const uint64_t address) const;
+
+    const std::vector<elf_section> &sections() const { return (loadable); }
+
+private:
+    std::vector<uint8_t> file;
+    std::vector<elf_section> loadable;
+};
+
+#endif
@@ -0,0 +1,397 @@
+// Capstone Host Tools - Event Loop Simulation
+// The firmware's event loop on a virtual clock: task latency of the mainboard task set, timer wheel check and benchmark
+
+/*
+*  Usage: evloop_sim <mode> [options]
+*      tasks       Run the mainboard task set (sequencing, protect, DVS, host, telemetry, log) with simulated handler
+*                  times and host commands arriving at random, then report every task's worst case latency
+*      wheel       Start, stop and restart random one-shot and periodic timers and check every expiry lands on its
+*                  exact tick, then time start/stop/expiry on this machine
+*
+*  Options:
+*      --seconds <t>       Simulated time (tasks: default 60, wheel: default 600)
+*      --timers <n>        wheel: timers (default 10000)
+*      --cmd-us <us>       tasks: longest host command (default 70000, dumping a full fault log over USB)
+*      --budget-us <us>    tasks: protect task latency budget (default 10000, one protect period)
+*      --seed <n>          Random seed
+*
+*  The virtual clock only moves when a handler "runs" (by its simulated cost) or the loop idles, so results are exact
+*  and repeatable. Host commands arrive like the USB interrupt would: in the middle of whatever is running.
+*/
+
+/* Libraries */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include "evloop.h"
+
+/* Parameters */
+static const uint32_t PROTECT_PERIOD_MS         = 10;       // Firmware task periods (main.cpp)
+static const uint32_t HOST_POLL_PERIOD_MS       = 10;
+static const uint32_t SEQ_STEP_PERIOD_MS        = 1;
+static const uint32_t SCRUB_PERIOD_MS           = 1000;
+static const uint32_t LOG_SERVICE_PERIOD_MS     = 100;
+static const uint32_t SEQ_RAILS                 = 7;        // Rails brought up one after another
+static const uint32_t SEQ_RAMP_MS               = 3;        // Enable to PG of each rail
+static const double CMD_MEAN_GAP_MS             = 250.0;    // Mean time between host commands
+
+// Simulated handler times on the RP2040 at 125 MHz (in us)
+static const uint32_t COST_PROTECT_US           = 5;        // PG read and watchdog feed
+static const uint32_t COST_SEQ_US               = 20;       // One sequencer pass
+static const uint32_t COST_DVS_US               = 40;       // Load hint read, occasionally a VSET write
+static const uint32_t COST_HOST_POLL_US         = 15;       // Empty USB poll and status LEDs
+static const uint32_t COST_TELEMETRY_US         = 1800;     // One PMIC scrub and one TMP1075 read at 100 kHz
+static const uint32_t COST_LOG_US               = 30;       // Nothing staged, most of the time
+
+/* Types */
+
+enum sim_msg : uint16_t {
+    MSG_TICK = 0,
+    MSG_COMMAND
+};
+
+/* Variables */
+static uint64_t virtual_us = 0;                             // The simulated clock
+static std::mt19937_64 rng;
+static evloop_t *sim_loop = nullptr;
+static evloop_task_t *command_task = nullptr;               // Receives the simulated USB interrupt's posts
+static uint64_t next_command_us = UINT64_MAX;               // When the next host command arrives
+static uint32_t max_cmd_us = 70000;                         // A full fault log dump (512 records, about 28 kB over USB), the longest firmware handler
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s tasks|wheel [--seconds t] [--timers n] [--cmd-us us] [--budget-us us] [--seed n]\n", program);
+}
+
+static uint32_t sim_now_us(void) {
+    return ((uint32_t) virtual_us);
+}
+
+static uint32_t sim_lock(void) {
+    return (0);
+}
+
+static void sim_unlock(const uint32_t saved) {
+    (void) saved;
+}
+
+// Deliver every host command that arrives up to end_us, each posted at its own arrival time
+static bool deliver_commands(const uint64_t end_us) {
+
+    bool delivered = false;
+    std::exponential_distribution<double> gap(1.0 / (CMD_MEAN_GAP_MS * 1000.0));
+
+    while ((command_task != nullptr) && (next_command_us <= end_us)) {
+        virtual_us = next_command_us;
+        evloop_post(sim_loop, command_task, MSG_COMMAND, 0);
+        next_command_us += 1 + (uint64_t) gap(rng);
+        delivered = true;
+    }
+    return (delivered);
+}
+
+// A handler taking us of CPU time, with interrupts still arriving meanwhile
+static void spend(const uint32_t us) {
+
+    const uint64_t end_us = virtual_us + us;
+    deliver_commands(end_us);
+    virtual_us = end_us;
+}
+
+// Idle until max_us has passed or an interrupt posted something
+static void sim_idle(const uint32_t max_us) {
+
+    const uint64_t end_us = virtual_us + max_us;
+    if (!deliver_commands(end_us)) {
+        virtual_us = end_us;
+    }
+}
+
+/* Mainboard task set */
+
+static evloop_timer_t seq_timer;
+static evloop_timer_t protect_timer;
+static evloop_timer_t dvs_timer;
+static evloop_timer_t host_timer;
+static evloop_timer_t telemetry_timer;
+static evloop_timer_t log_timer;
+static evloop_task_t protect_task;
+static evloop_task_t seq_task;
+static evloop_task_t dvs_task;
+static evloop_task_t host_task;
+static evloop_task_t telemetry_task;
+static evloop_task_t log_task;
+static uint32_t rails_up = 0;
+static uint64_t rails_up_us = 0;
+static uint32_t commands_run = 0;
+
+static void task_protect(evloop_t *, evloop_task_t *, const evloop_msg_t *) {
+    spend(COST_PROTECT_US);
+}
+
+static void task_dvs(evloop_t *, evloop_task_t *, const evloop_msg_t *) {
+    spend(COST_DVS_US);
+}
+
+static void task_host(evloop_t *, evloop_task_t *, const evloop_msg_t *msg) {
+
+    if (msg->type == MSG_COMMAND) {
+        std::uniform_int_distribution<uint32_t> cost(100, max_cmd_us);
+        spend(cost(rng));
+        commands_run++;
+    }
+    else {
+        spend(COST_HOST_POLL_US);
+    }
+}
+
+static void task_telemetry(evloop_t *, evloop_task_t *, const evloop_msg_t *) {
+    spend(COST_TELEMETRY_US);
+}
+
+static void task_log(evloop_t *, evloop_task_t *, const evloop_msg_t *) {
+    spend(COST_LOG_US);
+}
+
+// One pass per tick, a rail comes up every SEQ_RAMP_MS, then the rest of the board starts as in main.cpp
+static void task_seq(evloop_t *loop, evloop_task_t *, const evloop_msg_t *) {
+
+    spend(COST_SEQ_US);
+    if ((virtual_us / 1000) < ((uint64_t)(rails_up + 1) * SEQ_RAMP_MS)) {
+        return;
+    }
+    if (++rails_up < SEQ_RAILS) {
+        return;
+    }
+
+    rails_up_us = virtual_us;
+    evloop_timer_stop(loop, &seq_timer);
+    evloop_timer_start(loop, &protect_timer, &protect_task, MSG_TICK, 0, PROTECT_PERIOD_MS, PROTECT_PERIOD_MS);
+    evloop_timer_start(loop, &dvs_timer, &dvs_task, MSG_TICK, 0, HOST_POLL_PERIOD_MS, HOST_POLL_PERIOD_MS);
+    evloop_timer_start(loop, &host_timer, &host_task, MSG_TICK, 0, HOST_POLL_PERIOD_MS, HOST_POLL_PERIOD_MS);
+    evloop_timer_start(loop, &telemetry_timer, &telemetry_task, MSG_TICK, 0, SCRUB_PERIOD_MS, SCRUB_PERIOD_MS);
+    evloop_timer_start(loop, &log_timer, &log_task, MSG_TICK, 0, LOG_SERVICE_PERIOD_MS, LOG_SERVICE_PERIOD_MS);
+
+    // Host commands are only accepted once startup is done
+    command_task = &host_task;
+    next_command_us = virtual_us + 1000;
+}
+
+static int run_tasks(const double seconds, const uint32_t budget_us) {
+
+    const evloop_port_t port = { sim_now_us, sim_lock, sim_unlock, sim_idle };
+    const uint64_t end_us = (uint64_t)(seconds * 1e6);
+    evloop_t loop;
+
+    evloop_init(&loop, &port);
+    sim_loop = &loop;
+    evloop_add_task(&loop, &protect_task, "protect", 0, task_protect, nullptr);
+    evloop_add_task(&loop, &seq_task, "sequence", 1, task_seq, nullptr);
+    evloop_add_task(&loop, &dvs_task, "dvs", 2, task_dvs, nullptr);
+    evloop_add_task(&loop, &host_task, "host", 3, task_host, nullptr);
+    evloop_add_task(&loop, &telemetry_task, "telemetry", 4, task_telemetry, nullptr);
+    evloop_add_task(&loop, &log_task, "log", 5, task_log, nullptr);
+    evloop_timer_start(&loop, &seq_timer, &seq_task, MSG_TICK, 0, SEQ_STEP_PERIOD_MS, SEQ_STEP_PERIOD_MS);
+
+    // evloop_run() without the forever
+    while (virtual_us < end_us) {
+        while (evloop_run_once(&loop)) {
+        }
+        const uint32_t idle_us = evloop_idle_us(&loop);
+        sim_idle((idle_us != 0) ? idle_us : 1);
+    }
+
+    evloop_print(&loop);
+    std::printf("Rails up after %.1f ms, %u host commands (up to %u us each)\n", (double) rails_up_us / 1000.0, commands_run, max_cmd_us);
+
+    // Nothing preempts a handler, so the protect task can wait for the longest handler of any other task
+    uint32_t blocking_us = 0;
+    for (size_t index = 1; index < loop.num_tasks; index++) {
+        blocking_us = (loop.tasks[index]->max_run_us > blocking_us) ? loop.tasks[index]->max_run_us : blocking_us;
+    }
+    std::printf("Protect latency %u us (longest other handler %u us), budget %u us\t%s\n", protect_task.max_latency_us, blocking_us,
+                budget_us, (protect_task.max_latency_us > budget_us) ? "OVER BUDGET" : "ok");
+
+    return (((rails_up == SEQ_RAILS) && (protect_task.max_latency_us <= budget_us)) ? 0 : 2);
+}
+
+/* Timer wheel check */
+
+struct wheel_timer {
+    evloop_timer_t timer;
+    uint32_t expected_tick;                                 // Tick the next expiry has to land on
+    uint32_t fired;
+};
+
+static std::vector<wheel_timer> wheel_timers;
+static uint64_t wheel_errors = 0;
+static uint64_t wheel_restarts = 0;
+
+// Expiry: on the exact tick, then now and then restarted or stopped from inside the handler
+static void task_check(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+
+    wheel_timer &entry = wheel_timers[msg->arg];
+    const uint32_t due_tick = msg->posted_us / 1000;
+    std::uniform_int_distribution<uint32_t> action(0, 99);
+    std::uniform_int_distribution<uint32_t> delay(1, 400000);
+
+    entry.fired++;
+    if ((due_tick != entry.expected_tick) || !(entry.timer.active || (entry.timer.period_ms == 0))) {
+        if (wheel_errors++ < 10) {
+            std::printf("ERROR: timer %u due at tick %u, expected %u\n", msg->arg, due_tick, entry.expected_tick);
+        }
+    }
+
+    const uint32_t roll = action(rng);
+    if (roll < 5) {
+        evloop_timer_start(loop, &entry.timer, task, MSG_TICK, msg->arg, delay(rng), 0);
+        entry.expected_tick = entry.timer.expires;
+        wheel_restarts++;
+    }
+    else if ((roll < 8) && entry.timer.active) {
+        evloop_timer_stop(loop, &entry.timer);
+    }
+    else if (entry.timer.period_ms != 0) {
+        entry.expected_tick += entry.timer.period_ms;
+    }
+}
+
+// Benchmark sink: takes the expiry and nothing else
+static void task_sink(evloop_t *, evloop_task_t *, const evloop_msg_t *) {
+}
+
+static int run_wheel(const double seconds, const size_t num_timers) {
+
+    const evloop_port_t port = { sim_now_us, sim_lock, sim_unlock, sim_idle };
+    const uint64_t end_us = (uint64_t)(seconds * 1e6);
+    std::uniform_int_distribution<uint32_t> delay(1, 400000);      // Past the wheel's 262 s reach
+    std::uniform_int_distribution<uint32_t> period(1, 5000);
+    std::bernoulli_distribution periodic(0.2);
+    evloop_t loop;
+    evloop_task_t check_task;
+    uint64_t idles = 0;
+
+    evloop_init(&loop, &port);
+    evloop_add_task(&loop, &check_task, "check", 0, task_check, nullptr);
+
+    wheel_timers.assign(num_timers, wheel_timer());
+    for (size_t index = 0; index < num_timers; index++) {
+        wheel_timer &entry = wheel_timers[index];
+        evloop_timer_start(&loop, &entry.timer, &check_task, MSG_TICK, (uint32_t) index, delay(rng), periodic(rng) ? period(rng) : 0);
+        entry.expected_tick = entry.timer.expires;
+    }
+
+    // The queue is only EVLOOP_QUEUE_LEN deep, so drain it after every tick rather than idling through several
+    while (virtual_us < end_us) {
+        while (evloop_run_once(&loop)) {
+        }
+        const uint32_t idle_us = evloop_idle_us(&loop);
+        virtual_us += (idle_us < 1000) ? ((idle_us != 0) ? idle_us : 1) : (idle_us - (idle_us % 1000));
+        idles++;
+    }
+
+    // Nothing may be overdue
+    for (size_t index = 0; index < num_timers; index++) {
+        const wheel_timer &entry = wheel_timers[index];
+        if (entry.timer.active && ((int32_t)(entry.expected_tick - loop.tick) < 0)) {
+            if (wheel_errors++ < 10) {
+                std::printf("ERROR: timer %zu missed tick %u\n", index, entry.expected_tick);
+            }
+        }
+    }
+
+    std::printf("%zu timers, %lu expiries over %u ticks (%llu idles), %llu restarts, %lu dropped posts, %llu errors\n", num_timers,
+                (unsigned long) loop.timers_fired, loop.tick, (unsigned long long) idles, (unsigned long long) wheel_restarts,
+                (unsigned long) check_task.dropped, (unsigned long long) wheel_errors);
+
+    // Throughput on this machine: fresh timers started, stopped, then started again and run out
+    std::vector<evloop_timer_t> bench(num_timers);
+    evloop_task_t sink_task;
+    evloop_t bench_loop;
+    evloop_init(&bench_loop, &port);
+    evloop_add_task(&bench_loop, &sink_task, "sink", 0, task_sink, nullptr);
+
+    auto start = std::chrono::steady_clock::now();
+    for (evloop_timer_t &timer : bench) {
+        evloop_timer_start(&bench_loop, &timer, &sink_task, MSG_TICK, 0, delay(rng), 0);
+    }
+    const double start_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double) num_timers;
+
+    start = std::chrono::steady_clock::now();
+    for (evloop_timer_t &timer : bench) {
+        evloop_timer_stop(&bench_loop, &timer);
+    }
+    const double stop_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (double) num_timers;
+
+    // Short delays this time, run out as the loop would: each expiry costs its share of the ticks, cascades, post and dispatch
+    std::uniform_int_distribution<uint32_t> short_delay(1, 60000);
+    for (evloop_timer_t &timer : bench) {
+        evloop_timer_start(&bench_loop, &timer, &sink_task, MSG_TICK, 0, short_delay(rng), 0);
+    }
+    start = std::chrono::steady_clock::now();
+    for (uint32_t tick = 0; tick <= 60000; tick++) {
+        virtual_us += 1000;
+        while (evloop_run_once(&bench_loop)) {
+        }
+    }
+    const double expire_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                             (double) bench_loop.timers_fired;
+
+    std::printf("Start %.1f ns, stop %.1f ns, expiry %.1f ns per timer (%lu fired)\n", start_ns, stop_ns, expire_ns,
+                (unsigned long) bench_loop.timers_fired);
+
+    return (((wheel_errors == 0) && (check_task.dropped == 0) && (bench_loop.timers_fired == num_timers)) ? 0 : 2);
+}
+
+int main(int argc, char **argv) {
+
+    double seconds = 0.0;
+    size_t num_timers = 10000;
+    uint32_t budget_us = 10000;
+    uint64_t seed = 1;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+    const std::string mode = argv[1];
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--seconds") == 0) && has_value) {
+            seconds = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--timers") == 0) && has_value) {
+            num_timers = (size_t) std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--cmd-us") == 0) && has_value) {
+            max_cmd_us = (uint32_t) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--budget-us") == 0) && has_value) {
+            budget_us = (uint32_t) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--seed") == 0) && has_value) {
+            seed = std::strtoull(argv[++arg], nullptr, 0);
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+    rng.seed(seed);
+
+    if (mode == "tasks") {
+        return (run_tasks((seconds > 0.0) ? seconds : 60.0, budget_us));
+    }
+    else if (mode == "wheel") {
+        return (run_wheel((seconds > 0.0) ? seconds : 600.0, (num_timers > 0) ? num_timers : 1));
+    }
+
+    usage(argv[0]);
+    return (1);
+}
@@ -0,0 +1,245 @@
+// Capstone Host Tools - QSFP Link BER Test
+// PRBS source, sink and loopback stand-in for qualifying the GTX/QSFP link, plus a checker throughput benchmark
+
+/*
+*  Usage: ber_test <mode> [options]
+*      gen         Write a PRBS stream (64-bit little endian words) to --out or stdout
+*      check       Check a stream read from --in or stdin and report the BER
+*      loopback    Generator -> channel stand-in -> checker in memory, reports injected against measured errors
+*      bench       Generator and checker throughput for every sequence
+*
+*  Options:
+*      --prbs <n>          7, 15, 23 or 31 (default 31)
+*      --words <n>         Words to generate (gen: default 0, endless; loopback: default 16M)
+*      --ber <x>           Bit error rate the channel stand-in injects (default 0)
+*      --slip <bits>       Drop one bit every n bits (default 0, never)
+*      --invert            Invert the stream (swapped P/N)
+*      --seed <n>          Generator seed
+*      --out <file>        gen output (default stdout)
+*      --in <file>         check input (default stdin)
+*      --seconds <t>       bench time per measurement (default 0.5)
+*
+*  Without hardware, "ber_test gen --ber 1e-7 | ber_test check" exercises the whole path through a pipe.
+*/
+
+/* Libraries */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "prbs.hpp"
+
+/* Parameters */
+static const size_t BLOCK_WORDS                 = 65536;    // Words per read/write/check call (512 kB)
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s gen|check|loopback|bench [--prbs 7|15|23|31] [--words n] [--ber x] [--slip bits] [--invert]\n"
+                "       [--seed n] [--out file] [--in file] [--seconds t]\n", program);
+}
+
+static void print_stats(const prbs_stats &stats, const bool locked) {
+
+    std::printf("%s%s, %llu bits checked, %llu errors, BER %.3e (< %.3e at 95%% confidence)\n", locked ? "Locked" : "NOT locked",
+                stats.inverted ? " (inverted)" : "", (unsigned long long) stats.bits_checked, (unsigned long long) stats.bit_errors,
+                stats.ber(), stats.ber_upper_bound(0.95));
+    std::printf("%llu bits spent acquiring, %llu lock losses\n", (unsigned long long) stats.bits_unlocked, (unsigned long long) stats.lock_losses);
+}
+
+static int run_gen(const prbs_order order, const uint64_t words, const double ber, const uint64_t slip, const bool invert, const uint32_t seed,
+                   const std::string &out_path) {
+
+    std::FILE *file = out_path.empty() ? stdout : std::fopen(out_path.c_str(), "wb");
+    prbs_generator generator(order, seed);
+    prbs_channel channel(ber, slip, invert, seed);
+    std::vector<uint64_t> block(BLOCK_WORDS);
+    std::vector<uint64_t> line(BLOCK_WORDS);
+
+    if (file == nullptr) {
+        std::fprintf(stderr, "ERROR: cannot write %s\n", out_path.c_str());
+        return (1);
+    }
+
+    for (uint64_t done = 0; (words == 0) || (done < words); ) {
+        const size_t count = (words == 0) ? BLOCK_WORDS : (size_t) std::min<uint64_t>(BLOCK_WORDS, words - done);
+        generator.fill(block.data(), count);
+        const size_t sent = channel.transfer(block.data(), count, line.data());
+        if (std::fwrite(line.data(), sizeof(uint64_t), sent, file) != sent) {
+            break;                                          // Reader went away
+        }
+        done += count;
+    }
+
+    if (file != stdout) {
+        std::fclose(file);
+    }
+    std::fprintf(stderr, "%llu errors and %llu slips injected\n", (unsigned long long) channel.errors_injected(),
+                 (unsigned long long) channel.slips_injected());
+
+    return (0);
+}
+
+static int run_check(const prbs_order order, const std::string &in_path) {
+
+    std::FILE *file = in_path.empty() ? stdin : std::fopen(in_path.c_str(), "rb");
+    prbs_checker checker(order);
+    std::vector<uint64_t> block(BLOCK_WORDS);
+    size_t count = 0;
+
+    if (file == nullptr) {
+        std::fprintf(stderr, "ERROR: cannot open %s\n", in_path.c_str());
+        return (1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    while ((count = std::fread(block.data(), sizeof(uint64_t), BLOCK_WORDS, file)) > 0) {
+        checker.check(block.data(), count);
+    }
+    const double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (file != stdin) {
+        std::fclose(file);
+    }
+
+    const prbs_stats &stats = checker.stats();
+    print_stats(stats, checker.locked());
+    std::printf("%.2f Gb/s\n", (double)(stats.bits_checked + stats.bits_unlocked) / elapsed_s / 1e9);
+
+    return (checker.locked() ? 0 : 2);
+}
+
+static int run_loopback(const prbs_order order, const uint64_t words, const double ber, const uint64_t slip, const bool invert, const uint32_t seed) {
+
+    prbs_generator generator(order, seed);
+    prbs_channel channel(ber, slip, invert, seed);
+    prbs_checker checker(order);
+    std::vector<uint64_t> block(BLOCK_WORDS);
+    std::vector<uint64_t> line(BLOCK_WORDS);
+
+    for (uint64_t done = 0; done < words; ) {
+        const size_t count = (size_t) std::min<uint64_t>(BLOCK_WORDS, words - done);
+        generator.fill(block.data(), count);
+        checker.check(line.data(), channel.transfer(block.data(), count, line.data()));
+        done += count;
+    }
+
+    const prbs_stats &stats = checker.stats();
+    print_stats(stats, checker.locked());
+    std::printf("Channel injected %llu errors (BER %.3e) and %llu slips\n", (unsigned long long) channel.errors_injected(),
+                (double) channel.errors_injected() / (64.0 * (double) words), (unsigned long long) channel.slips_injected());
+
+    return (checker.locked() ? 0 : 2);
+}
+
+static int run_bench(const double seconds) {
+
+    const prbs_order orders[] = { prbs_order::prbs7, prbs_order::prbs15, prbs_order::prbs23, prbs_order::prbs31 };
+    std::vector<uint64_t> block(BLOCK_WORDS);
+
+    std::printf("Sequence\tGenerate (Gb/s)\tCheck (Gb/s)\n");
+    for (const prbs_order order : orders) {
+
+        prbs_generator generator(order);
+        prbs_checker checker(order);
+        uint64_t generated = 0;
+        uint64_t checked = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+            generator.fill(block.data(), BLOCK_WORDS);
+            generated += BLOCK_WORDS;
+        }
+        const double generate_gbps = 64.0 * (double) generated / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / 1e9;
+
+        // The block is a valid continuation each time round because the generator keeps running
+        start = std::chrono::steady_clock::now();
+        while (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() < seconds) {
+            generator.fill(block.data(), BLOCK_WORDS);
+            checker.check(block.data(), BLOCK_WORDS);
+            checked += BLOCK_WORDS;
+        }
+        const double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double check_gbps = 1.0 / ((total_s / (64.0 * (double) checked / 1e9)) - (1.0 / generate_gbps));
+
+        std::printf("PRBS%u\t\t%.2f\t\t%.2f%s\n", (unsigned) order, generate_gbps, check_gbps,
+                    (checker.locked() && (checker.stats().bit_errors == 0)) ? "" : "\t(checker failed)");
+    }
+
+    return (0);
+}
+
+int main(int argc, char **argv) {
+
+    prbs_order order = prbs_order::prbs31;
+    uint64_t words = 0;
+    double ber = 0.0;
+    uint64_t slip = 0;
+    bool invert = false;
+    uint32_t seed = 0xFFFFFFFF;
+    std::string out_path;
+    std::string in_path;
+    double seconds = 0.5;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+    const std::string mode = argv[1];
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--prbs") == 0) && has_value) {
+            if (!parse_prbs_order(argv[++arg], order)) {
+                usage(argv[0]);
+                return (1);
+            }
+        }
+        else if ((std::strcmp(argv[arg], "--words") == 0) && has_value) {
+            words = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--ber") == 0) && has_value) {
+            ber = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--slip") == 0) && has_value) {
+            slip = std::strtoull(argv[++arg], nullptr, 10);
+        }
+        else if (std::strcmp(argv[arg], "--invert") == 0) {
+            invert = true;
+        }
+        else if ((std::strcmp(argv[arg], "--seed") == 0) && has_value) {
+            seed = (uint32_t) std::strtoul(argv[++arg], nullptr, 0);
+        }
+        else if ((std::strcmp(argv[arg], "--out") == 0) && has_value) {
+            out_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--in") == 0) && has_value) {
+            in_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--seconds") == 0) && has_value) {
+            seconds = std::strtod(argv[++arg], nullptr);
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (mode == "gen") {
+        return (run_gen(order, words, ber, slip, invert, seed, out_path));
+    }
+    else if (mode == "check") {
+        return (run_check(order, in_path));
+    }
+    else if (mode == "loopback") {
+        return (run_loopback(order, (words > 0) ? words : (16 * 1024 * 1024), ber, slip, invert, seed));
+    }
+    else if (mode == "bench") {
+        return (run_bench(seconds));
+    }
+
+    usage(argv[0]);
+    return (1);
+}
@@ -0,0 +1,340 @@
+// Capstone Host Tools - PRBS Generator/Checker
+// Table driven PRBS7/15/23/31 streams, 64 bits per step, for QSFP/GTX bit error rate tests
+
+/*
+*  A bit serial LFSR costs a few operations per bit, far too slow for the volumes an eye/BER sweep produces. The
+*  next 64 bits of a sequence are a linear (GF(2)) function of its last degree bits, so they are precomputed for
+*  every value of every state byte: one step is at most four lookups and XORs for 64 bits, and the new state is just
+*  the top bits of the word. The tables take 8 kB at most and stay in L1.
+*
+*  The checker does not need its own sequence while the line is clean: a received word that matches the prediction
+*  from the word before it is correct, and predicts the next one. Those steps are independent of each other, so the
+*  core overlaps them. Only words with errors fall back to the free running local sequence.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <cmath>
+#include "prbs.hpp"
+
+/* Functions */
+
+// Second tap of each polynomial (x^degree + x^tap + 1)
+static unsigned prbs_tap(const prbs_order order) {
+
+    switch (order) {
+        case prbs_order::prbs7:
+            return (6);
+        case prbs_order::prbs15:
+            return (14);
+        case prbs_order::prbs23:
+            return (18);
+        default:
+            return (28);
+    }
+}
+
+// Reference bit serial LFSR, only used to fill the tables
+static uint64_t serial_word(const prbs_order order, uint32_t state) {
+
+    const unsigned degree = (unsigned) order;
+    const unsigned tap = prbs_tap(order);
+    uint64_t word = 0;
+
+    for (unsigned bit = 0; bit < 64; bit++) {
+        // b[n] = b[n - tap] ^ b[n - degree], bit j of the state being b[n - degree + j]
+        const uint32_t next = ((state >> (degree - tap)) ^ state) & 0x1;
+        word |= (uint64_t) next << bit;
+        state = (state >> 1) | (next << (degree - 1));
+    }
+
+    return (word);
+}
+
+bool parse_prbs_order(const std::string &name, prbs_order &order) {
+
+    const std::string digits = (name.compare(0, 4, "prbs") == 0) ? name.substr(4) : name;
+
+    if (digits == "7") {
+        order = prbs_order::prbs7;
+    }
+    else if (digits == "15") {
+        order = prbs_order::prbs15;
+    }
+    else if (digits == "23") {
+        order = prbs_order::prbs23;
+    }
+    else if (digits == "31") {
+        order = prbs_order::prbs31;
+    }
+    else {
+        return (false);
+    }
+
+    return (true);
+}
+
+/* Tables */
+
+prbs_table::prbs_table(const prbs_order order) : poly(order), num_bytes(((unsigned) order + 7) / 8), bytes {} {
+
+    uint64_t basis[32] = {};
+
+    for (unsigned bit = 0; bit < degree(); bit++) {
+        basis[bit] = serial_word(order, (uint32_t) 1 << bit);
+    }
+
+    for (unsigned byte = 0; byte < num_bytes; byte++) {
+        for (unsigned value = 0; value < 256; value++) {
+            uint64_t word = 0;
+            for (unsigned bit = 0; bit < 8; bit++) {
+                if ((value & (1u << bit)) && (((8 * byte) + bit) < degree())) {
+                    word ^= basis[(8 * byte) + bit];
+                }
+            }
+            bytes[byte][value] = word;
+        }
+    }
+}
+
+/* Generator */
+
+prbs_generator::prbs_generator(const prbs_order order, const uint32_t seed) : table(order) {
+
+    const uint32_t mask = (uint32_t)(((uint64_t) 1 << table.degree()) - 1);
+
+    state = ((seed & mask) != 0) ? (seed & mask) : mask;
+}
+
+void prbs_generator::fill(uint64_t *words, const size_t num_words) {
+
+    uint32_t current = state;
+
+    for (size_t index = 0; index < num_words; index++) {
+        const uint64_t word = table.next(current);
+        words[index] = word;
+        current = table.state_after(word);
+    }
+
+    state = current;
+}
+
+/* Checker */
+
+double prbs_stats::ber_upper_bound(const double confidence) const {
+
+    if (bits_checked == 0) {
+        return (1.0);
+    }
+
+    // Largest mean error count that still gives at most bit_errors errors with probability 1 - confidence
+    const double target = 1.0 - confidence;
+
+    // Plenty of errors: normal approximation (the exact sum underflows past a few hundred)
+    if (bit_errors > 500) {
+        double z_low = 0.0;
+        double z_high = 10.0;
+        for (unsigned step = 0; step < 60; step++) {
+            const double z = (z_low + z_high) / 2.0;
+            if ((0.5 * std::erfc(z / std::sqrt(2.0))) > target) {
+                z_low = z;
+            }
+            else {
+                z_high = z;
+            }
+        }
+        return (((double) bit_errors + (z_high * std::sqrt((double) bit_errors)) + 1.0) / (double) bits_checked);
+    }
+
+    double low = (double) bit_errors;
+    double high = (double) bit_errors + 10.0 + (10.0 * std::sqrt((double) bit_errors + 1.0));
+
+    for (unsigned step = 0; step < 100; step++) {
+        const double mean = (low + high) / 2.0;
+        double term = std::exp(-mean);
+        double cumulative = term;
+        for (uint64_t count = 1; count <= bit_errors; count++) {
+            term *= mean / (double) count;
+            cumulative += term;
+        }
+        if (cumulative > target) {
+            low = mean;
+        }
+        else {
+            high = mean;
+        }
+    }
+
+    return (high / (double) bits_checked);
+}
+
+prbs_checker::prbs_checker(const prbs_order order, const unsigned lock_words, const unsigned lock_window, const double loss_ber)
+    : table(order), lock_words((lock_words > 0) ? lock_words : 1), lock_window((lock_window > 0) ? lock_window : 1),
+      loss_errors((uint64_t)(loss_ber * 64.0 * this->lock_window)) {
+}
+
+void prbs_checker::check(const uint64_t *words, const size_t num_words) {
+
+    size_t index = 0;
+
+    while (index < num_words) {
+
+        // Acquire: seed from the stream in both polarities and wait for lock_words correct predictions in a row
+        if (!is_locked) {
+
+            const uint64_t word = words[index++];
+
+            counters.bits_unlocked += 64;
+            if (have_seed) {
+                const uint64_t predicted = table.next(state);
+                if ((predicted ^ flip) == word) {
+                    state = table.state_after(predicted);
+                    if (++matches >= lock_words) {
+                        is_locked = true;
+                        counters.inverted = (flip != 0);
+                        window_words = 0;
+                        window_errors = 0;
+                        last_window_words = 0;
+                        last_window_errors = 0;
+                    }
+                    continue;
+                }
+                // Try the other polarity on the next word before reseeding in this one
+                if ((matches == 0) && (flip == 0)) {
+                    flip = ~(uint64_t) 0;
+                    state = table.state_after(word ^ flip);
+                    continue;
+                }
+            }
+
+            flip = 0;
+            state = table.state_after(word);
+            matches = 0;
+            have_seed = true;
+            continue;
+        }
+
+        // Locked: compare against the local sequence
+        const size_t run = std::min<size_t>(num_words - index, lock_window - window_words);
+        const uint64_t *line = words + index;
+        uint32_t current = state;
+        uint64_t errors = 0;
+        size_t word = 0;
+
+        while (word < run) {
+
+            const uint64_t expected = table.next(current);
+
+            if (expected == (line[word] ^ flip)) {
+                // Clean so far: every received word predicts the next one, so iterations do not wait on each other
+                word++;
+                while ((word < run) && (table.next(table.state_after(line[word - 1] ^ flip)) == (line[word] ^ flip))) {
+                    word++;
+                }
+                current = table.state_after(line[word - 1] ^ flip);
+            }
+            else {
+                // Errors: stay on the free running sequence so they are counted once, not fed into the prediction
+                errors += (uint64_t) __builtin_popcountll(expected ^ flip ^ line[word]);
+                current = table.state_after(expected);
+                word++;
+            }
+        }
+
+        state = current;
+        index += run;
+        window_words += (unsigned) run;
+        window_errors += errors;
+        counters.bits_checked += 64 * run;
+        counters.bit_errors += errors;
+
+        if (window_words == lock_window) {
+            if (window_errors > loss_errors) {
+                // This window (and the tail of a slip in the one before) measured a slip or a dead link, not the line BER
+                const uint64_t words_dropped = window_words + last_window_words;
+                counters.bits_checked -= 64 * words_dropped;
+                counters.bit_errors -= window_errors + last_window_errors;
+                counters.bits_unlocked += 64 * words_dropped;
+                counters.lock_losses++;
+                is_locked = false;
+                have_seed = false;
+                window_words = 0;
+                window_errors = 0;
+            }
+            last_window_words = window_words;
+            last_window_errors = window_errors;
+            window_words = 0;
+            window_errors = 0;
+        }
+    }
+}
+
+/* Loopback stand-in */
+
+prbs_channel::prbs_channel(const double ber, const uint64_t slip_bits, const bool invert, const uint64_t seed)
+    : rng(seed), error_rate(ber), slip_period(((slip_bits > 0) && (slip_bits < 64)) ? 64 : slip_bits),
+      invert_mask(invert ? ~(uint64_t) 0 : 0) {
+
+    next_error = draw_gap();
+    next_slip = (slip_period > 0) ? slip_period : UINT64_MAX;
+}
+
+// Bits up to and including the next error
+uint64_t prbs_channel::draw_gap() {
+
+    if (error_rate <= 0.0) {
+        return (UINT64_MAX);
+    }
+    if (error_rate >= 1.0) {
+        return (1);
+    }
+
+    std::geometric_distribution<uint64_t> gap(error_rate);
+    return (gap(rng) + 1);
+}
+
+size_t prbs_channel::transfer(const uint64_t *in, const size_t num_words, uint64_t *out) {
+
+    size_t written = 0;
+
+    for (size_t index = 0; index < num_words; index++) {
+
+        uint64_t word = in[index] ^ invert_mask;
+        unsigned bits = 64;
+
+        // next_error counts from the start of this word (1 is its first bit)
+        while (next_error <= 64) {
+            word ^= (uint64_t) 1 << (next_error - 1);
+            injected++;
+            const uint64_t gap = draw_gap();
+            next_error = (gap > UINT64_MAX - next_error) ? UINT64_MAX : (next_error + gap);
+        }
+        if (next_error != UINT64_MAX) {
+            next_error -= 64;
+        }
+
+        // Drop one bit, the ones above it move down
+        if (next_slip <= 64) {
+            const uint64_t keep = ((uint64_t) 1 << (next_slip - 1)) - 1;
+            word = (word & keep) | ((word >> 1) & ~keep);
+            bits = 63;
+            slips++;
+            next_slip += slip_period;
+        }
+        if (next_slip != UINT64_MAX) {
+            next_slip -= 64;
+        }
+
+        pending |= word << pending_bits;
+        if ((pending_bits + bits) >= 64) {
+            out[written++] = pending;
+            pending = (pending_bits > 0) ? (word >> (64 - pending_bits)) : 0;
+            pending_bits = pending_bits + bits - 64;
+        }
+        else {
+            pending_bits += bits;
+        }
+    }
+
+    return (written);
+}
@@ -0,0 +1,149 @@
+// Capstone Host Tools - PRBS Generator/Checker
+// Table driven PRBS7/15/23/31 streams, 64 bits per step, for QSFP/GTX bit error rate tests
+
+#ifndef PRBS_HPP
+#define PRBS_HPP
+
+/* Libraries */
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+/*
+*  Sequences are the ITU-T O.150 polynomials the GTX transceivers generate and check in hardware:
+*      PRBS7  x^7 + x^6 + 1       PRBS15  x^15 + x^14 + 1
+*      PRBS23 x^23 + x^18 + 1     PRBS31  x^31 + x^28 + 1
+*  Streams are sequences of 64-bit words, bit 0 of a word is the first bit on the line. Files and pipes carry the
+*  words little endian.
+*/
+
+/* Types */
+
+enum class prbs_order : unsigned {
+    prbs7 = 7,
+    prbs15 = 15,
+    prbs23 = 23,
+    prbs31 = 31
+};
+
+// Next 64 bits of a sequence from its last order bits. The map is linear, so it is the XOR of one table entry per state byte
+class prbs_table {
+public:
+    explicit prbs_table(const prbs_order order);
+
+    prbs_order order() const { return (poly); }
+    unsigned degree() const { return ((unsigned) poly); }
+
+    // Word following a state (bit j of state is the bit degree - j places back)
+    uint64_t next(const uint32_t state) const {
+        uint64_t word = bytes[0][state & 0xFF];
+        for (unsigned byte = 1; byte < num_bytes; byte++) {
+            word ^= bytes[byte][(state >> (8 * byte)) & 0xFF];
+        }
+        return (word);
+    }
+
+    // State after a word: its last degree bits
+    uint32_t state_after(const uint64_t word) const { return ((uint32_t)(word >> (64 - degree()))); }
+
+private:
+    prbs_order poly;
+    unsigned num_bytes;
+    std::array<std::array<uint64_t, 256>, 4> bytes;
+};
+
+class prbs_generator {
+public:
+    /* seed must not be zero in its low order bits (the all zero state never leaves zero) */
+    explicit prbs_generator(const prbs_order order, const uint32_t seed = 0xFFFFFFFF);
+
+    void fill(uint64_t *words, const size_t num_words);
+
+private:
+    prbs_table table;
+    uint32_t state;
+};
+
+// Error counters of a checker
+struct prbs_stats {
+    uint64_t bits_checked = 0;                              // Bits compared while locked
+    uint64_t bit_errors = 0;                                // Of those, bits that differed
+    uint64_t bits_unlocked = 0;                             // Bits spent acquiring lock (not checked)
+    uint64_t lock_losses = 0;                               // Times the error rate forced a resync
+    bool inverted = false;                                  // Stream matched with inverted polarity (swapped P/N)
+
+    double ber() const { return ((bits_checked > 0) ? ((double) bit_errors / (double) bits_checked) : 0.0); }
+
+    // BER that is still consistent with the count at the given confidence (Poisson, exact for zero errors)
+    double ber_upper_bound(const double confidence = 0.95) const;
+};
+
+/*
+*  The checker seeds itself from the received stream, then runs its own generator and compares, so a bit error is
+*  counted once instead of being fed back into the prediction. lock_words error free words in a row acquire lock. A
+*  window of lock_window words with more than loss_ber errors (bit slip, wrong sequence, link dropped) loses it again,
+*  and that window and the one before it are taken back out of the counts.
+*/
+class prbs_checker {
+public:
+    explicit prbs_checker(const prbs_order order, const unsigned lock_words = 4, const unsigned lock_window = 64, const double loss_ber = 0.1);
+
+    void check(const uint64_t *words, const size_t num_words);
+    bool locked() const { return (is_locked); }
+    const prbs_stats &stats() const { return (counters); }
+
+private:
+    prbs_table table;
+    prbs_stats counters;
+    unsigned lock_words;
+    unsigned lock_window;
+    uint64_t loss_errors;                                   // Errors in a window that lose lock
+    bool is_locked = false;
+    bool have_seed = false;
+    uint64_t flip = 0;                                      // All ones while the stream is inverted
+    uint32_t state = 0;
+    unsigned matches = 0;                                   // Consecutive matching words while acquiring
+    unsigned window_words = 0;
+    uint64_t window_errors = 0;
+    unsigned last_window_words = 0;                         // Previous window, dropped along with a window that loses lock
+    uint64_t last_window_errors = 0;
+};
+
+/*
+*  Loopback stand-in for the optical link: passes words through with random bit errors at a set BER, optional
+*  inversion and optional bit slips (one bit dropped every slip_bits bits).
+*/
+class prbs_channel {
+public:
+    prbs_channel(const double ber, const uint64_t slip_bits = 0, const bool invert = false, const uint64_t seed = 1);
+
+    /* Push num_words words through the channel. Returns the number of words written to out (at most num_words,
+    fewer while slips are eating bits) */
+    size_t transfer(const uint64_t *in, const size_t num_words, uint64_t *out);
+
+    uint64_t errors_injected() const { return (injected); }
+    uint64_t slips_injected() const { return (slips); }
+
+private:
+    uint64_t draw_gap();
+
+    std::mt19937_64 rng;
+    double error_rate;
+    uint64_t slip_period;
+    uint64_t invert_mask;
+    uint64_t next_error;                                    // Bits until the next flipped bit
+    uint64_t next_slip;                                     // Bits until the next dropped bit
+    uint64_t pending = 0;                                   // Bits waiting for a full output word
+    unsigned pending_bits = 0;
+    uint64_t injected = 0;
+    uint64_t slips = 0;
+};
+
+/* Functions */
+
+// "7", "prbs7", ... "prbs31"
+bool parse_prbs_order(const std::string &name, prbs_order &order);
+
+#endif
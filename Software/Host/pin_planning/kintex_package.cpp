@@ -0,0 +1,228 @@
+// Capstone Host Tools - Kintex-7 Package Data
+// Ball names, banks, pair structure and package flight times of the XC7K160T-2FFG676I
+
+/*
+*  Two inputs describe the package. The delay CSV is the Vivado export kept in IO_Planning (one "ball,ps" line per
+*  ball, 0 for balls without a flight time). The pinout text file is the AMD package file for the part
+*  (xc7k160tffg676pkg.txt, whitespace separated: Pin, Pin Name, Memory Byte Group, Bank, ...). Pair numbers, P/N
+*  polarity and clock capability are decoded from the 7 series pin names ("IO_L12P_T1_MRCC_33").
+*
+*  IO_0_xx and IO_25_xx are the VRN/VRP pins on HP banks. They are flagged as reserved on every bank, HR included,
+*  following Documentation/FPGA/Kintex_pin_planning.txt.
+*/
+
+/* Libraries */
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include "kintex_package.hpp"
+
+/* Functions */
+
+package_pin &kintex_package::get_or_add(const std::string &ball) {
+
+    auto found = index.find(ball);
+
+    if (found != index.end()) {
+        return (pins[found->second]);
+    }
+
+    index[ball] = pins.size();
+    pins.emplace_back();
+    pins.back().ball = ball;
+    return (pins.back());
+}
+
+// Trim spaces, tabs and a trailing CR
+static std::string trim(const std::string &text) {
+
+    const size_t first = text.find_first_not_of(" \t\r");
+    const size_t last = text.find_last_not_of(" \t\r");
+
+    if (first == std::string::npos) {
+        return ("");
+    }
+    return (text.substr(first, last - first + 1));
+}
+
+bool kintex_package::load_delays(const std::string &path, std::string &error) {
+
+    std::ifstream file(path);
+    std::string line;
+    size_t line_number = 0;
+
+    if (!file) {
+        error = "cannot open " + path;
+        return (false);
+    }
+
+    while (std::getline(file, line)) {
+
+        line_number++;
+        line = trim(line);
+        if (line.empty() || (line[0] == '#')) {
+            continue;
+        }
+
+        const size_t comma = line.find(',');
+        if (comma == std::string::npos) {
+            error = path + ":" + std::to_string(line_number) + ": expected ball,delay_ps";
+            return (false);
+        }
+
+        const std::string ball = trim(line.substr(0, comma));
+        const std::string value = trim(line.substr(comma + 1));
+        char *end = nullptr;
+        const double delay = std::strtod(value.c_str(), &end);
+
+        // Tolerate a header line
+        if ((end == value.c_str()) && (line_number == 1)) {
+            continue;
+        }
+        if (end == value.c_str()) {
+            error = path + ":" + std::to_string(line_number) + ": bad delay '" + value + "'";
+            return (false);
+        }
+
+        package_pin &pin = get_or_add(ball);
+        pin.delay_ps = delay;
+        pin.has_delay = (delay > 0.0);
+    }
+
+    return (true);
+}
+
+// Decode "IO_L<nn><P|N>_T<n>[_<function>...]_<bank>" style names
+static void decode_pin_name(package_pin &pin) {
+
+    std::vector<std::string> fields;
+    std::stringstream stream(pin.name);
+    std::string field;
+
+    while (std::getline(stream, field, '_')) {
+        fields.push_back(field);
+    }
+
+    if ((fields.size() < 3) || (fields[0] != "IO")) {
+        return;
+    }
+
+    // Pair member
+    if ((fields[1].size() >= 3) && (fields[1][0] == 'L')) {
+        const char polarity = fields[1].back();
+        if ((polarity == 'P') || (polarity == 'N')) {
+            pin.pair = std::atoi(fields[1].substr(1, fields[1].size() - 2).c_str());
+            pin.positive = (polarity == 'P');
+        }
+    }
+    // Single ended IO_0 / IO_25 (VRN/VRP on HP banks)
+    else if ((fields[1] == "0") || (fields[1] == "25")) {
+        pin.vr_reserved = true;
+    }
+
+    for (const std::string &function : fields) {
+        pin.mrcc |= (function == "MRCC");
+        pin.srcc |= (function == "SRCC");
+        pin.vr_reserved |= ((function == "VRN") || (function == "VRP"));
+    }
+}
+
+bool kintex_package::load_pinout(const std::string &path, std::string &error) {
+
+    std::ifstream file(path);
+    std::string line;
+
+    if (!file) {
+        error = "cannot open " + path;
+        return (false);
+    }
+
+    while (std::getline(file, line)) {
+
+        std::stringstream stream(line);
+        std::string ball, name, byte_group, bank, vccaux, slr, io_type;
+
+        // Every pin row has at least Pin, Pin Name, Memory Byte Group and Bank
+        if (!(stream >> ball >> name >> byte_group >> bank)) {
+            continue;
+        }
+        if ((ball == "Pin") || (ball == "Device/Package") || (ball == "Total")) {
+            continue;
+        }
+        stream >> vccaux >> slr >> io_type;
+
+        package_pin &pin = get_or_add(ball);
+        pin.name = name;
+        pin.bank = (bank == "NA") ? -1 : std::atoi(bank.c_str());
+        pin.io_type = io_type;
+        decode_pin_name(pin);
+    }
+
+    if (pins.empty()) {
+        error = path + ": no pins found";
+        return (false);
+    }
+
+    pinout_loaded = true;
+    return (true);
+}
+
+const package_pin *kintex_package::find(const std::string &ball) const {
+
+    auto found = index.find(ball);
+
+    return ((found == index.end()) ? nullptr : &pins[found->second]);
+}
+
+std::vector<package_pair> kintex_package::pairs_in_bank(const int bank) const {
+
+    std::vector<package_pair> pairs;
+    std::unordered_map<int, size_t> by_number;
+
+    for (const package_pin &pin : pins) {
+
+        if ((pin.bank != bank) || (pin.pair < 0)) {
+            continue;
+        }
+
+        auto found = by_number.find(pin.pair);
+        if (found == by_number.end()) {
+            by_number[pin.pair] = pairs.size();
+            pairs.emplace_back();
+            pairs.back().bank = bank;
+            pairs.back().number = pin.pair;
+            found = by_number.find(pin.pair);
+        }
+
+        package_pair &pair = pairs[found->second];
+        (pin.positive ? pair.p : pair.n) = &pin;
+        pair.clock_capable |= (pin.mrcc || pin.srcc);
+    }
+
+    // Drop anything that is not a complete pair
+    std::vector<package_pair> complete;
+    for (const package_pair &pair : pairs) {
+        if ((pair.p != nullptr) && (pair.n != nullptr)) {
+            complete.push_back(pair);
+        }
+    }
+
+    return (complete);
+}
+
+package_pair kintex_package::pair_of(const std::string &ball) const {
+
+    const package_pin *pin = find(ball);
+
+    if ((pin == nullptr) || (pin->pair < 0)) {
+        return (package_pair());
+    }
+
+    for (const package_pair &pair : pairs_in_bank(pin->bank)) {
+        if (pair.number == pin->pair) {
+            return (pair);
+        }
+    }
+
+    return (package_pair());
+}
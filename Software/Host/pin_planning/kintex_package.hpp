@@ -0,0 +1,70 @@
+// Capstone Host Tools - Kintex-7 Package Data
+// Ball names, banks, pair structure and package flight times of the XC7K160T-2FFG676I
+
+#ifndef KINTEX_PACKAGE_HPP
+#define KINTEX_PACKAGE_HPP
+
+/* Libraries */
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/* Types */
+
+// One package ball
+struct package_pin {
+    std::string ball;                                       // Ball name ("A3")
+    std::string name;                                       // Pin name from the package file ("IO_L1P_T0_12"), empty if only delays are known
+    std::string io_type;                                    // HP, HR, GTX, CONFIG, ... (empty if unknown)
+    int bank = -1;                                          // I/O bank, -1 if unknown or not an I/O
+    int pair = -1;                                          // Differential pair number (the XX in IO_LXX), -1 if not part of a pair
+    bool positive = false;                                  // P side of its pair
+    bool mrcc = false;                                      // Multi-region clock capable
+    bool srcc = false;                                      // Single-region clock capable
+    bool vr_reserved = false;                               // VRP/VRN pin, kept free for DCI termination
+    double delay_ps = 0.0;                                  // Package flight time (in ps)
+    bool has_delay = false;                                 // delay_ps came from the delay CSV
+};
+
+// A P/N pair of balls in one bank
+struct package_pair {
+    const package_pin *p = nullptr;                         // P side
+    const package_pin *n = nullptr;                         // N side
+    int bank = -1;                                          // Bank of both balls
+    int number = -1;                                        // Pair number within the bank
+    bool clock_capable = false;                             // MRCC or SRCC pair
+};
+
+// Package description built from the Vivado delay export and (optionally) the AMD package pinout file
+class kintex_package {
+public:
+    /* Load "ball,delay_ps" lines (IO_Planning/XC7K160T-2FFG676I_Package_Delays.csv). Returns false and sets error on failure */
+    bool load_delays(const std::string &path, std::string &error);
+
+    /* Load the AMD package pinout text file (xc7k160tffg676pkg.txt) for pin names, banks and pairs */
+    bool load_pinout(const std::string &path, std::string &error);
+
+    // Ball lookup, nullptr if the ball is unknown
+    const package_pin *find(const std::string &ball) const;
+
+    // Every complete P/N pair in a bank (needs the pinout file)
+    std::vector<package_pair> pairs_in_bank(const int bank) const;
+
+    // Pair containing a ball, pair.p is nullptr if the ball is not part of a complete pair
+    package_pair pair_of(const std::string &ball) const;
+
+    // True once the pinout file has been loaded
+    bool has_pinout() const { return (pinout_loaded); }
+
+    // Every known ball
+    const std::vector<package_pin> &all_pins() const { return (pins); }
+
+private:
+    package_pin &get_or_add(const std::string &ball);
+
+    std::vector<package_pin> pins;                          // Every ball seen in either file
+    std::unordered_map<std::string, size_t> index;          // Ball name to position in pins
+    bool pinout_loaded = false;                             // load_pinout() succeeded
+};
+
+#endif
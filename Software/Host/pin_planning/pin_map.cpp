@@ -0,0 +1,107 @@
+// Capstone Host Tools - FPGA Pin Map
+// Board level signal to ball assignments with routed lengths
+
+/* Libraries */
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include "pin_map.hpp"
+
+/* Pin map format */
+static const char PIN_MAP_HEADER[] = "net,bus,lane,ball_p,ball_n,length_p_mm,length_n_mm,iostandard,diff_term";
+static const size_t PIN_MAP_COLUMNS = 9;
+
+/* Functions */
+
+static std::vector<std::string> split_csv(const std::string &line) {
+
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+
+    while (std::getline(stream, field, ',')) {
+        const size_t first = field.find_first_not_of(" \t\r");
+        const size_t last = field.find_last_not_of(" \t\r");
+        fields.push_back((first == std::string::npos) ? "" : field.substr(first, last - first + 1));
+    }
+
+    // A trailing empty column has no text after the last comma
+    if (!line.empty() && (line.back() == ',')) {
+        fields.push_back("");
+    }
+
+    return (fields);
+}
+
+bool load_pin_map(const std::string &path, std::vector<pin_assignment> &map, std::string &error) {
+
+    std::ifstream file(path);
+    std::string line;
+    size_t line_number = 0;
+    bool header_seen = false;
+
+    if (!file) {
+        error = "cannot open " + path;
+        return (false);
+    }
+
+    map.clear();
+    while (std::getline(file, line)) {
+
+        line_number++;
+        if ((line.find_first_not_of(" \t\r") == std::string::npos) || (line[0] == '#')) {
+            continue;
+        }
+        if (!header_seen) {
+            header_seen = true;
+            continue;
+        }
+
+        std::vector<std::string> fields = split_csv(line);
+        if (fields.size() < 4) {
+            error = path + ":" + std::to_string(line_number) + ": expected at least net,bus,lane,ball_p";
+            return (false);
+        }
+        fields.resize(PIN_MAP_COLUMNS);
+
+        pin_assignment assignment;
+        assignment.net = fields[0];
+        assignment.bus = fields[1];
+        assignment.lane = fields[2];
+        assignment.ball_p = fields[3];
+        assignment.ball_n = fields[4];
+        assignment.length_p_mm = std::strtod(fields[5].c_str(), nullptr);
+        assignment.length_n_mm = std::strtod(fields[6].c_str(), nullptr);
+        assignment.iostandard = fields[7];
+        assignment.diff_term = ((fields[8] == "1") || (fields[8] == "TRUE") || (fields[8] == "true"));
+
+        if (assignment.net.empty() || assignment.ball_p.empty()) {
+            error = path + ":" + std::to_string(line_number) + ": net and ball_p are required";
+            return (false);
+        }
+
+        map.push_back(assignment);
+    }
+
+    return (true);
+}
+
+bool save_pin_map(const std::string &path, const std::vector<pin_assignment> &map, std::string &error) {
+
+    std::ofstream file(path);
+
+    if (!file) {
+        error = "cannot write " + path;
+        return (false);
+    }
+
+    file << PIN_MAP_HEADER << "\n";
+    for (const pin_assignment &assignment : map) {
+        file << assignment.net << "," << assignment.bus << "," << assignment.lane << ","
+             << assignment.ball_p << "," << assignment.ball_n << ","
+             << assignment.length_p_mm << "," << assignment.length_n_mm << ","
+             << assignment.iostandard << "," << (assignment.diff_term ? "TRUE" : "FALSE") << "\n";
+    }
+
+    return (static_cast<bool>(file));
+}
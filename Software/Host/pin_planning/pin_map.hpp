@@ -0,0 +1,39 @@
+// Capstone Host Tools - FPGA Pin Map
+// Board level signal to ball assignments with routed lengths
+
+#ifndef PIN_MAP_HPP
+#define PIN_MAP_HPP
+
+/* Libraries */
+#include <string>
+#include <vector>
+
+/* Types */
+
+// One FPGA port (a differential pair, or a single ended signal when ball_n is empty)
+struct pin_assignment {
+    std::string net;                                        // Top level port name without _P/_N ("ADC0_D3")
+    std::string bus;                                        // Bus the port belongs to ("ADC0"), skew is computed per bus
+    std::string lane;                                       // "CLK" for the bus clock, "OVR" for out-of-range, otherwise the data lane number
+    std::string ball_p;                                     // Ball of the P side (or the single ended signal)
+    std::string ball_n;                                     // Ball of the N side, empty for single ended signals
+    double length_p_mm = 0.0;                               // Routed board length of the P side (in mm)
+    double length_n_mm = 0.0;                               // Routed board length of the N side (in mm)
+    std::string iostandard;                                 // IOSTANDARD for the constraints ("LVDS_25"), empty to use the bank default
+    bool diff_term = false;                                 // Enable the internal 100R differential termination
+
+    bool differential() const { return (!ball_n.empty()); }
+    bool is_clock() const { return (lane == "CLK"); }
+};
+
+/* Functions */
+
+/* Load a pin map CSV. The first non-comment line is the header:
+net,bus,lane,ball_p,ball_n,length_p_mm,length_n_mm,iostandard,diff_term
+Lines starting with # are ignored. Returns false and sets error on failure */
+bool load_pin_map(const std::string &path, std::vector<pin_assignment> &map, std::string &error);
+
+/* Write a pin map CSV in the same format load_pin_map() reads */
+bool save_pin_map(const std::string &path, const std::vector<pin_assignment> &map, std::string &error);
+
+#endif
@@ -0,0 +1,379 @@
+// Capstone Host Tools - ADC Bus Pin Assignment Optimizer
+// Rule-legal, minimum skew bank and pin assignment for the ADC LVDS buses
+
+/*
+*  The search is split in two levels.
+*
+*  Inside one bank the order in which data lanes land on pairs does not change the skew, only which pairs are used.
+*  With the free data pairs sorted by delay the best set for a bus is always a run of consecutive pairs, so trying
+*  every clock capable pair as the clock against every window of the sorted list is exact and takes microseconds.
+*  Buses sharing a bank are packed one after the other, every packing order is tried and the best kept.
+*
+*  Across banks the cost of every (bank, set of buses) combination is independent, so that table is filled by all
+*  cores in parallel. The buses are then partitioned over the banks with an exact subset DP over that table.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include "pin_optimizer.hpp"
+
+/* Types */
+
+// Free resources of one bank
+struct bank_resources {
+    int bank = -1;                                          // Bank number
+    bool high_performance = false;                          // HP bank (1.8 V LVDS), otherwise HR (LVDS_25)
+    std::vector<package_pair> clock_pairs;                  // Free MRCC/SRCC pairs
+    std::vector<package_pair> data_pairs;                   // Free other pairs, sorted by delay
+};
+
+// Where one bus goes inside its bank
+struct bus_fit {
+    double skew_ps = std::numeric_limits<double>::infinity();
+    size_t clock = 0;                                       // Index into clock_pairs
+    size_t first = 0;                                       // First data_pairs index of the window
+};
+
+// Best packing of a set of buses into one bank
+struct bank_packing {
+    double cost = std::numeric_limits<double>::infinity();  // Sum of bus skews, infinite if the set does not fit
+    std::vector<std::pair<unsigned, bus_fit>> fits;         // (request, placement) in packing order
+    std::vector<std::vector<bool>> data_used;               // data_pairs taken before each bus was placed (for replay)
+};
+
+/* Functions */
+
+static double pair_delay(const package_pair &pair) {
+    return ((pair.p->delay_ps + pair.n->delay_ps) / 2.0);
+}
+
+bool parse_bus_request(const std::string &text, bus_request &request, std::string &error) {
+
+    const size_t equals = text.find('=');
+    std::string variant;
+
+    if ((equals == std::string::npos) || (equals == 0)) {
+        error = "bus '" + text + "' must look like NAME=VARIANT[+ovr]";
+        return (false);
+    }
+
+    request.name = text.substr(0, equals);
+    variant = text.substr(equals + 1);
+    request.ovr = false;
+    if ((variant.size() > 4) && (variant.compare(variant.size() - 4, 4, "+ovr") == 0)) {
+        request.ovr = true;
+        variant.erase(variant.size() - 4);
+    }
+
+    // AD/TI DDR LVDS and Renesas SDR mode (Documentation/FPGA/Kintex_pin_planning.txt)
+    if (variant == "ddr14") {
+        request.data_pairs = 7;
+    }
+    else if (variant == "ddr16") {
+        request.data_pairs = 8;
+    }
+    else if (variant == "sdr14") {
+        request.data_pairs = 14;
+    }
+    else {
+        error = "unknown bus variant '" + variant + "' (ddr14, ddr16 or sdr14)";
+        return (false);
+    }
+
+    request.variant = variant;
+    return (true);
+}
+
+// Pairs a bus needs besides its clock (the OVR output takes one side of a pair)
+static size_t window_size(const bus_request &request) {
+    return (request.data_pairs + (request.ovr ? 1 : 0));
+}
+
+// Best clock + window for one bus among the pairs still free. Exact for a single bus
+static bus_fit fit_bus(const bank_resources &bank, const bus_request &request, const std::vector<bool> &clock_used,
+                       const std::vector<bool> &data_used) {
+
+    std::vector<size_t> free_data;
+    const size_t window = window_size(request);
+    bus_fit best;
+
+    for (size_t index = 0; index < bank.data_pairs.size(); index++) {
+        if (!data_used[index]) {
+            free_data.push_back(index);
+        }
+    }
+    if (free_data.size() < window) {
+        return (best);
+    }
+
+    for (size_t clock = 0; clock < bank.clock_pairs.size(); clock++) {
+
+        if (clock_used[clock]) {
+            continue;
+        }
+
+        const double clock_ps = pair_delay(bank.clock_pairs[clock]);
+        for (size_t start = 0; start + window <= free_data.size(); start++) {
+
+            const double lo = std::min(clock_ps, pair_delay(bank.data_pairs[free_data[start]]));
+            const double hi = std::max(clock_ps, pair_delay(bank.data_pairs[free_data[start + window - 1]]));
+
+            if ((hi - lo) < best.skew_ps) {
+                best.skew_ps = hi - lo;
+                best.clock = clock;
+                best.first = start;
+            }
+        }
+    }
+
+    return (best);
+}
+
+// Mark the pairs of a fitted bus as used. The window is over the free pairs at the time of the fit
+static void take_fit(const bus_request &request, const bus_fit &fit, std::vector<bool> &clock_used, std::vector<bool> &data_used,
+                     std::vector<size_t> *taken) {
+
+    size_t free_index = 0;
+    const size_t window = window_size(request);
+
+    clock_used[fit.clock] = true;
+    for (size_t index = 0; index < data_used.size(); index++) {
+        if (data_used[index]) {
+            continue;
+        }
+        if ((free_index >= fit.first) && (free_index < fit.first + window)) {
+            data_used[index] = true;
+            if (taken != nullptr) {
+                taken->push_back(index);
+            }
+        }
+        free_index++;
+    }
+}
+
+// Best packing of the buses in mask into one bank, trying every packing order for small sets
+static bank_packing pack_bank(const bank_resources &bank, const std::vector<bus_request> &requests, const unsigned mask) {
+
+    std::vector<unsigned> order;
+    bank_packing best;
+    size_t pairs_needed = 0;
+
+    for (unsigned request = 0; request < requests.size(); request++) {
+        if (mask & (1u << request)) {
+            order.push_back(request);
+            pairs_needed += window_size(requests[request]);
+        }
+    }
+
+    // Quick capacity check before any fitting
+    if ((order.size() > bank.clock_pairs.size()) || (pairs_needed > bank.data_pairs.size())) {
+        return (best);
+    }
+
+    do {
+        std::vector<bool> clock_used(bank.clock_pairs.size(), false);
+        std::vector<bool> data_used(bank.data_pairs.size(), false);
+        bank_packing trial;
+
+        trial.cost = 0.0;
+        for (const unsigned request : order) {
+            const bus_fit fit = fit_bus(bank, requests[request], clock_used, data_used);
+            if (std::isinf(fit.skew_ps)) {
+                trial.cost = std::numeric_limits<double>::infinity();
+                break;
+            }
+            trial.fits.emplace_back(request, fit);
+            trial.data_used.push_back(data_used);
+            trial.cost += fit.skew_ps;
+            take_fit(requests[request], fit, clock_used, data_used, nullptr);
+        }
+
+        if (trial.cost < best.cost) {
+            best = trial;
+        }
+    } while ((order.size() <= PIN_PLAN_MAX_SHARED) && std::next_permutation(order.begin(), order.end()));
+
+    return (best);
+}
+
+// Collect the free resources of a bank
+static bool load_bank(const kintex_package &package, const int bank_number, const plan_options &options, bank_resources &bank) {
+
+    bank.bank = bank_number;
+    for (const package_pair &pair : package.pairs_in_bank(bank_number)) {
+
+        if (options.reserved_balls.count(pair.p->ball) || options.reserved_balls.count(pair.n->ball) ||
+            pair.p->vr_reserved || pair.n->vr_reserved || !pair.p->has_delay || !pair.n->has_delay) {
+            continue;
+        }
+
+        bank.high_performance = (pair.p->io_type == "HP");
+        (pair.clock_capable ? bank.clock_pairs : bank.data_pairs).push_back(pair);
+    }
+
+    std::sort(bank.data_pairs.begin(), bank.data_pairs.end(), [](const package_pair &a, const package_pair &b) {
+        return (pair_delay(a) < pair_delay(b));
+    });
+
+    return (!bank.clock_pairs.empty() || !bank.data_pairs.empty());
+}
+
+// Turn a bus placement into pin map lines
+static void emit_bus(const bank_resources &bank, const bus_request &request, const bus_fit &fit, std::vector<bool> data_used,
+                     std::vector<pin_assignment> &map) {
+
+    std::vector<bool> clock_used(bank.clock_pairs.size(), false);
+    std::vector<size_t> taken;
+    const std::string lvds = bank.high_performance ? "LVDS" : "LVDS_25";
+    const std::string cmos = bank.high_performance ? "LVCMOS18" : "LVCMOS25";
+    const package_pair &clock = bank.clock_pairs[fit.clock];
+
+    take_fit(request, fit, clock_used, data_used, &taken);
+
+    // The OVR output takes the pair whose P ball is closest to the middle of the window, data lanes go in pair order
+    size_t ovr_slot = taken.size();
+    if (request.ovr) {
+        const double middle = (pair_delay(bank.data_pairs[taken.front()]) + pair_delay(bank.data_pairs[taken.back()])) / 2.0;
+        double closest = std::numeric_limits<double>::infinity();
+        for (size_t slot = 0; slot < taken.size(); slot++) {
+            const double distance = std::fabs(bank.data_pairs[taken[slot]].p->delay_ps - middle);
+            if (distance < closest) {
+                closest = distance;
+                ovr_slot = slot;
+            }
+        }
+    }
+
+    std::vector<const package_pair *> data;
+    for (size_t slot = 0; slot < taken.size(); slot++) {
+        if (slot != ovr_slot) {
+            data.push_back(&bank.data_pairs[taken[slot]]);
+        }
+    }
+    std::sort(data.begin(), data.end(), [](const package_pair *a, const package_pair *b) { return (a->number < b->number); });
+
+    map.push_back({ request.name + "_CLK", request.name, "CLK", clock.p->ball, clock.n->ball, 0.0, 0.0, lvds, true });
+    for (size_t lane = 0; lane < data.size(); lane++) {
+        map.push_back({ request.name + "_D" + std::to_string(lane), request.name, std::to_string(lane),
+                        data[lane]->p->ball, data[lane]->n->ball, 0.0, 0.0, lvds, true });
+    }
+    if (ovr_slot < taken.size()) {
+        map.push_back({ request.name + "_OVR", request.name, "OVR", bank.data_pairs[taken[ovr_slot]].p->ball, "", 0.0, 0.0, cmos, false });
+    }
+}
+
+bool plan_pins(const kintex_package &package, const std::vector<bus_request> &requests, const plan_options &options,
+               pin_plan &plan, std::string &error) {
+
+    std::vector<bank_resources> banks;
+    std::vector<int> bank_numbers = options.banks;
+    const unsigned num_requests = (unsigned) requests.size();
+    const unsigned num_masks = 1u << num_requests;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    if (!package.has_pinout()) {
+        error = "the optimizer needs the package pinout (--pkg)";
+        return (false);
+    }
+    if ((num_requests == 0) || (num_requests > PIN_PLAN_MAX_BUSES)) {
+        error = "between 1 and " + std::to_string(PIN_PLAN_MAX_BUSES) + " buses can be planned at once";
+        return (false);
+    }
+
+    // Default to every bank with select I/O (HP and HR)
+    if (bank_numbers.empty()) {
+        for (const package_pin &pin : package.all_pins()) {
+            if (((pin.io_type == "HP") || (pin.io_type == "HR")) && (pin.pair >= 0) &&
+                (std::find(bank_numbers.begin(), bank_numbers.end(), pin.bank) == bank_numbers.end())) {
+                bank_numbers.push_back(pin.bank);
+            }
+        }
+        std::sort(bank_numbers.begin(), bank_numbers.end());
+    }
+    for (const int number : bank_numbers) {
+        bank_resources bank;
+        if (load_bank(package, number, options, bank)) {
+            banks.push_back(bank);
+        }
+    }
+    if (banks.empty()) {
+        error = "no usable banks";
+        return (false);
+    }
+
+    // Cost of every (bank, bus set) pair, filled in parallel
+    std::vector<bank_packing> table(banks.size() * num_masks);
+    std::atomic<size_t> next_item(0);
+    unsigned num_threads = (options.threads > 0) ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> workers;
+
+    auto worker = [&]() {
+        for (size_t item = next_item++; item < table.size(); item = next_item++) {
+            const unsigned mask = (unsigned)(item % num_masks);
+            if (mask != 0) {
+                table[item] = pack_bank(banks[item / num_masks], requests, mask);
+            }
+            else {
+                table[item].cost = 0.0;
+            }
+        }
+    };
+    for (unsigned thread = 0; thread < num_threads; thread++) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+
+    // Partition the buses over the banks: best[b][mask] = cheapest placement of mask into banks b..end
+    std::vector<std::vector<double>> best(banks.size() + 1, std::vector<double>(num_masks, infinity));
+    std::vector<std::vector<unsigned>> choice(banks.size(), std::vector<unsigned>(num_masks, 0));
+    best[banks.size()][0] = 0.0;
+
+    for (size_t bank = banks.size(); bank-- > 0;) {
+        for (unsigned mask = 0; mask < num_masks; mask++) {
+            // Every subset of mask (including the empty one) may go into this bank
+            for (unsigned subset = mask;; subset = (subset - 1) & mask) {
+                const double cost = table[(bank * num_masks) + subset].cost + best[bank + 1][mask ^ subset];
+                if (cost < best[bank][mask]) {
+                    best[bank][mask] = cost;
+                    choice[bank][mask] = subset;
+                }
+                if (subset == 0) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (std::isinf(best[0][num_masks - 1])) {
+        error = "the buses do not fit the selected banks";
+        return (false);
+    }
+
+    // Replay the choices into a pin map
+    plan.map.clear();
+    plan.bank_of_bus.assign(num_requests, -1);
+    plan.skew_ps.assign(num_requests, 0.0);
+    plan.total_skew_ps = best[0][num_masks - 1];
+
+    unsigned remaining = num_masks - 1;
+    for (size_t bank = 0; bank < banks.size(); bank++) {
+        const unsigned subset = choice[bank][remaining];
+        const bank_packing &packing = table[(bank * num_masks) + subset];
+        for (size_t placed = 0; placed < packing.fits.size(); placed++) {
+            const unsigned request = packing.fits[placed].first;
+            const bus_fit &fit = packing.fits[placed].second;
+            plan.bank_of_bus[request] = banks[bank].bank;
+            plan.skew_ps[request] = fit.skew_ps;
+            emit_bus(banks[bank], requests[request], fit, packing.data_used[placed], plan.map);
+        }
+        remaining ^= subset;
+    }
+
+    return (true);
+}
@@ -0,0 +1,54 @@
+// Capstone Host Tools - ADC Bus Pin Assignment Optimizer
+// Rule-legal, minimum skew bank and pin assignment for the ADC LVDS buses
+
+#ifndef PIN_OPTIMIZER_HPP
+#define PIN_OPTIMIZER_HPP
+
+/* Libraries */
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include "kintex_package.hpp"
+#include "pin_map.hpp"
+
+/* Optimizer limits */
+static const unsigned PIN_PLAN_MAX_BUSES        = 16;       // Buses per plan (the bank partition search is 3^n)
+static const unsigned PIN_PLAN_MAX_SHARED       = 6;        // Buses sharing one bank that get every packing order tried
+
+/* Types */
+
+// One ADC bus to place
+struct bus_request {
+    std::string name;                                       // Bus and net prefix ("ADC0")
+    std::string variant;                                    // ddr14 (7 DP), ddr16 (8 DP) or sdr14 (14 DP), see Kintex_pin_planning.txt
+    unsigned data_pairs = 0;                                // Data pairs implied by the variant
+    bool ovr = false;                                       // Bus has a single ended out-of-range output
+};
+
+// Solver inputs besides the package
+struct plan_options {
+    std::vector<int> banks;                                 // Banks the buses may use (empty: every HP and HR bank)
+    std::unordered_set<std::string> reserved_balls;         // Balls already taken by existing constraints
+    unsigned threads = 0;                                   // Worker threads (0: one per core)
+};
+
+// Solver result
+struct pin_plan {
+    std::vector<pin_assignment> map;                        // Every placed lane, in the pin map format
+    std::vector<int> bank_of_bus;                           // Bank chosen for each request
+    std::vector<double> skew_ps;                            // Package skew of each bus (pair means, clock included)
+    double total_skew_ps = 0.0;                             // Sum of skew_ps, the minimized objective
+};
+
+/* Functions */
+
+/* Parse "NAME=VARIANT[+ovr]", e.g. "ADC0=ddr16+ovr" */
+bool parse_bus_request(const std::string &text, bus_request &request, std::string &error);
+
+/* Find the assignment with the lowest total package skew that follows the bank rules:
+every lane of a bus in one bank, the clock on one of the bank's MRCC/SRCC pairs, data never on clock capable
+pairs, VRN/VRP (IO_0/IO_25) left free. Needs the delays and the pinout loaded */
+bool plan_pins(const kintex_package &package, const std::vector<bus_request> &requests, const plan_options &options,
+               pin_plan &plan, std::string &error);
+
+#endif
@@ -0,0 +1,151 @@
+// Capstone Host Tools - ADC Bus Pin Planner
+// Solves the bank rules for a set of ADC buses and writes the resulting pin map
+
+/*
+*  Usage: pin_plan --delays <package_delays.csv> --pkg <pinout.txt> --bus NAME=VARIANT[+ovr] ... [options]
+*      --banks <list>      Comma separated banks to use (default: every HP and HR bank)
+*      --xpr <file>        Keep the balls locked by the project's XDC files free (IO_Planning/K7160T_2FFG_Planning.xpr)
+*      --xdc <file>        Keep the balls locked by an XDC file free
+*      --threads <n>       Worker threads (default: one per core)
+*      --out <file>        Write the plan as a pin map CSV (for skew_calc and the XDC generator)
+*  Variants: ddr14 (AD/TI 14 bit, 7 DP + CLK), ddr16 (16 bit, 8 DP + CLK), sdr14 (Renesas SDR, 14 DP + CLK)
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "kintex_package.hpp"
+#include "pin_map.hpp"
+#include "pin_optimizer.hpp"
+#include "xdc.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s --delays <package_delays.csv> --pkg <pinout.txt> --bus NAME=ddr14|ddr16|sdr14[+ovr] ...\n"
+                "       [--banks 12,13,...] [--xpr <project.xpr>] [--xdc <file.xdc>] [--threads <n>] [--out <pin_map.csv>]\n", program);
+}
+
+// Add the PACKAGE_PIN balls of an XDC file to the reserved set
+static bool reserve_xdc(const std::string &path, plan_options &options, std::string &error) {
+
+    std::map<std::string, std::string> pins;
+
+    if (!load_xdc_package_pins(path, pins, error)) {
+        return (false);
+    }
+    for (const auto &pin : pins) {
+        options.reserved_balls.insert(pin.second);
+    }
+
+    return (true);
+}
+
+int main(int argc, char **argv) {
+
+    std::string delays_path;
+    std::string pinout_path;
+    std::string out_path;
+    std::string error;
+    std::vector<std::string> xdc_paths;
+    std::vector<bus_request> requests;
+    plan_options options;
+    kintex_package package;
+    pin_plan plan;
+
+    for (int arg = 1; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--delays") == 0) && has_value) {
+            delays_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--pkg") == 0) && has_value) {
+            pinout_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--bus") == 0) && has_value) {
+            bus_request request;
+            if (!parse_bus_request(argv[++arg], request, error)) {
+                std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+                return (1);
+            }
+            requests.push_back(request);
+        }
+        else if ((std::strcmp(argv[arg], "--banks") == 0) && has_value) {
+            std::stringstream list(argv[++arg]);
+            std::string bank;
+            while (std::getline(list, bank, ',')) {
+                options.banks.push_back(std::atoi(bank.c_str()));
+            }
+        }
+        else if ((std::strcmp(argv[arg], "--xpr") == 0) && has_value) {
+            std::vector<std::string> files;
+            if (!xpr_constraint_files(argv[++arg], files, error)) {
+                std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+                return (1);
+            }
+            if (files.empty()) {
+                std::printf("Note: %s has no constraint files, no balls reserved\n", argv[arg]);
+            }
+            xdc_paths.insert(xdc_paths.end(), files.begin(), files.end());
+        }
+        else if ((std::strcmp(argv[arg], "--xdc") == 0) && has_value) {
+            xdc_paths.push_back(argv[++arg]);
+        }
+        else if ((std::strcmp(argv[arg], "--threads") == 0) && has_value) {
+            options.threads = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--out") == 0) && has_value) {
+            out_path = argv[++arg];
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (delays_path.empty() || pinout_path.empty() || requests.empty()) {
+        usage(argv[0]);
+        return (1);
+    }
+
+    if (!package.load_delays(delays_path, error) || !package.load_pinout(pinout_path, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+    for (const std::string &path : xdc_paths) {
+        if (!reserve_xdc(path, options, error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return (1);
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if (!plan_pins(package, requests, options, plan, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-10s %-8s %-6s %-10s\n", "Bus", "Variant", "Bank", "Skew(ps)");
+    for (size_t request = 0; request < requests.size(); request++) {
+        std::printf("%-10s %-8s %-6d %-10.1f\n", requests[request].name.c_str(),
+                    (requests[request].variant + (requests[request].ovr ? "+ovr" : "")).c_str(),
+                    plan.bank_of_bus[request], plan.skew_ps[request]);
+    }
+    std::printf("Total package skew %.1f ps, solved in %.1f ms\n", plan.total_skew_ps, elapsed_ms);
+
+    if (!out_path.empty()) {
+        if (!save_pin_map(out_path, plan.map, error)) {
+            std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+            return (1);
+        }
+        std::printf("Pin map written to %s\n", out_path.c_str());
+    }
+
+    return (0);
+}
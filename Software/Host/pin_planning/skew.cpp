@@ -0,0 +1,213 @@
+// Capstone Host Tools - Bus Skew Model
+// Package plus board flight time per lane, per-bus skew and pin swap evaluation
+
+/*
+*  A lane's delay is the package flight time of its ball plus its routed length times the board propagation
+*  delay, averaged over P and N. Bus skew is the spread of lane delays with the clock included, since the clock is
+*  what the data is captured against.
+*
+*  Swaps keep each lane's board length and only change which ball (and so which package delay) it lands on, which
+*  is how a pinout iteration looks before the bus is re-tuned. A bus has at most 17 lanes and a bank 24 pairs, so
+*  the full candidate set is a few thousand spread calculations and the whole search runs in well under a
+*  millisecond without anything cleverer.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <unordered_set>
+#include "skew.hpp"
+
+/* Functions */
+
+// Flight time of one ball plus its board route
+static bool side_delay(const kintex_package &package, const std::string &ball, const double length_mm, const skew_model &model,
+                       double &delay_ps, std::string &error) {
+
+    const package_pin *pin = package.find(ball);
+
+    if (pin == nullptr) {
+        error = "ball " + ball + " is not in the package data";
+        return (false);
+    }
+
+    delay_ps = pin->delay_ps + (length_mm * model.ps_per_mm);
+    return (true);
+}
+
+static bool lane_delay(const kintex_package &package, const pin_assignment &assignment, const std::string &ball_p,
+                       const std::string &ball_n, const skew_model &model, lane_timing &lane, std::string &error) {
+
+    if (!side_delay(package, ball_p, assignment.length_p_mm, model, lane.delay_p_ps, error)) {
+        return (false);
+    }
+
+    if (ball_n.empty()) {
+        lane.delay_n_ps = lane.delay_p_ps;
+    }
+    else if (!side_delay(package, ball_n, assignment.length_n_mm, model, lane.delay_n_ps, error)) {
+        return (false);
+    }
+
+    lane.delay_ps = (lane.delay_p_ps + lane.delay_n_ps) / 2.0;
+    lane.intra_skew_ps = std::fabs(lane.delay_p_ps - lane.delay_n_ps);
+    return (true);
+}
+
+// Fill in min/max/skew from the lanes
+static void summarize(bus_timing &bus) {
+
+    bus.min_ps = bus.lanes.empty() ? 0.0 : bus.lanes.front().delay_ps;
+    bus.max_ps = bus.min_ps;
+    bus.worst_intra_skew_ps = 0.0;
+
+    for (const lane_timing &lane : bus.lanes) {
+        bus.min_ps = std::min(bus.min_ps, lane.delay_ps);
+        bus.max_ps = std::max(bus.max_ps, lane.delay_ps);
+        bus.worst_intra_skew_ps = std::max(bus.worst_intra_skew_ps, lane.intra_skew_ps);
+    }
+
+    bus.skew_ps = bus.max_ps - bus.min_ps;
+}
+
+bool compute_bus_timing(const kintex_package &package, const std::vector<pin_assignment> &map, const skew_model &model,
+                        std::vector<bus_timing> &buses, std::string &error) {
+
+    std::map<std::string, size_t> by_name;
+
+    buses.clear();
+    for (size_t index = 0; index < map.size(); index++) {
+
+        const pin_assignment &assignment = map[index];
+        lane_timing lane;
+
+        // Signals without a bus (control, I2C, ...) have no skew budget
+        if (assignment.bus.empty()) {
+            continue;
+        }
+
+        lane.assignment = index;
+        if (!lane_delay(package, assignment, assignment.ball_p, assignment.ball_n, model, lane, error)) {
+            error = assignment.net + ": " + error;
+            return (false);
+        }
+
+        auto found = by_name.find(assignment.bus);
+        if (found == by_name.end()) {
+            found = by_name.emplace(assignment.bus, buses.size()).first;
+            buses.emplace_back();
+            buses.back().bus = assignment.bus;
+        }
+
+        bus_timing &bus = buses[found->second];
+        if (assignment.is_clock()) {
+            bus.clock_lane = (int) bus.lanes.size();
+        }
+        bus.lanes.push_back(lane);
+    }
+
+    for (bus_timing &bus : buses) {
+        summarize(bus);
+    }
+
+    return (true);
+}
+
+std::vector<swap_candidate> evaluate_swaps(const kintex_package &package, const std::vector<pin_assignment> &map,
+                                           const skew_model &model, const bus_timing &bus) {
+
+    std::vector<swap_candidate> candidates;
+    std::unordered_set<std::string> used_balls;
+    std::string error;
+
+    for (const pin_assignment &assignment : map) {
+        used_balls.insert(assignment.ball_p);
+        if (assignment.differential()) {
+            used_balls.insert(assignment.ball_n);
+        }
+    }
+
+    // Skew of the bus with some lanes replaced
+    auto rescore = [&bus](const std::vector<std::pair<size_t, lane_timing>> &replaced, swap_candidate &candidate) {
+        bus_timing trial = bus;
+        for (const auto &replacement : replaced) {
+            trial.lanes[replacement.first] = replacement.second;
+        }
+        summarize(trial);
+        candidate.skew_ps = trial.skew_ps;
+        candidate.worst_intra_skew_ps = trial.worst_intra_skew_ps;
+    };
+
+    for (size_t lane = 0; lane < bus.lanes.size(); lane++) {
+
+        const pin_assignment &assignment = map[bus.lanes[lane].assignment];
+        const bool clock = ((int) lane == bus.clock_lane);
+
+        // Moves to a free pair in the same bank
+        const package_pin *current = package.find(assignment.ball_p);
+        if (package.has_pinout() && assignment.differential() && (current != nullptr) && (current->bank >= 0)) {
+            for (const package_pair &pair : package.pairs_in_bank(current->bank)) {
+
+                if (used_balls.count(pair.p->ball) || used_balls.count(pair.n->ball) || (clock && !pair.clock_capable)) {
+                    continue;
+                }
+
+                swap_candidate candidate;
+                lane_timing moved = bus.lanes[lane];
+                if (!lane_delay(package, assignment, pair.p->ball, pair.n->ball, model, moved, error)) {
+                    continue;
+                }
+                candidate.assignment = bus.lanes[lane].assignment;
+                candidate.ball_p = pair.p->ball;
+                candidate.ball_n = pair.n->ball;
+                rescore({ { lane, moved } }, candidate);
+                candidates.push_back(candidate);
+            }
+        }
+
+        // Exchanges with the other lanes of the bus
+        for (size_t other = lane + 1; other < bus.lanes.size(); other++) {
+
+            const pin_assignment &other_assignment = map[bus.lanes[other].assignment];
+            const bool other_clock = ((int) other == bus.clock_lane);
+
+            if (assignment.differential() != other_assignment.differential()) {
+                continue;
+            }
+
+            // The clock may only land on a clock capable ball
+            if (clock || other_clock) {
+                const package_pin *target = package.find(clock ? other_assignment.ball_p : assignment.ball_p);
+                if ((target == nullptr) || !(target->mrcc || target->srcc)) {
+                    continue;
+                }
+            }
+
+            swap_candidate candidate;
+            lane_timing first = bus.lanes[lane];
+            lane_timing second = bus.lanes[other];
+            if (!lane_delay(package, assignment, other_assignment.ball_p, other_assignment.ball_n, model, first, error) ||
+                !lane_delay(package, other_assignment, assignment.ball_p, assignment.ball_n, model, second, error)) {
+                continue;
+            }
+            candidate.assignment = bus.lanes[lane].assignment;
+            candidate.exchange = true;
+            candidate.other_assignment = bus.lanes[other].assignment;
+            candidate.ball_p = other_assignment.ball_p;
+            candidate.ball_n = other_assignment.ball_n;
+            rescore({ { lane, first }, { other, second } }, candidate);
+            candidates.push_back(candidate);
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(), [](const swap_candidate &a, const swap_candidate &b) {
+        return (a.skew_ps < b.skew_ps);
+    });
+
+    return (candidates);
+}
+
+double match_length_mm(const bus_timing &bus, const lane_timing &lane, const skew_model &model) {
+    return ((bus.max_ps - lane.delay_ps) / model.ps_per_mm);
+}
@@ -0,0 +1,66 @@
+// Capstone Host Tools - Bus Skew Model
+// Package plus board flight time per lane, per-bus skew and pin swap evaluation
+
+#ifndef SKEW_HPP
+#define SKEW_HPP
+
+/* Libraries */
+#include <string>
+#include <vector>
+#include "kintex_package.hpp"
+#include "pin_map.hpp"
+
+/* Types */
+
+// Board propagation model
+struct skew_model {
+    double ps_per_mm = 6.88;                                // Stripline flight time (in ps/mm), sqrt(Dk 4.25) / c for the 2116 prepreg
+};
+
+// Timing of one lane (pair or single ended signal)
+struct lane_timing {
+    size_t assignment = 0;                                  // Index of the lane in the pin map
+    double delay_p_ps = 0.0;                                // Package + board flight time of the P side (in ps)
+    double delay_n_ps = 0.0;                                // Package + board flight time of the N side (in ps)
+    double delay_ps = 0.0;                                  // Lane delay: mean of P and N, or P for single ended lanes (in ps)
+    double intra_skew_ps = 0.0;                             // |P - N| (in ps)
+};
+
+// Timing of one bus
+struct bus_timing {
+    std::string bus;                                        // Bus name from the pin map
+    std::vector<lane_timing> lanes;                         // Every lane of the bus, clock included
+    int clock_lane = -1;                                    // Position of the clock in lanes, -1 if the bus has none
+    double min_ps = 0.0;                                    // Fastest lane (in ps)
+    double max_ps = 0.0;                                    // Slowest lane (in ps)
+    double skew_ps = 0.0;                                   // max_ps - min_ps, the figure length matching works on (in ps)
+    double worst_intra_skew_ps = 0.0;                       // Largest P/N skew of any lane (in ps)
+};
+
+// A candidate pin swap and the bus skew it would give
+struct swap_candidate {
+    size_t assignment = 0;                                  // Lane that moves
+    bool exchange = false;                                  // true: trade balls with other_assignment, false: move to a free pair
+    size_t other_assignment = 0;                            // Lane traded with (exchange only)
+    std::string ball_p;                                     // New P ball of the moving lane
+    std::string ball_n;                                     // New N ball of the moving lane
+    double skew_ps = 0.0;                                   // Bus skew after the swap (in ps)
+    double worst_intra_skew_ps = 0.0;                       // Worst P/N skew of the bus after the swap (in ps)
+};
+
+/* Functions */
+
+/* Compute lane and bus timing for every bus in the pin map. Fails on balls the package does not know */
+bool compute_bus_timing(const kintex_package &package, const std::vector<pin_assignment> &map, const skew_model &model,
+                        std::vector<bus_timing> &buses, std::string &error);
+
+/* Evaluate every single-lane move to a free pair in the same bank, and every ball exchange between two lanes of the
+bus. Clock lanes only go to clock capable pairs. Moves need the package pinout, exchanges only need the delays.
+Results are sorted best (lowest skew) first */
+std::vector<swap_candidate> evaluate_swaps(const kintex_package &package, const std::vector<pin_assignment> &map,
+                                           const skew_model &model, const bus_timing &bus);
+
+// Length to add to a lane's board route so it arrives with the slowest lane of its bus (in mm)
+double match_length_mm(const bus_timing &bus, const lane_timing &lane, const skew_model &model);
+
+#endif
@@ -0,0 +1,156 @@
+// Capstone Host Tools - Package Delay Aware Skew Calculator
+// Per-pair and per-bus skew of the ADC LVDS buses, length matching targets and pin swap evaluation
+
+/*
+*  Usage: skew_calc --delays <package_delays.csv> --map <pin_map.csv> [options]
+*      --pkg <file>        AMD package pinout (xc7k160tffg676pkg.txt), enables moves to free pairs in the bank
+*      --ps-per-mm <x>     Board propagation delay (default 6.88 ps/mm)
+*      --bus <name>        Only report this bus
+*      --swaps <n>         List the n best pin swaps per bus (default 0)
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "kintex_package.hpp"
+#include "pin_map.hpp"
+#include "skew.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s --delays <package_delays.csv> --map <pin_map.csv> [--pkg <pinout.txt>] [--ps-per-mm <x>] [--bus <name>] [--swaps <n>]\n", program);
+}
+
+static void print_bus(const bus_timing &bus, const std::vector<pin_assignment> &map, const kintex_package &package, const skew_model &model) {
+
+    const double clock_ps = (bus.clock_lane >= 0) ? bus.lanes[bus.clock_lane].delay_ps : 0.0;
+
+    std::printf("\nBus %s: %zu lanes%s\n", bus.bus.c_str(), bus.lanes.size(), (bus.clock_lane >= 0) ? "" : " (no clock lane)");
+    std::printf("%-16s %-5s %-11s %-17s %-15s %-10s %-10s %-10s %-10s\n",
+                "Net", "Lane", "Ball P/N", "Pkg P/N (ps)", "Board P/N (mm)", "Delay(ps)", "Intra(ps)", "vsCLK(ps)", "Add(mm)");
+
+    for (const lane_timing &lane : bus.lanes) {
+
+        const pin_assignment &assignment = map[lane.assignment];
+        const package_pin *pin_p = package.find(assignment.ball_p);
+        const package_pin *pin_n = assignment.differential() ? package.find(assignment.ball_n) : nullptr;
+        const std::string balls = assignment.ball_p + (assignment.differential() ? "/" + assignment.ball_n : "");
+        char package_delays[32];
+        char board_lengths[32];
+
+        std::snprintf(package_delays, sizeof(package_delays), "%.1f/%.1f", pin_p->delay_ps, (pin_n != nullptr) ? pin_n->delay_ps : pin_p->delay_ps);
+        std::snprintf(board_lengths, sizeof(board_lengths), "%.2f/%.2f", assignment.length_p_mm, assignment.length_n_mm);
+
+        std::printf("%-16s %-5s %-11s %-17s %-15s %-10.1f %-10.1f %-10.1f %-10.2f\n",
+                    assignment.net.c_str(), assignment.lane.c_str(), balls.c_str(), package_delays, board_lengths,
+                    lane.delay_ps, lane.intra_skew_ps, (bus.clock_lane >= 0) ? (lane.delay_ps - clock_ps) : 0.0,
+                    match_length_mm(bus, lane, model));
+    }
+
+    std::printf("Bus skew %.1f ps (%.1f to %.1f ps), worst intra-pair skew %.1f ps\n", bus.skew_ps, bus.min_ps, bus.max_ps, bus.worst_intra_skew_ps);
+}
+
+static void print_swaps(const bus_timing &bus, const std::vector<pin_assignment> &map, const kintex_package &package,
+                        const skew_model &model, const size_t max_swaps) {
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<swap_candidate> candidates = evaluate_swaps(package, map, model, bus);
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t shown = 0;
+
+    std::printf("%zu swap candidates evaluated in %.3f ms\n", candidates.size(), elapsed_ms);
+
+    for (const swap_candidate &candidate : candidates) {
+
+        if ((shown >= max_swaps) || (candidate.skew_ps >= bus.skew_ps)) {
+            break;
+        }
+
+        const pin_assignment &assignment = map[candidate.assignment];
+        if (candidate.exchange) {
+            std::printf("  exchange %-16s <-> %-16s skew %.1f ps (%+.1f), intra %.1f ps\n", assignment.net.c_str(),
+                        map[candidate.other_assignment].net.c_str(), candidate.skew_ps, candidate.skew_ps - bus.skew_ps,
+                        candidate.worst_intra_skew_ps);
+        }
+        else {
+            std::printf("  move     %-16s  -> %-16s skew %.1f ps (%+.1f), intra %.1f ps\n", assignment.net.c_str(),
+                        (candidate.ball_p + "/" + candidate.ball_n).c_str(), candidate.skew_ps, candidate.skew_ps - bus.skew_ps,
+                        candidate.worst_intra_skew_ps);
+        }
+        shown++;
+    }
+
+    if (shown == 0) {
+        std::printf("  no swap improves this bus\n");
+    }
+}
+
+int main(int argc, char **argv) {
+
+    std::string delays_path;
+    std::string map_path;
+    std::string pinout_path;
+    std::string only_bus;
+    std::string error;
+    size_t max_swaps = 0;
+    skew_model model;
+    kintex_package package;
+    std::vector<pin_assignment> map;
+    std::vector<bus_timing> buses;
+
+    for (int arg = 1; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--delays") == 0) && has_value) {
+            delays_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--map") == 0) && has_value) {
+            map_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--pkg") == 0) && has_value) {
+            pinout_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--ps-per-mm") == 0) && has_value) {
+            model.ps_per_mm = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--bus") == 0) && has_value) {
+            only_bus = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--swaps") == 0) && has_value) {
+            max_swaps = (size_t) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (delays_path.empty() || map_path.empty() || (model.ps_per_mm <= 0.0)) {
+        usage(argv[0]);
+        return (1);
+    }
+
+    if (!package.load_delays(delays_path, error) ||
+        (!pinout_path.empty() && !package.load_pinout(pinout_path, error)) ||
+        !load_pin_map(map_path, map, error) ||
+        !compute_bus_timing(package, map, model, buses, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    for (const bus_timing &bus : buses) {
+        if (!only_bus.empty() && (bus.bus != only_bus)) {
+            continue;
+        }
+        print_bus(bus, map, package, model);
+        if (max_swaps > 0) {
+            print_swaps(bus, map, package, model, max_swaps);
+        }
+    }
+
+    return (0);
+}
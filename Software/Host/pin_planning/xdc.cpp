@@ -0,0 +1,193 @@
+// Capstone Host Tools - XDC Constraint Files
+// Reading pin locations out of Vivado projects and XDC files, and generating per-bank pin constraints
+
+/* Libraries */
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include "xdc.hpp"
+
+/* Functions */
+
+// Directory part of a path, "." if there is none
+static std::string directory_of(const std::string &path) {
+
+    const size_t slash = path.find_last_of('/');
+
+    return ((slash == std::string::npos) ? "." : path.substr(0, slash));
+}
+
+static void replace_all(std::string &text, const std::string &from, const std::string &to) {
+
+    for (size_t position = text.find(from); position != std::string::npos; position = text.find(from, position + to.size())) {
+        text.replace(position, from.size(), to);
+    }
+}
+
+bool xpr_constraint_files(const std::string &xpr_path, std::vector<std::string> &files, std::string &error) {
+
+    std::ifstream file(xpr_path);
+    std::string line;
+    bool in_constraints = false;
+    const std::string project_dir = directory_of(xpr_path);
+    std::string project_name = xpr_path.substr(xpr_path.find_last_of('/') + 1);
+
+    if (!file) {
+        error = "cannot open " + xpr_path;
+        return (false);
+    }
+    project_name = project_name.substr(0, project_name.rfind(".xpr"));
+
+    files.clear();
+    while (std::getline(file, line)) {
+
+        if (line.find("<FileSet Name=\"constrs_1\"") != std::string::npos) {
+            in_constraints = true;
+        }
+        else if (in_constraints && (line.find("</FileSet>") != std::string::npos)) {
+            in_constraints = false;
+        }
+        else if (in_constraints && (line.find("<File Path=\"") != std::string::npos)) {
+            const size_t start = line.find("<File Path=\"") + 12;
+            std::string path = line.substr(start, line.find('"', start) - start);
+            replace_all(path, "$PSRCDIR", project_dir + "/" + project_name + ".srcs");
+            replace_all(path, "$PPRDIR", project_dir);
+            files.push_back(path);
+        }
+    }
+
+    return (true);
+}
+
+bool load_xdc_package_pins(const std::string &path, std::map<std::string, std::string> &pins, std::string &error) {
+
+    std::ifstream file(path);
+    std::string line;
+
+    if (!file) {
+        error = "cannot open " + path;
+        return (false);
+    }
+
+    while (std::getline(file, line)) {
+
+        std::stringstream stream(line);
+        std::vector<std::string> words;
+        std::string word;
+        std::string ball;
+        std::string port;
+
+        if (line.find("PACKAGE_PIN") == std::string::npos) {
+            continue;
+        }
+        while (stream >> word) {
+            // "{PACKAGE_PIN" at the start of a -dict list
+            if ((word.size() > 1) && (word.front() == '{')) {
+                word.erase(0, 1);
+            }
+            words.push_back(word);
+        }
+
+        // "set_property PACKAGE_PIN A3 [get_ports X]" or "set_property -dict { PACKAGE_PIN A3 ... } [get_ports X]"
+        for (size_t index = 0; index + 1 < words.size(); index++) {
+            if (words[index] == "PACKAGE_PIN") {
+                ball = words[index + 1];
+            }
+            else if (words[index] == "[get_ports") {
+                port = words[index + 1];
+            }
+        }
+        if (ball.empty() || port.empty()) {
+            continue;
+        }
+
+        // Strip the closing bracket and any braces around the port name
+        while (!port.empty() && ((port.back() == ']') || (port.back() == '}'))) {
+            port.pop_back();
+        }
+        if (!port.empty() && (port.front() == '{')) {
+            port.erase(0, 1);
+        }
+        while (!ball.empty() && (ball.back() == '}')) {
+            ball.pop_back();
+        }
+        pins[port] = ball;
+    }
+
+    return (true);
+}
+
+uint64_t xdc_hash(const std::string &text) {
+
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (const unsigned char character : text) {
+        hash ^= character;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return (hash);
+}
+
+// Constraint lines of one port side
+static void append_port(std::string &text, const std::string &port, const std::string &ball, const pin_assignment &assignment,
+                        const package_pin *pin) {
+
+    text += "set_property -dict {PACKAGE_PIN " + ball;
+
+    // Transceiver balls only take a location
+    if ((pin == nullptr) || (pin->io_type != "GTX")) {
+        if (!assignment.iostandard.empty()) {
+            text += " IOSTANDARD " + assignment.iostandard;
+        }
+        if (assignment.differential() && assignment.diff_term) {
+            text += " DIFF_TERM TRUE";
+        }
+    }
+
+    text += "} [get_ports {" + port + "}]\n";
+}
+
+bool build_xdc_banks(const kintex_package &package, const std::vector<pin_assignment> &map, const std::string &source,
+                     std::vector<xdc_bank_file> &files, std::string &error) {
+
+    std::map<int, std::vector<const pin_assignment *>> by_bank;
+
+    for (const pin_assignment &assignment : map) {
+        const package_pin *pin = package.find(assignment.ball_p);
+        if ((pin == nullptr) || (pin->bank < 0)) {
+            error = assignment.net + ": ball " + assignment.ball_p + " is not an I/O of the package";
+            return (false);
+        }
+        by_bank[pin->bank].push_back(&assignment);
+    }
+
+    files.clear();
+    for (auto &bank : by_bank) {
+
+        xdc_bank_file file;
+
+        // Sorted by port so the text (and its hash) only depends on the assignments, not on pin map order
+        std::sort(bank.second.begin(), bank.second.end(), [](const pin_assignment *a, const pin_assignment *b) {
+            return (a->net < b->net);
+        });
+
+        file.bank = bank.first;
+        for (const pin_assignment *assignment : bank.second) {
+            if (assignment->differential()) {
+                append_port(file.text, assignment->net + "_P", assignment->ball_p, *assignment, package.find(assignment->ball_p));
+                append_port(file.text, assignment->net + "_N", assignment->ball_n, *assignment, package.find(assignment->ball_n));
+            }
+            else {
+                append_port(file.text, assignment->net, assignment->ball_p, *assignment, package.find(assignment->ball_p));
+            }
+        }
+
+        // The header is left out of the hash so renaming the pin map alone does not rewrite every bank
+        file.hash = xdc_hash(file.text);
+        file.text = "# Bank " + std::to_string(bank.first) + " pin constraints, generated from " + source + " by xdc_gen. Do not edit\n" + file.text;
+        files.push_back(file);
+    }
+
+    return (true);
+}
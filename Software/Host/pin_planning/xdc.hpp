@@ -0,0 +1,41 @@
+// Capstone Host Tools - XDC Constraint Files
+// Reading pin locations out of Vivado projects and XDC files, and generating per-bank pin constraints
+
+#ifndef XDC_HPP
+#define XDC_HPP
+
+/* Libraries */
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "kintex_package.hpp"
+#include "pin_map.hpp"
+
+/* Types */
+
+// Generated constraints of one bank
+struct xdc_bank_file {
+    int bank = -1;                                          // Bank number
+    std::string text;                                       // Complete XDC file contents
+    uint64_t hash = 0;                                      // xdc_hash() of the constraint lines (header excluded)
+};
+
+/* Functions */
+
+/* List the XDC files of the constrs_1 fileset of a Vivado project, with $PPRDIR/$PSRCDIR expanded.
+An empty fileset is not an error */
+bool xpr_constraint_files(const std::string &xpr_path, std::vector<std::string> &files, std::string &error);
+
+/* Collect every "set_property PACKAGE_PIN <ball> [get_ports <port>]" of an XDC file (either property syntax) into port -> ball */
+bool load_xdc_package_pins(const std::string &path, std::map<std::string, std::string> &pins, std::string &error);
+
+// 64-bit FNV-1a hash used to detect changed banks
+uint64_t xdc_hash(const std::string &text);
+
+/* Build PACKAGE_PIN/IOSTANDARD/DIFF_TERM constraints for every bank the pin map touches, one file per bank.
+Differential lanes become <net>_P/<net>_N ports. GTX balls only get a location. Needs the package pinout */
+bool build_xdc_banks(const kintex_package &package, const std::vector<pin_assignment> &map, const std::string &source,
+                     std::vector<xdc_bank_file> &files, std::string &error);
+
+#endif
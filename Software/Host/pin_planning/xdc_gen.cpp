@@ -0,0 +1,169 @@
+// Capstone Host Tools - XDC Constraint Generator
+// Writes one XDC file per bank from a pin map, rewriting only the banks that changed
+
+/*
+*  Usage: xdc_gen --pkg <pinout.txt> --map <pin_map.csv> --out <directory> [--force]
+*
+*  Files are named bank_<n>.xdc. A hash of every generated bank is kept in <directory>/.xdc_gen_cache and a bank is
+*  only written when its hash differs (or its file is missing), so Vivado only sees the banks that were actually
+*  edited and untouched files keep their timestamps. Banks that drop out of the pin map have their file removed.
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstring>
+#include <cinttypes>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+#include "kintex_package.hpp"
+#include "pin_map.hpp"
+#include "xdc.hpp"
+
+/* Generator parameters */
+static const char CACHE_FILE[] = ".xdc_gen_cache";
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s --pkg <pinout.txt> --map <pin_map.csv> --out <directory> [--force]\n", program);
+}
+
+static std::string bank_file(const std::string &directory, const int bank) {
+    return (directory + "/bank_" + std::to_string(bank) + ".xdc");
+}
+
+static bool file_exists(const std::string &path) {
+    return (static_cast<bool>(std::ifstream(path)));
+}
+
+// Bank -> hash of the last generated contents
+static std::map<int, uint64_t> load_cache(const std::string &path) {
+
+    std::map<int, uint64_t> cache;
+    std::ifstream file(path);
+    int bank = 0;
+    uint64_t hash = 0;
+
+    while (file >> bank >> std::hex >> hash >> std::dec) {
+        cache[bank] = hash;
+    }
+
+    return (cache);
+}
+
+static bool save_cache(const std::string &path, const std::map<int, uint64_t> &cache) {
+
+    std::FILE *file = std::fopen(path.c_str(), "w");
+
+    if (file == nullptr) {
+        return (false);
+    }
+    for (const auto &entry : cache) {
+        std::fprintf(file, "%d %016" PRIx64 "\n", entry.first, entry.second);
+    }
+
+    return (std::fclose(file) == 0);
+}
+
+int main(int argc, char **argv) {
+
+    std::string pinout_path;
+    std::string map_path;
+    std::string out_dir;
+    std::string error;
+    bool force = false;
+    kintex_package package;
+    std::vector<pin_assignment> map;
+    std::vector<xdc_bank_file> banks;
+    std::map<int, uint64_t> new_cache;
+    unsigned written = 0;
+    unsigned removed = 0;
+
+    for (int arg = 1; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        if ((std::strcmp(argv[arg], "--pkg") == 0) && has_value) {
+            pinout_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--map") == 0) && has_value) {
+            map_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--out") == 0) && has_value) {
+            out_dir = argv[++arg];
+        }
+        else if (std::strcmp(argv[arg], "--force") == 0) {
+            force = true;
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+    }
+
+    if (pinout_path.empty() || map_path.empty() || out_dir.empty()) {
+        usage(argv[0]);
+        return (1);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    if (!package.load_pinout(pinout_path, error) || !load_pin_map(map_path, map, error) ||
+        !build_xdc_banks(package, map, map_path, banks, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    // A fresh output directory (and any parents) is created rather than treated as a write failure
+    std::error_code dir_error;
+    std::filesystem::create_directories(out_dir, dir_error);
+    if (dir_error) {
+        std::fprintf(stderr, "ERROR: cannot create %s: %s\n", out_dir.c_str(), dir_error.message().c_str());
+        return (1);
+    }
+
+    const std::string cache_path = out_dir + "/" + CACHE_FILE;
+    std::map<int, uint64_t> old_cache = force ? std::map<int, uint64_t>() : load_cache(cache_path);
+
+    for (const xdc_bank_file &bank : banks) {
+
+        const std::string path = bank_file(out_dir, bank.bank);
+        auto cached = old_cache.find(bank.bank);
+
+        new_cache[bank.bank] = bank.hash;
+        if ((cached != old_cache.end()) && (cached->second == bank.hash) && file_exists(path)) {
+            continue;
+        }
+
+        std::ofstream file(path);
+        file << bank.text;
+        if (!file) {
+            std::fprintf(stderr, "ERROR: cannot write %s\n", path.c_str());
+            return (1);
+        }
+        std::printf("Bank %d: written %s\n", bank.bank, path.c_str());
+        written++;
+    }
+
+    // Banks that are no longer used
+    for (const auto &entry : old_cache) {
+        if (new_cache.count(entry.first) == 0) {
+            std::remove(bank_file(out_dir, entry.first).c_str());
+            std::printf("Bank %d: removed %s\n", entry.first, bank_file(out_dir, entry.first).c_str());
+            removed++;
+        }
+    }
+
+    if (!save_cache(cache_path, new_cache)) {
+        std::fprintf(stderr, "ERROR: cannot write %s\n", cache_path.c_str());
+        return (1);
+    }
+
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%zu banks, %u written, %u unchanged, %u removed in %.1f ms\n", banks.size(), written,
+                (unsigned)(banks.size() - written), removed, elapsed_ms);
+
+    return (0);
+}
@@ -0,0 +1,221 @@
+// Capstone Host Tools - Board Power Budget
+// Rail currents, regulator losses and temperatures of the mainboard for one scenario or a what-if sweep
+
+/*
+*  Usage: power_budget report|sweep --rails <power_rails.csv> --loads <power_loads.csv> [options]
+*      report              Operating point of every rail for one scenario (the first value of each axis)
+*      sweep               Every combination of the axes: worst cases, failing scenarios and throughput
+*
+*  Options (each axis is "x" or "first:last:step", factors relative to the XPE worst case estimate):
+*      --util <axis>       Logic/BRAM/DSP utilization (default 1)
+*      --clock <axis>      Fabric clock (default 1)
+*      --io <axis>         I/O activity (default 1)
+*      --gtx <axis>        Transceiver lanes in use (default 1)
+*      --ambient <axis>    Board ambient in C (default 35)
+*      --theta-ja <x>      FPGA effective theta JA (default 2.24 C/W)
+*      --tj-max <x>        FPGA junction limit (default 100 C)
+*      --threads <n>       Sweep worker threads (default: one per core)
+*      --csv <file>        sweep: write one line per scenario
+*
+*  Exits with 2 when a scenario violates a limit, so the budget can gate a build or a design review script.
+*/
+
+/* Libraries */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "power_model.hpp"
+
+/* Functions */
+
+static void usage(const char *program) {
+    std::printf("Usage: %s report|sweep --rails <power_rails.csv> --loads <power_loads.csv> [--util a[:b:step]] [--clock a[:b:step]]\n"
+                "       [--io a[:b:step]] [--gtx a[:b:step]] [--ambient a[:b:step]] [--theta-ja x] [--tj-max x] [--threads n] [--csv file]\n",
+                program);
+}
+
+static void print_scenario(const power_scenario &scenario) {
+    std::printf("util %.3g, clock %.3g, io %.3g, gtx %.3g, ambient %.1f C", scenario.util, scenario.clock, scenario.io, scenario.gtx,
+                scenario.ambient_c);
+}
+
+static int run_report(const power_model &model, const power_scenario &scenario) {
+
+    power_result result;
+    model.evaluate(scenario, result);
+
+    std::printf("Scenario: ");
+    print_scenario(scenario);
+    std::printf("\n\nRail\tType\tPart\t\tVout (V)\tIout (A)\tImax (A)\tHeadroom\tPout (W)\tLoss (W)\tEff\tTj (C)\tStatus\n");
+    for (size_t rail = 0; rail < model.rails().size(); rail++) {
+        const power_rail &entry = model.rails()[rail];
+        const rail_result &point = result.rails[rail];
+        const double input_w = point.pout_w + point.loss_w;
+        std::printf("%s\t%s\t%-12s\t%.3f\t\t%.3f\t\t%.2f\t\t%5.1f%%\t\t%.3f\t\t%.3f\t\t%5.1f%%\t%.1f\t%s\n", entry.name.c_str(), rail_type_name(entry.type),
+                    entry.part.c_str(), point.vout_v, point.iout_a, entry.imax_a, 100.0 * point.headroom, point.pout_w, point.loss_w,
+                    (input_w > 0.0) ? (100.0 * point.pout_w / input_w) : 100.0, point.tj_c, power_violation_names(point.violations).c_str());
+    }
+
+    std::printf("\nInput %.2f W, regulator losses %.2f W (%.1f%% of the input)\n", result.input_w, result.loss_w,
+                (result.input_w > 0.0) ? (100.0 * result.loss_w / result.input_w) : 0.0);
+    std::printf("FPGA %.2f W, junction %.1f C (limit %.1f C)%s\n", result.fpga_w, result.fpga_tj_c, model.options().fpga_tj_max_c,
+                (result.violations & POWER_RUNAWAY) ? ", THERMAL RUNAWAY" : "");
+
+    // Programmed voltages that miss their window are a firmware or table error, not a load problem
+    for (size_t rail = 0; rail < model.rails().size(); rail++) {
+        const power_rail &entry = model.rails()[rail];
+        if (result.rails[rail].violations & POWER_VOLTAGE) {
+            std::printf("WARNING: %s is programmed to %.3f V (VSET 0x%02X, CONTROL2 0x%02X), outside %.3f - %.3f V\n", entry.name.c_str(),
+                        result.rails[rail].vout_v, entry.vset, entry.ctrl2, entry.vmin_v, entry.vmax_v);
+        }
+    }
+
+    std::printf("Result: %s\n", power_violation_names(result.violations).c_str());
+    return ((result.violations != 0) ? 2 : 0);
+}
+
+static bool write_csv(const std::string &path, const power_model &model, const power_sweep &sweep, const std::vector<sweep_row> &rows,
+                      std::string &error) {
+
+    const std::string temp_path = path + ".tmp";
+    std::FILE *file = std::fopen(temp_path.c_str(), "w");
+
+    if (file == nullptr) {
+        error = "cannot write " + temp_path;
+        return (false);
+    }
+
+    std::fprintf(file, "util,clock,io,gtx,ambient_c,input_w,fpga_tj_c,worst_rail,worst_headroom,violations\n");
+    for (const sweep_row &row : rows) {
+        const power_scenario scenario = sweep.at(row.scenario);
+        std::fprintf(file, "%g,%g,%g,%g,%g,%.3f,%.2f,%s,%.4f,%s\n", scenario.util, scenario.clock, scenario.io, scenario.gtx, scenario.ambient_c,
+                     row.input_w, row.fpga_tj_c, model.rails()[row.worst_rail].name.c_str(), row.worst_headroom,
+                     power_violation_names(row.violations).c_str());
+    }
+
+    const bool written = (std::fclose(file) == 0);
+    if (!written || (std::rename(temp_path.c_str(), path.c_str()) != 0)) {
+        error = "cannot write " + path;
+        return (false);
+    }
+
+    return (true);
+}
+
+static int run_sweep(const power_model &model, const power_sweep &sweep, const unsigned threads, const std::string &csv_path) {
+
+    sweep_summary summary;
+    std::vector<sweep_row> rows;
+    std::string error;
+
+    run_power_sweep(model, sweep, threads, summary, csv_path.empty() ? nullptr : &rows);
+
+    std::printf("%zu scenarios in %.3f s (%.0f scenarios/s)\n", summary.scenarios, summary.seconds,
+                (summary.seconds > 0.0) ? ((double) summary.scenarios / summary.seconds) : 0.0);
+    std::printf("%zu failing (%s), %zu of them on load limits rather than a programmed voltage\n", summary.failing,
+                power_violation_names(summary.violations).c_str(), summary.load_failing);
+    for (size_t rail = 0; rail < model.rails().size(); rail++) {
+        if (summary.rail_failing[rail] > 0) {
+            std::printf("    %s\t%zu\n", model.rails()[rail].name.c_str(), summary.rail_failing[rail]);
+        }
+    }
+
+    std::printf("Least current headroom: %s %.1f%% at ", model.rails()[summary.worst_rail].name.c_str(), 100.0 * summary.worst_headroom);
+    print_scenario(sweep.at(summary.worst_headroom_scenario));
+    std::printf("\nHottest FPGA junction: %.1f C at ", summary.hottest_tj_c);
+    print_scenario(sweep.at(summary.hottest_scenario));
+    std::printf("\nMost input power: %.2f W at ", summary.max_input_w);
+    print_scenario(sweep.at(summary.max_input_scenario));
+    std::printf("\n");
+
+    if (!csv_path.empty() && !write_csv(csv_path, model, sweep, rows, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    return ((summary.failing > 0) ? 2 : 0);
+}
+
+int main(int argc, char **argv) {
+
+    std::string rails_path;
+    std::string loads_path;
+    std::string csv_path;
+    power_sweep sweep;
+    power_model model;
+    unsigned threads = 0;
+    std::string error;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        return (1);
+    }
+    const std::string mode = argv[1];
+
+    for (int arg = 2; arg < argc; arg++) {
+        const bool has_value = (arg + 1 < argc);
+        sweep_axis *axis = nullptr;
+        if ((std::strcmp(argv[arg], "--rails") == 0) && has_value) {
+            rails_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--loads") == 0) && has_value) {
+            loads_path = argv[++arg];
+        }
+        else if ((std::strcmp(argv[arg], "--util") == 0) && has_value) {
+            axis = &sweep.util;
+        }
+        else if ((std::strcmp(argv[arg], "--clock") == 0) && has_value) {
+            axis = &sweep.clock;
+        }
+        else if ((std::strcmp(argv[arg], "--io") == 0) && has_value) {
+            axis = &sweep.io;
+        }
+        else if ((std::strcmp(argv[arg], "--gtx") == 0) && has_value) {
+            axis = &sweep.gtx;
+        }
+        else if ((std::strcmp(argv[arg], "--ambient") == 0) && has_value) {
+            axis = &sweep.ambient_c;
+        }
+        else if ((std::strcmp(argv[arg], "--theta-ja") == 0) && has_value) {
+            model.options().fpga_theta_ja = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--tj-max") == 0) && has_value) {
+            model.options().fpga_tj_max_c = std::strtod(argv[++arg], nullptr);
+        }
+        else if ((std::strcmp(argv[arg], "--threads") == 0) && has_value) {
+            threads = (unsigned) std::strtoul(argv[++arg], nullptr, 10);
+        }
+        else if ((std::strcmp(argv[arg], "--csv") == 0) && has_value) {
+            csv_path = argv[++arg];
+        }
+        else {
+            usage(argv[0]);
+            return (1);
+        }
+        if ((axis != nullptr) && !parse_sweep_axis(argv[++arg], *axis)) {
+            std::fprintf(stderr, "ERROR: bad range '%s', expected x or first:last:step\n", argv[arg]);
+            return (1);
+        }
+    }
+
+    if (rails_path.empty() || loads_path.empty()) {
+        usage(argv[0]);
+        return (1);
+    }
+    if (!model.load(rails_path, loads_path, error)) {
+        std::fprintf(stderr, "ERROR: %s\n", error.c_str());
+        return (1);
+    }
+
+    if (mode == "report") {
+        return (run_report(model, sweep.at(0)));
+    }
+    else if (mode == "sweep") {
+        return (run_sweep(model, sweep, threads, csv_path));
+    }
+
+    usage(argv[0]);
+    return (1);
+}
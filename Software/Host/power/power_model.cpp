@@ -0,0 +1,620 @@
+// Capstone Host Tools - Board Power Model
+// Rail tree, regulator losses and thermal rise of the mainboard power distribution, fast enough for what-if sweeps
+
+/*
+*  Everything that does not depend on the scenario (tree order, programmed voltages, which loads sit on the FPGA) is
+*  worked out once when the model is built, so an evaluation is a pass over the loads and a pass over the rails with
+*  no allocation: a few hundred nanoseconds, millions of scenarios per second over all cores.
+*
+*  FPGA leakage grows exponentially with junction temperature and the junction temperature grows with the power, so
+*  Tj = ambient + theta * (S * exp(k * (Tj - Tref)) + D) is solved with Newton's method. Starting below the root on
+*  a convex function it converges from one side, and if the slope reaches one before it does there is no root at all:
+*  the die would run away thermally.
+*/
+
+/* Libraries */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include "power_model.hpp"
+
+/* Table formats */
+static const size_t RAIL_COLUMNS                = 17;       // rail,parent,type,part,vout_v,imax_a,vset,ctrl2,vmin_v,vmax_v,q_w,k_v,r_ohm,iq_a,dropout_v,theta_ja,tj_max_c
+static const size_t LOAD_COLUMNS                = 6;        // load,rail,device,static_a,dynamic_a,scale
+
+/* Parameters */
+static const unsigned TJ_ITERATIONS             = 32;       // Newton steps before the FPGA junction counts as running away
+static const double TJ_TOLERANCE_C              = 1e-4;     // Newton step small enough to stop
+static const size_t SWEEP_BLOCK                 = 4096;     // Scenarios a worker takes at a time
+
+/* Functions */
+
+static std::vector<std::string> split_csv(const std::string &line) {
+
+    std::vector<std::string> fields;
+    std::stringstream stream(line);
+    std::string field;
+
+    while (std::getline(stream, field, ',')) {
+        const size_t first = field.find_first_not_of(" \t\r");
+        const size_t last = field.find_last_not_of(" \t\r");
+        fields.push_back((first == std::string::npos) ? "" : field.substr(first, last - first + 1));
+    }
+
+    // A trailing empty column has no text after the last comma
+    if (!line.empty() && (line.back() == ',')) {
+        fields.push_back("");
+    }
+
+    return (fields);
+}
+
+// Data lines of a CSV table (comments, blank lines and the header skipped), with their line numbers
+static bool read_table(const std::string &path, const size_t columns, std::vector<std::vector<std::string>> &rows,
+                       std::vector<size_t> &line_numbers, std::string &error) {
+
+    std::ifstream file(path);
+    std::string line;
+    size_t line_number = 0;
+    bool header_seen = false;
+
+    if (!file) {
+        error = "cannot open " + path;
+        return (false);
+    }
+
+    while (std::getline(file, line)) {
+
+        line_number++;
+        if ((line.find_first_not_of(" \t\r") == std::string::npos) || (line[0] == '#')) {
+            continue;
+        }
+        if (!header_seen) {
+            header_seen = true;
+            continue;
+        }
+
+        std::vector<std::string> fields = split_csv(line);
+        if (fields.size() != columns) {
+            error = path + ":" + std::to_string(line_number) + ": expected " + std::to_string(columns) + " columns";
+            return (false);
+        }
+        rows.push_back(fields);
+        line_numbers.push_back(line_number);
+    }
+
+    return (true);
+}
+
+static double parse_number(const std::string &text) {
+    return (text.empty() ? 0.0 : std::strtod(text.c_str(), nullptr));
+}
+
+// Register values may be written in hex, -1 when empty
+static int parse_register(const std::string &text) {
+    return (text.empty() ? -1 : (int) std::strtol(text.c_str(), nullptr, 0));
+}
+
+double tps6287x_vout(const int ctrl2, const int vset) {
+
+    switch ((ctrl2 & 0x0C) >> 2) {
+        case 0:
+            return (0.4 + (vset * 0.00125));
+        case 1:
+            return (0.4 + (vset * 0.0025));
+        case 2:
+            return (0.4 + (vset * 0.005));
+        default:
+            return (0.8 + (vset * 0.01));
+    }
+}
+
+const char *rail_type_name(const rail_type type) {
+
+    switch (type) {
+        case rail_type::input:
+            return ("input");
+        case rail_type::smps:
+            return ("smps");
+        case rail_type::ldo:
+            return ("ldo");
+        default:
+            return ("ref");
+    }
+}
+
+const char *load_scale_name(const load_scale scale) {
+
+    switch (scale) {
+        case load_scale::logic:
+            return ("logic");
+        case load_scale::io:
+            return ("io");
+        case load_scale::gtx:
+            return ("gtx");
+        default:
+            return ("fixed");
+    }
+}
+
+std::string power_violation_names(const uint32_t violations) {
+
+    static const char *names[] = { "overcurrent", "overtemp", "dropout", "voltage", "fpga_tj", "runaway" };
+    std::string text;
+
+    for (unsigned bit = 0; bit < (sizeof(names) / sizeof(names[0])); bit++) {
+        if (violations & (1u << bit)) {
+            text += (text.empty() ? "" : ",") + std::string(names[bit]);
+        }
+    }
+
+    return (text.empty() ? "ok" : text);
+}
+
+bool parse_sweep_axis(const std::string &text, sweep_axis &axis) {
+
+    std::vector<double> values;
+    std::stringstream stream(text);
+    std::string field;
+
+    while (std::getline(stream, field, ':')) {
+        char *end = nullptr;
+        values.push_back(std::strtod(field.c_str(), &end));
+        if (field.empty() || (*end != '\0')) {
+            return (false);
+        }
+    }
+
+    if (values.size() == 1) {
+        axis = sweep_axis { values[0], values[0], 0.0 };
+        return (true);
+    }
+    if ((values.size() == 3) && (values[2] > 0.0) && (values[1] >= values[0])) {
+        axis = sweep_axis { values[0], values[1], values[2] };
+        return (true);
+    }
+
+    return (false);
+}
+
+/* Model */
+
+bool power_model::load(const std::string &rails_path, const std::string &loads_path, std::string &error) {
+
+    std::vector<std::vector<std::string>> rows;
+    std::vector<size_t> line_numbers;
+    std::vector<power_rail> rail_table;
+    std::vector<power_load> load_table;
+
+    if (!read_table(rails_path, RAIL_COLUMNS, rows, line_numbers, error)) {
+        return (false);
+    }
+    for (size_t row = 0; row < rows.size(); row++) {
+
+        const std::vector<std::string> &fields = rows[row];
+        power_rail rail;
+
+        rail.name = fields[0];
+        rail.parent = fields[1];
+        if (fields[2] == "input") {
+            rail.type = rail_type::input;
+        }
+        else if (fields[2] == "smps") {
+            rail.type = rail_type::smps;
+        }
+        else if (fields[2] == "ldo") {
+            rail.type = rail_type::ldo;
+        }
+        else if (fields[2] == "ref") {
+            rail.type = rail_type::ref;
+        }
+        else {
+            error = rails_path + ":" + std::to_string(line_numbers[row]) + ": unknown rail type '" + fields[2] + "'";
+            return (false);
+        }
+        rail.part = fields[3];
+        rail.vout_v = parse_number(fields[4]);
+        rail.imax_a = parse_number(fields[5]);
+        rail.vset = parse_register(fields[6]);
+        rail.ctrl2 = parse_register(fields[7]);
+        rail.vmin_v = parse_number(fields[8]);
+        rail.vmax_v = parse_number(fields[9]);
+        rail.q_w = parse_number(fields[10]);
+        rail.k_v = parse_number(fields[11]);
+        rail.r_ohm = parse_number(fields[12]);
+        rail.iq_a = parse_number(fields[13]);
+        rail.dropout_v = parse_number(fields[14]);
+        rail.theta_ja = parse_number(fields[15]);
+        rail.tj_max_c = parse_number(fields[16]);
+        rail_table.push_back(rail);
+    }
+
+    rows.clear();
+    line_numbers.clear();
+    if (!read_table(loads_path, LOAD_COLUMNS, rows, line_numbers, error)) {
+        return (false);
+    }
+    for (size_t row = 0; row < rows.size(); row++) {
+
+        const std::vector<std::string> &fields = rows[row];
+        power_load load;
+
+        load.name = fields[0];
+        load.rail = fields[1];
+        load.device = fields[2];
+        load.static_a = parse_number(fields[3]);
+        load.dynamic_a = parse_number(fields[4]);
+        if (fields[5] == "fixed") {
+            load.scale = load_scale::fixed;
+        }
+        else if (fields[5] == "logic") {
+            load.scale = load_scale::logic;
+        }
+        else if (fields[5] == "io") {
+            load.scale = load_scale::io;
+        }
+        else if (fields[5] == "gtx") {
+            load.scale = load_scale::gtx;
+        }
+        else {
+            error = loads_path + ":" + std::to_string(line_numbers[row]) + ": unknown scale '" + fields[5] + "'";
+            return (false);
+        }
+        load_table.push_back(load);
+    }
+
+    return (build(rail_table, load_table, error));
+}
+
+bool power_model::build(const std::vector<power_rail> &rail_table, const std::vector<power_load> &load_table, std::string &error) {
+
+    const size_t num_rails = rail_table.size();
+    std::vector<int> parents(num_rails, -1);
+    std::vector<size_t> depth(num_rails, 0);
+    std::vector<int> load_rails(load_table.size(), -1);
+    size_t inputs = 0;
+
+    // Every rail is named once and fed from a known rail, except the one input
+    for (size_t rail = 0; rail < num_rails; rail++) {
+
+        const power_rail &entry = rail_table[rail];
+
+        if (entry.name.empty()) {
+            error = "rail " + std::to_string(rail) + " has no name";
+            return (false);
+        }
+        for (size_t other = 0; other < rail; other++) {
+            if (rail_table[other].name == entry.name) {
+                error = "rail " + entry.name + " is listed twice";
+                return (false);
+            }
+        }
+        if (entry.type == rail_type::input) {
+            inputs++;
+            continue;
+        }
+        for (size_t other = 0; other < num_rails; other++) {
+            if (rail_table[other].name == entry.parent) {
+                parents[rail] = (int) other;
+            }
+        }
+        if ((parents[rail] < 0) || (parents[rail] == (int) rail)) {
+            error = "rail " + entry.name + " is fed from unknown rail '" + entry.parent + "'";
+            return (false);
+        }
+    }
+    if (inputs != 1) {
+        error = "the rail table needs exactly one input rail";
+        return (false);
+    }
+
+    // Depth below the input, a chain longer than the table is a loop
+    for (size_t rail = 0; rail < num_rails; rail++) {
+        for (int parent = parents[rail]; parent >= 0; parent = parents[parent]) {
+            if (++depth[rail] > num_rails) {
+                error = "rail " + rail_table[rail].name + " is part of a loop";
+                return (false);
+            }
+        }
+    }
+
+    for (size_t load = 0; load < load_table.size(); load++) {
+        for (size_t rail = 0; rail < num_rails; rail++) {
+            if (rail_table[rail].name == load_table[load].rail) {
+                load_rails[load] = (int) rail;
+            }
+        }
+        if (load_rails[load] < 0) {
+            error = "load " + load_table[load].name + " is on unknown rail '" + load_table[load].rail + "'";
+            return (false);
+        }
+    }
+
+    rail_list = rail_table;
+    load_list = load_table;
+    parent_index = parents;
+    load_rail = load_rails;
+    load_fpga.resize(load_list.size());
+    for (size_t load = 0; load < load_list.size(); load++) {
+        load_fpga[load] = (load_list[load].device == "fpga") ? 1 : 0;
+    }
+
+    // Deepest rails first, so a rail's current is complete before it is passed on to its parent
+    order.resize(num_rails);
+    for (size_t rail = 0; rail < num_rails; rail++) {
+        order[rail] = rail;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return (depth[a] > depth[b]); });
+
+    // What the firmware actually programs, checked against the rail window once
+    rail_vout.assign(num_rails, 0.0);
+    static_flags.assign(num_rails, 0);
+    for (size_t rail = 0; rail < num_rails; rail++) {
+        const power_rail &entry = rail_list[rail];
+        rail_vout[rail] = ((entry.vset >= 0) && (entry.ctrl2 >= 0)) ? tps6287x_vout(entry.ctrl2, entry.vset) : entry.vout_v;
+        if ((entry.vmin_v > 0.0) && ((rail_vout[rail] < entry.vmin_v) || (rail_vout[rail] > entry.vmax_v))) {
+            static_flags[rail] |= POWER_VOLTAGE;
+        }
+    }
+
+    return (true);
+}
+
+int power_model::find_rail(const std::string &name) const {
+
+    for (size_t rail = 0; rail < rail_list.size(); rail++) {
+        if (rail_list[rail].name == name) {
+            return ((int) rail);
+        }
+    }
+
+    return (-1);
+}
+
+void power_model::evaluate(const power_scenario &scenario, power_result &result) const {
+
+    const power_model_options &opts = model_options;
+    const size_t num_rails = rail_list.size();
+    const double scale[4] = { 1.0, scenario.util * scenario.clock, scenario.io, scenario.gtx };
+    double static_w = 0.0;
+    double dynamic_w = 0.0;
+
+    result.rails.resize(num_rails);
+    for (size_t rail = 0; rail < num_rails; rail++) {
+        result.rails[rail] = rail_result();
+        result.rails[rail].vout_v = rail_vout[rail];
+    }
+
+    // FPGA power at the reference junction temperature, split into the part that leaks and the part that does not
+    for (size_t load = 0; load < load_list.size(); load++) {
+        const power_load &entry = load_list[load];
+        if (load_fpga[load]) {
+            const double vout = rail_vout[load_rail[load]];
+            static_w += vout * entry.static_a;
+            dynamic_w += vout * entry.dynamic_a * scale[(int) entry.scale];
+        }
+    }
+
+    // Junction temperature: Newton from the leakage free temperature, which is always below the root
+    double tj = scenario.ambient_c + (opts.fpga_theta_ja * dynamic_w);
+    bool settled = (static_w <= 0.0);
+    for (unsigned step = 0; (step < TJ_ITERATIONS) && !settled; step++) {
+        const double leak = static_w * std::exp(opts.leakage_per_c * (tj - opts.fpga_tj_ref_c));
+        const double f = scenario.ambient_c + (opts.fpga_theta_ja * (leak + dynamic_w)) - tj;
+        const double slope = (opts.fpga_theta_ja * opts.leakage_per_c * leak) - 1.0;
+        if (slope >= 0.0) {
+            break;
+        }
+        const double delta = -f / slope;
+        tj += delta;
+        settled = (std::fabs(delta) < TJ_TOLERANCE_C);
+    }
+    const double leakage = std::exp(opts.leakage_per_c * (tj - opts.fpga_tj_ref_c));
+
+    result.fpga_tj_c = tj;
+    result.fpga_w = (static_w * leakage) + dynamic_w;
+    result.violations = settled ? 0 : POWER_RUNAWAY;
+    if (tj > opts.fpga_tj_max_c) {
+        result.violations |= POWER_FPGA_TJ;
+    }
+
+    for (size_t load = 0; load < load_list.size(); load++) {
+        const power_load &entry = load_list[load];
+        const double leak = load_fpga[load] ? leakage : 1.0;
+        result.rails[load_rail[load]].iout_a += (entry.static_a * leak) + (entry.dynamic_a * scale[(int) entry.scale]);
+    }
+
+    // Children first: each rail's input current becomes part of its parent's output current
+    result.loss_w = 0.0;
+    result.worst_headroom = 1.0;
+    result.worst_rail = 0;
+    for (const size_t rail : order) {
+
+        const power_rail &entry = rail_list[rail];
+        rail_result &point = result.rails[rail];
+        const int parent = parent_index[rail];
+        const double vin = (parent >= 0) ? rail_vout[parent] : point.vout_v;
+
+        point.pout_w = point.vout_v * point.iout_a;
+        point.violations = static_flags[rail];
+        switch (entry.type) {
+            case rail_type::input:
+                point.iin_a = point.iout_a;
+                break;
+            case rail_type::smps:
+                point.loss_w = entry.q_w + (entry.k_v * point.iout_a) + (entry.r_ohm * point.iout_a * point.iout_a);
+                point.iin_a = (point.pout_w + point.loss_w) / vin;
+                break;
+            default:
+                point.iin_a = point.iout_a + entry.iq_a;
+                point.loss_w = ((vin - point.vout_v) * point.iout_a) + (vin * entry.iq_a);
+                if ((vin - point.vout_v) < entry.dropout_v) {
+                    point.violations |= POWER_DROPOUT;
+                }
+                break;
+        }
+        if (parent >= 0) {
+            result.rails[parent].iout_a += point.iin_a;
+        }
+
+        point.tj_c = scenario.ambient_c + (point.loss_w * entry.theta_ja);
+        if ((entry.theta_ja > 0.0) && (point.tj_c > entry.tj_max_c)) {
+            point.violations |= POWER_OVERTEMP;
+        }
+        if (entry.imax_a > 0.0) {
+            point.headroom = 1.0 - (point.iout_a / entry.imax_a);
+            if (point.iout_a > entry.imax_a) {
+                point.violations |= POWER_OVERCURRENT;
+            }
+        }
+        if (point.headroom < result.worst_headroom) {
+            result.worst_headroom = point.headroom;
+            result.worst_rail = rail;
+        }
+
+        result.loss_w += point.loss_w;
+        result.violations |= point.violations;
+        if (entry.type == rail_type::input) {
+            result.input_w = point.pout_w;
+        }
+    }
+}
+
+/* Sweeps */
+
+size_t sweep_axis::size() const {
+
+    if ((step <= 0.0) || (last <= first)) {
+        return (1);
+    }
+
+    // Tolerate the rounding of decimal steps so the last value is included
+    return ((size_t) std::floor(((last - first) / step) + 1e-9) + 1);
+}
+
+double sweep_axis::at(const size_t index) const {
+    return (first + ((double) index * step));
+}
+
+size_t power_sweep::size() const {
+    return (util.size() * clock.size() * io.size() * gtx.size() * ambient_c.size());
+}
+
+power_scenario power_sweep::at(size_t index) const {
+
+    power_scenario scenario;
+
+    scenario.util = util.at(index % util.size());
+    index /= util.size();
+    scenario.clock = clock.at(index % clock.size());
+    index /= clock.size();
+    scenario.io = io.at(index % io.size());
+    index /= io.size();
+    scenario.gtx = gtx.at(index % gtx.size());
+    index /= gtx.size();
+    scenario.ambient_c = ambient_c.at(index);
+
+    return (scenario);
+}
+
+// Fold one worker's findings into the total, ties go to the earlier scenario so the result does not depend on threads
+static void merge_summary(sweep_summary &total, const sweep_summary &part) {
+
+    total.failing += part.failing;
+    total.load_failing += part.load_failing;
+    total.violations |= part.violations;
+    for (size_t rail = 0; rail < total.rail_failing.size(); rail++) {
+        total.rail_failing[rail] += part.rail_failing[rail];
+    }
+    if ((part.worst_headroom < total.worst_headroom) ||
+        ((part.worst_headroom == total.worst_headroom) && (part.worst_headroom_scenario < total.worst_headroom_scenario))) {
+        total.worst_headroom = part.worst_headroom;
+        total.worst_headroom_scenario = part.worst_headroom_scenario;
+        total.worst_rail = part.worst_rail;
+    }
+    if ((part.hottest_tj_c > total.hottest_tj_c) ||
+        ((part.hottest_tj_c == total.hottest_tj_c) && (part.hottest_scenario < total.hottest_scenario))) {
+        total.hottest_tj_c = part.hottest_tj_c;
+        total.hottest_scenario = part.hottest_scenario;
+    }
+    if ((part.max_input_w > total.max_input_w) ||
+        ((part.max_input_w == total.max_input_w) && (part.max_input_scenario < total.max_input_scenario))) {
+        total.max_input_w = part.max_input_w;
+        total.max_input_scenario = part.max_input_scenario;
+    }
+}
+
+void run_power_sweep(const power_model &model, const power_sweep &sweep, const unsigned threads, sweep_summary &summary,
+                     std::vector<sweep_row> *rows) {
+
+    const size_t total = sweep.size();
+    const size_t num_rails = model.rails().size();
+    const unsigned workers = std::max(1u, (threads > 0) ? threads : std::thread::hardware_concurrency());
+    std::atomic<size_t> next {0};
+    std::vector<sweep_summary> parts(workers);
+    std::vector<std::thread> pool;
+
+    summary = sweep_summary();
+    summary.scenarios = total;
+    summary.rail_failing.assign(num_rails, 0);
+    if (rows != nullptr) {
+        rows->resize(total);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned worker = 0; worker < workers; worker++) {
+        pool.emplace_back([&, worker]() {
+
+            sweep_summary &part = parts[worker];
+            power_result result;
+
+            part.rail_failing.assign(num_rails, 0);
+            for (size_t first = next.fetch_add(SWEEP_BLOCK); first < total; first = next.fetch_add(SWEEP_BLOCK)) {
+                const size_t last = std::min(total, first + SWEEP_BLOCK);
+                for (size_t index = first; index < last; index++) {
+
+                    model.evaluate(sweep.at(index), result);
+
+                    if (result.violations != 0) {
+                        part.failing++;
+                        part.load_failing += ((result.violations & ~POWER_VOLTAGE) != 0) ? 1 : 0;
+                        part.violations |= result.violations;
+                        for (size_t rail = 0; rail < num_rails; rail++) {
+                            part.rail_failing[rail] += (result.rails[rail].violations != 0) ? 1 : 0;
+                        }
+                    }
+                    if (result.worst_headroom < part.worst_headroom) {
+                        part.worst_headroom = result.worst_headroom;
+                        part.worst_headroom_scenario = index;
+                        part.worst_rail = result.worst_rail;
+                    }
+                    if (result.fpga_tj_c > part.hottest_tj_c) {
+                        part.hottest_tj_c = result.fpga_tj_c;
+                        part.hottest_scenario = index;
+                    }
+                    if (result.input_w > part.max_input_w) {
+                        part.max_input_w = result.input_w;
+                        part.max_input_scenario = index;
+                    }
+                    if (rows != nullptr) {
+                        (*rows)[index] = sweep_row { index, (float) result.input_w, (float) result.fpga_tj_c, (float) result.worst_headroom,
+                                                     (uint16_t) result.worst_rail, (uint16_t) result.violations };
+                    }
+                }
+            }
+        });
+    }
+    for (std::thread &worker : pool) {
+        worker.join();
+    }
+
+    for (const sweep_summary &part : parts) {
+        merge_summary(summary, part);
+    }
+    summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
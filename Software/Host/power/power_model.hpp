@@ -0,0 +1,221 @@
+// Capstone Host Tools - Board Power Model
+// Rail tree, regulator losses and thermal rise of the mainboard power distribution, fast enough for what-if sweeps
+
+#ifndef POWER_MODEL_HPP
+#define POWER_MODEL_HPP
+
+/* Libraries */
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+*  The model is two tables exported from Documentation/PDN: the rails (regulator tree, PMIC settings and limits) and the
+*  loads hanging off them (per supply static and dynamic current from the XPE estimate and the board requirements
+*  sheet). A scenario scales the dynamic currents (FPGA utilization, clock, I/O activity, transceivers in use) and sets
+*  the ambient temperature. Evaluating it walks the tree once from the loads up to the input:
+*      SMPS:   loss = q + k * Iout + r * Iout^2, Iin = (Pout + loss) / Vin
+*      LDO:    Iin = Iout + Iq, loss = (Vin - Vout) * Iout + Vin * Iq
+*      Tj      = ambient + loss * theta_ja
+*  FPGA leakage depends on its own junction temperature, which is solved for before the rails are summed.
+*/
+
+/* Types */
+
+enum class rail_type : uint8_t {
+    input = 0,                                              // Board input, feeds everything else
+    smps = 1,                                               // Switching regulator
+    ldo = 2,                                                // Linear regulator
+    ref = 3                                                 // Voltage reference (handled like an LDO)
+};
+
+// One regulator output
+struct power_rail {
+    std::string name;                                       // "1V0", matches the firmware rail names
+    std::string parent;                                     // Rail that feeds this one, empty for the input
+    rail_type type = rail_type::smps;
+    std::string part;                                       // Regulator part number
+    double vout_v = 0.0;                                    // Nominal output voltage
+    double imax_a = 0.0;                                    // Regulator output current limit (0: not checked)
+    int vset = -1;                                          // TPS6287x VSET/CONTROL2 the firmware programs (-1: not a PMIC)
+    int ctrl2 = -1;
+    double vmin_v = 0.0;                                    // Window the programmed voltage has to fall in (0: not checked)
+    double vmax_v = 0.0;
+    double q_w = 0.0;                                       // SMPS fixed loss (switching, gate drive, quiescent)
+    double k_v = 0.0;                                       // SMPS loss proportional to current
+    double r_ohm = 0.0;                                     // SMPS conduction loss resistance (FETs plus inductor DCR)
+    double iq_a = 0.0;                                      // LDO/reference ground current
+    double dropout_v = 0.0;                                 // LDO minimum Vin - Vout at full load
+    double theta_ja = 0.0;                                  // Regulator junction to ambient thermal resistance (C/W, 0: not checked)
+    double tj_max_c = 0.0;                                  // Regulator junction limit
+};
+
+// How a load's dynamic current follows the scenario
+enum class load_scale : uint8_t {
+    fixed = 0,                                              // Does not change
+    logic = 1,                                              // Utilization * clock (VCCINT, VCCBRAM)
+    io = 2,                                                 // I/O activity (VCCO, VCCAUX)
+    gtx = 3                                                 // Transceiver lanes in use (MGT supplies)
+};
+
+// One supply pin group (or off-FPGA device) on a rail
+struct power_load {
+    std::string name;                                       // "VCCINT"
+    std::string rail;                                       // Rail it is powered from
+    std::string device;                                     // "fpga" loads heat the FPGA die and leak with its temperature
+    double static_a = 0.0;                                  // Static current at the reference junction temperature
+    double dynamic_a = 0.0;                                 // Dynamic current of the reference estimate
+    load_scale scale = load_scale::fixed;
+};
+
+// A what-if point, every factor relative to the reference estimate (1.0 = the XPE worst case)
+struct power_scenario {
+    double util = 1.0;                                      // Logic, BRAM and DSP utilization
+    double clock = 1.0;                                     // Fabric clock
+    double io = 1.0;                                        // I/O toggle activity
+    double gtx = 1.0;                                       // Transceiver lanes in use
+    double ambient_c = 35.0;                                // Board ambient (C)
+};
+
+// FPGA die thermal model, defaults from the Kintex-7 worst case XPE estimate
+struct power_model_options {
+    double fpga_theta_ja = 2.24;                            // Effective theta JA with the heat sink and airflow of the estimate (C/W)
+    double fpga_tj_ref_c = 99.6;                            // Junction temperature the static currents were estimated at
+    double fpga_tj_max_c = 100.0;                           // Industrial grade junction limit
+    double leakage_per_c = 0.032;                           // Exponential growth of static current with junction temperature (1/C)
+};
+
+/* Violation flags */
+static const uint32_t POWER_OVERCURRENT         = 0x01;     // Rail current above its regulator limit
+static const uint32_t POWER_OVERTEMP            = 0x02;     // Regulator junction above its limit
+static const uint32_t POWER_DROPOUT             = 0x04;     // LDO input too close to its output
+static const uint32_t POWER_VOLTAGE             = 0x08;     // Programmed PMIC voltage outside the rail window
+static const uint32_t POWER_FPGA_TJ             = 0x10;     // FPGA junction above its limit
+static const uint32_t POWER_RUNAWAY             = 0x20;     // FPGA leakage and temperature do not settle
+
+// Operating point of one rail
+struct rail_result {
+    double vout_v = 0.0;                                    // Programmed output voltage
+    double iout_a = 0.0;                                    // Output current (loads plus regulators fed from it)
+    double pout_w = 0.0;
+    double loss_w = 0.0;                                    // Dissipated in the regulator
+    double iin_a = 0.0;                                     // Current drawn from the parent rail
+    double tj_c = 0.0;                                      // Regulator junction temperature
+    double headroom = 1.0;                                  // 1 - Iout / Imax (1 when not checked)
+    uint32_t violations = 0;                                // POWER_* flags
+};
+
+// Operating point of the board
+struct power_result {
+    std::vector<rail_result> rails;                         // In power_model::rails() order
+    double input_w = 0.0;                                   // Drawn from the board input
+    double loss_w = 0.0;                                    // Dissipated in all regulators
+    double fpga_w = 0.0;                                    // Delivered to the FPGA
+    double fpga_tj_c = 0.0;
+    size_t worst_rail = 0;                                  // Rail with the least current headroom
+    double worst_headroom = 1.0;
+    uint32_t violations = 0;                                // Every rail's flags plus the FPGA ones
+};
+
+class power_model {
+public:
+    /* Load the rail and load tables (CSV, see Documentation/PDN/power_rails.csv and power_loads.csv). Returns false and
+    sets error on failure, the model is unchanged then */
+    bool load(const std::string &rails_path, const std::string &loads_path, std::string &error);
+
+    /* Build from tables in memory: checks every name, parent and load rail and that the tree has one input */
+    bool build(const std::vector<power_rail> &rail_table, const std::vector<power_load> &load_table, std::string &error);
+
+    /* Evaluate one scenario. result is reused between calls, so sweeps do not allocate */
+    void evaluate(const power_scenario &scenario, power_result &result) const;
+
+    const std::vector<power_rail> &rails() const { return (rail_list); }
+    const std::vector<power_load> &loads() const { return (load_list); }
+    power_model_options &options() { return (model_options); }
+    const power_model_options &options() const { return (model_options); }
+
+    // Index of a rail, -1 if unknown
+    int find_rail(const std::string &name) const;
+
+private:
+    std::vector<power_rail> rail_list;
+    std::vector<power_load> load_list;
+    power_model_options model_options;
+    std::vector<int> parent_index;                          // Per rail, -1 for the input
+    std::vector<size_t> order;                              // Rails with every child before its parent
+    std::vector<int> load_rail;                             // Per load
+    std::vector<uint8_t> load_fpga;                         // Per load, 1 if it is on the FPGA die
+    std::vector<double> rail_vout;                          // Programmed output voltage per rail
+    std::vector<uint32_t> static_flags;                     // Violations that do not depend on the scenario
+};
+
+// Grid of values of one scenario variable
+struct sweep_axis {
+    double first = 1.0;
+    double last = 1.0;
+    double step = 0.0;                                      // 0: the single value first
+
+    size_t size() const;
+    double at(const size_t index) const;
+};
+
+// Every combination of the axes, util varying fastest
+struct power_sweep {
+    sweep_axis util;
+    sweep_axis clock;
+    sweep_axis io;
+    sweep_axis gtx;
+    sweep_axis ambient_c = sweep_axis { 35.0, 35.0, 0.0 };
+
+    size_t size() const;
+    power_scenario at(size_t index) const;
+};
+
+// One evaluated sweep point
+struct sweep_row {
+    uint64_t scenario;                                      // Index into the sweep
+    float input_w;
+    float fpga_tj_c;
+    float worst_headroom;
+    uint16_t worst_rail;
+    uint16_t violations;
+};
+
+// What a sweep found
+struct sweep_summary {
+    size_t scenarios = 0;
+    size_t failing = 0;                                     // Scenarios with any violation
+    size_t load_failing = 0;                                // Of those, the ones failing on more than a programmed voltage
+    uint32_t violations = 0;                                // Every flag seen
+    std::vector<size_t> rail_failing;                       // Failing scenarios per rail
+    uint64_t worst_headroom_scenario = 0;                   // Least current headroom on any rail
+    double worst_headroom = 1.0;
+    size_t worst_rail = 0;
+    uint64_t hottest_scenario = 0;                          // Hottest FPGA junction
+    double hottest_tj_c = -1e9;
+    uint64_t max_input_scenario = 0;                        // Most input power
+    double max_input_w = 0.0;
+    double seconds = 0.0;                                   // Wall time of the sweep
+};
+
+/* Functions */
+
+/* Evaluate every scenario of a sweep on threads worker threads (0: one per core). rows, if not null, receives one row
+per scenario in sweep order */
+void run_power_sweep(const power_model &model, const power_sweep &sweep, const unsigned threads, sweep_summary &summary,
+                     std::vector<sweep_row> *rows);
+
+// "x" (single value) or "first:last:step"
+bool parse_sweep_axis(const std::string &text, sweep_axis &axis);
+
+// Output voltage (V) a TPS6287x produces for a CONTROL2/VSET pair, as the firmware computes it
+double tps6287x_vout(const int ctrl2, const int vset);
+
+const char *rail_type_name(const rail_type type);
+const char *load_scale_name(const load_scale scale);
+
+// Comma separated names of the set POWER_* flags ("ok" if none)
+std::string power_violation_names(const uint32_t violations);
+
+#endif
@@ -0,0 +1,408 @@
+// Capstone Mainboard Board Description
+// Pins, I2C devices, PMIC settings and the rail sequencing graph, checked by the compiler
+
+/*
+*  Everything the firmware knows about the board lives in constexpr tables here, and the static_asserts at the bottom
+*  reject a table that cannot be right before it reaches a board: two signals on one GPIO, an enable without a power
+*  good to watch, a rail that waits for a later sequencing group (or for itself), a PMIC programmed outside its rail
+*  window, two I2C devices on one address. PMIC_RAILS and the sequencer nodes are built from these tables by constexpr
+*  code rather than written out again. Code that walks the rails for protection uses for_each_rail(), which the compiler unrolls, so the hot path
+*  reads the table entries as immediates instead of looping over memory.
+*/
+
+#ifndef BOARD_HPP
+#define BOARD_HPP
+
+/* Libraries */
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string_view>
+#include <utility>
+#include "rail_seq.h"
+#include "tps6287x.h"
+#include "margin.h"
+
+/* GPIO Pin declarations */
+// Communications
+constexpr uint8_t I2C_0_SDA_PIN             = 16;           // I2C-0 (PMICs & Temp Sensor) Interface data pin [pulled up externally]
+constexpr uint8_t I2C_0_SCL_PIN             = 17;           // I2C-0 (PMICs & Temp Sensor) Interface clock pin [pulled up externally]
+
+// SMPS ICs
+constexpr uint8_t PIMC_1V0_EN               = 8;            // Enable singal for the 1.0V core SMPS [pulled down externally]
+constexpr uint8_t PIMC_1V8_EN               = 10;           // Enable singal for the 1.8V SMPS [pulled down externally]
+constexpr uint8_t PIMC_2V5_EN               = 11;           // Enable singal for the 2.5V SMPS [pulled down externally]
+constexpr uint8_t PIMC_3V3_EN               = 12;           // Enable singal for the 3.3V SMPS [pulled down externally]
+constexpr uint8_t PIMC_1V0_PG               = 2;            // Power good signal from the 1.0V core SMPS [pulled up externally]
+constexpr uint8_t PIMC_1V8_PG               = 3;            // Power good signal from the 1.8V SMPS [pulled up externally]
+constexpr uint8_t PIMC_2V5_PG               = 4;            // Power good signal from the 2.5V SMPS [pulled up externally]
+constexpr uint8_t PIMC_3V3_PG               = 5;            // Power good signal from the 3.3V SMPS [pulled up externally]
+
+// Linear Reg ICs
+constexpr uint8_t PIMC_3V3AUX_PG            = 1;            // Power good signal from the 3.3V auxiliary rail linear reg [pulled up externally]
+constexpr uint8_t PIMC_1V0GTX_EN            = 13;           // Enable singal for the 1.0V GTX transceiver linear reg [pulled down externally]
+constexpr uint8_t PIMC_1V2GTX_EN            = 14;           // Enable singal for the 1.2V GTX transceiver linear reg [pulled down externally]
+constexpr uint8_t PIMC_1V8GTX_EN            = 15;           // Enable singal for the 1.8V GTX transceiver linear reg [pulled down externally]
+constexpr uint8_t PIMC_1V0GTX_PG            = 6;            // Power good signal from the 1.0V GTX transceiver linear reg [pulled up externally]
+constexpr uint8_t PIMC_1V2GTX_PG            = 7;            // Power good signal from the 1.2V GTX transceiver linear reg [pulled up externally]
+
+// FPGA Control
+constexpr uint8_t FPGA_CONFDONE             = 19;           // FPGA Configuration done indicator: [Output] high indicates completion of the configuration sequence
+constexpr uint8_t FPGA_INIT_CRCERR          = 20;           // FPGA Initialization done or CRC error signal: [Bidirectional, pulled up externally] Low when in initializing/reset state, or when a configuration error occurs. Hold low to stall the power-on configuration sequence.
+constexpr uint8_t FPGA_NRESET               = 21;           // FPGA Reset (active low) signal: [Input, pulled up externally] Pulse (or hold) low to reset the FPGA. Holding low does not stop the configuration process.
+
+// Indication
+constexpr uint8_t IND_PWR_STATUS_GREEN      = 23;           // Indicator 1-Green: PMIC Initialization status {Blinking: Starting, Solid: Done}
+constexpr uint8_t IND_PWR_STATUS_ORANGE     = 24;           // Indicator 1-Orange: PMIC Output status {Blinking: Failure, Solid: Overtemperature}
+constexpr uint8_t IND_FPGA_IMG_GREEN        = 25;           // Indicator 2-Green: FPGA Boot process {Blinking: In progress, Solid: Successful}
+constexpr uint8_t IND_FPGA_IMG_ORANGE       = 26;           // Indicator 2-Orange: FPGA Boot error {Blinking: CRC Error, Solid: General failure}
+constexpr uint8_t IND_UC_STATUS_GREEN       = 27;           // Indicator 3-Green: Microcontroller boot status A {Blinking: USB Connected, Solid: Successful}
+constexpr uint8_t IND_UC_STATUS_ORANGE      = 28;           // Indicator 3-Orange: Microcontroller boot status B {Blinking: Boot or PMIC comm failure, Solid: Booting}
+
+// Misc
+constexpr uint8_t MASTER_PWR_GOOD           = 0;            // Global power status output, driven by the PIO power good monitor [pulled up externally]
+constexpr uint8_t UNUSED_PIN                = 9;            // Unused [pulled down externally]
+constexpr uint8_t DIAG_USB_CONN             = 18;           // USB connection indicator: high when connected
+constexpr uint8_t PWR_IN_MOD_RESERVED       = 22;           // Reserved for use with future power input module. Until then: FPGA load hint for DVS (low = idle)
+constexpr uint8_t PWR_INPUT_SENSE           = 29;           // Analog signal for monitoring input voltage: proportional to unprotected input divided by 2
+
+// PIMC I2C Addresses
+constexpr uint8_t PMIC_1V0_ADDR             = 0x40;         // TPS62872QWRXSRQ1 PMIC address for the 1.0V rail
+constexpr uint8_t PMIC_1V8_ADDR             = 0x41;         // TPS62871QWRXSRQ1 PMIC address for the 1.8V rail
+constexpr uint8_t PMIC_2V5_ADDR             = 0x43;         // TPS62871QWRXSRQ1 PMIC address for the 2.5V rail
+constexpr uint8_t PMIC_3V3_ADDR             = 0x42;         // TPS62870QWRXSRQ1 PMIC address for the 3.3V rail
+
+// Temperature Sensor I2C Addresses (7-bit, TMP1075 A2..A0 select 0x48 to 0x4F)
+constexpr uint8_t TEMP_SEN_1_ADDR           = 0x48;         // Temperature sensor address for the GTX linear reg region
+constexpr uint8_t TEMP_SEN_2_ADDR           = 0x49;         // Temperature sensor address for the 1V8 & 2V5 SMPS region
+constexpr uint8_t TEMP_SEN_3_ADDR           = 0x4A;         // Temperature sensor address for the 1V0 & 3V3 SMPS region
+
+// PIMC I2C Design Set Values (Device Specific)
+constexpr uint8_t PMIC_1V0_VSET_SET         = 0xF0;         // 1V0 PMIC VSET register set value
+constexpr uint8_t PMIC_1V8_VSET_SET         = 0x64;         // 1V8 PMIC VSET register set value
+constexpr uint8_t PMIC_2V5_VSET_SET         = 0xAA;         // 2V5 PMIC VSET register set value
+constexpr uint8_t PMIC_3V3_VSET_SET         = 0xFA;         // 3V3 PMIC VSET register set value
+constexpr uint8_t PMIC_1V0_CTRL2_SET        = 0b00000101;   // 1V0 PMIC CONTROL2 register set value
+constexpr uint8_t PMIC_1V8_CTRL2_SET        = 0b00001101;   // 1V8 PMIC CONTROL2 register set value
+constexpr uint8_t PMIC_2V5_CTRL2_SET        = 0b00001101;   // 2V5 PMIC CONTROL2 register set value
+constexpr uint8_t PMIC_3V3_CTRL2_SET        = 0b00001101;   // 3V3 PMIC CONTROL2 register set value
+constexpr uint8_t PMIC_1V0_VSET_IDLE        = 0xEC;         // 1V0 PMIC VSET value while the FPGA reports idle (0.99V, VCCINT minimum plus RAIL_SETPOINT_TOL_MV)
+
+// Rail Margining Windows (DS182 recommended operating conditions)
+constexpr uint16_t RAIL_1V0_MIN_MV          = 970;          // VCCINT/VCCBRAM minimum (in mV)
+constexpr uint16_t RAIL_1V0_MAX_MV          = 1030;         // VCCINT/VCCBRAM maximum (in mV)
+constexpr uint16_t RAIL_1V8_MIN_MV          = 1710;         // VCCAUX/VCCO 1.8V minimum (in mV)
+constexpr uint16_t RAIL_1V8_MAX_MV          = 1890;         // VCCAUX/VCCO 1.8V maximum (in mV)
+constexpr uint16_t RAIL_2V5_MIN_MV          = 2375;         // VCCO 2.5V minimum (in mV)
+constexpr uint16_t RAIL_2V5_MAX_MV          = 2625;         // VCCO 2.5V maximum (in mV)
+constexpr uint16_t RAIL_3V3_MIN_MV          = 3135;         // VCCO 3.3V minimum (in mV)
+constexpr uint16_t RAIL_3V3_MAX_MV          = 3465;         // VCCO 3.3V maximum (in mV)
+constexpr uint16_t RAIL_SETPOINT_TOL_MV     = 20;           // Kept above a rail minimum by fixed operating points: TPS6287x 1% accuracy plus load step droop (in mV)
+
+// Sequencing timing
+constexpr uint16_t SEQ_SETTLE_MS            = 1;            // Time a rail must have been enabled before its PG is trusted (in ms)
+constexpr uint16_t SEQ_NO_PG_SETTLE_MS      = 5;            // Time after which a rail without a PG pin counts as up (in ms)
+constexpr uint16_t SEQ_PG_TIMEOUT_MS        = 50;           // Time from enable by which a rail's PG must assert (in ms)
+
+/* Types */
+
+// FPGA power sequencing groups (DS182): every group is up before the next one starts, and goes down after it
+enum class seq_group : uint8_t {
+    always_on = 0,                                          // Comes up with the board input, no enable
+    a = 1,                                                  // VCCINT, VCCBRAM, VMGTAVCC
+    b = 2,                                                  // VCCAUX, VMGTAVTT, VMGTVCCAUX, VCCO 1.8V
+    c = 3                                                   // VCCO 2.5V/3.3V, VCC_QSFP
+};
+
+// One rail of the sequencing graph
+struct board_rail {
+    const char *name;                                       // Rail name used in logs ("1V0")
+    uint8_t en_pin;                                         // Enable GPIO (RAIL_SEQ_NO_PIN: always on)
+    uint8_t pg_pin;                                         // Power good GPIO (RAIL_SEQ_NO_PIN: none on the board)
+    seq_group group;
+    uint32_t after;                                         // Rails (bit per table index) that must be good first
+    uint16_t settle_ms;
+    uint16_t timeout_ms;
+    bool pg_exempt;                                         // Enabled rail without a PG pin, trusted once settled
+};
+
+// One TPS6287x and the rail it regulates
+struct board_pmic {
+    const char *name;
+    uint8_t address;                                        // 7-bit I2C address
+    uint8_t rail;                                           // Index into BOARD_RAILS
+    uint8_t temp_addr;                                      // 7-bit address of the TMP1075 next to it
+    uint8_t ctrl2;                                          // CONTROL2 design value
+    uint8_t vset;                                           // VSET design value
+    uint16_t min_mv;                                        // Rail window (in mV)
+    uint16_t max_mv;
+};
+
+/* Parameters */
+
+/*
+*  Rail sequencing graph (DS182, see Documentation/PDN/Kintex sequencing requirements.txt):
+*  Core:  VCCINT/VCCBRAM [1V0] → VCCAUX/VCCAUX_IO [1V8] → VCCO [1V8, 2V5, 3V3]
+*  GTX:   VCCINT [1V0] and VMGTAVCC [1V0GTX] in either order, VMGTVCCAUX [1V8GTX] after VCCINT, VMGTAVTT [1V2GTX] last
+*  Everything waits for the 3.3V auxiliary rail (no enable of its own). The 1.8V GTX regulator has no PG output on
+*  this board revision, so it counts as up once it has had SEQ_NO_PG_SETTLE_MS to ramp.
+*/
+enum { SEQ_3V3AUX, SEQ_1V0, SEQ_1V0GTX, SEQ_1V8, SEQ_1V8GTX, SEQ_1V2GTX, SEQ_2V5, SEQ_3V3, NUM_SEQ_RAILS };
+
+constexpr uint32_t seq_bit(const size_t rail) { return (1u << rail); }
+
+constexpr board_rail BOARD_RAILS[NUM_SEQ_RAILS] = {
+    { "3V3AUX", RAIL_SEQ_NO_PIN, PIMC_3V3AUX_PG, seq_group::always_on, 0, SEQ_SETTLE_MS, SEQ_PG_TIMEOUT_MS, false },
+    { "1V0", PIMC_1V0_EN, PIMC_1V0_PG, seq_group::a, seq_bit(SEQ_3V3AUX), SEQ_SETTLE_MS, SEQ_PG_TIMEOUT_MS, false },
+    { "1V0GTX", PIMC_1V0GTX_EN, PIMC_1V0GTX_PG, seq_group::a, seq_bit(SEQ_3V3AUX), SEQ_SETTLE_MS, SEQ_PG_TIMEOUT_MS, false },
+    { "1V8", PIMC_1V8_EN, PIMC_1V8_PG, seq_group::b, seq_bit(SEQ_1V0), SEQ_SETTLE_MS, SEQ_PG_TIMEOUT_MS, false },
+    { "1V8GTX", PIMC_1V8GTX_EN, RAIL_SEQ_NO_PIN, seq_group::b, seq_bit(SEQ_1V0), SEQ_NO_PG_SETTLE_MS, SEQ_PG_TIMEOUT_MS, true },
+    { "1V2GTX", PIMC_1V2GTX_EN, PIMC_1V2GTX_PG, seq_group::b, seq_bit(SEQ_1V0) | seq_bit(SEQ_1V0GTX) | seq_bit(SEQ_1V8GTX), SEQ_SETTLE_MS,
+      SEQ_PG_TIMEOUT_MS, false },
+    { "2V5", PIMC_2V5_EN, PIMC_2V5_PG, seq_group::c, seq_bit(SEQ_1V8), SEQ_SETTLE_MS, SEQ_PG_TIMEOUT_MS, false },
+    { "3V3", PIMC_3V3_EN, PIMC_3V3_PG, seq_group::c, seq_bit(SEQ_1V8), SEQ_SETTLE_MS, SEQ_PG_TIMEOUT_MS, false }
+};
+
+// Ordered by rail voltage, the PMICs are scanned and programmed from the last entry down
+constexpr board_pmic BOARD_PMICS[] = {
+    { "1V0", PMIC_1V0_ADDR, SEQ_1V0, TEMP_SEN_3_ADDR, PMIC_1V0_CTRL2_SET, PMIC_1V0_VSET_SET, RAIL_1V0_MIN_MV, RAIL_1V0_MAX_MV },
+    { "1V8", PMIC_1V8_ADDR, SEQ_1V8, TEMP_SEN_2_ADDR, PMIC_1V8_CTRL2_SET, PMIC_1V8_VSET_SET, RAIL_1V8_MIN_MV, RAIL_1V8_MAX_MV },
+    { "2V5", PMIC_2V5_ADDR, SEQ_2V5, TEMP_SEN_2_ADDR, PMIC_2V5_CTRL2_SET, PMIC_2V5_VSET_SET, RAIL_2V5_MIN_MV, RAIL_2V5_MAX_MV },
+    { "3V3", PMIC_3V3_ADDR, SEQ_3V3, TEMP_SEN_3_ADDR, PMIC_3V3_CTRL2_SET, PMIC_3V3_VSET_SET, RAIL_3V3_MIN_MV, RAIL_3V3_MAX_MV }
+};
+constexpr size_t NUM_BOARD_PMICS = sizeof(BOARD_PMICS) / sizeof(BOARD_PMICS[0]);
+
+// Temperature sensors in fault log snapshot order
+constexpr uint8_t BOARD_TEMP_SENSORS[] = { TEMP_SEN_1_ADDR, TEMP_SEN_2_ADDR, TEMP_SEN_3_ADDR };
+constexpr size_t NUM_BOARD_TEMP_SENSORS = sizeof(BOARD_TEMP_SENSORS) / sizeof(BOARD_TEMP_SENSORS[0]);
+
+// Every GPIO the firmware drives or reads, for the duplicate check
+constexpr uint8_t BOARD_PINS[] = {
+    I2C_0_SDA_PIN, I2C_0_SCL_PIN,
+    PIMC_1V0_EN, PIMC_1V8_EN, PIMC_2V5_EN, PIMC_3V3_EN, PIMC_1V0_PG, PIMC_1V8_PG, PIMC_2V5_PG, PIMC_3V3_PG,
+    PIMC_3V3AUX_PG, PIMC_1V0GTX_EN, PIMC_1V2GTX_EN, PIMC_1V8GTX_EN, PIMC_1V0GTX_PG, PIMC_1V2GTX_PG,
+    FPGA_CONFDONE, FPGA_INIT_CRCERR, FPGA_NRESET,
+    IND_PWR_STATUS_GREEN, IND_PWR_STATUS_ORANGE, IND_FPGA_IMG_GREEN, IND_FPGA_IMG_ORANGE, IND_UC_STATUS_GREEN, IND_UC_STATUS_ORANGE,
+    MASTER_PWR_GOOD, UNUSED_PIN, DIAG_USB_CONN, PWR_IN_MOD_RESERVED, PWR_INPUT_SENSE
+};
+constexpr uint8_t BOARD_NUM_GPIOS = 30;                    // GPIO0 to GPIO29 on the RP2040
+
+/* Functions */
+
+// PG pins of every rail that has one, in gpio_get_all() bit order
+constexpr uint32_t board_pg_mask() {
+
+    uint32_t mask = 0;
+
+    for (size_t index = 0; index < NUM_SEQ_RAILS; index++) {
+        if (BOARD_RAILS[index].pg_pin != RAIL_SEQ_NO_PIN) {
+            mask |= (1u << BOARD_RAILS[index].pg_pin);
+        }
+    }
+
+    return (mask);
+}
+
+constexpr uint32_t BOARD_PG_MASK = board_pg_mask();
+
+// Enable pins of every rail in a sequencing group, in gpio_get_all() bit order
+constexpr uint32_t board_group_en_mask(const seq_group group) {
+
+    uint32_t mask = 0;
+
+    for (const board_rail &rail : BOARD_RAILS) {
+        if ((rail.group == group) && (rail.en_pin != RAIL_SEQ_NO_PIN)) {
+            mask |= (1u << rail.en_pin);
+        }
+    }
+
+    return (mask);
+}
+
+/* Call f(std::integral_constant<size_t, index>) for every rail. The calls are expanded at compile time, so inside f
+BOARD_RAILS[index] is a constant expression and the generated code has no loop and no table reads */
+template <typename F, size_t... index>
+inline void for_each_rail(F &&f, std::index_sequence<index...>) {
+    (f(std::integral_constant<size_t, index> {}), ...);
+}
+
+template <typename F>
+inline void for_each_rail(F &&f) {
+    for_each_rail(f, std::make_index_sequence<NUM_SEQ_RAILS> {});
+}
+
+// Sequencer nodes for the C rail_seq API, built from BOARD_RAILS at compile time
+constexpr std::array<rail_seq_node_t, NUM_SEQ_RAILS> make_seq_nodes() {
+
+    std::array<rail_seq_node_t, NUM_SEQ_RAILS> nodes {};
+
+    for (size_t index = 0; index < NUM_SEQ_RAILS; index++) {
+        const board_rail &rail = BOARD_RAILS[index];
+        nodes[index] = rail_seq_node_t { rail.name, rail.en_pin, rail.pg_pin, rail.after, rail.settle_ms, rail.timeout_ms };
+    }
+
+    return (nodes);
+}
+
+// Margining/scrub view of every PMIC for the C modules, built from BOARD_PMICS at compile time (shadows: one per PMIC)
+constexpr std::array<pmic_rail_t, NUM_BOARD_PMICS> make_pmic_rails(pmic_shadow_t (&shadows)[NUM_BOARD_PMICS]) {
+
+    std::array<pmic_rail_t, NUM_BOARD_PMICS> rails {};
+
+    for (size_t index = 0; index < NUM_BOARD_PMICS; index++) {
+        const board_pmic &pmic = BOARD_PMICS[index];
+        rails[index] = pmic_rail_t { pmic.name, &shadows[index], BOARD_RAILS[pmic.rail].pg_pin, pmic.temp_addr, pmic.ctrl2, pmic.vset,
+                                     pmic.min_mv, pmic.max_mv };
+    }
+
+    return (rails);
+}
+
+/* Checks */
+
+constexpr bool board_pins_ok() {
+
+    constexpr size_t count = sizeof(BOARD_PINS) / sizeof(BOARD_PINS[0]);
+
+    for (size_t index = 0; index < count; index++) {
+        if (BOARD_PINS[index] >= BOARD_NUM_GPIOS) {
+            return (false);
+        }
+        for (size_t other = index + 1; other < count; other++) {
+            if (BOARD_PINS[index] == BOARD_PINS[other]) {
+                return (false);
+            }
+        }
+    }
+
+    return (true);
+}
+
+// Every enable has a PG to watch, unless the rail is marked exempt (and then it needs a settle time to trust instead)
+constexpr bool board_rails_watched() {
+
+    for (const board_rail &rail : BOARD_RAILS) {
+        if (rail.pg_exempt ? ((rail.pg_pin != RAIL_SEQ_NO_PIN) || (rail.settle_ms == 0)) :
+                             ((rail.en_pin != RAIL_SEQ_NO_PIN) && (rail.pg_pin == RAIL_SEQ_NO_PIN))) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Only always-on rails lack an enable, and they wait for nothing
+constexpr bool board_always_on_ok() {
+
+    for (const board_rail &rail : BOARD_RAILS) {
+        if ((rail.group == seq_group::always_on) != (rail.en_pin == RAIL_SEQ_NO_PIN)) {
+            return (false);
+        }
+        if ((rail.group == seq_group::always_on) && (rail.after != 0)) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+/* A rail waits only for rails listed before it (so the graph is acyclic and the table order is a valid power-up
+order), never for a rail of a later group, and for at least one rail of the group before its own */
+constexpr bool board_groups_ok() {
+
+    for (size_t index = 0; index < NUM_SEQ_RAILS; index++) {
+        const board_rail &rail = BOARD_RAILS[index];
+        bool follows_previous = (rail.group == seq_group::always_on);
+
+        if ((rail.after >> index) != 0) {
+            return (false);
+        }
+        for (size_t other = 0; other < index; other++) {
+            if (!(rail.after & seq_bit(other))) {
+                continue;
+            }
+            if (BOARD_RAILS[other].group > rail.group) {
+                return (false);
+            }
+            if ((uint8_t) BOARD_RAILS[other].group + 1 == (uint8_t) rail.group) {
+                follows_previous = true;
+            }
+        }
+        if (!follows_previous) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+constexpr bool board_pmics_ok() {
+
+    for (size_t index = 0; index < NUM_BOARD_PMICS; index++) {
+        const board_pmic &pmic = BOARD_PMICS[index];
+        const uint16_t mv = tps6287x_vset_to_mv(pmic.ctrl2, pmic.vset);
+
+        if ((mv < pmic.min_mv) || (mv > pmic.max_mv) || (pmic.rail >= NUM_SEQ_RAILS)) {
+            return (false);
+        }
+        if ((BOARD_RAILS[pmic.rail].pg_pin == RAIL_SEQ_NO_PIN) || (std::string_view(pmic.name) != BOARD_RAILS[pmic.rail].name)) {
+            return (false);
+        }
+        for (size_t other = index + 1; other < NUM_BOARD_PMICS; other++) {
+            if ((pmic.address == BOARD_PMICS[other].address) || (pmic.rail == BOARD_PMICS[other].rail)) {
+                return (false);
+            }
+        }
+    }
+
+    return (true);
+}
+
+// Every I2C address in 7-bit form and no two devices on one, every PMIC next to a listed temperature sensor
+constexpr bool board_i2c_ok() {
+
+    uint8_t addresses[NUM_BOARD_PMICS + NUM_BOARD_TEMP_SENSORS] {};
+    size_t count = 0;
+
+    for (const board_pmic &pmic : BOARD_PMICS) {
+        bool sensor_listed = false;
+        for (const uint8_t sensor : BOARD_TEMP_SENSORS) {
+            sensor_listed = sensor_listed || (pmic.temp_addr == sensor);
+        }
+        if (!sensor_listed) {
+            return (false);
+        }
+        addresses[count++] = pmic.address;
+    }
+    for (const uint8_t sensor : BOARD_TEMP_SENSORS) {
+        addresses[count++] = sensor;
+    }
+
+    for (size_t index = 0; index < count; index++) {
+        if (addresses[index] > 0x7F) {
+            return (false);
+        }
+        for (size_t other = index + 1; other < count; other++) {
+            if (addresses[index] == addresses[other]) {
+                return (false);
+            }
+        }
+    }
+
+    return (true);
+}
+
+static_assert(board_pins_ok(), "two board signals share a GPIO, or a pin is not on the RP2040");
+static_assert(board_rails_watched(), "a rail has an enable but no PG pin (mark it pg_exempt with a settle time if the board has none)");
+static_assert(board_always_on_ok(), "a rail without an enable must be always on and wait for nothing");
+static_assert(board_groups_ok(), "a rail waits for itself, a later rail or a later sequencing group, or skips the group before its own");
+static_assert(board_pmics_ok(), "a PMIC design value programs a voltage outside its rail window, two PMICs share an address or rail, "
+              "or a PMIC's rail is not the BOARD_RAILS entry of the same name with a PG pin");
+static_assert(board_i2c_ok(), "two I2C devices share an address, an address is not in 7-bit form, or a PMIC's sensor is not listed");
+static_assert((BOARD_RAILS[SEQ_1V2GTX].after & seq_bit(SEQ_1V0)) && (BOARD_RAILS[SEQ_1V2GTX].after & seq_bit(SEQ_1V0GTX)),
+              "VMGTAVTT [1V2GTX] must follow both VCCINT [1V0] and VMGTAVCC [1V0GTX] (DS182)");
+static_assert((tps6287x_vset_to_mv(PMIC_1V0_CTRL2_SET, PMIC_1V0_VSET_IDLE) >= (RAIL_1V0_MIN_MV + RAIL_SETPOINT_TOL_MV)) &&
+              (tps6287x_vset_to_mv(PMIC_1V0_CTRL2_SET, PMIC_1V0_VSET_IDLE) <= RAIL_1V0_MAX_MV),
+              "1V0 idle VSET leaves less than RAIL_SETPOINT_TOL_MV above the VCCINT minimum, or is above its maximum");
+
+#endif
@@ -0,0 +1,72 @@
+# Capstone Mainboard SRAM Placement Check
+# Fails the build if a fault path function is in flash, calls into flash or the fault path outgrows its SRAM budget
+#
+# Usage: cmake -DELF=<firmware.elf> -DNM=<nm> -DOBJDUMP=<objdump> -DSYMBOLS=<a,b,...> -DBUDGET_BYTES=<n> -P check_sram.cmake
+#
+# A function copied to SRAM still stalls on XIP if it calls something that stayed in flash, so every direct call
+# (bl) inside the listed functions must land in SRAM or the boot ROM. Calls through a pointer cannot be followed
+# here; list their targets as well.
+
+# RP2040 address map
+math(EXPR SRAM_START "0x20000000")
+math(EXPR SRAM_END "0x20042000")
+math(EXPR FLASH_START "0x10000000")
+math(EXPR FLASH_END "0x20000000")
+
+string(REPLACE "," ";" SYMBOLS "${SYMBOLS}")
+execute_process(COMMAND ${NM} -C -S --defined-only ${ELF} OUTPUT_VARIABLE NM_OUTPUT RESULT_VARIABLE NM_RESULT)
+if(NOT NM_RESULT EQUAL 0)
+    message(FATAL_ERROR "check_sram: cannot read symbols of ${ELF}")
+endif()
+string(REPLACE "\n" ";" NM_LINES "${NM_OUTPUT}")
+
+set(TOTAL_BYTES 0)
+set(ERRORS "")
+foreach(SYMBOL ${SYMBOLS})
+    # "address size type name", C++ names demangled with their argument list
+    set(FOUND FALSE)
+    foreach(LINE ${NM_LINES})
+        if(LINE MATCHES "^([0-9a-fA-F]+) ([0-9a-fA-F]+) [A-Za-z] ${SYMBOL}(\\(.*\\))?$")
+            set(FOUND TRUE)
+            math(EXPR ADDRESS "0x${CMAKE_MATCH_1}")
+            math(EXPR SIZE "0x${CMAKE_MATCH_2}")
+            break()
+        endif()
+    endforeach()
+
+    if(NOT FOUND)
+        list(APPEND ERRORS "${SYMBOL}: not found (inlined away or renamed)")
+        continue()
+    endif()
+    math(EXPR TOTAL_BYTES "${TOTAL_BYTES} + ${SIZE}")
+    if((ADDRESS LESS SRAM_START) OR (NOT ADDRESS LESS SRAM_END))
+        math(EXPR ADDRESS_HEX "${ADDRESS}" OUTPUT_FORMAT HEXADECIMAL)
+        list(APPEND ERRORS "${SYMBOL}: at ${ADDRESS_HEX}, not in SRAM")
+        continue()
+    endif()
+
+    # Every direct call must stay out of flash, including through a linker veneer
+    math(EXPR STOP "${ADDRESS} + ${SIZE}")
+    math(EXPR START_HEX "${ADDRESS}" OUTPUT_FORMAT HEXADECIMAL)
+    math(EXPR STOP_HEX "${STOP}" OUTPUT_FORMAT HEXADECIMAL)
+    execute_process(COMMAND ${OBJDUMP} -d -C --start-address=${START_HEX} --stop-address=${STOP_HEX} ${ELF} OUTPUT_VARIABLE DISASSEMBLY)
+    string(REGEX MATCHALL "\tbl\t[0-9a-fA-F]+ <[^>]+>" CALLS "${DISASSEMBLY}")
+    foreach(CALL ${CALLS})
+        string(REGEX MATCH "\tbl\t([0-9a-fA-F]+) <([^>]+)>" CALL "${CALL}")
+        math(EXPR CALL_ADDRESS "0x${CMAKE_MATCH_1}")
+        set(CALLEE "${CMAKE_MATCH_2}")
+        if(((NOT CALL_ADDRESS LESS FLASH_START) AND (CALL_ADDRESS LESS FLASH_END)) OR (CALLEE MATCHES "veneer"))
+            list(APPEND ERRORS "${SYMBOL}: calls ${CALLEE} in flash")
+        endif()
+    endforeach()
+endforeach()
+
+if(TOTAL_BYTES GREATER BUDGET_BYTES)
+    list(APPEND ERRORS "fault path is ${TOTAL_BYTES} bytes of SRAM, budget ${BUDGET_BYTES}")
+endif()
+
+if(ERRORS)
+    string(REPLACE ";" "\n    " ERRORS "${ERRORS}")
+    message(FATAL_ERROR "check_sram:\n    ${ERRORS}")
+endif()
+message(STATUS "check_sram: fault path in SRAM, ${TOTAL_BYTES} of ${BUDGET_BYTES} bytes")
@@ -0,0 +1,175 @@
+// Capstone Mainboard Deferred Log
+// printf-style status lines recorded as a format string address and raw argument words, formatted on the host
+
+/*
+*  A call costs an interrupt mask, a bounds check and one store per word: a few dozen cycles and no formatting. The
+*  text is rebuilt on the host from the format strings in the ELF (Software/Host dlog_decode).
+*
+*  Only the writers move head, only dlog_drain() moves tail, and head moves after the record it covers is complete.
+*  Writers serialize among themselves by masking interrupts for the few stores a record takes (the M0+ has no exclusive
+*  load/store to do it with), so interrupt handlers can log too. The drain masks them just as briefly while it copies
+*  a record out and moves tail past it. Only core 0 logs.
+*
+*  A full ring drops the new record. The ring always keeps room for one dropped-records marker: the first drop writes
+*  one in place of its record, and further drops count up in it for as long as it is the newest record. The marker
+*  therefore goes out after everything queued before the first drop and before anything queued once there was space
+*  again, so the host sees exactly where lines are missing.
+*/
+
+/* Libraries */
+#include <pico/stdlib.h>
+#include <hardware/sync.h>
+#include "dlog.h"
+
+/* Parameters */
+#define DLOG_RING_MASK (DLOG_RING_WORDS - 1)
+#define DLOG_HEADER_WORDS 2                                 // Format | count, time
+#define DLOG_MARKER_WORDS (DLOG_HEADER_WORDS + 1)           // Dropped-records marker: format 0 | 1, time, records dropped
+#define DLOG_FRAME_MAX (((DLOG_HEADER_WORDS + DLOG_MAX_ARGS) * 4) + 2)     // COBS adds one byte per 254, plus the delimiter
+
+_Static_assert((DLOG_RING_WORDS & DLOG_RING_MASK) == 0, "DLOG_RING_WORDS must be a power of two");
+
+/* Variables */
+static uint32_t ring[DLOG_RING_WORDS];
+static volatile uint32_t head = 0;                          // Words written (writers only)
+static volatile uint32_t tail = 0;                          // Words drained (dlog_drain() only)
+static volatile uint32_t dropped = 0;                       // Records lost to a full ring since boot
+static uint32_t marker_at = 0;                              // Ring position of the last dropped-records marker
+static bool marker_newest = false;                          // Nothing has been queued after that marker, drops count up in it
+
+/* Functions */
+
+// Append one record, or count it as dropped in the marker at the end of the ring
+static inline void put(const char *fmt, const uint32_t count, const uint32_t *args) {
+
+    const uint32_t saved = save_and_disable_interrupts();
+    const uint32_t start = head;
+
+    // Records leave room for a marker behind them, so a drop always has somewhere to go
+    if ((DLOG_RING_WORDS - (start - tail)) >= (DLOG_HEADER_WORDS + count + DLOG_MARKER_WORDS)) {
+        ring[start & DLOG_RING_MASK] = (uint32_t)(uintptr_t) fmt | count;
+        ring[(start + 1) & DLOG_RING_MASK] = time_us_32();
+        for (uint32_t index = 0; index < count; index++) {
+            ring[(start + DLOG_HEADER_WORDS + index) & DLOG_RING_MASK] = args[index];
+        }
+        __dmb();
+        head = start + DLOG_HEADER_WORDS + count;
+        marker_newest = false;
+    }
+    else if (marker_newest) {
+        ring[(marker_at + DLOG_HEADER_WORDS) & DLOG_RING_MASK]++;
+        dropped++;
+    }
+    else {
+        ring[start & DLOG_RING_MASK] = 1;
+        ring[(start + 1) & DLOG_RING_MASK] = time_us_32();
+        ring[(start + 2) & DLOG_RING_MASK] = 1;
+        __dmb();
+        head = start + DLOG_MARKER_WORDS;
+        marker_at = start;
+        marker_newest = true;
+        dropped++;
+    }
+
+    restore_interrupts(saved);
+}
+
+void dlog_write0(const char *fmt) {
+    put(fmt, 0, NULL);
+}
+
+void dlog_write1(const char *fmt, const uint32_t a0) {
+    put(fmt, 1, &a0);
+}
+
+void dlog_write2(const char *fmt, const uint32_t a0, const uint32_t a1) {
+    const uint32_t args[] = { a0, a1 };
+    put(fmt, 2, args);
+}
+
+void dlog_write3(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2) {
+    const uint32_t args[] = { a0, a1, a2 };
+    put(fmt, 3, args);
+}
+
+void dlog_write4(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3) {
+    const uint32_t args[] = { a0, a1, a2, a3 };
+    put(fmt, 4, args);
+}
+
+void dlog_write5(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, const uint32_t a4) {
+    const uint32_t args[] = { a0, a1, a2, a3, a4 };
+    put(fmt, 5, args);
+}
+
+void dlog_write6(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, const uint32_t a4,
+                 const uint32_t a5) {
+    const uint32_t args[] = { a0, a1, a2, a3, a4, a5 };
+    put(fmt, 6, args);
+}
+
+void dlog_write7(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, const uint32_t a4,
+                 const uint32_t a5, const uint32_t a6) {
+    const uint32_t args[] = { a0, a1, a2, a3, a4, a5, a6 };
+    put(fmt, 7, args);
+}
+
+// Send one record as a COBS frame: 0x00, the encoded bytes, 0x00
+static size_t send_frame(const uint32_t *words, const uint32_t num_words) {
+
+    uint8_t frame[DLOG_FRAME_MAX];
+    size_t code_at = 0;
+    size_t length = 1;
+    uint8_t code = 1;
+
+    for (uint32_t index = 0; index < (num_words * 4); index++) {
+        const uint8_t byte = (uint8_t)(words[index / 4] >> (8 * (index % 4)));
+        if (byte == 0) {
+            frame[code_at] = code;
+            code_at = length++;
+            code = 1;
+        }
+        else {
+            frame[length++] = byte;
+            code++;
+        }
+    }
+    frame[code_at] = code;
+
+    putchar_raw(0);
+    for (size_t index = 0; index < length; index++) {
+        putchar_raw(frame[index]);
+    }
+    putchar_raw(0);
+
+    return (length + 2);
+}
+
+bool dlog_drain(void) {
+
+    uint32_t words[DLOG_HEADER_WORDS + DLOG_MAX_ARGS];
+    size_t sent = 0;
+
+    while ((tail != head) && (sent < DLOG_DRAIN_BYTES)) {
+
+        // A drop counted into a marker between the copy and the tail move would be lost, so no writer runs in between
+        const uint32_t saved = save_and_disable_interrupts();
+        const uint32_t start = tail;
+        const uint32_t count = ring[start & DLOG_RING_MASK] & DLOG_MAX_ARGS;
+
+        for (uint32_t index = 0; index < (DLOG_HEADER_WORDS + count); index++) {
+            words[index] = ring[(start + index) & DLOG_RING_MASK];
+        }
+        tail = start + DLOG_HEADER_WORDS + count;
+        marker_newest = marker_newest && (tail != head);
+        restore_interrupts(saved);
+
+        sent += send_frame(words, DLOG_HEADER_WORDS + count);
+    }
+
+    return (tail != head);
+}
+
+uint32_t dlog_dropped(void) {
+    return (dropped);
+}
@@ -0,0 +1,96 @@
+// Capstone Mainboard Deferred Log
+// printf-style status lines recorded as a format string address and raw argument words, formatted on the host
+
+#ifndef DLOG_H
+#define DLOG_H
+
+/* Libraries */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Log parameters */
+#ifndef DLOG_TEXT
+#define DLOG_TEXT 0                                         // 1: DLOG() is plain printf, for a terminal without the decoder
+#endif
+#define DLOG_RING_WORDS 1024                                // Ring size (power of two, 4 kB)
+#define DLOG_MAX_ARGS 7                                     // Argument words per record (the format's low address bits hold the count)
+
+static const uint32_t DLOG_DRAIN_BYTES      = 512;          // Most a dlog_drain() call writes to stdio (about 1 ms of full speed USB)
+
+/*
+*  Record layout (words, little endian): format address | argument count, time_us_32(), then the arguments. Format
+*  strings are aligned to 8 bytes so the low 3 bits of their address are free for the count; address 0 is the
+*  dropped-records marker (one argument: how many, time: the first drop), queued in the ring where the records went
+*  missing. Each record goes out as one COBS frame between 0x00 bytes, which text never contains, so printf output and
+*  records can share the USB stream.
+*
+*  Arguments are 32-bit words: integers, characters and pointers. %s is decoded from the ELF, so it only works for
+*  strings the image holds (literals, const tables), not for buffers built at run time. No floating point.
+*/
+
+/* Functions */
+
+// Records a format string and its arguments, never waits. Use through DLOG()
+void dlog_write0(const char *fmt);
+void dlog_write1(const char *fmt, const uint32_t a0);
+void dlog_write2(const char *fmt, const uint32_t a0, const uint32_t a1);
+void dlog_write3(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2);
+void dlog_write4(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3);
+void dlog_write5(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, const uint32_t a4);
+void dlog_write6(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, const uint32_t a4,
+                 const uint32_t a5);
+void dlog_write7(const char *fmt, const uint32_t a0, const uint32_t a1, const uint32_t a2, const uint32_t a3, const uint32_t a4,
+                 const uint32_t a5, const uint32_t a6);
+
+/* Write queued records to stdio as frames, up to DLOG_DRAIN_BYTES (whole records only). Call from one place at a
+time, outside time critical code. Returns true if records are still waiting */
+bool dlog_drain(void);
+
+// Records lost to a full ring since boot
+uint32_t dlog_dropped(void);
+
+/* Macro layer */
+
+// Argument count, 0 to DLOG_MAX_ARGS
+#define DLOG_PICK(_0, _1, _2, _3, _4, _5, _6, _7, n, ...) n
+#define DLOG_NARGS(...) DLOG_PICK(_0, ##__VA_ARGS__, 7, 6, 5, 4, 3, 2, 1, 0)
+
+// Each argument as a 32-bit word
+#define DLOG_W(x) ((uint32_t)(uintptr_t)(x))
+#define DLOG_MAP0()
+#define DLOG_MAP1(a) , DLOG_W(a)
+#define DLOG_MAP2(a, b) , DLOG_W(a), DLOG_W(b)
+#define DLOG_MAP3(a, b, c) DLOG_MAP2(a, b), DLOG_W(c)
+#define DLOG_MAP4(a, b, c, d) DLOG_MAP3(a, b, c), DLOG_W(d)
+#define DLOG_MAP5(a, b, c, d, e) DLOG_MAP4(a, b, c, d), DLOG_W(e)
+#define DLOG_MAP6(a, b, c, d, e, f) DLOG_MAP5(a, b, c, d, e), DLOG_W(f)
+#define DLOG_MAP7(a, b, c, d, e, f, g) DLOG_MAP6(a, b, c, d, e, f), DLOG_W(g)
+
+#define DLOG_CAT(a, b) a##b
+#define DLOG_CALL(n, fmt, ...) DLOG_CAT(dlog_write, n)(fmt DLOG_CAT(DLOG_MAP, n)(__VA_ARGS__))
+
+/* DLOG(fmt, ...): log a printf-style line. The format has to be a string literal; it is checked against the arguments
+like printf (the check compiles away) and its address is what the host decodes */
+#if DLOG_TEXT
+#define DLOG(fmt, ...) printf(fmt, ##__VA_ARGS__)
+#else
+#define DLOG(fmt, ...) \
+    do { \
+        static const char dlog_fmt[] __attribute__((aligned(8))) = fmt; \
+        if (0) { \
+            printf(fmt, ##__VA_ARGS__); \
+        } \
+        DLOG_CALL(DLOG_NARGS(__VA_ARGS__), dlog_fmt, ##__VA_ARGS__); \
+    } while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
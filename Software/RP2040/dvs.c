@@ -0,0 +1,168 @@
+// Capstone Mainboard Dynamic Core Voltage Scaling
+// Slews the 1V0 (VCCINT/VCCBRAM) rail between validated operating points on FPGA load hints
+
+/*
+*  The FPGA drives the hint pin low while its ADC pipeline is idle and releases it (pulled up here) when work is
+*  about to start. Moves are margin walks, so every change is rate limited, stays inside the rail window and is checked
+*  (PG, temperature, STATUS, FPGA still configured) step by step, one dvs_step() per MARGIN_STEP_DWELL_MS. If lowering ever fails a check the rail
+*  is already back at full load and scaling locks out until re-enabled, so a bad idle point costs power, not uptime.
+*
+*  The FPGA must allow for the upward slew before loading the core: (idle to full distance / MARGIN_MAX_STEP) steps
+*  of MARGIN_STEP_DWELL_MS each, plus DVS_HINT_DEBOUNCE_MS.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include "tps6287x.h"
+#include "margin.h"
+#include "dvs.h"
+
+/* Functions */
+
+// Clamp a VSET value into the rail window
+static uint8_t clamp_to_window(const pmic_rail_t *rail, const uint8_t vset) {
+
+    uint8_t clamped = vset;
+
+    while ((tps6287x_vset_to_mv(rail->ctrl2, clamped) < rail->limit_lo_mv) && (clamped < rail->vset_nominal)) {
+        clamped++;
+    }
+    while ((tps6287x_vset_to_mv(rail->ctrl2, clamped) > rail->limit_hi_mv) && (clamped > rail->vset_nominal)) {
+        clamped--;
+    }
+
+    return (clamped);
+}
+
+// A move has ended: note the new level, or lock scaling out if lowering failed
+static int move_done(dvs_state_t *dvs, const dvs_level_t level, const int result) {
+
+    dvs->moving = false;
+
+    if (result == 0) {
+        dvs->applied_level = level;
+        printf("DVS: %s rail at %u mV (%s)\n", dvs->rail->name, tps6287x_vset_to_mv(dvs->rail->ctrl2, dvs->vset_points[level]),
+               ((level == DVS_LEVEL_IDLE) ? "idle" : "full load"));
+    }
+    else if (level == DVS_LEVEL_IDLE) {
+        // The walk has already taken the rail back to full load
+        dvs->fault = true;
+        printf("ERROR: DVS check failed lowering the %s rail - scaling locked at full load\n", dvs->rail->name);
+    }
+    else {
+        printf("ERROR: DVS could not restore the %s rail (code %d)\n", dvs->rail->name, result);
+    }
+
+    return (result);
+}
+
+// Start moving the rail to the operating point for a level, with its first step
+static int start_level(dvs_state_t *dvs, i2c_inst_t *i2c, const dvs_level_t level, margin_design_check_fn design_check) {
+
+    int result = 0;
+
+    // Going up is always allowed, a glitch on the way must not leave the core under-volted
+    if (level == DVS_LEVEL_FULL) {
+        result = margin_restore_start(i2c, dvs->rail, &dvs->walk);
+    }
+    else {
+        result = margin_set_vset_start(i2c, dvs->rail, dvs->vset_points[level], design_check, &dvs->walk);
+    }
+    if (result != 0) {
+        return (move_done(dvs, level, result));
+    }
+
+    dvs->moving = true;
+    dvs->moving_to = level;
+    return (dvs_step(dvs, i2c));
+}
+
+void dvs_init(dvs_state_t *dvs, const pmic_rail_t *rail, const uint8_t hint_pin, const uint8_t vset_idle) {
+
+    dvs->rail = rail;
+    dvs->hint_pin = hint_pin;
+    dvs->vset_points[DVS_LEVEL_FULL] = rail->vset_nominal;
+    dvs->vset_points[DVS_LEVEL_IDLE] = clamp_to_window(rail, vset_idle);
+    dvs->applied_level = DVS_LEVEL_FULL;
+    dvs->pending_level = DVS_LEVEL_FULL;
+    dvs->pending_since_us = time_us_64();
+    dvs->enabled = false;
+    dvs->fault = false;
+    dvs->moving = false;
+    dvs->moving_to = DVS_LEVEL_FULL;
+
+    // Undriven hint reads as full load
+    gpio_init(hint_pin);
+    gpio_set_dir(hint_pin, GPIO_IN);
+    gpio_pull_up(hint_pin);
+}
+
+bool dvs_set_idle_from_shmoo(dvs_state_t *dvs, const margin_shmoo_t *shmoo) {
+
+    uint16_t vset = 0;
+
+    if (shmoo->rail != dvs->rail) {
+        return (false);
+    }
+
+    vset = (uint16_t) shmoo->vset_lowest_pass + DVS_GUARD_LSB;
+    if (vset > dvs->rail->vset_nominal) {
+        vset = dvs->rail->vset_nominal;
+    }
+    dvs->vset_points[DVS_LEVEL_IDLE] = clamp_to_window(dvs->rail, (uint8_t) vset);
+
+    return (true);
+}
+
+void dvs_enable(dvs_state_t *dvs, const bool enable) {
+
+    dvs->enabled = enable;
+    dvs->fault = false;
+    dvs->pending_since_us = time_us_64();
+}
+
+int dvs_poll(dvs_state_t *dvs, i2c_inst_t *i2c, margin_design_check_fn design_check) {
+
+    dvs_level_t requested = gpio_get(dvs->hint_pin) ? DVS_LEVEL_FULL : DVS_LEVEL_IDLE;
+    uint64_t now_us = time_us_64();
+
+    if (dvs->moving) {
+        return (0);
+    }
+
+    // Off (or locked out) means full load, straight away
+    if (!dvs->enabled || dvs->fault) {
+        return ((dvs->applied_level != DVS_LEVEL_FULL) ? start_level(dvs, i2c, DVS_LEVEL_FULL, design_check) : 0);
+    }
+
+    // Restart the debounce window whenever the hint changes
+    if (requested != dvs->pending_level) {
+        dvs->pending_level = requested;
+        dvs->pending_since_us = now_us;
+        return (0);
+    }
+
+    if ((requested == dvs->applied_level) || ((now_us - dvs->pending_since_us) < ((uint64_t) DVS_HINT_DEBOUNCE_MS * 1000))) {
+        return (0);
+    }
+
+    return (start_level(dvs, i2c, requested, design_check));
+}
+
+int dvs_step(dvs_state_t *dvs, i2c_inst_t *i2c) {
+
+    int result = 0;
+
+    if (!dvs->moving) {
+        return (0);
+    }
+
+    result = margin_step(i2c, &dvs->walk);
+    if (result == MARGIN_BUSY) {
+        return (result);
+    }
+
+    return (move_done(dvs, dvs->moving_to, result));
+}
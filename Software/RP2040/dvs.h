@@ -0,0 +1,70 @@
+// Capstone Mainboard Dynamic Core Voltage Scaling
+// Slews the 1V0 (VCCINT/VCCBRAM) rail between validated operating points on FPGA load hints
+
+#ifndef DVS_H
+#define DVS_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+#include <hardware/i2c.h>
+#include "margin.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* DVS parameters */
+static const uint32_t DVS_HINT_DEBOUNCE_MS  = 50;           // Time a load hint has to be stable before the rail is moved (in ms)
+static const uint8_t DVS_GUARD_LSB          = 4;            // Margin kept above the lowest passing shmoo point when deriving an idle point (in VSET LSBs)
+
+// Load levels signalled by the FPGA
+typedef enum {
+    DVS_LEVEL_IDLE = 0,                                     // ADC pipeline idle: rail may sit at the idle operating point
+    DVS_LEVEL_FULL = 1,                                     // Full load: rail at its design value
+    DVS_NUM_LEVELS
+} dvs_level_t;
+
+/* Types */
+
+// State of one DVS controlled rail
+typedef struct {
+    const pmic_rail_t *rail;                                // Rail being scaled
+    uint8_t hint_pin;                                       // GPIO carrying the load hint (low = idle, high or floating = full load)
+    uint8_t vset_points[DVS_NUM_LEVELS];                    // VSET value for each load level
+    dvs_level_t applied_level;                              // Level the rail is currently set for
+    dvs_level_t pending_level;                              // Level the hint is currently asking for
+    uint64_t pending_since_us;                              // When the hint last changed
+    bool enabled;                                           // Closed loop scaling on/off (off leaves the rail at full load)
+    bool fault;                                             // A check failed while lowering, scaling stays locked at full load
+    bool moving;                                            // A move is in progress, dvs_step() drives it
+    dvs_level_t moving_to;                                  // Level the move in progress is heading for
+    margin_walk_t walk;                                     // The move in progress
+} dvs_state_t;
+
+/* Functions */
+
+/* Set up a rail for DVS. The idle point is clamped to the rail window. Scaling starts disabled at full load */
+void dvs_init(dvs_state_t *dvs, const pmic_rail_t *rail, const uint8_t hint_pin, const uint8_t vset_idle);
+
+/* Derive the idle point from a shmoo of the same rail: lowest passing value plus DVS_GUARD_LSB, never below the rail window.
+Returns false (and leaves the idle point alone) if the shmoo belongs to another rail */
+bool dvs_set_idle_from_shmoo(dvs_state_t *dvs, const margin_shmoo_t *shmoo);
+
+/* Enable or disable scaling. Disabling returns the rail to full load at the next dvs_poll(), without waiting for the hint */
+void dvs_enable(dvs_state_t *dvs, const bool enable);
+
+/* Sample the load hint and start moving the rail if a new level has been stable for DVS_HINT_DEBOUNCE_MS. Call
+periodically. Returns MARGIN_BUSY if a move is under way (call dvs_step() MARGIN_STEP_DWELL_MS later), 0 if there was
+nothing to start (or a move is already running) or the MARGIN_ERR code of a move that ended straight away */
+int dvs_poll(dvs_state_t *dvs, i2c_inst_t *i2c, margin_design_check_fn design_check);
+
+/* Take the move in progress one VSET step further. Returns MARGIN_BUSY while it is still going (call again
+MARGIN_STEP_DWELL_MS later), then 0 or the MARGIN_ERR code of the move */
+int dvs_step(dvs_state_t *dvs, i2c_inst_t *i2c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
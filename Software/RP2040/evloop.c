@@ -0,0 +1,342 @@
+// Capstone Mainboard Event Loop
+// Run-to-completion tasks with priorities, message queues and a hierarchical timer wheel, on the target or a host
+
+/*
+*  Tasks never block: a handler runs one message to completion and returns. Anything that has to wait (a rail ramp, the
+*  next telemetry sample) sets a timer, and the timer posts a message later. With no preemption the worst case latency
+*  of a task is the longest handler of any task plus its own queue, and every task keeps a record of both, measured
+*  from the post (or the moment its timer was due) to the handler starting.
+*
+*  The run order is kept sorted by priority, so picking the next task is one count-trailing-zeros on the ready bits.
+*
+*  Timers live in a hierarchical wheel: level 0 has one slot per millisecond for the next 64 ms, level 1 one slot per
+*  64 ms, level 2 one slot per 4.096 s. Starting or stopping a timer is a list insert or unlink, and each millisecond
+*  tick only looks at one slot. When level 0 wraps the next level 1 slot is spread over it (and level 2 over level 1
+*  when that wraps), so every timer is moved at most twice before it fires. Timers further out than the wheel reaches
+*  sit in the last slot it does reach and are filed again from there.
+*
+*  Nothing here depends on the Pico SDK: time, the lock against interrupt posts and idling come from the port, so the
+*  same file builds on a host for the simulation in Software/Host.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include "evloop.h"
+
+/* Parameters */
+#define EVLOOP_SLOT_MASK (EVLOOP_WHEEL_SLOTS - 1)
+#define EVLOOP_SPAN(level) (1u << (EVLOOP_WHEEL_BITS * ((level) + 1)))  // Ticks a level reaches ahead
+
+/* Functions */
+
+// Lowest set bit, the next slot or task in order
+static uint32_t lowest_bit(const uint64_t bits) {
+    return ((uint32_t) __builtin_ctzll(bits));
+}
+
+// File a timer in the slot its expiry tick falls into
+static void wheel_insert(evloop_t *loop, evloop_timer_t *timer) {
+
+    const int32_t delta = (int32_t)(timer->expires - loop->tick);
+    uint32_t target = timer->expires;
+    uint8_t level = 0;
+
+    // Overdue: the next tick
+    if (delta < 0) {
+        target = loop->tick + 1;
+    }
+    else {
+        while ((level < (EVLOOP_WHEEL_LEVELS - 1)) && ((uint32_t) delta >= EVLOOP_SPAN(level))) {
+            level++;
+        }
+        if ((uint32_t) delta >= EVLOOP_SPAN(level)) {
+            target = loop->tick + EVLOOP_SPAN(level) - 1;
+        }
+    }
+
+    const uint8_t slot = (uint8_t)((target >> (EVLOOP_WHEEL_BITS * level)) & EVLOOP_SLOT_MASK);
+    evloop_timer_t **head = &loop->wheel[level][slot];
+
+    timer->level = level;
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = *head;
+    if (*head != NULL) {
+        (*head)->prev = timer;
+    }
+    *head = timer;
+    loop->occupied[level] |= 1ull << slot;
+}
+
+// Take a timer out of its slot
+static void wheel_remove(evloop_t *loop, evloop_timer_t *timer) {
+
+    if (timer->prev != NULL) {
+        timer->prev->next = timer->next;
+    }
+    else {
+        loop->wheel[timer->level][timer->slot] = timer->next;
+    }
+    if (timer->next != NULL) {
+        timer->next->prev = timer->prev;
+    }
+    if (loop->wheel[timer->level][timer->slot] == NULL) {
+        loop->occupied[timer->level] &= ~(1ull << timer->slot);
+    }
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+// Detach a whole slot, returning its list
+static evloop_timer_t *wheel_take(evloop_t *loop, const uint8_t level, const uint8_t slot) {
+
+    evloop_timer_t *list = loop->wheel[level][slot];
+    loop->wheel[level][slot] = NULL;
+    loop->occupied[level] &= ~(1ull << slot);
+    return (list);
+}
+
+// Spread a slot of a higher level over the levels below it
+static void wheel_cascade(evloop_t *loop, const uint8_t level) {
+
+    const uint8_t slot = (uint8_t)((loop->tick >> (EVLOOP_WHEEL_BITS * level)) & EVLOOP_SLOT_MASK);
+    evloop_timer_t *timer = wheel_take(loop, level, slot);
+
+    while (timer != NULL) {
+        evloop_timer_t *next = timer->next;
+        wheel_insert(loop, timer);
+        timer = next;
+    }
+}
+
+// Queue a message, interrupts (or other threads) locked out by the caller
+static bool post_locked(evloop_t *loop, evloop_task_t *task, const uint16_t type, const uint32_t arg, const uint32_t posted_us) {
+
+    if (task->count >= EVLOOP_QUEUE_LEN) {
+        task->dropped++;
+        return (false);
+    }
+
+    evloop_msg_t *msg = &task->queue[(task->head + task->count) % EVLOOP_QUEUE_LEN];
+    msg->type = type;
+    msg->arg = arg;
+    msg->posted_us = posted_us;
+    task->count++;
+    loop->ready |= 1u << task->slot;
+    return (true);
+}
+
+/* Process the next millisecond: cascade where a level wraps, then fire what is due, due_us being when that was.
+last_tick is the tick this catch-up ends on */
+static void wheel_advance(evloop_t *loop, const uint32_t due_us, const uint32_t last_tick) {
+
+    loop->tick++;
+
+    // Higher levels first, so what they hand down is spread again by the one below
+    for (int level = EVLOOP_WHEEL_LEVELS - 1; level > 0; level--) {
+        if ((loop->tick & (EVLOOP_SPAN(level - 1) - 1)) == 0) {
+            wheel_cascade(loop, (uint8_t) level);
+        }
+    }
+
+    evloop_timer_t *timer = wheel_take(loop, 0, (uint8_t)(loop->tick & EVLOOP_SLOT_MASK));
+    while (timer != NULL) {
+        evloop_timer_t *next = timer->next;
+        timer->next = NULL;
+        timer->prev = NULL;
+
+        const uint32_t saved = loop->port.lock();
+        post_locked(loop, timer->task, timer->type, timer->arg, due_us);
+        loop->port.unlock(saved);
+        loop->timers_fired++;
+
+        if (timer->period_ms != 0) {
+            // Keep the period phase, but file it after the catch-up: periods that fell inside it are skipped, not
+            // each posted on one of the ticks processed below
+            timer->expires += timer->period_ms;
+            if ((int32_t)(timer->expires - last_tick) <= 0) {
+                timer->expires += ((last_tick - timer->expires) / timer->period_ms + 1) * timer->period_ms;
+            }
+            wheel_insert(loop, timer);
+        }
+        else {
+            timer->active = false;
+        }
+        timer = next;
+    }
+}
+
+// Turn the time since the last update into ticks
+static void update_time(evloop_t *loop) {
+
+    const uint32_t now = loop->port.now_us();
+
+    loop->pending_us += now - loop->last_us;
+    loop->last_us = now;
+
+    const uint32_t last_tick = loop->tick + (loop->pending_us / 1000);
+    while (loop->pending_us >= 1000) {
+        loop->pending_us -= 1000;
+        wheel_advance(loop, now - loop->pending_us, last_tick);
+    }
+}
+
+void evloop_init(evloop_t *loop, const evloop_port_t *port) {
+
+    loop->port = *port;
+    loop->num_tasks = 0;
+    loop->ready = 0;
+    for (uint8_t level = 0; level < EVLOOP_WHEEL_LEVELS; level++) {
+        for (uint32_t slot = 0; slot < EVLOOP_WHEEL_SLOTS; slot++) {
+            loop->wheel[level][slot] = NULL;
+        }
+        loop->occupied[level] = 0;
+    }
+    loop->tick = 0;
+    loop->last_us = loop->port.now_us();
+    loop->pending_us = 0;
+    loop->timers_fired = 0;
+}
+
+bool evloop_add_task(evloop_t *loop, evloop_task_t *task, const char *name, const uint8_t priority, evloop_handler_fn handler,
+                     void *context) {
+
+    if (loop->num_tasks >= EVLOOP_MAX_TASKS) {
+        return (false);
+    }
+
+    task->name = name;
+    task->priority = priority;
+    task->handler = handler;
+    task->context = context;
+    task->head = 0;
+    task->count = 0;
+    task->runs = 0;
+    task->dropped = 0;
+    task->max_latency_us = 0;
+    task->max_run_us = 0;
+
+    // Behind every task of the same or a higher priority
+    size_t position = loop->num_tasks;
+    while ((position > 0) && (loop->tasks[position - 1]->priority > priority)) {
+        loop->tasks[position] = loop->tasks[position - 1];
+        loop->tasks[position]->slot = (uint8_t) position;
+        position--;
+    }
+    loop->tasks[position] = task;
+    task->slot = (uint8_t) position;
+    loop->num_tasks++;
+
+    return (true);
+}
+
+bool evloop_post(evloop_t *loop, evloop_task_t *task, const uint16_t type, const uint32_t arg) {
+
+    const uint32_t saved = loop->port.lock();
+    const bool queued = post_locked(loop, task, type, arg, loop->port.now_us());
+    loop->port.unlock(saved);
+    return (queued);
+}
+
+void evloop_timer_start(evloop_t *loop, evloop_timer_t *timer, evloop_task_t *task, const uint16_t type, const uint32_t arg,
+                        const uint32_t delay_ms, const uint32_t period_ms) {
+
+    evloop_timer_stop(loop, timer);
+    update_time(loop);
+
+    timer->task = task;
+    timer->type = type;
+    timer->arg = arg;
+    timer->expires = loop->tick + ((delay_ms != 0) ? delay_ms : 1);
+    timer->period_ms = period_ms;
+    timer->active = true;
+    wheel_insert(loop, timer);
+}
+
+void evloop_timer_stop(evloop_t *loop, evloop_timer_t *timer) {
+
+    if (timer->active) {
+        wheel_remove(loop, timer);
+        timer->active = false;
+    }
+}
+
+bool evloop_run_once(evloop_t *loop) {
+
+    update_time(loop);
+
+    uint32_t saved = loop->port.lock();
+    if (loop->ready == 0) {
+        loop->port.unlock(saved);
+        return (false);
+    }
+
+    evloop_task_t *task = loop->tasks[lowest_bit(loop->ready)];
+    const evloop_msg_t msg = task->queue[task->head];
+    task->head = (uint8_t)((task->head + 1) % EVLOOP_QUEUE_LEN);
+    task->count--;
+    if (task->count == 0) {
+        loop->ready &= ~(1u << task->slot);
+    }
+    loop->port.unlock(saved);
+
+    const uint32_t start_us = loop->port.now_us();
+    task->handler(loop, task, &msg);
+    const uint32_t run_us = loop->port.now_us() - start_us;
+
+    const uint32_t latency_us = start_us - msg.posted_us;
+    task->runs++;
+    task->max_latency_us = (latency_us > task->max_latency_us) ? latency_us : task->max_latency_us;
+    task->max_run_us = (run_us > task->max_run_us) ? run_us : task->max_run_us;
+
+    return (true);
+}
+
+uint32_t evloop_idle_us(const evloop_t *loop) {
+
+    const uint32_t position = loop->tick & EVLOOP_SLOT_MASK;
+    uint32_t ticks = EVLOOP_MAX_IDLE_US / 1000;
+
+    // Nearest filed level 0 slot after this tick
+    if (loop->occupied[0] != 0) {
+        const uint32_t shift = (position + 1) & EVLOOP_SLOT_MASK;
+        const uint64_t rotated = (shift == 0) ? loop->occupied[0] : ((loop->occupied[0] >> shift) | (loop->occupied[0] << (64 - shift)));
+        ticks = lowest_bit(rotated) + 1;
+    }
+    // The next cascade may hand down something due on that very tick
+    for (uint8_t level = 1; level < EVLOOP_WHEEL_LEVELS; level++) {
+        if ((loop->occupied[level] != 0) && ((EVLOOP_WHEEL_SLOTS - position) < ticks)) {
+            ticks = EVLOOP_WHEEL_SLOTS - position;
+        }
+    }
+
+    const uint32_t idle_us = ticks * 1000;
+    const uint32_t elapsed_us = loop->pending_us + (loop->port.now_us() - loop->last_us);
+    if (idle_us > EVLOOP_MAX_IDLE_US) {
+        return (EVLOOP_MAX_IDLE_US);
+    }
+    return ((elapsed_us < idle_us) ? (idle_us - elapsed_us) : 0);
+}
+
+void evloop_run(evloop_t *loop) {
+
+    while (true) {
+        while (evloop_run_once(loop)) {
+        }
+        const uint32_t idle_us = evloop_idle_us(loop);
+        if ((idle_us != 0) && (loop->ready == 0)) {
+            loop->port.idle(idle_us);
+        }
+    }
+}
+
+void evloop_print(const evloop_t *loop) {
+
+    printf("Task\t\tPrio\tRuns\tDropped\tMax latency (us)\tMax run (us)\n");
+    for (size_t i = 0; i < loop->num_tasks; i++) {
+        const evloop_task_t *task = loop->tasks[i];
+        printf("%-15s\t%u\t%lu\t%lu\t%lu\t\t\t%lu\n", task->name, (unsigned) task->priority, (unsigned long) task->runs,
+               (unsigned long) task->dropped, (unsigned long) task->max_latency_us, (unsigned long) task->max_run_us);
+    }
+    printf("Timers fired %lu, %lu ms run\n", (unsigned long) loop->timers_fired, (unsigned long) loop->tick);
+}
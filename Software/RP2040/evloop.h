@@ -0,0 +1,130 @@
+// Capstone Mainboard Event Loop
+// Run-to-completion tasks with priorities, message queues and a hierarchical timer wheel, on the target or a host
+
+#ifndef EVLOOP_H
+#define EVLOOP_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Event loop parameters */
+#define EVLOOP_MAX_TASKS 16                                 // Tasks per loop (one ready bit each)
+#define EVLOOP_QUEUE_LEN 8                                  // Messages that can wait for a task
+#define EVLOOP_WHEEL_BITS 6                                 // Slots per wheel level: 64
+#define EVLOOP_WHEEL_LEVELS 3                               // 1 ms, 64 ms and 4.096 s slots, 262 s before a timer cascades again
+#define EVLOOP_WHEEL_SLOTS (1u << EVLOOP_WHEEL_BITS)
+
+static const uint32_t EVLOOP_MAX_IDLE_US    = 1000000;      // Longest idle wait when no timer is close (in us)
+
+/* Types */
+
+struct evloop;
+struct evloop_task;
+
+// What the loop needs from the platform
+typedef struct {
+    uint32_t (*now_us)(void);                               // Free running microsecond clock (wraps)
+    uint32_t (*lock)(void);                                 // Keep interrupts (or other threads) from posting, returns what unlock needs
+    void (*unlock)(const uint32_t saved);
+    void (*idle)(const uint32_t max_us);                    // Wait for max_us at most, returning early on anything that may have posted
+} evloop_port_t;
+
+// One message, copied into the receiving task's queue
+typedef struct {
+    uint16_t type;                                          // Meaning is up to the task
+    uint32_t arg;
+    uint32_t posted_us;                                     // When it was posted (timers: when they were due)
+} evloop_msg_t;
+
+// Runs one message to completion. Never waits: anything slow is a timer and a later message
+typedef void (*evloop_handler_fn)(struct evloop *loop, struct evloop_task *task, const evloop_msg_t *msg);
+
+// One task: a handler, its queue and its timing
+typedef struct evloop_task {
+    const char *name;                                       // Task name used in reports ("protect")
+    uint8_t priority;                                       // 0 runs first, equal priorities in the order they were added
+    evloop_handler_fn handler;
+    void *context;                                          // For the handler
+    evloop_msg_t queue[EVLOOP_QUEUE_LEN];
+    uint8_t head;                                           // Oldest waiting message
+    uint8_t count;                                          // Messages waiting
+    uint8_t slot;                                           // Position in the loop's run order (ready bit)
+    uint32_t runs;                                          // Messages handled
+    uint32_t dropped;                                       // Posts lost to a full queue
+    uint32_t max_latency_us;                                // Slowest post (or timer due) to handler start
+    uint32_t max_run_us;                                    // Slowest handler run
+} evloop_task_t;
+
+// A one-shot or periodic timer that posts a message when it expires
+typedef struct evloop_timer {
+    struct evloop_timer *next;                              // Wheel slot list
+    struct evloop_timer *prev;
+    evloop_task_t *task;                                    // Receives the message
+    uint16_t type;
+    uint32_t arg;
+    uint32_t expires;                                       // Tick it is due at
+    uint32_t period_ms;                                     // 0: one-shot
+    uint8_t level;                                          // Where it is filed, while active
+    uint8_t slot;
+    bool active;
+} evloop_timer_t;
+
+// The loop
+typedef struct evloop {
+    evloop_port_t port;
+    evloop_task_t *tasks[EVLOOP_MAX_TASKS];                 // Run order: priority, then order added
+    size_t num_tasks;
+    uint32_t ready;                                         // Tasks with messages waiting, bit per run order slot
+    evloop_timer_t *wheel[EVLOOP_WHEEL_LEVELS][EVLOOP_WHEEL_SLOTS];
+    uint64_t occupied[EVLOOP_WHEEL_LEVELS];                 // Non-empty slots, bit per slot
+    uint32_t tick;                                          // Milliseconds processed since evloop_init()
+    uint32_t last_us;                                       // Clock at the last update
+    uint32_t pending_us;                                    // Time since the last processed tick
+    uint32_t timers_fired;
+} evloop_t;
+
+/* Functions */
+
+// Set up an empty loop on a platform
+void evloop_init(evloop_t *loop, const evloop_port_t *port);
+
+/* Add a task to the run order. Tasks are added before the loop starts running, handler and priority set by the caller.
+Returns false if the loop is full */
+bool evloop_add_task(evloop_t *loop, evloop_task_t *task, const char *name, const uint8_t priority, evloop_handler_fn handler,
+                     void *context);
+
+/* Queue a message for a task. Safe from interrupts (or other threads) through the port lock. Returns false, and counts
+a drop, if the task's queue is full */
+bool evloop_post(evloop_t *loop, evloop_task_t *task, const uint16_t type, const uint32_t arg);
+
+/* Start (or restart) a timer: after delay_ms (at least 1) task receives type/arg, then every period_ms if that is not
+0. Insert and expiry are O(1) whatever the number of timers */
+void evloop_timer_start(evloop_t *loop, evloop_timer_t *timer, evloop_task_t *task, const uint16_t type, const uint32_t arg,
+                        const uint32_t delay_ms, const uint32_t period_ms);
+
+// Stop a timer, nothing happens if it is not running
+void evloop_timer_stop(evloop_t *loop, evloop_timer_t *timer);
+
+/* Bring the timers up to date and run the highest priority waiting message. Returns false if nothing was waiting */
+bool evloop_run_once(evloop_t *loop);
+
+/* Microseconds until a timer may expire (EVLOOP_MAX_IDLE_US at most), the longest the loop can idle */
+uint32_t evloop_idle_us(const evloop_t *loop);
+
+// Run forever: every waiting message in priority order, idling through the port in between
+void evloop_run(evloop_t *loop);
+
+// Prints every task's runs, drops and worst case latency and run time
+void evloop_print(const evloop_t *loop);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,295 @@
+// Capstone Mainboard Persistent Fault/Event Log
+// Append-only record log in the last flash sectors, staged in RAM and written outside time critical code
+
+/*
+*  The log is a circular array of 32 byte records spread over FAULT_LOG_SECTORS sectors at the top of flash. Records
+*  are appended in order and every sector is only erased ahead of the log wrapping back into it, so wear is spread evenly
+*  over the whole region. The newest record is the valid one with the highest sequence number. Slots with a bad CRC
+*  (power lost mid-write) are skipped, never reprogrammed.
+*
+*  fault_log_event() only copies a record into a RAM ring, so callers never wait on flash. fault_log_service() later
+*  programs each touched page once. NOR flash only clears bits, so reprogramming a page that already holds records
+*  with those same records plus new ones in blank slots is safe.
+*
+*  A sector erase keeps interrupts off for about 50 ms, too long for anything that runs with the rails up. So the
+*  service never erases: fault_log_prepare() erases the sector the log enters next, and the firmware only calls it
+*  where nothing is powered (boot, after a power-down). That is the sector after the current one, or the sector about
+*  to be entered when the write position sits on a sector boundary. A running board therefore has room for at least
+*  one whole sector (128 records), and at most the rest of the current sector on top of that, before records start
+*  waiting in RAM for the next safe point.
+*
+*  Erasing the whole log is the same: the host command only writes a FAULT_LOG_ERASE_REQUEST record, and the next
+*  fault_log_prepare() (at the latest the one at the next boot) erases every sector.
+*
+*  Core 1 is not used by this firmware. If it ever runs from flash it has to be locked out around the erase/program.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <pico/stdlib.h>
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include "fault_log.h"
+
+/* Log geometry */
+#define FAULT_LOG_OFFSET (PICO_FLASH_SIZE_BYTES - (FAULT_LOG_SECTORS * FLASH_SECTOR_SIZE))
+#define FAULT_LOG_SLOTS ((FAULT_LOG_SECTORS * FLASH_SECTOR_SIZE) / sizeof(fault_record_t))
+#define SLOTS_PER_SECTOR (FLASH_SECTOR_SIZE / sizeof(fault_record_t))
+#define SLOTS_PER_PAGE (FLASH_PAGE_SIZE / sizeof(fault_record_t))
+
+_Static_assert(sizeof(fault_record_t) == 32, "fault_record_t must stay 32 bytes");
+_Static_assert((FLASH_PAGE_SIZE % sizeof(fault_record_t)) == 0, "records must not straddle flash pages");
+
+extern char __flash_binary_end;                             // End of the firmware image (from the linker script)
+
+/* Variables */
+static fault_record_t stage[FAULT_LOG_STAGE_LEN];           // Records waiting for fault_log_service()
+static volatile uint8_t stage_head = 0;                     // Next stage[] entry to fill
+static volatile uint8_t stage_tail = 0;                     // Next stage[] entry to write to flash
+static uint32_t next_slot = 0;                              // Next log slot to program
+static uint32_t next_sequence = 0;                          // Sequence number of the next record
+static uint32_t boot_count = 0;                             // Boot count of the running firmware
+static uint32_t dropped_records = 0;                        // Records lost to a full staging buffer
+static int16_t temp_snapshot[FAULT_LOG_NUM_TEMPS];          // Last temperatures reported through fault_log_note_temp()
+static bool log_ready = false;                              // fault_log_init() found a usable log region
+static int32_t blank_sector = -1;                           // Sector erased ahead for the log to enter next (-1: none)
+static bool erase_pending = false;                          // An erase request is in the log (or staged) and not carried out yet
+static uint8_t page_buffer[FLASH_PAGE_SIZE];                // RAM image of the page being programmed
+
+/* Functions */
+
+// CRC-16/CCITT (poly 0x1021, init 0xFFFF)
+static uint16_t crc16(const uint8_t *data, const size_t len) {
+
+    uint16_t crc = 0xFFFF;
+
+    for (size_t index = 0; index < len; index++) {
+        crc ^= (uint16_t)(data[index] << 8);
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+
+    return (crc);
+}
+
+// Memory mapped (XIP) view of a slot
+static const fault_record_t *slot_ptr(const uint32_t slot) {
+    return ((const fault_record_t *)(XIP_BASE + FAULT_LOG_OFFSET + (slot * sizeof(fault_record_t))));
+}
+
+static bool record_valid(const fault_record_t *record) {
+    return ((record->sequence != 0xFFFFFFFF) && (record->crc == crc16((const uint8_t *) record, offsetof(fault_record_t, crc))));
+}
+
+static bool range_blank(const uint8_t *data, const size_t len) {
+
+    for (size_t index = 0; index < len; index++) {
+        if (data[index] != 0xFF) {
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// Erase a log sector unless it is already blank
+static void prepare_sector(const uint32_t slot) {
+
+    const uint32_t sector_offset = FAULT_LOG_OFFSET + ((slot / SLOTS_PER_SECTOR) * FLASH_SECTOR_SIZE);
+
+    if (!range_blank((const uint8_t *)(XIP_BASE + sector_offset), FLASH_SECTOR_SIZE)) {
+        uint32_t interrupts = save_and_disable_interrupts();
+        flash_range_erase(sector_offset, FLASH_SECTOR_SIZE);
+        restore_interrupts(interrupts);
+    }
+}
+
+bool fault_log_init(void) {
+
+    const fault_record_t *newest = NULL;
+
+    // The region has to sit above the firmware image
+    if ((uintptr_t) &__flash_binary_end > (XIP_BASE + FAULT_LOG_OFFSET)) {
+        printf("ERROR: Firmware image overlaps the fault log region - logging disabled\n");
+        log_ready = false;
+        return (false);
+    }
+
+    // Any erase request still in the log was never carried out, carrying it out wipes it too
+    erase_pending = false;
+    for (uint32_t slot = 0; slot < FAULT_LOG_SLOTS; slot++) {
+        const fault_record_t *record = slot_ptr(slot);
+        if (!record_valid(record)) {
+            continue;
+        }
+        if ((newest == NULL) || (record->sequence > newest->sequence)) {
+            newest = record;
+            next_slot = (slot + 1) % FAULT_LOG_SLOTS;
+        }
+        erase_pending |= (record->type == FAULT_LOG_ERASE_REQUEST);
+    }
+
+    if (newest != NULL) {
+        next_sequence = newest->sequence + 1;
+        boot_count = newest->boot_count + 1;
+    }
+    else {
+        next_slot = 0;
+        next_sequence = 0;
+        boot_count = 0;
+    }
+
+    log_ready = true;
+    return (true);
+}
+
+bool fault_log_event(const fault_log_type_t type, const uint8_t code, const uint32_t data) {
+
+    uint8_t head = stage_head;
+    uint8_t next_head = (uint8_t)((head + 1) % FAULT_LOG_STAGE_LEN);
+    fault_record_t *record = &stage[head];
+
+    if (next_head == stage_tail) {
+        dropped_records++;
+        return (false);
+    }
+
+    // Sequence and CRC are filled in when the record is written, the rest is captured now
+    record->boot_count = boot_count;
+    record->time_ms = (uint32_t)(time_us_64() / 1000);
+    record->gpio_state = gpio_get_all();
+    record->data = data;
+    for (uint8_t sensor = 0; sensor < FAULT_LOG_NUM_TEMPS; sensor++) {
+        record->temp_c_x16[sensor] = temp_snapshot[sensor];
+    }
+    record->type = (uint8_t) type;
+    record->code = code;
+    record->reserved = 0xFFFF;
+
+    stage_head = next_head;
+    return (true);
+}
+
+void fault_log_note_temp(const uint8_t sensor, const int16_t temp_c_x16) {
+
+    if (sensor < FAULT_LOG_NUM_TEMPS) {
+        temp_snapshot[sensor] = temp_c_x16;
+    }
+}
+
+void fault_log_service(void) {
+
+    while (log_ready && (stage_tail != stage_head)) {
+
+        const uint32_t page_slot = next_slot - (next_slot % SLOTS_PER_PAGE);
+        const uint32_t page_offset = FAULT_LOG_OFFSET + (page_slot * sizeof(fault_record_t));
+        bool page_dirty = false;
+
+        // Entering a sector means wrapping onto the oldest records. Only one fault_log_prepare() erased is entered here,
+        // otherwise the records stay staged until the next safe point
+        if ((next_slot % SLOTS_PER_SECTOR) == 0) {
+            if ((int32_t)(next_slot / SLOTS_PER_SECTOR) != blank_sector) {
+                break;
+            }
+            blank_sector = -1;
+        }
+
+        // Fill every blank slot left in this page from the staging buffer
+        memcpy(page_buffer, (const void *)(XIP_BASE + page_offset), FLASH_PAGE_SIZE);
+        while ((stage_tail != stage_head) && ((next_slot - page_slot) < SLOTS_PER_PAGE)) {
+
+            uint8_t *slot_image = &page_buffer[(next_slot - page_slot) * sizeof(fault_record_t)];
+
+            fault_record_t *record = &stage[stage_tail];
+
+            // A request staged before the erase it asked for has nothing left to ask for
+            if ((record->type == FAULT_LOG_ERASE_REQUEST) && !erase_pending) {
+                stage_tail = (uint8_t)((stage_tail + 1) % FAULT_LOG_STAGE_LEN);
+                continue;
+            }
+
+            if (range_blank(slot_image, sizeof(fault_record_t))) {
+                record->sequence = next_sequence++;
+                record->crc = crc16((const uint8_t *) record, offsetof(fault_record_t, crc));
+                memcpy(slot_image, record, sizeof(fault_record_t));
+                stage_tail = (uint8_t)((stage_tail + 1) % FAULT_LOG_STAGE_LEN);
+                page_dirty = true;
+            }
+
+            next_slot++;
+        }
+
+        if (page_dirty) {
+            uint32_t interrupts = save_and_disable_interrupts();
+            flash_range_program(page_offset, page_buffer, FLASH_PAGE_SIZE);
+            restore_interrupts(interrupts);
+        }
+
+        next_slot %= FAULT_LOG_SLOTS;
+    }
+}
+
+void fault_log_prepare(void) {
+
+    // The sector holding the write position was prepared when the log entered it, the next one may not be yet
+    const uint32_t sector = (uint32_t)(((next_slot + SLOTS_PER_SECTOR - 1) / SLOTS_PER_SECTOR) % FAULT_LOG_SECTORS);
+
+    if (!log_ready) {
+        return;
+    }
+    if (erase_pending) {
+        for (uint32_t erase = 0; erase < FAULT_LOG_SECTORS; erase++) {
+            prepare_sector(erase * SLOTS_PER_SECTOR);
+        }
+        next_slot = 0;
+        blank_sector = 0;
+        erase_pending = false;
+        return;
+    }
+    if ((int32_t) sector == blank_sector) {
+        return;
+    }
+    prepare_sector(sector * SLOTS_PER_SECTOR);
+    blank_sector = (int32_t) sector;
+}
+
+void fault_log_dump(void) {
+
+    uint32_t count = 0;
+
+    printf("Fault log: boot %lu, %lu records dropped this boot\n", (unsigned long) boot_count, (unsigned long) dropped_records);
+    printf("Seq\tBoot\tTime(ms)\tType\tCode\tData\t\tGPIO\t\tTemps(C)\n");
+
+    // Oldest record is the first valid one after the write position
+    for (uint32_t index = 0; index < FAULT_LOG_SLOTS; index++) {
+        const fault_record_t *record = slot_ptr((next_slot + index) % FAULT_LOG_SLOTS);
+        if (!record_valid(record)) {
+            continue;
+        }
+        printf("%lu\t%lu\t%lu\t\t%u\t%u\t0x%08lx\t0x%08lx", (unsigned long) record->sequence, (unsigned long) record->boot_count,
+               (unsigned long) record->time_ms, record->type, record->code, (unsigned long) record->data, (unsigned long) record->gpio_state);
+        for (uint8_t sensor = 0; sensor < FAULT_LOG_NUM_TEMPS; sensor++) {
+            printf("\t%d", record->temp_c_x16[sensor] / 16);
+        }
+        printf("\n");
+        count++;
+    }
+
+    printf("%lu records\n", (unsigned long) count);
+}
+
+bool fault_log_request_erase(void) {
+
+    if (!fault_log_event(FAULT_LOG_ERASE_REQUEST, 0, 0)) {
+        return (false);
+    }
+    erase_pending = true;
+    return (true);
+}
+
+uint32_t fault_log_boot_count(void) {
+    return (boot_count);
+}
@@ -0,0 +1,87 @@
+// Capstone Mainboard Persistent Fault/Event Log
+// Append-only record log in the last flash sectors, staged in RAM and written outside time critical code
+
+#ifndef FAULT_LOG_H
+#define FAULT_LOG_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Log parameters */
+#define FAULT_LOG_SECTORS 4                                 // Flash sectors reserved at the top of flash (4 kB each, 128 records each)
+#define FAULT_LOG_STAGE_LEN 16                              // Records that can wait in RAM for the next fault_log_service()
+#define FAULT_LOG_NUM_TEMPS 3                               // Temperature sensors snapshotted into every record
+
+// Event types
+typedef enum {
+    FAULT_LOG_BOOT = 1,                                     // Firmware started (code: recovery_cause_t, data: recovery_boot_data())
+    FAULT_LOG_STARTUP_DONE,                                 // Sequencing finished (data: ms from reset to all rails up)
+    FAULT_LOG_STARTUP_ABORT,                                // Startup given up (code: last i2c_error_state, 0 if sequencing failed)
+    FAULT_LOG_PMIC_ERROR,                                   // PMIC readback/communication error (code: i2c_error_state)
+    FAULT_LOG_SCRUB_MISMATCH,                               // PMIC registers changed behind the firmware (code: rail index, data: register mask)
+    FAULT_LOG_MARGIN,                                       // Margin sweep finished (code: rail index, data: lowest/highest passing VSET)
+    FAULT_LOG_DVS_FAULT,                                    // DVS check failed while lowering (code: rail index, data: VSET)
+    FAULT_LOG_SEQ_STAGE,                                    // Rail enabled by the sequencer (code: rail index, data: ms into the sequence)
+    FAULT_LOG_PG_FAULT,                                     // Power good lost (data: PG pin mask)
+    FAULT_LOG_SEQ_FAULT,                                    // Sequencing stopped (code: rail index, data: -RAIL_SEQ_ERR code)
+    FAULT_LOG_WCET_OVER,                                    // Fault path over its time budget at boot (code: path index, data: cycles)
+    FAULT_LOG_IDLE_OVER,                                    // Idle mode turned off, shutdown latency bound over budget (data: bound in us)
+    FAULT_LOG_ERASE_REQUEST                                 // Host asked for the log to be erased, carried out by the next fault_log_prepare()
+} fault_log_type_t;
+
+/* Types */
+
+// One 32 byte log record. A slot reading all 0xFF is empty
+typedef struct {
+    uint32_t sequence;                                      // Increments with every record ever written, used to find the newest record
+    uint32_t boot_count;                                    // Boot the record belongs to
+    uint32_t time_ms;                                       // Time since reset (in ms)
+    uint32_t gpio_state;                                    // Raw GPIO levels at the time of the event (enables and PG pins)
+    uint32_t data;                                          // Event specific data
+    int16_t temp_c_x16[FAULT_LOG_NUM_TEMPS];                // Last known board temperatures (in 1/16 degC)
+    uint8_t type;                                           // fault_log_type_t
+    uint8_t code;                                           // Event specific code
+    uint16_t reserved;                                      // Written as 0xFFFF
+    uint16_t crc;                                           // CRC-16/CCITT of everything above
+} fault_record_t;
+
+/* Functions */
+
+/* Find the end of the log in flash and work out the boot count. Returns false if the log region overlaps the firmware image */
+bool fault_log_init(void);
+
+/* Queue a record in RAM. Cheap enough to call from anywhere, including the protection loop; never touches flash.
+Returns false if the staging buffer was full (the record is counted as dropped) */
+bool fault_log_event(const fault_log_type_t type, const uint8_t code, const uint32_t data);
+
+// Update the temperature snapshot copied into every following record
+void fault_log_note_temp(const uint8_t sensor, const int16_t temp_c_x16);
+
+/* Move staged records to flash. Interrupts are off while a page is programmed (about 1 ms). Never erases: records
+that would enter a sector fault_log_prepare() has not erased stay staged */
+void fault_log_service(void);
+
+/* Erase the sector the log enters next, unless it is already blank, or the whole log if an erase was requested.
+Interrupts are off for the erase (about 50 ms a sector), so only call this where nothing is powered */
+void fault_log_prepare(void);
+
+// Prints every record in the log, oldest first, over stdio
+void fault_log_dump(void);
+
+/* Ask for the whole log to be erased at the next fault_log_prepare(). The request is a log record, so once it is in
+flash it also holds across a reset. Returns false if the staging buffer was full */
+bool fault_log_request_erase(void);
+
+// Boot count of the running firmware
+uint32_t fault_log_boot_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
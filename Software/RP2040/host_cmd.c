@@ -0,0 +1,69 @@
+// Capstone Mainboard Host Command Interface
+// Line based commands over the USB serial port
+
+/* Libraries */
+#include <stdio.h>
+#include <string.h>
+#include <pico/stdlib.h>
+#include "host_cmd.h"
+
+/* Variables */
+static char line_buffer[HOST_CMD_LINE_LEN];                 // Characters received since the last end of line
+static uint8_t line_length = 0;                             // Number of valid characters in line_buffer
+
+/* Functions */
+
+// Split a line into words and run the matching handler
+static void run_line(const host_cmd_t *cmds, const size_t num_cmds) {
+
+    char *argv[HOST_CMD_MAX_ARGS];
+    int argc = 0;
+    char *word = strtok(line_buffer, " \t");
+
+    while ((word != NULL) && (argc < HOST_CMD_MAX_ARGS)) {
+        argv[argc++] = word;
+        word = strtok(NULL, " \t");
+    }
+
+    if (argc == 0) {
+        return;
+    }
+
+    if (strcmp(argv[0], "help") == 0) {
+        for (size_t index = 0; index < num_cmds; index++) {
+            printf("%s %s\n", cmds[index].name, cmds[index].help);
+        }
+        return;
+    }
+
+    for (size_t index = 0; index < num_cmds; index++) {
+        if (strcmp(argv[0], cmds[index].name) == 0) {
+            cmds[index].handler(argc, argv);
+            return;
+        }
+    }
+
+    printf("Unknown command: %s (try help)\n", argv[0]);
+}
+
+bool host_cmd_poll(const host_cmd_t *cmds, const size_t num_cmds) {
+
+    int received = getchar_timeout_us(0);
+    const bool any = (received != PICO_ERROR_TIMEOUT);
+
+    while (received != PICO_ERROR_TIMEOUT) {
+
+        if ((received == '\r') || (received == '\n')) {
+            line_buffer[line_length] = '\0';
+            run_line(cmds, num_cmds);
+            line_length = 0;
+        }
+        else if (line_length < (HOST_CMD_LINE_LEN - 1)) {
+            line_buffer[line_length++] = (char) received;
+        }
+
+        received = getchar_timeout_us(0);
+    }
+
+    return (any);
+}
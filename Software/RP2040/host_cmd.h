@@ -0,0 +1,42 @@
+// Capstone Mainboard Host Command Interface
+// Line based commands over the USB serial port
+
+#ifndef HOST_CMD_H
+#define HOST_CMD_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Command parameters */
+#define HOST_CMD_LINE_LEN 64                                // Longest accepted command line (characters)
+#define HOST_CMD_MAX_ARGS 8                                 // Most whitespace separated words per command (including the command name)
+
+/* Types */
+
+// Command handler, argv[0] is the command name
+typedef void (*host_cmd_fn)(int argc, char *argv[]);
+
+// One entry of a command table
+typedef struct {
+    const char *name;                                       // Command word typed by the host
+    const char *help;                                       // Argument summary printed by "help"
+    host_cmd_fn handler;                                    // Function run when the command is received
+} host_cmd_t;
+
+/* Functions */
+
+/* Drain whatever the host has sent so far and run every complete line against the command table.
+Never waits for input, so it can be called from the main loop as often as needed. Returns true if anything arrived */
+bool host_cmd_poll(const host_cmd_t *cmds, const size_t num_cmds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,421 @@
+// Capstone Mainboard I2C Transaction Layer
+// Scatter/gather I2C transfers straight from caller-owned buffers
+
+/*
+*  The SDK i2c_write_*() calls need the whole message in one contiguous buffer, which forced write_i2c() to copy
+*  the register offset and payload into a stack array on every call. The DW_apb_i2c block only cares about the
+*  stream of bytes pushed into IC_DATA_CMD, so the gather write below feeds it from each segment in turn instead.
+*  The per-byte handshake (TX_EMPTY, then TX_ABRT/STOP_DET) is the same one the SDK uses internally.
+*
+*  Deadlines follow the transfer: a byte is 9 SCL periods, so read_i2c() of 5 registers at 100 kHz is allowed about
+*  1.5 ms instead of a fixed quarter second. A missing device NACKs its address after one byte (90 us at 100 kHz)
+*  and a stuck bus costs the deadline plus I2C_RECOVERY_CLOCKS clock pulses. Devices that keep failing are backed off
+*  exponentially, so a dead sensor polled from the main loop costs one check of a timestamp instead of a transfer.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include "i2c_bus.h"
+
+/* Types */
+
+// What the transfer layer knows about one I2C instance
+typedef struct {
+    uint32_t baud_hz;                                       // Actual bus speed, 0 before i2c_bus_init()
+    uint8_t sda_pin;
+    uint8_t scl_pin;
+    uint32_t recoveries;                                    // Bus recoveries since boot
+    i2c_dev_health_t devices[128];                          // Indexed by 7-bit address
+} i2c_bus_state_t;
+
+/* Variables */
+static i2c_bus_state_t bus_states[NUM_I2CS];                // Indexed by i2c_hw_index()
+
+/* Functions */
+
+static i2c_bus_state_t *bus_state(i2c_inst_t *i2c) {
+    return (&bus_states[i2c_hw_index(i2c)]);
+}
+
+// Record the outcome of a transfer in the device health. Returns the result unchanged
+static int note_result(i2c_inst_t *i2c, const uint8_t address, const int result) {
+
+    i2c_dev_health_t *device = &bus_state(i2c)->devices[address & 0x7F];
+    const uint8_t cost = ((result == -1) || (result == -3)) ? I2C_HEALTH_TIMEOUT_COST : I2C_HEALTH_NACK_COST;
+
+    if (result >= 0) {
+        device->score = ((I2C_HEALTH_MAX - device->score) > I2C_HEALTH_CREDIT) ? (device->score + I2C_HEALTH_CREDIT) : I2C_HEALTH_MAX;
+        device->failures = 0;
+        return (result);
+    }
+
+    device->score = (device->score > cost) ? (device->score - cost) : 0;
+    device->failures = (device->failures < 0xFF) ? (device->failures + 1) : 0xFF;
+    device->errors = (device->errors < 0xFFFF) ? (device->errors + 1) : 0xFFFF;
+
+    // Double the wait with every failure past the threshold
+    if (device->failures >= I2C_BACKOFF_AFTER) {
+        const uint8_t doublings = device->failures - I2C_BACKOFF_AFTER;
+        uint32_t backoff_ms = I2C_BACKOFF_MAX_MS;
+        if (doublings < 16) {
+            backoff_ms = (uint32_t) I2C_BACKOFF_BASE_MS << doublings;
+            backoff_ms = (backoff_ms > I2C_BACKOFF_MAX_MS) ? I2C_BACKOFF_MAX_MS : backoff_ms;
+        }
+        device->backoff_until_ms = to_ms_since_boot(get_absolute_time()) + backoff_ms;
+    }
+
+    return (result);
+}
+
+// True while a device is serving a backoff
+static bool backed_off(i2c_inst_t *i2c, const uint8_t address) {
+
+    const i2c_dev_health_t *device = &bus_state(i2c)->devices[address & 0x7F];
+
+    if (device->failures < I2C_BACKOFF_AFTER) {
+        return (false);
+    }
+    return ((int32_t)(device->backoff_until_ms - to_ms_since_boot(get_absolute_time())) > 0);
+}
+
+uint32_t i2c_bus_init(i2c_inst_t *i2c, const uint32_t baud_hz, const uint8_t sda_pin, const uint8_t scl_pin) {
+
+    i2c_bus_state_t *bus = bus_state(i2c);
+
+    bus->baud_hz = i2c_init(i2c, baud_hz);
+    bus->sda_pin = sda_pin;
+    bus->scl_pin = scl_pin;
+    bus->recoveries = 0;
+    for (size_t address = 0; address < 128; address++) {
+        bus->devices[address].score = I2C_HEALTH_MAX;
+        bus->devices[address].failures = 0;
+        bus->devices[address].errors = 0;
+        bus->devices[address].backoff_until_ms = 0;
+    }
+
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+
+    return (bus->baud_hz);
+}
+
+uint32_t i2c_bus_deadline_us(i2c_inst_t *i2c, const size_t num_bytes) {
+
+    const uint32_t baud_hz = (bus_state(i2c)->baud_hz > 0) ? bus_state(i2c)->baud_hz : I2C_DEFAULT_BAUD;
+
+    // 9 clocks per byte plus START and STOP, rounded up
+    const uint64_t bus_us = ((((uint64_t) num_bytes * 9) + 2) * 1000000 + baud_hz - 1) / baud_hz;
+
+    return ((uint32_t)(bus_us * I2C_DEADLINE_FACTOR) + I2C_DEADLINE_MARGIN_US);
+}
+
+bool i2c_bus_recover(i2c_inst_t *i2c) {
+
+    i2c_bus_state_t *bus = bus_state(i2c);
+    const uint32_t baud_hz = (bus->baud_hz > 0) ? bus->baud_hz : I2C_DEFAULT_BAUD;
+    const uint32_t half_us = (500000 + baud_hz - 1) / baud_hz;
+    bool released = false;
+
+    if (bus->baud_hz == 0) {
+        return (false);
+    }
+
+    // Stop the controller and take the pins. Open drain by hand: output value 0, pull low = output, release = input
+    i2c->hw->enable = 0;
+    i2c->restart_on_next = false;
+    gpio_put(bus->scl_pin, false);
+    gpio_put(bus->sda_pin, false);
+    gpio_set_dir(bus->scl_pin, GPIO_IN);
+    gpio_set_dir(bus->sda_pin, GPIO_IN);
+    gpio_set_function(bus->scl_pin, GPIO_FUNC_SIO);
+    gpio_set_function(bus->sda_pin, GPIO_FUNC_SIO);
+    busy_wait_us_32(half_us);
+
+    // Clock out whatever byte the target thinks it is in the middle of, until it lets go of SDA
+    for (uint8_t clock = 0; (clock < I2C_RECOVERY_CLOCKS) && !gpio_get(bus->sda_pin); clock++) {
+        gpio_set_dir(bus->scl_pin, GPIO_OUT);
+        busy_wait_us_32(half_us);
+        gpio_set_dir(bus->scl_pin, GPIO_IN);
+        busy_wait_us_32(half_us);
+    }
+
+    // STOP: SDA rises while SCL is high
+    gpio_set_dir(bus->scl_pin, GPIO_OUT);
+    busy_wait_us_32(half_us);
+    gpio_set_dir(bus->sda_pin, GPIO_OUT);
+    busy_wait_us_32(half_us);
+    gpio_set_dir(bus->scl_pin, GPIO_IN);
+    busy_wait_us_32(half_us);
+    gpio_set_dir(bus->sda_pin, GPIO_IN);
+    busy_wait_us_32(half_us);
+
+    released = gpio_get(bus->sda_pin) && gpio_get(bus->scl_pin);
+    gpio_set_function(bus->scl_pin, GPIO_FUNC_I2C);
+    gpio_set_function(bus->sda_pin, GPIO_FUNC_I2C);
+    i2c->hw->enable = 1;
+    bus->recoveries++;
+
+    return (released);
+}
+
+const i2c_dev_health_t *i2c_bus_health(i2c_inst_t *i2c, const uint8_t address) {
+    return (&bus_state(i2c)->devices[address & 0x7F]);
+}
+
+void i2c_bus_print_health(i2c_inst_t *i2c) {
+
+    const i2c_bus_state_t *bus = bus_state(i2c);
+    const uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    bool any = false;
+
+    printf("I2C%u: %lu Hz, %lu bus recoveries\n", i2c_hw_index(i2c), (unsigned long) bus->baud_hz, (unsigned long) bus->recoveries);
+    for (size_t address = 0; address < 128; address++) {
+        const i2c_dev_health_t *device = &bus->devices[address];
+        if (device->errors == 0) {
+            continue;
+        }
+        any = true;
+        printf("0x%02x\tscore %u\terrors %u\tfailing %u", (unsigned) address, device->score, device->errors, device->failures);
+        if ((device->failures >= I2C_BACKOFF_AFTER) && ((int32_t)(device->backoff_until_ms - now_ms) > 0)) {
+            printf("\tbacked off %lu ms", (unsigned long)(device->backoff_until_ms - now_ms));
+        }
+        printf("\n");
+    }
+    if (!any) {
+        printf("No device has failed\n");
+    }
+}
+
+// Spin until any of the given raw interrupt bits is set. Returns false if the deadline passed first
+static bool wait_raw_intr(i2c_inst_t *i2c, const uint32_t bits, const absolute_time_t deadline) {
+
+    while (!(i2c->hw->raw_intr_stat & bits)) {
+        if (time_reached(deadline)) {
+            return (false);
+        }
+        tight_loop_contents();
+    }
+
+    return (true);
+}
+
+int i2c_bus_write_sg(i2c_inst_t *i2c, const uint8_t address, const i2c_seg_t *segs, const size_t num_segs, const bool nostop, const uint32_t timeout_us) {
+
+    absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    size_t total_bytes = 0;
+    size_t bytes_sent = 0;
+    uint32_t abort_reason = 0;
+    bool timed_out = false;
+    bool aborted = false;
+
+    // Total message length is needed up front to know where the STOP goes
+    for (size_t seg = 0; seg < num_segs; seg++) {
+        total_bytes += segs[seg].len;
+    }
+    if (total_bytes == 0) {
+        return (-2);
+    }
+
+    // Point the controller at the target device
+    i2c->hw->enable = 0;
+    i2c->hw->tar = address;
+    i2c->hw->enable = 1;
+
+    for (size_t seg = 0; (seg < num_segs) && !aborted; seg++) {
+        for (size_t index = 0; (index < segs[seg].len) && !aborted; index++) {
+
+            bool first = (bytes_sent == 0);
+            bool last = (bytes_sent == (total_bytes - 1));
+
+            i2c->hw->data_cmd =
+                    bool_to_bit(first && i2c->restart_on_next) << I2C_IC_DATA_CMD_RESTART_LSB |
+                    bool_to_bit(last && !nostop) << I2C_IC_DATA_CMD_STOP_LSB |
+                    segs[seg].data[index];
+
+            // Wait for the byte to leave the shift register (TX_EMPTY_CTRL is set by i2c_init)
+            if (!wait_raw_intr(i2c, I2C_IC_RAW_INTR_STAT_TX_EMPTY_BITS, deadline)) {
+                timed_out = true;
+                aborted = true;
+                break;
+            }
+
+            // Any abort reason ends the message. Reading clr_tx_abrt clears both the flag and the reason
+            abort_reason = i2c->hw->tx_abrt_source;
+            if (abort_reason) {
+                (void) i2c->hw->clr_tx_abrt;
+                aborted = true;
+            }
+
+            // On abort the hardware issues STOP by itself, wait for it as well as for the final STOP
+            if (aborted || (last && !nostop)) {
+                if (!wait_raw_intr(i2c, I2C_IC_RAW_INTR_STAT_STOP_DET_BITS, deadline)) {
+                    timed_out = true;
+                    aborted = true;
+                    break;
+                }
+                (void) i2c->hw->clr_stop_det;
+            }
+
+            if (!aborted) {
+                bytes_sent++;
+            }
+        }
+    }
+
+    // Next message starts with a repeated START if this one left the bus claimed
+    i2c->restart_on_next = nostop && !aborted;
+
+    if (timed_out) {
+        return (-1);
+    }
+    else if (aborted && (abort_reason & I2C_IC_TX_ABRT_SOURCE_ABRT_TXDATA_NOACK_BITS)) {
+        // Address was acknowledged but part of the data was not
+        return ((int) bytes_sent);
+    }
+    else if (aborted) {
+        return (-2);
+    }
+    else {
+        return ((int) bytes_sent);
+    }
+}
+
+int i2c_bus_transfer(i2c_inst_t *i2c, const uint8_t address, const i2c_seg_t *segs, const size_t num_segs, uint8_t *rx_buffer, const size_t rx_len, const uint32_t timeout_us) {
+
+    int bytes_written = 0;
+    int bytes_read = 0;
+    size_t total_bytes = 0;
+    uint64_t start_us = time_us_64();
+    uint64_t elapsed_us = 0;
+
+    // Send the offset/command phase, keep the bus for the read
+    bytes_written = i2c_bus_write_sg(i2c, address, segs, num_segs, (rx_len > 0), timeout_us);
+    if (bytes_written == -1) {
+        return (-1);
+    }
+    else if (bytes_written < 0) {
+        return (-2);
+    }
+
+    // A partially acknowledged offset is as good as no offset at all
+    for (size_t seg = 0; seg < num_segs; seg++) {
+        total_bytes += segs[seg].len;
+    }
+    if ((size_t) bytes_written != total_bytes) {
+        return (-2);
+    }
+
+    if (rx_len == 0) {
+        return (0);
+    }
+
+    // The read shares what is left of the same deadline
+    elapsed_us = time_us_64() - start_us;
+    if (elapsed_us >= timeout_us) {
+        return (-3);
+    }
+
+    bytes_read = i2c_read_timeout_us(i2c, address, rx_buffer, rx_len, false, (uint32_t)(timeout_us - elapsed_us));
+    if (bytes_read == PICO_ERROR_TIMEOUT) {
+        return (-3);
+    }
+    else if (bytes_read == PICO_ERROR_GENERIC) {
+        return (-4);
+    }
+    else {
+        return (bytes_read);
+    }
+}
+
+/* Write any number of bytes to target address at provided offset. Returns the number of bytes written, or negative values on error
+The offset and payload are sent straight from their own storage (no copy, no stack buffer)
+WARNING: This function is blocking (up to i2c_bus_deadline_us() for the message, plus a bus recovery on timeout) */
+int write_i2c(i2c_inst_t *i2c, const uint8_t address, const uint8_t offset, const uint8_t *buffer, const size_t num_bytes) {
+
+    int bytes_written = 0;
+
+    // Offset byte followed by the payload, as one message
+    const i2c_seg_t message[2] = {
+        { &offset, 1 },
+        { buffer, num_bytes }
+    };
+
+    if (backed_off(i2c, address)) {
+        return (I2C_BUS_ERR_BACKOFF);
+    }
+
+    // Send out the message, retun negative values if an error occurs
+    bytes_written = i2c_bus_write_sg(i2c, address, message, 2, false, i2c_bus_deadline_us(i2c, num_bytes + 2));
+    if (bytes_written == -1) {
+        i2c_bus_recover(i2c);
+    }
+    bytes_written = note_result(i2c, address, ((bytes_written == 0) ? -2 : bytes_written));
+    if (bytes_written < 0) {
+        return (bytes_written);
+    }
+    else {
+        return (bytes_written - 1);
+    }
+}
+
+// Offset write and read with a deadline sized for the transfer, recovering the bus if it times out
+static int read_with_recovery(i2c_inst_t *i2c, const uint8_t address, const uint8_t offset, uint8_t *buffer, const size_t num_bytes) {
+
+    const i2c_seg_t request = { &offset, 1 };
+
+    // Zero length reads are not possible on I2C, always read at least one byte
+    const size_t rx_len = (num_bytes < 1) ? 1 : num_bytes;
+
+    // Two address bytes (write, then read after the repeated START) and the offset
+    const int result = i2c_bus_transfer(i2c, address, &request, 1, buffer, rx_len, i2c_bus_deadline_us(i2c, rx_len + 3));
+    if ((result == -1) || (result == -3)) {
+        i2c_bus_recover(i2c);
+    }
+
+    return (result);
+}
+
+/* Read any number of bytes (up to the size of buffer) from target address at provided offset. Returns the number of bytes read, or negative values on error
+WARNING: This function is blocking (up to i2c_bus_deadline_us() for the transfer, plus a bus recovery on timeout) */
+int read_i2c(i2c_inst_t *i2c, const uint8_t address, const uint8_t offset, uint8_t *buffer, const size_t num_bytes) {
+
+    if (backed_off(i2c, address)) {
+        return (I2C_BUS_ERR_BACKOFF);
+    }
+    return (note_result(i2c, address, read_with_recovery(i2c, address, offset, buffer, num_bytes)));
+}
+
+// Scans the I2C bus for devices
+void scan_i2c(i2c_inst_t *i2c, uint8_t *buffer) {
+
+    int bytes_read = 0;
+    bool device_found = false;
+
+    // Probes bypass the health records: an empty address failing is the expected answer, not a sick device
+    for (uint8_t test_address = 0x00; test_address < 128; test_address++) {
+
+        printf("Testing address %03d (0x%x)\t", test_address, test_address);
+
+        bytes_read = read_with_recovery(i2c, test_address, 0x00, buffer, 1);
+
+        if (bytes_read > 0) {
+            printf("Device found!\n");
+            device_found = true;
+        }
+        else if (bytes_read == -2) {
+            printf("Communication Error (Write)\n");
+        }
+        else if (bytes_read == -4) {
+            printf("Communication Error (Read)\n");
+        }
+        else {
+            printf("No response\n");
+        }
+    }
+
+    if (!device_found) {
+        printf("WARNING: No devices found on bus\n");
+    }
+}
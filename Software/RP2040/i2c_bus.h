@@ -0,0 +1,95 @@
+// Capstone Mainboard I2C Transaction Layer
+// Scatter/gather I2C transfers straight from caller-owned buffers
+
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <hardware/i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Communication parameters */
+static const uint32_t I2C_DEFAULT_BAUD      = 100000;       // Bus speed assumed for an instance not set up with i2c_bus_init() (in Hz)
+static const uint32_t I2C_DEADLINE_MARGIN_US = 100;         // Added to every computed deadline: FIFO latency, short clock stretches (in us)
+static const uint8_t I2C_DEADLINE_FACTOR    = 2;            // Computed bus time is multiplied by this before the margin is added
+static const uint8_t I2C_RECOVERY_CLOCKS    = 9;            // SCL pulses that free a target stuck mid-byte (8 data bits and the ACK)
+
+// Device health
+static const uint8_t I2C_HEALTH_MAX         = 100;          // Score of a device that has never failed
+static const uint8_t I2C_HEALTH_CREDIT      = 10;           // Score regained per successful transfer
+static const uint8_t I2C_HEALTH_NACK_COST   = 10;           // Score lost per NACK or bus error
+static const uint8_t I2C_HEALTH_TIMEOUT_COST = 30;          // Score lost per timeout (the bus needed recovering)
+static const uint8_t I2C_BACKOFF_AFTER      = 3;            // Consecutive failures before a device is backed off
+static const uint16_t I2C_BACKOFF_BASE_MS   = 10;           // First backoff, doubled with every further failure (in ms)
+static const uint16_t I2C_BACKOFF_MAX_MS    = 5000;         // Longest backoff (in ms)
+
+// Transfer error codes (in addition to the -1 to -4 of the transfer functions)
+static const int I2C_BUS_ERR_BACKOFF        = -5;           // Device is backed off after repeated failures, nothing was sent
+
+/* Types */
+
+// Track record of one device address
+typedef struct {
+    uint8_t score;                                          // I2C_HEALTH_MAX when healthy, 0 when every recent transfer failed
+    uint8_t failures;                                       // Consecutive failed transfers
+    uint16_t errors;                                        // Failed transfers since boot (saturates)
+    uint32_t backoff_until_ms;                              // Transfers return I2C_BUS_ERR_BACKOFF until then (boot time in ms)
+} i2c_dev_health_t;
+
+// One piece of an outgoing message. The bytes are clocked out of the caller's memory directly, nothing is copied.
+typedef struct {
+    const uint8_t *data;                                    // Start of the segment (caller-owned, must stay valid for the transfer)
+    size_t len;                                             // Number of bytes in the segment (zero-length segments are skipped)
+} i2c_seg_t;
+
+/* Functions */
+
+/* Write every segment back to back as a single I2C message (one START, one address byte, one STOP).
+Set nostop to leave the bus claimed so a following read starts with a repeated START.
+Returns the number of bytes written, -1 on timeout or -2 on a NACK/bus error */
+int i2c_bus_write_sg(i2c_inst_t *i2c, const uint8_t address, const i2c_seg_t *segs, const size_t num_segs, const bool nostop, const uint32_t timeout_us);
+
+/* Write the segments (usually a register or memory offset), then read len bytes after a repeated START.
+There is no length limit beyond the size of the caller's buffer, so full EEPROM pages and 128 byte QSFP pages go in one transfer.
+Returns the number of bytes read, -1/-2 if the write phase failed, or -3/-4 if the read phase timed out/failed */
+int i2c_bus_transfer(i2c_inst_t *i2c, const uint8_t address, const i2c_seg_t *segs, const size_t num_segs, uint8_t *rx_buffer, const size_t rx_len, const uint32_t timeout_us);
+
+/* Set up an instance (like i2c_init() plus the pin functions) and remember the bus speed and pins for deadlines and
+recovery. Returns the actual bus speed in Hz */
+uint32_t i2c_bus_init(i2c_inst_t *i2c, const uint32_t baud_hz, const uint8_t sda_pin, const uint8_t scl_pin);
+
+/* Time a transfer of num_bytes bytes (address bytes included) may take: the bits at the configured bus speed, times
+I2C_DEADLINE_FACTOR, plus I2C_DEADLINE_MARGIN_US. A missing device NACKs its address well within this */
+uint32_t i2c_bus_deadline_us(i2c_inst_t *i2c, const size_t num_bytes);
+
+/* Free a bus that a target holds: up to I2C_RECOVERY_CLOCKS SCL pulses until SDA is released, then a STOP, all by
+hand on the pins. Runs automatically after a timeout in read_i2c()/write_i2c()/scan_i2c(). Returns true if both
+lines are high afterwards */
+bool i2c_bus_recover(i2c_inst_t *i2c);
+
+// Health record of a 7-bit device address
+const i2c_dev_health_t *i2c_bus_health(i2c_inst_t *i2c, const uint8_t address);
+
+// Prints the bus speed, recovery count and every device that has failed since boot
+void i2c_bus_print_health(i2c_inst_t *i2c);
+
+/* Write any number of bytes to target address at provided offset. Returns the number of bytes written, or negative values on error */
+int write_i2c(i2c_inst_t *i2c, const uint8_t address, const uint8_t offset, const uint8_t *buffer, const size_t num_bytes);
+
+/* Read any number of bytes from target address at provided offset. Returns the number of bytes read, or negative values on error */
+int read_i2c(i2c_inst_t *i2c, const uint8_t address, const uint8_t offset, uint8_t *buffer, const size_t num_bytes);
+
+// Scans the I2C bus for devices
+void scan_i2c(i2c_inst_t *i2c, uint8_t *buffer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
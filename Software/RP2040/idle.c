@@ -0,0 +1,204 @@
+// Capstone Mainboard Idle Mode
+// Slow clk_sys, gated peripheral clocks and deep sleep between main loop ticks, supervised against a shutdown latency bound
+
+/*
+*  Dormant mode would stop every clock, the PIO power good monitor included, so idle here means the next step down:
+*  clk_sys moves from PLL_SYS to PLL_USB (which has to run for USB anyway) and PLL_SYS is switched off, and between
+*  main loop ticks the core sleeps with SLEEPDEEP set. While it sleeps only the clocks in SLEEP_EN keep running: the
+*  PIO monitor, the GPIO and timer wake sources, USB and what the bus needs to bring the core back. Peripherals the
+*  board never uses lose their clocks for good.
+*
+*  clk_peri is moved to PLL_USB once at init, so the I2C baud rate stays put whatever clk_sys does. The PIO monitor
+*  runs on clk_sys and slows down with it, but its 5 cycle loop is still well under a microsecond at the idle clock.
+*  Anything that keeps time in clk_sys cycles (the LED state machine) is retuned through the on_clock callback.
+*
+*  Supervision: every sleep that runs to its deadline measures how late the core got going again. That wake latency
+*  plus the software trip path (timed at boot in cycles, scaled to the idle clock) bounds the time from a PG edge to
+*  every enable low. If the bound ever grows past its budget, idle mode switches itself off.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/clocks.h>
+#include <hardware/pll.h>
+#include <hardware/sync.h>
+#include <hardware/structs/scb.h>
+#include "idle.h"
+
+/* Parameters */
+#define IDLE_PLL_SYS_VCO_HZ (1500 * MHZ)                    // PLL_SYS setting of the full speed clock: 12 MHz * 125 / 6 / 2 = 125 MHz
+#define IDLE_PLL_SYS_POSTDIV1 6
+#define IDLE_PLL_SYS_POSTDIV2 2
+
+// Peripherals the board does not use: SPI, UART (stdio is on USB), I2C-1, PIO-1 and the RTC
+#define IDLE_UNUSED_EN0 (CLOCKS_WAKE_EN0_CLK_SYS_SPI1_BITS | CLOCKS_WAKE_EN0_CLK_PERI_SPI1_BITS | CLOCKS_WAKE_EN0_CLK_SYS_SPI0_BITS | \
+                         CLOCKS_WAKE_EN0_CLK_PERI_SPI0_BITS | CLOCKS_WAKE_EN0_CLK_SYS_RTC_BITS | CLOCKS_WAKE_EN0_CLK_RTC_RTC_BITS | \
+                         CLOCKS_WAKE_EN0_CLK_SYS_PIO1_BITS | CLOCKS_WAKE_EN0_CLK_SYS_I2C1_BITS)
+#define IDLE_UNUSED_EN1 (CLOCKS_WAKE_EN1_CLK_SYS_UART1_BITS | CLOCKS_WAKE_EN1_CLK_PERI_UART1_BITS | CLOCKS_WAKE_EN1_CLK_SYS_UART0_BITS | \
+                         CLOCKS_WAKE_EN1_CLK_PERI_UART0_BITS)
+
+// Used, but only by the core: nothing starts an I2C, ADC or DMA transfer or calls into the ROM while it sleeps
+#define IDLE_AWAKE_ONLY_EN0 (CLOCKS_SLEEP_EN0_CLK_SYS_I2C0_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_ADC_BITS | CLOCKS_SLEEP_EN0_CLK_ADC_ADC_BITS | \
+                             CLOCKS_SLEEP_EN0_CLK_SYS_DMA_BITS | CLOCKS_SLEEP_EN0_CLK_SYS_ROM_BITS)
+
+/* Variables */
+static idle_state_t *active_idle = NULL;                    // State fed by the wake pin interrupt
+
+/* Functions */
+
+// Wake pin interrupt: note the pin and set the event register, so an edge just before the WFE still ends the sleep
+static void on_wake_pin(uint gpio, uint32_t events) {
+
+    (void) events;
+    if (active_idle != NULL) {
+        active_idle->wake_pins |= 1u << gpio;
+    }
+    __sev();
+}
+
+// Move clk_sys between PLL_SYS and PLL_USB, powering PLL_SYS down while it is not needed
+static void set_low_clock(idle_state_t *idle, const bool low) {
+
+    if (low == idle->low_clock) {
+        return;
+    }
+
+    if (low) {
+        clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX, CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB,
+                        IDLE_CLK_KHZ * 1000, IDLE_CLK_KHZ * 1000);
+        pll_deinit(pll_sys);
+    }
+    else {
+        pll_init(pll_sys, 1, IDLE_PLL_SYS_VCO_HZ, IDLE_PLL_SYS_POSTDIV1, IDLE_PLL_SYS_POSTDIV2);
+        clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLKSRC_CLK_SYS_AUX, CLOCKS_CLK_SYS_CTRL_AUXSRC_VALUE_CLKSRC_PLL_SYS,
+                        IDLE_FULL_CLK_KHZ * 1000, IDLE_FULL_CLK_KHZ * 1000);
+    }
+    idle->low_clock = low;
+
+    if (idle->on_clock != NULL) {
+        idle->on_clock(clock_get_hz(clk_sys));
+    }
+}
+
+void idle_init(idle_state_t *idle, idle_clock_fn on_clock) {
+
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLKSRC_PLL_USB, 48 * MHZ, 48 * MHZ);
+
+    clocks_hw->wake_en0 &= ~IDLE_UNUSED_EN0;
+    clocks_hw->wake_en1 &= ~IDLE_UNUSED_EN1;
+    clocks_hw->sleep_en0 = clocks_hw->wake_en0 & ~IDLE_AWAKE_ONLY_EN0;
+    clocks_hw->sleep_en1 = clocks_hw->wake_en1;
+
+    idle->enabled = false;
+    idle->low_clock = false;
+    idle->on_clock = on_clock;
+    idle->activity_us = time_us_32();
+    idle->activity_pins = 0;
+    idle->trip_cycles = 0;
+    idle->budget_us = 0;
+    idle->max_wake_us = 0;
+    idle->sleeps = 0;
+    idle->pin_wakes = 0;
+    idle->wake_pins = 0;
+}
+
+void idle_start(idle_state_t *idle, const uint32_t fall_pins, const uint32_t edge_pins, const uint32_t trip_cycles,
+                const uint32_t budget_us) {
+
+    idle->activity_pins = edge_pins & ~fall_pins;
+    idle->trip_cycles = trip_cycles;
+    idle->budget_us = budget_us;
+    active_idle = idle;
+
+    for (uint pin = 0; pin < NUM_BANK0_GPIOS; pin++) {
+        uint32_t events = 0;
+        if (edge_pins & (1u << pin)) {
+            events = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+        }
+        else if (fall_pins & (1u << pin)) {
+            events = GPIO_IRQ_EDGE_FALL;
+        }
+        if (events != 0) {
+            gpio_set_irq_enabled_with_callback(pin, events, true, on_wake_pin);
+        }
+    }
+
+    idle_enable(idle, true);
+}
+
+void idle_enable(idle_state_t *idle, const bool enable) {
+
+    idle->enabled = enable;
+    idle->activity_us = time_us_32();
+    if (!enable) {
+        set_low_clock(idle, false);
+    }
+}
+
+void idle_activity(idle_state_t *idle) {
+
+    idle->activity_us = time_us_32();
+    set_low_clock(idle, false);
+}
+
+int idle_wait(idle_state_t *idle, const uint32_t timeout_us) {
+
+    const absolute_time_t deadline = make_timeout_time_us(timeout_us);
+    bool reached = false;
+    uint32_t pins = 0;
+
+    if (!idle->enabled) {
+        sleep_until(deadline);
+        return (0);
+    }
+    if (!idle->low_clock && ((time_us_32() - idle->activity_us) >= (IDLE_AFTER_MS * 1000))) {
+        set_low_clock(idle, true);
+    }
+
+    // Interrupts that are not wake pins (the USB task timer, USB itself) get served and the core goes back to sleep
+    while (!reached && (idle->wake_pins == 0)) {
+        idle->sleeps++;
+        scb_hw->scr |= M0PLUS_SCR_SLEEPDEEP_BITS;
+        reached = best_effort_wfe_or_timeout(deadline);
+        scb_hw->scr &= ~M0PLUS_SCR_SLEEPDEEP_BITS;
+    }
+
+    const uint32_t saved = save_and_disable_interrupts();
+    pins = idle->wake_pins;
+    idle->wake_pins = 0;
+    restore_interrupts(saved);
+
+    if (pins != 0) {
+        idle->pin_wakes++;
+        if (pins & idle->activity_pins) {
+            idle_activity(idle);
+        }
+        return (0);
+    }
+
+    // Ran to the deadline: how long after it the core was back is the wake latency
+    const uint32_t late_us = (uint32_t) absolute_time_diff_us(deadline, get_absolute_time());
+    idle->max_wake_us = (late_us > idle->max_wake_us) ? late_us : idle->max_wake_us;
+    if (idle_bound_us(idle) > idle->budget_us) {
+        idle_enable(idle, false);
+        return (IDLE_ERR_OVER_BUDGET);
+    }
+
+    return (0);
+}
+
+uint32_t idle_bound_us(const idle_state_t *idle) {
+
+    const uint32_t idle_mhz = IDLE_CLK_KHZ / 1000;
+    return (idle->max_wake_us + ((idle->trip_cycles + idle_mhz - 1) / idle_mhz));
+}
+
+void idle_print(const idle_state_t *idle) {
+
+    printf("Idle %s, clk_sys %lu kHz\n", (idle->enabled ? "on" : "off"), (unsigned long)(clock_get_hz(clk_sys) / 1000));
+    printf("Sleeps %lu, pin wakes %lu, slowest wake %lu us\n", (unsigned long) idle->sleeps, (unsigned long) idle->pin_wakes,
+           (unsigned long) idle->max_wake_us);
+    printf("PG to shutdown bound %lu us, budget %lu us\t%s\n", (unsigned long) idle_bound_us(idle), (unsigned long) idle->budget_us,
+           (idle_bound_us(idle) > idle->budget_us) ? "OVER BUDGET" : "ok");
+}
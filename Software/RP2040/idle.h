@@ -0,0 +1,78 @@
+// Capstone Mainboard Idle Mode
+// Slow clk_sys, gated peripheral clocks and deep sleep between main loop ticks, supervised against a shutdown latency bound
+
+#ifndef IDLE_H
+#define IDLE_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Idle parameters */
+static const uint32_t IDLE_FULL_CLK_KHZ     = 125000;       // clk_sys while busy (from PLL_SYS, in kHz)
+static const uint32_t IDLE_CLK_KHZ          = 48000;        // clk_sys while idle (from PLL_USB, which USB keeps running anyway, in kHz)
+static const uint32_t IDLE_AFTER_MS         = 2000;         // Time without activity before clk_sys drops (in ms)
+
+// Idle error codes
+static const int IDLE_ERR_OVER_BUDGET       = -1;           // The measured shutdown latency bound exceeds its budget, idle mode is off
+
+/* Types */
+
+// Called after clk_sys has moved, with its new frequency, for anything that has to retune to it
+typedef void (*idle_clock_fn)(const uint32_t sys_hz);
+
+// Idle mode state
+typedef struct {
+    bool enabled;                                           // Deep sleep and the slow clock may be used
+    bool low_clock;                                         // clk_sys is on the idle clock
+    idle_clock_fn on_clock;                                 // Run after every clk_sys change, may be NULL
+    uint32_t activity_us;                                   // Last activity (time_us_32())
+    uint32_t activity_pins;                                 // Wake pins whose edges count as activity (USB plugged in, load hint)
+    uint32_t trip_cycles;                                   // Slowest software trip path (clk_sys cycles, from the boot benchmark)
+    uint32_t budget_us;                                     // Longest allowed PG wake to every enable low (in us)
+    uint32_t max_wake_us;                                   // Slowest wake seen: timer deadline to code running again (in us)
+    uint32_t sleeps;                                        // Sleeps entered
+    uint32_t pin_wakes;                                     // Sleeps ended by a wake pin edge
+    volatile uint32_t wake_pins;                            // Pins that saw an edge since the last idle_wait() (gpio_get_all() bit order)
+} idle_state_t;
+
+/* Functions */
+
+/* Run clk_peri from PLL_USB, so the peripheral baud rates no longer follow clk_sys, and stop the clocks of every
+peripheral this board does not use. on_clock follows every later clk_sys change. Call before any peripheral (I2C,
+stdio) is set up */
+void idle_init(idle_state_t *idle, idle_clock_fn on_clock);
+
+/* Turn idle mode on once startup is done: any edge on fall_pins (falling only) or edge_pins (both) ends a sleep, and
+an edge_pins edge also counts as activity. trip_cycles is the measured worst case of the software trip path,
+budget_us the bound it has to stay inside */
+void idle_start(idle_state_t *idle, const uint32_t fall_pins, const uint32_t edge_pins, const uint32_t trip_cycles,
+                const uint32_t budget_us);
+
+/* Allow or forbid idle mode. Forbidding returns clk_sys to full speed straight away */
+void idle_enable(idle_state_t *idle, const bool enable);
+
+// Something needs the full clock (host input, USB plugged in): leave the slow clock and restart the idle timer
+void idle_activity(idle_state_t *idle);
+
+/* Sleep until a wake pin edge, any interrupt (PIO monitor, USB) or timeout_us, dropping clk_sys first once nothing
+has happened for IDLE_AFTER_MS. Sleeps that run to their deadline measure the wake latency; if the bound then
+exceeds the budget, idle mode turns itself off and IDLE_ERR_OVER_BUDGET is returned (once). Returns 0 otherwise */
+int idle_wait(idle_state_t *idle, const uint32_t timeout_us);
+
+/* Worst case from a PG edge to every enable low while idle: the slowest wake plus the trip path at the idle clock.
+Group C does not wait for either, the PIO monitor drops it within a few of its own cycles */
+uint32_t idle_bound_us(const idle_state_t *idle);
+
+// Prints the mode, clock, wake counts and the latency bound against its budget
+void idle_print(const idle_state_t *idle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+// Capstone Mainboard Indicator LEDs
+// PIO state machine that plays solid and blinking patterns on the indicator LEDs, one FIFO write per pattern change
+
+/*
+*  The PWM slices cannot blink an LED at a rate anyone would read as blinking: with the largest divider a 16-bit
+*  counter still wraps several times a second. A PIO state machine clocked down to LED_ENGINE_TICK_HZ counts half
+*  periods of many seconds instead, and drives all six LEDs from one word: the levels of phase A, the levels of phase
+*  B and the half period. Solid is the same level in both phases, blinking is on in one of them.
+*
+*  The CPU only writes a new word when something changes, so the display costs nothing while nothing changes and
+*  never waits on anything. The state machine shares PIO-0 with the power good monitor, which leaves PIO-1 gated.
+*/
+
+/* Libraries */
+#include <pico/stdlib.h>
+#include <hardware/pio.h>
+#include "led_engine.h"
+
+/* Parameters */
+#define LED_ENGINE_PHASE_CYCLES 5                           // Cycles of a phase outside the delay loop
+#define LED_ENGINE_DIV_MAX 0xFFFF                           // Largest integer clock divider
+
+/* Functions */
+
+// State machine clock divider for LED_ENGINE_TICK_HZ at sys_hz
+static uint16_t tick_divider(const uint32_t sys_hz) {
+
+    const uint32_t divider = sys_hz / LED_ENGINE_TICK_HZ;
+    return ((uint16_t)((divider > LED_ENGINE_DIV_MAX) ? LED_ENGINE_DIV_MAX : ((divider < 1) ? 1 : divider)));
+}
+
+// Pattern word for the current phases
+static uint32_t make_pattern(const led_engine_t *leds) {
+
+    uint32_t ticks = ((uint32_t) leds->half_period_ms * LED_ENGINE_TICK_HZ) / 1000;
+
+    ticks = (ticks > LED_ENGINE_PHASE_CYCLES) ? (ticks - LED_ENGINE_PHASE_CYCLES) : 0;
+    ticks = (ticks < (1u << LED_ENGINE_PERIOD_BITS)) ? ticks : ((1u << LED_ENGINE_PERIOD_BITS) - 1);
+
+    return ((uint32_t) leds->phase_a | ((uint32_t) leds->phase_b << LED_ENGINE_COUNT) | (ticks << (2 * LED_ENGINE_COUNT)));
+}
+
+int led_engine_init(led_engine_t *leds, PIO pio, const uint8_t pin_base, const uint16_t half_period_ms, const uint32_t sys_hz) {
+
+    pio_sm_config config;
+    uint offset = 0;
+    int sm = 0;
+
+    leds->pio = NULL;
+    if (!pio_can_add_program(pio, &led_engine_program)) {
+        return (LED_ENGINE_ERR_NO_SPACE);
+    }
+    sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0) {
+        return (LED_ENGINE_ERR_NO_SM);
+    }
+    offset = pio_add_program(pio, &led_engine_program);
+
+    leds->pio = pio;
+    leds->sm = (uint) sm;
+    leds->pin_base = pin_base;
+    leds->half_period_ms = half_period_ms;
+    leds->phase_a = 0;
+    leds->phase_b = 0;
+    leds->pattern = make_pattern(leds);
+
+    config = led_engine_program_get_default_config(offset);
+    sm_config_set_out_pins(&config, pin_base, LED_ENGINE_COUNT);
+    sm_config_set_out_shift(&config, true, false, 32);
+    sm_config_set_clkdiv_int_frac(&config, tick_divider(sys_hz), 0);
+
+    pio_sm_set_pins_with_mask(pio, leds->sm, 0, ((1u << LED_ENGINE_COUNT) - 1) << pin_base);
+    pio_sm_set_consecutive_pindirs(pio, leds->sm, pin_base, LED_ENGINE_COUNT, true);
+    for (uint8_t pin = pin_base; pin < (pin_base + LED_ENGINE_COUNT); pin++) {
+        pio_gpio_init(pio, pin);
+    }
+
+    pio_sm_init(pio, leds->sm, offset, &config);
+    pio_sm_put(pio, leds->sm, leds->pattern);
+    pio_sm_set_enabled(pio, leds->sm, true);
+
+    return (0);
+}
+
+void led_engine_set(led_engine_t *leds, const uint8_t pin, const led_mode_t mode) {
+
+    uint8_t bit = 0;
+
+    if ((leds->pio == NULL) || (pin < leds->pin_base) || (pin >= (leds->pin_base + LED_ENGINE_COUNT))) {
+        return;
+    }
+    bit = (uint8_t)(1u << (pin - leds->pin_base));
+
+    leds->phase_a = ((mode == LED_ON) || (mode == LED_BLINK)) ? (leds->phase_a | bit) : (leds->phase_a & ~bit);
+    leds->phase_b = ((mode == LED_ON) || (mode == LED_BLINK_ALT)) ? (leds->phase_b | bit) : (leds->phase_b & ~bit);
+
+    const uint32_t pattern = make_pattern(leds);
+    if (pattern == leds->pattern) {
+        return;
+    }
+
+    // Only the newest pattern matters: drop one the state machine has not picked up yet rather than queue behind it
+    if (!pio_sm_is_tx_fifo_empty(leds->pio, leds->sm)) {
+        pio_sm_clear_fifos(leds->pio, leds->sm);
+    }
+    pio_sm_put(leds->pio, leds->sm, pattern);
+    leds->pattern = pattern;
+}
+
+void led_engine_set_clock(led_engine_t *leds, const uint32_t sys_hz) {
+
+    if (leds->pio != NULL) {
+        pio_sm_set_clkdiv_int_frac(leds->pio, leds->sm, tick_divider(sys_hz), 0);
+    }
+}
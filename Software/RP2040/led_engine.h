@@ -0,0 +1,63 @@
+// Capstone Mainboard Indicator LEDs
+// PIO state machine that plays solid and blinking patterns on the indicator LEDs, one FIFO write per pattern change
+
+#ifndef LED_ENGINE_H
+#define LED_ENGINE_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+#include <hardware/pio.h>
+#include "led_engine.pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* LED parameters */
+static const uint32_t LED_ENGINE_TICK_HZ    = 10000;        // State machine clock, kept whatever clk_sys does (in Hz)
+static const uint16_t LED_ENGINE_BLINK_MS   = 250;          // Half period of the blinking patterns (in ms)
+
+// LED engine error codes
+static const int LED_ENGINE_ERR_NO_SPACE    = -1;           // No room in the PIO instruction memory for the program
+static const int LED_ENGINE_ERR_NO_SM       = -2;           // Every state machine of the PIO is in use
+
+// What one LED shows
+typedef enum {
+    LED_OFF = 0,
+    LED_ON,                                                 // Solid
+    LED_BLINK,                                              // On in phase A
+    LED_BLINK_ALT                                           // On in phase B, alternating with LED_BLINK
+} led_mode_t;
+
+/* Types */
+
+// The LED state machine
+typedef struct {
+    PIO pio;                                                // NULL if the engine could not start, every call is ignored then
+    uint sm;
+    uint8_t pin_base;                                       // First LED (LED_ENGINE_COUNT consecutive pins)
+    uint16_t half_period_ms;
+    uint8_t phase_a;                                        // LEDs on in phase A, bit 0 = pin_base
+    uint8_t phase_b;                                        // LEDs on in phase B
+    uint32_t pattern;                                       // Word last written to the state machine
+} led_engine_t;
+
+/* Functions */
+
+/* Load the program, claim a state machine and take over the LED pins, all off. sys_hz is the current clk_sys.
+Returns 0 or a LED_ENGINE_ERR code */
+int led_engine_init(led_engine_t *leds, PIO pio, const uint8_t pin_base, const uint16_t half_period_ms, const uint32_t sys_hz);
+
+/* Set what the LED on pin shows. Writes the state machine only if the pattern changed; the change shows from the start
+of the next blink period (2 * half_period_ms at most) */
+void led_engine_set(led_engine_t *leds, const uint8_t pin, const led_mode_t mode);
+
+// clk_sys moved: retune the state machine clock so the blink rate stays the same
+void led_engine_set_clock(led_engine_t *leds, const uint32_t sys_hz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
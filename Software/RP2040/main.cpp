@@ -0,0 +1,980 @@
+// Capstone Mainboard Power Supply Code V0.3
+// Jordan Harris-Toovy, May 2024
+
+/* 
+*  FPGA Power Sequencing Requirements:
+*  Group A: (VCCINT, VCCBRAM, VMGTAVCC) [1V0, 1V0GTX]
+*  Group B: (VCCAUX, VMGTAVTT, VMGTVCCAUX, VMGTAVTTRCAL, VCCADC, VREFP, VCCAUX_IO, VCCO_32/33/34, VCC_FLASH_IO, VCC_CONN_IO) [1V2GTX, 1V8, 1V8GTX]
+*  Group C: (VCCO_12/14, VCCO_13/15/16, VCC_QSFP) [2V5, 3V3]
+*
+*  Power uo: A → B → C
+*  Power down: C → B → A
+*/ 
+
+/* Libraries */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pico/multicore.h>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include <hardware/irq.h>
+#include <hardware/adc.h>
+#include <hardware/clocks.h>
+#include <hardware/sync.h>
+#include "i2c_bus.h"
+#include "tps6287x.h"
+#include "tmp1075.h"
+#include "pmic_shadow.h"
+#include "margin.h"
+#include "host_cmd.h"
+#include "dvs.h"
+#include "fault_log.h"
+#include "rail_seq.h"
+#include "pg_monitor.h"
+#include "wcet.h"
+#include "idle.h"
+#include "led_engine.h"
+#include "recovery.h"
+#include "evloop.h"
+#include "dlog.h"
+#include "board.hpp"
+
+/* Turn dev mode on or off */
+#define DEV_MODE true           // TODO: REMOVE: CONV TO WHEN USB CONN
+
+/* Communication parameters */
+// General I2C parameters
+static const uint32_t INIT_SERIAL_DELAY     = 5000;         // Delay before serial communication starts (in ms)
+static const uint32_t I2C_0_FREQ            = 100;          // I2C-0 Communication frequency (in kHz)
+static const uint8_t I2C_0_DATA_BUF_LEN     = 6;            // I2C-0 PMIC scratch buffer size (one TPS6287X register block), not a transfer limit
+
+//Timing constants
+static const uint16_t PMIC_SCRUB_PERIOD     = 1000;         // Time between PMIC register scrubs, one PMIC per scrub (in ms)
+static const uint32_t PROTECT_PERIOD        = 10;           // Software PG check and watchdog feed, wake pins run it early (in ms)
+static const uint32_t HOST_POLL_PERIOD      = 10;           // USB input, status LEDs and the DVS load hint (in ms)
+static const uint32_t SEQ_STEP_PERIOD       = 1;            // One sequencer pass (in ms)
+static const uint32_t LOG_SERVICE_PERIOD    = 100;          // Staged fault log records to flash (in ms)
+static const uint32_t IDLE_SHUTDOWN_BUDGET  = 500;          // PG edge to every enable low while idle, wake included (in us)
+static const uint32_t WCET_PG_CHECK_BUDGET  = 32;           // Software PG check (in clk_sys cycles)
+static const uint32_t WCET_PG_TRIP_BUDGET   = 12500;        // PG trip to every enable low, without discharge waits (in clk_sys cycles, 100 us at 125 MHz)
+
+/* PMIC register shadows */
+static pmic_shadow_t pmic_shadows[NUM_BOARD_PMICS];         // Register shadow of every PMIC, in BOARD_PMICS order
+
+/* Rail descriptions */
+// Margining and scrub view of BOARD_PMICS (board.hpp), in the same order
+static constexpr std::array<pmic_rail_t, NUM_BOARD_PMICS> PMIC_RAILS = make_pmic_rails(pmic_shadows);
+static const size_t NUM_PMIC_RAILS = PMIC_RAILS.size();
+
+// Power-on register values checked during discovery, by offset from TPS6287X_VSET_OA (readback buffer index)
+struct pmic_default {
+    uint8_t offset;
+    uint8_t value;
+    const char *name;                                       // Register name used in logs
+};
+static const pmic_default PMIC_DEFAULTS[] = {
+    { TPS6287X_CTRL1_OA, TPS6287X_CTRL1_DEF, "CONTROL1" },
+    { TPS6287X_CTRL2_OA, TPS6287X_CTRL2_DEF, "CONTROL2" },
+    { TPS6287X_CTRL3_OA, TPS6287X_CTRL3_DEF, "CONTROL3" },
+    { TPS6287X_STATUS_OA, TPS6287X_STATUS_INI, "STATUS" }
+};
+static const size_t NUM_PMIC_DEFAULTS = sizeof(PMIC_DEFAULTS) / sizeof(PMIC_DEFAULTS[0]);
+static const uint8_t PMIC_READBACK_LEN = TPS6287X_STATUS_OA + 1;   // VSET through STATUS in one read
+
+static_assert(PMIC_READBACK_LEN <= I2C_0_DATA_BUF_LEN, "PMIC readback does not fit the I2C-0 scratch buffer");
+static_assert(((NUM_PMIC_DEFAULTS + 1) < 10) && ((NUM_BOARD_PMICS * 10) <= 0xFF), "PMIC startup error codes must fit a byte, one decade per PMIC");
+
+// Sequencer view of BOARD_RAILS (board.hpp), indexed by the SEQ_ constants there. Kept in SRAM with the power-down
+// code that walks it, so a fault path never waits on a flash read
+static constexpr std::array<rail_seq_node_t, NUM_SEQ_RAILS> SEQ_RAILS __not_in_flash("seq_rails") = make_seq_nodes();
+
+static rail_seq_state_t seq_state;                          // Progress and timing of the power-up
+
+/*
+*  The PIO power good monitor samples PG_MONITOR_PG_COUNT consecutive pins and drops one run of consecutive enables
+*  with a single set instruction (5 pins at most). Group C goes first on a PG loss, the rest follows in software.
+*/
+constexpr uint32_t GROUP_C_EN_MASK = board_group_en_mask(seq_group::c);
+constexpr uint8_t GROUP_C_EN_BASE = (uint8_t) __builtin_ctz(GROUP_C_EN_MASK);
+constexpr uint8_t GROUP_C_EN_COUNT = (uint8_t) __builtin_popcount(GROUP_C_EN_MASK);
+constexpr uint8_t PG_MONITOR_BASE = (uint8_t) __builtin_ctz(BOARD_PG_MASK);
+
+static_assert(BOARD_PG_MASK == (((1u << PG_MONITOR_PG_COUNT) - 1) << PG_MONITOR_BASE), "PG pins must be PG_MONITOR_PG_COUNT consecutive GPIOs");
+static_assert((GROUP_C_EN_MASK == (((1u << GROUP_C_EN_COUNT) - 1) << GROUP_C_EN_BASE)) && (GROUP_C_EN_COUNT <= 5),
+              "group C enables must be consecutive GPIOs (at most 5) for the PIO set instruction");
+static_assert((MASTER_PWR_GOOD < PG_MONITOR_BASE) || (MASTER_PWR_GOOD >= PG_MONITOR_BASE + PG_MONITOR_PG_COUNT), "MASTER_PWR_GOOD is a PG input");
+
+static pg_monitor_t pg_monitor;                             // PIO state machine guarding the rails once they are up
+
+// The LED state machine drives the six indicators with one out instruction
+static_assert(((1u << IND_PWR_STATUS_GREEN) | (1u << IND_PWR_STATUS_ORANGE) | (1u << IND_FPGA_IMG_GREEN) | (1u << IND_FPGA_IMG_ORANGE) |
+               (1u << IND_UC_STATUS_GREEN) | (1u << IND_UC_STATUS_ORANGE)) == (((1u << LED_ENGINE_COUNT) - 1) << IND_PWR_STATUS_GREEN),
+              "indicator LEDs must be LED_ENGINE_COUNT consecutive GPIOs from IND_PWR_STATUS_GREEN");
+
+static led_engine_t leds;                                   // Indicator LED patterns, played by PIO-0
+
+// The watchdog scratch record keeps 16 bits of enabled and of good rails
+static_assert(NUM_SEQ_RAILS <= 16, "rail state must fit the recovery record");
+
+static recovery_state_t recovery;                           // Watchdog, boot stage and what the last reset left behind
+
+// Fault log records carry one snapshot per temperature sensor, in BOARD_TEMP_SENSORS order
+static_assert(NUM_BOARD_TEMP_SENSORS == FAULT_LOG_NUM_TEMPS, "fault log temperature snapshot does not match the board's sensors");
+
+// DVS scales the first PMIC
+static_assert(BOARD_PMICS[0].rail == SEQ_1V0, "the first BOARD_PMICS entry must be the 1V0 core rail");
+
+static margin_shmoo_t margin_results;                      // Last shmoo table, kept for the host to read back
+static dvs_state_t core_dvs;                                // Dynamic voltage scaling state of the 1V0 core rail
+static idle_state_t idle_mode;                              // Clock and sleep state between event loop tasks
+static int pg_monitor_result = 0;                           // Result of the PIO power good monitor setup
+
+/*
+*  Once the PMICs are set up everything runs as event loop tasks, highest priority first. None of them waits: the
+*  sequencer does one pass per tick, telemetry one PMIC and one sensor. The PIO monitor does not depend on any of them,
+*  the protect task only reports its trips (and checks PG itself when the PIO is not available).
+*/
+enum loop_msg : uint16_t {
+    MSG_TICK = 0,                                           // Task timer
+    MSG_WAKE,                                               // A wake pin ended the idle sleep
+    MSG_STEP                                                // A rail move's dwell is over, time for its next VSET step
+};
+
+static evloop_t loop;
+static evloop_task_t protect_task;                          // PG check, trip report, watchdog feed
+static evloop_task_t seq_task;                              // Rail sequencing, until every rail is up
+static evloop_task_t dvs_task;                              // Core rail scaling
+static evloop_task_t host_task;                             // Host commands and status LEDs
+static evloop_task_t telemetry_task;                        // PMIC scrub and temperature snapshot
+static evloop_task_t log_task;                              // Fault log writes
+static evloop_timer_t protect_timer;
+static evloop_timer_t seq_timer;
+static evloop_timer_t dvs_timer;
+static evloop_timer_t host_timer;
+static evloop_timer_t telemetry_timer;
+static evloop_timer_t log_timer;
+static evloop_timer_t dvs_step_timer;                       // Dwell of the DVS rail move
+static evloop_timer_t host_step_timer;                      // Dwell of the host's rail move
+
+static margin_walk_t host_walk;                             // Rail move started by a host command (margin, vset)
+static void (*host_walk_done)(const int result) = NULL;     // Reports the host's rail move once it is over, NULL while none runs
+
+/* Functions */
+
+// Finds a rail description by name, returns NULL if there is none
+const pmic_rail_t *find_rail(const char *name) {
+
+    for (size_t index = 0; index < NUM_PMIC_RAILS; index++) {
+        if (strcmp(PMIC_RAILS[index].name, name) == 0) {
+            return (&PMIC_RAILS[index]);
+        }
+    }
+
+    printf("Unknown rail: %s\n", name);
+    return (NULL);
+}
+
+// Design check used while margining: the FPGA must stay configured and free of CRC errors
+bool fpga_design_ok(void) {
+    return (gpio_get(FPGA_CONFDONE) && gpio_get(FPGA_INIT_CRCERR));
+}
+
+// One step of the host's rail move, the next one a dwell later, and the command's report once the rail has stopped
+void host_walk_step(void) {
+
+    const int result = margin_step(i2c0, &host_walk);
+    void (*done)(const int result) = host_walk_done;
+
+    if (result == MARGIN_BUSY) {
+        evloop_timer_start(&loop, &host_step_timer, &host_task, MSG_STEP, 0, MARGIN_STEP_DWELL_MS, 0);
+        return;
+    }
+    host_walk_done = NULL;
+    done(result);
+}
+
+// Start the host's rail move (start_result from its margin_*_start()), done reports it once it is over
+void host_walk_begin(const int start_result, void (*done)(const int result)) {
+
+    if (start_result != 0) {
+        done(start_result);
+        return;
+    }
+    host_walk_done = done;
+    host_walk_step();
+}
+
+// One host move at a time, and never on the rail DVS is moving
+bool host_walk_free(const pmic_rail_t *rail) {
+
+    if (host_walk_done != NULL) {
+        printf("ERROR: %s rail still moving - try again once it is done\n", host_walk.rail->name);
+        return (false);
+    }
+    if (core_dvs.moving && (core_dvs.rail == rail)) {
+        printf("ERROR: DVS is moving the %s rail - try again\n", rail->name);
+        return (false);
+    }
+    return (true);
+}
+
+// End of a margin sweep: print and log the shmoo table
+void report_margin(const int result) {
+
+    const pmic_rail_t *rail = margin_results.rail;
+
+    margin_print_shmoo(&margin_results);
+    fault_log_event(FAULT_LOG_MARGIN, (uint8_t)(rail - PMIC_RAILS.data()), ((uint32_t) margin_results.vset_lowest_pass << 8) | margin_results.vset_highest_pass);
+    if (result == MARGIN_ERR_I2C) {
+        printf("ERROR: I2C failure during sweep - %s rail returned to nominal\n", rail->name);
+    }
+}
+
+// End of a vset move
+void report_vset(const int result) {
+
+    const pmic_rail_t *rail = host_walk.rail;
+
+    if (result == MARGIN_ERR_LIMIT) {
+        printf("ERROR: Value outside the %s rail window (%u-%u mV)\n", rail->name, rail->limit_lo_mv, rail->limit_hi_mv);
+    }
+    else if (result == MARGIN_ERR_CHECK) {
+        printf("ERROR: Check failed while stepping - %s rail returned to its previous value\n", rail->name);
+    }
+    else if (result == MARGIN_ERR_I2C) {
+        printf("ERROR: %s PMIC did not respond\n", rail->name);
+    }
+    else {
+        printf("%s rail set\n", rail->name);
+    }
+}
+
+// Host command: margin <rail> [step] - sweep a rail and print the shmoo table once it is done
+void cmd_margin(int argc, char *argv[]) {
+
+    const pmic_rail_t *rail = NULL;
+    uint8_t step = 1;
+
+    if (argc < 2) {
+        printf("Usage: margin <rail> [step]\n");
+        return;
+    }
+    rail = find_rail(argv[1]);
+    if (rail == NULL) {
+        return;
+    }
+    if (argc > 2) {
+        step = (uint8_t) strtoul(argv[2], NULL, 0);
+    }
+    if (!host_walk_free(rail)) {
+        return;
+    }
+
+    host_walk_begin(margin_sweep_start(i2c0, rail, step, fpga_design_ok, &margin_results, &host_walk), report_margin);
+}
+
+// Host command: shmoo - print the last shmoo table again
+void cmd_shmoo(int argc, char *argv[]) {
+
+    if (margin_results.rail == NULL) {
+        printf("No sweep has been run\n");
+        return;
+    }
+    if (host_walk_done == report_margin) {
+        printf("Sweep still running\n");
+        return;
+    }
+    margin_print_shmoo(&margin_results);
+}
+
+// Host command: vset <rail> <value> - step a rail to a new VSET value with checks
+void cmd_vset(int argc, char *argv[]) {
+
+    const pmic_rail_t *rail = NULL;
+
+    if (argc < 3) {
+        printf("Usage: vset <rail> <value>\n");
+        return;
+    }
+    rail = find_rail(argv[1]);
+    if (rail == NULL) {
+        return;
+    }
+
+    if (!host_walk_free(rail)) {
+        return;
+    }
+
+    host_walk_begin(margin_set_vset_start(i2c0, rail, (uint8_t) strtoul(argv[2], NULL, 0), fpga_design_ok, &host_walk), report_vset);
+}
+
+// Host command: dvs <on|off|status|shmoo> - control core rail scaling
+void cmd_dvs(int argc, char *argv[]) {
+
+    if (argc < 2) {
+        printf("Usage: dvs <on|off|status|shmoo>\n");
+        return;
+    }
+
+    if (strcmp(argv[1], "on") == 0) {
+        dvs_enable(&core_dvs, true);
+    }
+    else if (strcmp(argv[1], "off") == 0) {
+        dvs_enable(&core_dvs, false);
+    }
+    else if (strcmp(argv[1], "shmoo") == 0) {
+        if (host_walk_done == report_margin) {
+            printf("ERROR: Sweep still running\n");
+        }
+        else if (!dvs_set_idle_from_shmoo(&core_dvs, &margin_results)) {
+            printf("ERROR: Last shmoo is not of the %s rail\n", core_dvs.rail->name);
+        }
+    }
+    else if (strcmp(argv[1], "status") != 0) {
+        printf("Usage: dvs <on|off|status|shmoo>\n");
+        return;
+    }
+
+    printf("DVS %s%s: idle %u mV, full %u mV, now %s%s\n", (core_dvs.enabled ? "on" : "off"), (core_dvs.fault ? " (locked out)" : ""),
+           tps6287x_vset_to_mv(core_dvs.rail->ctrl2, core_dvs.vset_points[DVS_LEVEL_IDLE]),
+           tps6287x_vset_to_mv(core_dvs.rail->ctrl2, core_dvs.vset_points[DVS_LEVEL_FULL]),
+           ((core_dvs.applied_level == DVS_LEVEL_IDLE) ? "idle" : "full load"), (core_dvs.moving ? " (moving)" : ""));
+}
+
+// Host command: pmic <rail> [status] - show a PMIC's registers from the shadow, STATUS only on request (read clears it)
+void cmd_pmic(int argc, char *argv[]) {
+
+    const pmic_rail_t *rail = NULL;
+    pmic_shadow_t *shadow = NULL;
+    uint8_t status = 0;
+
+    if (argc < 2) {
+        printf("Usage: pmic <rail> [status]\n");
+        return;
+    }
+    rail = find_rail(argv[1]);
+    if (rail == NULL) {
+        return;
+    }
+    shadow = rail->shadow;
+
+    printf("%s PMIC (0x%02x): VSET 0x%02x (%u mV)\tCTRL1 0x%02x\tCTRL2 0x%02x\tCTRL3 0x%02x\n", rail->name, shadow->address,
+           shadow->value[TPS6287X_VSET_OA], tps6287x_vset_to_mv(rail->ctrl2, shadow->value[TPS6287X_VSET_OA]),
+           shadow->value[TPS6287X_CTRL1_OA], shadow->value[TPS6287X_CTRL2_OA], shadow->value[TPS6287X_CTRL3_OA]);
+    printf("Valid 0x%02x\tDirty 0x%02x\tScrubs %lu\tMismatches %lu\n", shadow->valid, shadow->dirty,
+           (unsigned long) shadow->scrub_count, (unsigned long) shadow->scrub_mismatches);
+
+    if ((argc > 2) && (strcmp(argv[2], "status") == 0)) {
+        if (pmic_shadow_read(i2c0, shadow, TPS6287X_STATUS_OA, &status) == 1) {
+            printf("STATUS 0x%02x\n", status);
+        }
+        else {
+            printf("ERROR: %s PMIC did not respond\n", rail->name);
+        }
+    }
+}
+
+// Host command: log [erase] - print the persistent fault log (or have it erased at the next power-down or reset)
+void cmd_log(int argc, char *argv[]) {
+
+    const bool erase = (argc > 1) && (strcmp(argv[1], "erase") == 0);
+
+    // The rails are up, so erasing here would hold off the trip interrupts: the request is logged and carried out later
+    if (erase) {
+        if (!fault_log_request_erase()) {
+            printf("ERROR: Fault log staging buffer full, try again\n");
+            return;
+        }
+        printf("Fault log erase queued for the next power-down or reset\n");
+    }
+
+    // Anything still staged goes to flash first so the dump is complete
+    fault_log_service();
+    if (!erase) {
+        fault_log_dump();
+    }
+}
+
+// Host command: i2c [scan|recover] - device health on I2C-0, probe every address or free a stuck bus
+void cmd_i2c(int argc, char *argv[]) {
+
+    uint8_t buffer[1];
+
+    if ((argc > 1) && (strcmp(argv[1], "scan") == 0)) {
+        scan_i2c(i2c0, buffer);
+    }
+    else if ((argc > 1) && (strcmp(argv[1], "recover") == 0)) {
+        printf("Bus %s\n", (i2c_bus_recover(i2c0) ? "released" : "still held low"));
+    }
+    else if (argc > 1) {
+        printf("Usage: i2c [scan|recover]\n");
+        return;
+    }
+    i2c_bus_print_health(i2c0);
+}
+
+/* Power-on readback of one PMIC (BOARD_PMICS index), loading its shadow if every register holds its default. Returns 0,
+or the startup error code: ten times the index, plus 1 if the PMIC did not respond or 2 to 5 for the first of
+CONTROL1, CONTROL2, CONTROL3 and STATUS that does not hold its default */
+uint8_t scan_pmic(i2c_inst_t *i2c, const size_t index, uint8_t *buffer) {
+
+    const pmic_rail_t &rail = PMIC_RAILS[index];
+    const int bytes_read = read_i2c(i2c, BOARD_PMICS[index].address, TPS6287X_VSET_OA, buffer, PMIC_READBACK_LEN);
+
+    if (DEV_MODE) {
+        sleep_ms(200);
+    }
+    if (bytes_read <= 0) {
+        DLOG("ERROR: %s PMIC did not respond\n", rail.name);
+        return ((uint8_t)((10 * index) + 1));
+    }
+    for (size_t check = 0; check < NUM_PMIC_DEFAULTS; check++) {
+        const pmic_default &expected = PMIC_DEFAULTS[check];
+        if (buffer[expected.offset] != expected.value) {
+            DLOG("ERROR: Non-default readback value from %s PMIC %s register\n", rail.name, expected.name);
+            DLOG("Expected: %x\t Received: %x\n", expected.value, buffer[expected.offset]);
+            return ((uint8_t)((10 * index) + 2 + check));
+        }
+    }
+
+    DLOG("%s PMIC register readback successful\n", rail.name);
+    pmic_shadow_load(rail.shadow, buffer, PMIC_READBACK_LEN);
+    return (0);
+}
+
+// Scrub one PMIC against its shadow and put back anything that changed
+void scrub_pmic(i2c_inst_t *i2c, const pmic_rail_t *rail) {
+
+    int mismatches = pmic_shadow_scrub(i2c, rail->shadow);
+
+    if (mismatches < 0) {
+        DLOG("ERROR: %s PMIC did not respond to scrub\n", rail->name);
+    }
+    else if (mismatches > 0) {
+        fault_log_event(FAULT_LOG_SCRUB_MISMATCH, (uint8_t)(rail - PMIC_RAILS.data()), (uint32_t) mismatches);
+        DLOG("ERROR: %s PMIC registers changed (mask 0x%02x) - restoring\n", rail->name, mismatches);
+        if (pmic_shadow_restore(i2c, rail->shadow, (uint8_t) mismatches) != 0) {
+            DLOG("ERROR: %s PMIC restore incomplete\n", rail->name);
+        }
+    }
+}
+
+// PG pins that are low (gpio_get_all() bit order). One register read and a constant mask, from SRAM
+static uint32_t __no_inline_not_in_flash_func(pg_check)(void) {
+    return (~gpio_get_all() & BOARD_PG_MASK);
+}
+
+// clk_sys moved (idle mode): keep the LED blink rate
+void on_clock_change(const uint32_t sys_hz) {
+    led_engine_set_clock(&leds, sys_hz);
+}
+
+/* Indicator LEDs that follow board inputs: the FPGA configuration state and the USB connection. Called every host task
+pass, costs a few compares unless something changed */
+void show_status(void) {
+
+    const bool done = gpio_get(FPGA_CONFDONE);
+    const bool init = gpio_get(FPGA_INIT_CRCERR);
+
+    led_engine_set(&leds, IND_FPGA_IMG_GREEN, (done ? LED_ON : LED_BLINK));
+    led_engine_set(&leds, IND_FPGA_IMG_ORANGE, ((done && !init) ? LED_BLINK : LED_OFF));
+    led_engine_set(&leds, IND_UC_STATUS_GREEN, (gpio_get(DIAG_USB_CONN) ? LED_BLINK : LED_ON));
+}
+
+/* A PG pin dropped after startup: take everything down in reverse order, name the rails that lost it and wait for a
+reset. The shutdown comes first, so the time from the wake to every enable low is the one the idle bound covers. The
+rail walk is unrolled at compile time, each test is a bit check against a constant */
+void pg_trip(const uint32_t pg_lost) {
+
+    rail_seq_power_down(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+    fault_log_event(FAULT_LOG_PG_FAULT, 0, pg_lost);
+    led_engine_set(&leds, IND_PWR_STATUS_GREEN, LED_OFF);
+    led_engine_set(&leds, IND_PWR_STATUS_ORANGE, LED_BLINK);
+
+    for_each_rail([pg_lost](auto index) {
+        constexpr board_rail rail = BOARD_RAILS[index];
+        if constexpr (rail.pg_pin != RAIL_SEQ_NO_PIN) {
+            if (pg_lost & (1u << rail.pg_pin)) {
+                DLOG("ERROR: %s rail lost power good\n", rail.name);
+            }
+        }
+    });
+    DLOG("All rails powered down\n");
+
+    // Everything is off again, so this is a safe point to erase ahead and commit the log
+    fault_log_prepare();
+    fault_log_service();
+
+    // Stays down for a human: a watchdog retry would power into whatever made the rail fail
+    recovery_halt(&recovery, RECOVERY_STAGE_HALTED);
+    while (true) {
+        sleep_ms(10000);
+        DLOG("Power good lost (mask 0x%08lx) - awaiting reset\n", (unsigned long) pg_lost);
+        while (dlog_drain()) {
+        }
+    }
+}
+
+/* PIO monitor trip, from its interrupt: group C is already off and the pins are back with the CPU, take the rest down
+in order. Runs from SRAM. The report and the halt happen in the protect task */
+void __not_in_flash_func(on_pg_monitor_trip)(const uint32_t pg_lost) {
+    rail_seq_power_down(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+}
+
+// Benchmark: the protect task's PG check
+void bench_pg_check(void *arg) {
+    volatile uint32_t pg_lost = pg_check();
+    (void) pg_lost;
+}
+
+/* Benchmark: a PIO trip with every rail marked on, through to every enable low. Only run while the rails are really
+off, so every PG is already low and the discharge waits (bounded by the rail timeouts, not by the CPU) end at once */
+void bench_pg_trip(void *arg) {
+    seq_state.enabled = (1u << NUM_SEQ_RAILS) - 1;
+    seq_state.good = seq_state.enabled;
+    pg_monitor_service_trip(&pg_monitor);
+}
+
+// Fault paths timed at boot, in FAULT_LOG_WCET_OVER code order
+static wcet_path_t WCET_PATHS[] = {
+    { "pg check", bench_pg_check, NULL, WCET_PG_CHECK_BUDGET, 0, 0 },
+    { "pg trip", bench_pg_trip, NULL, WCET_PG_TRIP_BUDGET, 0, 0 }
+};
+static const size_t NUM_WCET_PATHS = sizeof(WCET_PATHS) / sizeof(WCET_PATHS[0]);
+static size_t num_wcet_measured = 0;                        // Paths the boot benchmark could run
+
+// Host command: wcet - print the fault path timings taken at boot (the trip path cannot be rerun with the rails up)
+void cmd_wcet(int argc, char *argv[]) {
+    wcet_print(WCET_PATHS, num_wcet_measured);
+}
+
+// Host command: idle [on|off] - allow or forbid idle mode and show its wake latency bound
+void cmd_idle(int argc, char *argv[]) {
+
+    if ((argc > 1) && (strcmp(argv[1], "on") == 0)) {
+        idle_enable(&idle_mode, true);
+    }
+    else if ((argc > 1) && (strcmp(argv[1], "off") == 0)) {
+        idle_enable(&idle_mode, false);
+    }
+    else if (argc > 1) {
+        printf("Usage: idle [on|off]\n");
+        return;
+    }
+    idle_print(&idle_mode);
+}
+
+// Host command: tasks - event loop tasks with their worst case latency and run time
+void cmd_tasks(int argc, char *argv[]) {
+    evloop_print(&loop);
+}
+
+// Commands accepted over USB once startup has finished
+static const host_cmd_t HOST_CMDS[] = {
+    { "margin", "<rail> [step] - sweep a rail and print the shmoo table", cmd_margin },
+    { "shmoo",  "- print the last shmoo table", cmd_shmoo },
+    { "vset",   "<rail> <value> - step a rail to a new VSET value", cmd_vset },
+    { "dvs",    "<on|off|status|shmoo> - core rail scaling on FPGA load hints", cmd_dvs },
+    { "pmic",   "<rail> [status] - show PMIC registers (from RAM, STATUS from the bus)", cmd_pmic },
+    { "log",    "[erase] - print or erase the persistent fault log", cmd_log },
+    { "i2c",    "[scan|recover] - I2C device health, bus scan or bus recovery", cmd_i2c },
+    { "wcet",   "- fault path execution times measured at boot", cmd_wcet },
+    { "idle",   "[on|off] - idle mode (slow clock, deep sleep) and its shutdown latency bound", cmd_idle },
+    { "tasks",  "- event loop tasks, worst case latency and run time", cmd_tasks }
+};
+static const size_t NUM_HOST_CMDS = sizeof(HOST_CMDS) / sizeof(HOST_CMDS[0]);
+
+/* Event loop tasks */
+
+// Protect task: report a PIO trip, or check PG in software without the PIO, then feed the watchdog
+void task_protect(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+
+    // The PIO monitor has already powered down by the time this sees a trip, what is left is the report
+    if (pg_monitor.tripped) {
+        pg_trip(pg_monitor.pg_lost);
+    }
+    else if (!pg_monitor.armed) {
+        // Every PG pin is read in one go and compared against a constant mask, no table walk on the way
+        const uint32_t pg_lost = pg_check();
+        if (pg_lost != 0) {
+            pg_trip(pg_lost);
+        }
+    }
+    recovery_feed(&recovery, seq_state.enabled, seq_state.good);
+}
+
+// DVS task: follow the FPGA load hint on the core rail, one VSET step per MSG_STEP while it moves
+void task_dvs(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+
+    int result = 0;
+
+    if (msg->type == MSG_STEP) {
+        result = dvs_step(&core_dvs, i2c0);
+    }
+    // A host move of the same rail finishes first, the hint is still there afterwards
+    else if ((host_walk_done == NULL) || (host_walk.rail != core_dvs.rail)) {
+        result = dvs_poll(&core_dvs, i2c0, fpga_design_ok);
+    }
+
+    if (result == MARGIN_BUSY) {
+        evloop_timer_start(loop, &dvs_step_timer, task, MSG_STEP, 0, MARGIN_STEP_DWELL_MS, 0);
+    }
+    else if ((result != 0) && core_dvs.fault) {
+        fault_log_event(FAULT_LOG_DVS_FAULT, 0, core_dvs.vset_points[DVS_LEVEL_IDLE]);
+    }
+}
+
+// Host task: run whatever arrived over USB and keep the status LEDs current, one VSET step per MSG_STEP of a rail move
+void task_host(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+
+    if (msg->type == MSG_STEP) {
+        host_walk_step();
+        return;
+    }
+
+    if (host_cmd_poll(HOST_CMDS, NUM_HOST_CMDS)) {
+        idle_activity(&idle_mode);
+    }
+    show_status();
+}
+
+// Telemetry task: catch PMICs that lost their settings (SEU, brown-out) and keep the fault log temperatures fresh
+void task_telemetry(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+
+    static size_t scrub_index = 0;                          // Rail to scrub next
+    static uint8_t temp_index = 0;                          // Temperature sensor to read next
+    int16_t temp_c_x16 = 0;
+
+    scrub_pmic(i2c0, &PMIC_RAILS[scrub_index]);
+    scrub_index = (scrub_index + 1) % NUM_PMIC_RAILS;
+
+    // One sensor per tick
+    if (tmp1075_read_temp(i2c0, BOARD_TEMP_SENSORS[temp_index], &temp_c_x16) == 0) {
+        fault_log_note_temp(temp_index, temp_c_x16);
+    }
+    temp_index = (temp_index + 1) % FAULT_LOG_NUM_TEMPS;
+}
+
+// Log task: staged fault records go to flash and deferred log records to USB here, behind every time critical task
+void task_log(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+    fault_log_service();
+    dlog_drain();
+}
+
+// Rails up: hand them to the PIO monitor and the protect task, then start everything else
+void start_running(void) {
+
+    // From here a PG loss drops group C in hardware, the protect task only checks PG if the PIO was not available
+    if (pg_monitor_result == 0) {
+        pg_monitor_arm(&pg_monitor, BOARD_PG_MASK >> PG_MONITOR_BASE);
+    }
+    else {
+        DLOG("ERROR: PIO power good monitor unavailable (code %d) - PG checked in software only\n", pg_monitor_result);
+    }
+
+    // Only the protect task feeds the watchdog from here
+    recovery_stage(&recovery, RECOVERY_STAGE_RUNNING, seq_state.enabled, seq_state.good);
+    DLOG("Startup successful\n");
+    led_engine_set(&leds, IND_PWR_STATUS_GREEN, LED_ON);
+    led_engine_set(&leds, IND_UC_STATUS_ORANGE, LED_OFF);
+    fault_log_event(FAULT_LOG_STARTUP_DONE, 0, (uint32_t)(time_us_64() / 1000));
+
+    // Core rail scaling starts off, the host enables it once the design has been margined
+    dvs_init(&core_dvs, &PMIC_RAILS[0], PWR_IN_MOD_RESERVED, PMIC_1V0_VSET_IDLE);
+
+    /* Sleep between tasks from here. A PG edge, USB being plugged in or a load hint change wakes the loop early. The
+    bound uses the measured trip path; without the PIO monitor there is no measurement, so its budget stands in */
+    idle_start(&idle_mode, BOARD_PG_MASK, (1u << DIAG_USB_CONN) | (1u << PWR_IN_MOD_RESERVED),
+               ((num_wcet_measured == NUM_WCET_PATHS) ? WCET_PATHS[1].max_cycles : WCET_PG_TRIP_BUDGET), IDLE_SHUTDOWN_BUDGET);
+
+    evloop_timer_start(&loop, &protect_timer, &protect_task, MSG_TICK, 0, PROTECT_PERIOD, PROTECT_PERIOD);
+    evloop_timer_start(&loop, &dvs_timer, &dvs_task, MSG_TICK, 0, HOST_POLL_PERIOD, HOST_POLL_PERIOD);
+    evloop_timer_start(&loop, &host_timer, &host_task, MSG_TICK, 0, HOST_POLL_PERIOD, HOST_POLL_PERIOD);
+    evloop_timer_start(&loop, &telemetry_timer, &telemetry_task, MSG_TICK, 0, PMIC_SCRUB_PERIOD, PMIC_SCRUB_PERIOD);
+    evloop_timer_start(&loop, &log_timer, &log_task, MSG_TICK, 0, LOG_SERVICE_PERIOD, LOG_SERVICE_PERIOD);
+}
+
+// Sequencing failed with every rail off again: log it and wait for the watchdog to retry
+void seq_abort(const int seq_result) {
+
+    DLOG("ERROR: %s rail failed to sequence (code %d) - all rails powered down\nAborting startup\n",
+           ((seq_state.failed_rail >= 0) ? SEQ_RAILS[seq_state.failed_rail].name : "?"), seq_result);
+
+    // Everything is off again, so this is a safe point to erase ahead and commit the log
+    fault_log_event(FAULT_LOG_STARTUP_ABORT, 0, (uint32_t) seq_state.failed_rail);
+    fault_log_prepare();
+    fault_log_service();
+    led_engine_set(&leds, IND_PWR_STATUS_GREEN, LED_OFF);
+    led_engine_set(&leds, IND_PWR_STATUS_ORANGE, LED_BLINK);
+
+    // Not fed from here: the watchdog resets and startup is tried again, up to RECOVERY_MAX_RESETS times in a row
+    recovery_stage(&recovery, RECOVERY_STAGE_ABORTED, 0, 0);
+    while (true) {
+        DLOG("Startup aborted (sequencing code %d) - awaiting reset\n", seq_result);
+        while (dlog_drain()) {
+        }
+        sleep_ms(10000);
+    }
+}
+
+// Sequencing task: one pass per tick until every rail is up, then the board is running
+void task_seq(evloop_t *loop, evloop_task_t *task, const evloop_msg_t *msg) {
+
+    const int seq_result = rail_seq_step(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+
+    if (seq_result == RAIL_SEQ_BUSY) {
+        return;
+    }
+    evloop_timer_stop(loop, &seq_timer);
+    rail_seq_print(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+
+    if (seq_result != 0) {
+        seq_abort(seq_result);
+    }
+    start_running();
+}
+
+// Event loop port: the 32-bit microsecond timer, interrupts off around queue changes and idle mode between tasks
+uint32_t loop_now_us(void) {
+    return (time_us_32());
+}
+
+uint32_t loop_lock(void) {
+    return (save_and_disable_interrupts());
+}
+
+void loop_unlock(const uint32_t saved) {
+    restore_interrupts(saved);
+}
+
+void loop_idle(const uint32_t max_us) {
+
+    const uint32_t pin_wakes = idle_mode.pin_wakes;
+
+    if (idle_wait(&idle_mode, max_us) == IDLE_ERR_OVER_BUDGET) {
+        DLOG("ERROR: PG to shutdown bound %lu us while idle, budget %lu us - idle mode off\n", (unsigned long) idle_bound_us(&idle_mode),
+               (unsigned long) IDLE_SHUTDOWN_BUDGET);
+        fault_log_event(FAULT_LOG_IDLE_OVER, 0, idle_bound_us(&idle_mode));
+    }
+
+    // A PG edge does not wait for the protect timer
+    if (idle_mode.pin_wakes != pin_wakes) {
+        evloop_post(&loop, &protect_task, MSG_WAKE, 0);
+    }
+}
+
+static const evloop_port_t LOOP_PORT = { loop_now_us, loop_lock, loop_unlock, loop_idle };
+
+/* Main program */
+
+int main(void) {
+
+    uint64_t timestamp_A_us             = time_us_64();     // 64-Bit timestamp in us. WARNING: Requires multiple clock cycles to process and could be malformed by an interrupt
+    uint64_t timestamp_B_us             = 0;                // 64-Bit timestamp in us. WARNING: Requires multiple clock cycles to process and could be malformed by an interrupt
+    uint8_t i2c_error_state             = 0;
+    uint8_t program_retry_count         = 0;
+    int seq_result                      = 0;                // Result of the rail sequencer
+    int led_result                      = 0;                // Result of the LED state machine setup
+
+    // Setup GPIO pins: every enable low and every PG an input before anything else happens
+    rail_seq_init(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+
+    // Start the watchdog and find out what the last reset left behind
+    recovery_init(&recovery);
+
+    /* A watchdog reset let go of every enable at once and rail_seq_init() has just driven them low, so the rails are
+    already going down together, not in order. What is left is to let them discharge: walk the recorded rails through
+    the power-down, which only waits (wave by wave, up to each rail's timeout) for their PG to drop */
+    if (recovery.last_enabled != 0) {
+        seq_state.enabled = recovery.last_enabled;
+        seq_state.good = recovery.last_good;
+        rail_seq_power_down(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+    }
+    pg_monitor_result = pg_monitor_init(&pg_monitor, pio0, PG_MONITOR_BASE, GROUP_C_EN_BASE, GROUP_C_EN_COUNT, MASTER_PWR_GOOD,
+                                        on_pg_monitor_trip);
+    gpio_init(FPGA_CONFDONE);
+    gpio_init(FPGA_INIT_CRCERR);
+
+    // Indicators: microcontroller booting
+    led_result = led_engine_init(&leds, pio0, IND_PWR_STATUS_GREEN, LED_ENGINE_BLINK_MS, clock_get_hz(clk_sys));
+    led_engine_set(&leds, IND_UC_STATUS_ORANGE, LED_ON);
+
+    // Peripheral clocks off PLL_USB from here on, so dropping clk_sys in idle leaves the baud rates alone
+    idle_init(&idle_mode, on_clock_change);
+
+    // Interface definitions
+    i2c_inst_t *i2c_0 = i2c0;                               // I2C-0 object creation
+
+    i2c_bus_init(i2c_0, ((uint32_t)1000 * I2C_0_FREQ), I2C_0_SDA_PIN, I2C_0_SCL_PIN);     // I2C-0 object activation
+
+    uint8_t i2c_0_data_buffer[I2C_0_DATA_BUF_LEN];          // I2C-0 Data buffer
+
+    // Initialize the serial port
+    stdio_init_all();
+
+    // Clear I2C-0 Data buffer
+    for (uint8_t index = 0; index < I2C_0_DATA_BUF_LEN; index++) {
+        i2c_0_data_buffer[index] = 0x00;
+    }
+
+    // Find the end of the fault log and record this boot. Nothing is powered yet, so the sector erase happens here and
+    // the running board only ever programs pages
+    fault_log_init();
+    fault_log_prepare();
+    fault_log_event(FAULT_LOG_BOOT, (uint8_t) recovery.cause, recovery_boot_data(&recovery));
+
+    // Nothing is known about the PMICs yet
+    for (size_t index = 0; index < NUM_BOARD_PMICS; index++) {
+        pmic_shadow_init(&pmic_shadows[index], BOARD_PMICS[index].address);
+    }
+
+    // Sleep before starting serial communication (not when resuming: the rails are waiting, not a host)
+    if (recovery.action != RECOVERY_RESUME) {
+        sleep_ms(INIT_SERIAL_DELAY);
+    }
+    if (recovery.cause == RECOVERY_CAUSE_WATCHDOG) {
+        DLOG("Watchdog reset during %s (rails 0x%02lx, %u in a row)\n", recovery_stage_name(recovery.last_stage),
+               (unsigned long) recovery.last_enabled, recovery.resets);
+    }
+    if (recovery.action == RECOVERY_STAY_DOWN) {
+        DLOG("ERROR: More than %u watchdog resets in a row - staying powered down\n", RECOVERY_MAX_RESETS);
+        led_engine_set(&leds, IND_UC_STATUS_ORANGE, LED_BLINK);
+
+        // Nothing is powered, so this is a safe point to erase ahead and commit the log
+        fault_log_prepare();
+        fault_log_service();
+        recovery_halt(&recovery, RECOVERY_STAGE_HALTED);
+        while (true) {
+            sleep_ms(10000);
+            DLOG("Startup stopped after repeated watchdog resets - awaiting reset\n");
+            while (dlog_drain()) {
+            }
+        }
+    }
+    if (led_result != 0) {
+        DLOG("ERROR: LED state machine unavailable (code %d) - indicators off\n", led_result);
+    }
+    led_engine_set(&leds, IND_PWR_STATUS_GREEN, LED_BLINK);
+
+    // After a watchdog reset with the PMICs already programmed there is nothing to discover: the setup below writes
+    // every register again and the readback check verifies them
+    if (recovery.action == RECOVERY_FULL_BOOT) {
+    do {
+
+    recovery_stage(&recovery, RECOVERY_STAGE_PMIC_SCAN, 0, 0);
+    i2c_error_state = 0;
+    DLOG("\nScanning for I2C PMICs\n");
+
+    // Highest rail first, the error state keeps the last failure
+    for (size_t index = NUM_BOARD_PMICS; index-- > 0;) {
+        const uint8_t pmic_error = scan_pmic(i2c_0, index, i2c_0_data_buffer);
+        if (pmic_error != 0) {
+            i2c_error_state = pmic_error;
+        }
+    }
+
+    // Check if an error has occured
+    if (i2c_error_state > 0) {
+        fault_log_event(FAULT_LOG_PMIC_ERROR, i2c_error_state, program_retry_count);
+        led_engine_set(&leds, IND_UC_STATUS_ORANGE, LED_BLINK);
+    }
+    if ((i2c_error_state > 0) && (program_retry_count == 0)) {
+        DLOG("Errors detected - reseting PMICS\n");
+        program_retry_count++;
+
+        // Write high reset bit to each PMIC. The bit clears itself and every register returns to default
+        for (const pmic_rail_t &rail : PMIC_RAILS) {
+            pmic_shadow_write(i2c_0, rail.shadow, TPS6287X_CTRL1_OA, TPS6287X_CTRL1_DEF_RST);
+            pmic_shadow_invalidate(rail.shadow);
+        }
+    }
+    else if (i2c_error_state > 0) {
+        DLOG("Persistent errors detected - last error: %d\nAborting startup\n", i2c_error_state);
+
+        // Nothing is powered, so this is a safe point to erase ahead and commit the log
+        fault_log_event(FAULT_LOG_STARTUP_ABORT, i2c_error_state, 0);
+        fault_log_prepare();
+        fault_log_service();
+        led_engine_set(&leds, IND_PWR_STATUS_GREEN, LED_OFF);
+        led_engine_set(&leds, IND_PWR_STATUS_ORANGE, LED_BLINK);
+
+        // Not fed from here: the watchdog resets and startup is tried again, up to RECOVERY_MAX_RESETS times in a row
+        recovery_stage(&recovery, RECOVERY_STAGE_ABORTED, 0, 0);
+        while (true) {
+            DLOG("Startup aborted (last code %d) - awaiting reset\n", i2c_error_state);
+            while (dlog_drain()) {
+            }
+            sleep_ms(10000);
+        }
+    }
+
+    // The startup is linear up to the event loop, its status lines go out at each stage
+    dlog_drain();
+
+    } while (i2c_error_state > 0);
+    }
+    else {
+        DLOG("PMICs were set up before the watchdog reset - skipping discovery\n");
+    }
+
+    recovery_stage(&recovery, RECOVERY_STAGE_PMIC_SETUP, 0, 0);
+
+    // Program every PMIC with its design values, highest rail first
+    for (size_t index = NUM_BOARD_PMICS; index-- > 0;) {
+        const pmic_rail_t &rail = PMIC_RAILS[index];
+        pmic_shadow_write(i2c_0, rail.shadow, TPS6287X_CTRL1_OA, TPS6287X_CTRL1_SET_EN);
+        pmic_shadow_write(i2c_0, rail.shadow, TPS6287X_CTRL2_OA, rail.ctrl2);
+        pmic_shadow_write(i2c_0, rail.shadow, TPS6287X_CTRL3_OA, TPS6287X_CTRL3_SET);
+        pmic_shadow_write(i2c_0, rail.shadow, TPS6287X_VSET_OA, rail.vset_nominal);
+        if (index > 0) {
+            sleep_ms(2);
+        }
+    }
+
+    // Readback check: compare every PMIC against what was just written
+    for (size_t index = 0; index < NUM_PMIC_RAILS; index++) {
+        scrub_pmic(i2c_0, &PMIC_RAILS[index]);
+    }
+
+    DLOG("PMICs setup\n");
+    dlog_drain();
+
+    // Time the fault paths while every rail is still off (the trip benchmark really runs the power-down)
+    num_wcet_measured = (pg_monitor_result == 0) ? NUM_WCET_PATHS : 1;     // The trip path needs the PIO monitor
+    if (wcet_run(WCET_PATHS, num_wcet_measured) > 0) {
+        for (size_t index = 0; index < num_wcet_measured; index++) {
+            if (WCET_PATHS[index].max_cycles > WCET_PATHS[index].budget_cycles) {
+                DLOG("ERROR: %s path takes %lu cycles, budget %lu\n", WCET_PATHS[index].name, (unsigned long) WCET_PATHS[index].max_cycles,
+                       (unsigned long) WCET_PATHS[index].budget_cycles);
+                fault_log_event(FAULT_LOG_WCET_OVER, (uint8_t) index, WCET_PATHS[index].max_cycles);
+            }
+        }
+    }
+    pg_monitor.tripped = false;
+
+    if (recovery.action != RECOVERY_RESUME) {
+        sleep_ms(2000);
+    }
+    recovery_stage(&recovery, RECOVERY_STAGE_SEQUENCING, 0, 0);
+
+    // From here everything is an event loop task, the sequencer first
+    evloop_init(&loop, &LOOP_PORT);
+    evloop_add_task(&loop, &protect_task, "protect", 0, task_protect, NULL);
+    evloop_add_task(&loop, &seq_task, "sequence", 1, task_seq, NULL);
+    evloop_add_task(&loop, &dvs_task, "dvs", 2, task_dvs, NULL);
+    evloop_add_task(&loop, &host_task, "host", 3, task_host, NULL);
+    evloop_add_task(&loop, &telemetry_task, "telemetry", 4, task_telemetry, NULL);
+    evloop_add_task(&loop, &log_task, "log", 5, task_log, NULL);
+
+    // Bring the rails up along the sequencing graph, each one as soon as the rails it waits for are good
+    seq_result = rail_seq_start(SEQ_RAILS.data(), NUM_SEQ_RAILS, &seq_state);
+    if (seq_result != 0) {
+        seq_abort(seq_result);
+    }
+    evloop_timer_start(&loop, &seq_timer, &seq_task, MSG_TICK, 0, SEQ_STEP_PERIOD, SEQ_STEP_PERIOD);
+
+    evloop_run(&loop);
+ 
+}
\ No newline at end of file
@@ -0,0 +1,298 @@
+// Capstone Mainboard Rail Voltage Margining
+// Rate-limited VSET stepping with PG/temperature/STATUS checks and shmoo logging
+
+/*
+*  Each rail is only ever moved MARGIN_MAX_STEP LSBs at a time with MARGIN_STEP_DWELL_MS between writes, so the
+*  output slews gently even when a large move is requested. After every write the PG pin, the TMP1075 next to the
+*  PMIC, the PMIC STATUS register and an optional design check are sampled. The first failure stops the move and the
+*  rail is walked back (unchecked) to where it started, or to nominal for a sweep. Limits come from the rail
+*  description and are never exceeded, whatever the caller asks for.
+*
+*  Nothing here sleeps through the dwell. A move is a walk that margin_step() takes one write further per call, checking
+*  the previous write first, so an event loop task runs one step per timer message and a full sweep never holds the
+*  core for more than a write and a check at a time.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include "i2c_bus.h"
+#include "tps6287x.h"
+#include "tmp1075.h"
+#include "pmic_shadow.h"
+#include "margin.h"
+
+/* Functions */
+
+// Lowest VSET value whose output is still inside the rail's window
+static uint8_t vset_lowest_allowed(const pmic_rail_t *rail) {
+
+    for (uint16_t vset = 0; vset <= 0xFF; vset++) {
+        if (tps6287x_vset_to_mv(rail->ctrl2, (uint8_t) vset) >= rail->limit_lo_mv) {
+            return ((uint8_t) vset);
+        }
+    }
+
+    return (rail->vset_nominal);
+}
+
+// Highest VSET value whose output is still inside the rail's window
+static uint8_t vset_highest_allowed(const pmic_rail_t *rail) {
+
+    for (int16_t vset = 0xFF; vset >= 0; vset--) {
+        if (tps6287x_vset_to_mv(rail->ctrl2, (uint8_t) vset) <= rail->limit_hi_mv) {
+            return ((uint8_t) vset);
+        }
+    }
+
+    return (rail->vset_nominal);
+}
+
+// Set up a walk that is not moving yet
+static void walk_init(margin_walk_t *walk, const pmic_rail_t *rail, margin_design_check_fn design_check, margin_shmoo_t *shmoo) {
+
+    walk->rail = rail;
+    walk->design_check = design_check;
+    walk->shmoo = shmoo;
+    walk->point = &walk->set_point;
+    walk->phase = MARGIN_WALK_DONE;
+    walk->current = 0;
+    walk->target = rail->vset_nominal;
+    walk->start = 0;
+    walk->step = 1;
+    walk->settling = false;
+    walk->result = 0;
+}
+
+// Phases that check the rail after every write, the rest are moves back towards safety
+static bool phase_checked(const margin_phase_t phase) {
+    return ((phase == MARGIN_WALK_SET) || (phase == MARGIN_WALK_SWEEP_DOWN) || (phase == MARGIN_WALK_SWEEP_UP));
+}
+
+// Sweep: aim at the next point delta away from the last one, false if that is outside the window or the table is full
+static bool next_point(margin_walk_t *walk, const int16_t delta) {
+
+    const int16_t target = (int16_t) walk->target + delta;
+    margin_shmoo_t *shmoo = walk->shmoo;
+
+    if ((target < vset_lowest_allowed(walk->rail)) || (target > vset_highest_allowed(walk->rail)) || (shmoo->num_points >= MARGIN_MAX_POINTS)) {
+        return (false);
+    }
+    walk->point = &shmoo->points[shmoo->num_points++];
+    walk->target = (uint8_t) target;
+    return (true);
+}
+
+// End a walk with a result
+static int walk_finish(margin_walk_t *walk, const int result) {
+    walk->phase = MARGIN_WALK_DONE;
+    return (result);
+}
+
+/* The current phase has reached its target (result 0) or failed: pick the next phase and target. Returns MARGIN_BUSY
+if the walk goes on, otherwise its result */
+static int next_phase(i2c_inst_t *i2c, margin_walk_t *walk, int result) {
+
+    const pmic_rail_t *rail = walk->rail;
+    margin_shmoo_t *shmoo = walk->shmoo;
+
+    switch (walk->phase) {
+
+        case MARGIN_WALK_SET:
+            if (result == 0) {
+                return (walk_finish(walk, 0));
+            }
+            walk->result = result;
+            walk->phase = MARGIN_WALK_SET_BACK;
+            walk->target = walk->start;
+            return (MARGIN_BUSY);
+
+        case MARGIN_WALK_SET_BACK:
+            return (walk_finish(walk, walk->result));
+
+        case MARGIN_WALK_SWEEP_NOMINAL:
+            // Nominal itself has to pass before anything else is tried
+            if (result == 0) {
+                walk->point = &shmoo->points[shmoo->num_points++];
+                result = margin_check(i2c, rail, walk->current, walk->design_check, walk->point);
+            }
+            if (result != 0) {
+                return (walk_finish(walk, result));
+            }
+            walk->phase = next_point(walk, -(int16_t) walk->step) ? MARGIN_WALK_SWEEP_DOWN : MARGIN_WALK_SWEEP_CENTRE;
+            return (MARGIN_BUSY);
+
+        case MARGIN_WALK_SWEEP_DOWN:
+        case MARGIN_WALK_SWEEP_UP: {
+            const bool down = (walk->phase == MARGIN_WALK_SWEEP_DOWN);
+
+            if (result == 0) {
+                if (down) {
+                    shmoo->vset_lowest_pass = walk->target;
+                }
+                else {
+                    shmoo->vset_highest_pass = walk->target;
+                }
+                if (next_point(walk, (down ? -(int16_t) walk->step : (int16_t) walk->step))) {
+                    return (MARGIN_BUSY);
+                }
+            }
+
+            // A failed check ends this half, a silent PMIC the whole sweep
+            walk->result = (result == MARGIN_ERR_I2C) ? result : 0;
+            walk->phase = (down && (result != MARGIN_ERR_I2C)) ? MARGIN_WALK_SWEEP_CENTRE : MARGIN_WALK_SWEEP_END;
+            walk->target = rail->vset_nominal;
+            return (MARGIN_BUSY);
+        }
+
+        case MARGIN_WALK_SWEEP_CENTRE:
+            if (result != 0) {
+                return (walk_finish(walk, result));
+            }
+            walk->phase = next_point(walk, (int16_t) walk->step) ? MARGIN_WALK_SWEEP_UP : MARGIN_WALK_SWEEP_END;
+            return (MARGIN_BUSY);
+
+        case MARGIN_WALK_SWEEP_END:
+            return (walk_finish(walk, ((walk->result != 0) ? walk->result : result)));
+
+        default:
+            return (walk_finish(walk, result));
+    }
+}
+
+int margin_check(i2c_inst_t *i2c, const pmic_rail_t *rail, const uint8_t vset, margin_design_check_fn design_check, margin_point_t *point) {
+
+    point->vset = vset;
+    point->mv = tps6287x_vset_to_mv(rail->ctrl2, vset);
+    point->pg = gpio_get(rail->pg_pin);
+    point->design_ok = (design_check == NULL) ? true : design_check();
+    point->pass = false;
+
+    if (pmic_shadow_read(i2c, rail->shadow, TPS6287X_STATUS_OA, &point->status) != 1) {
+        return (MARGIN_ERR_I2C);
+    }
+    if (tmp1075_read_temp(i2c, rail->temp_addr, &point->temp_c_x16) != 0) {
+        return (MARGIN_ERR_I2C);
+    }
+
+    point->pass = point->pg && point->design_ok &&
+                  ((point->status & TPS6287X_STATUS_FAULT) == 0) &&
+                  (point->temp_c_x16 < (MARGIN_TEMP_LIMIT_C * 16));
+
+    return (point->pass ? 0 : MARGIN_ERR_CHECK);
+}
+
+int margin_set_vset_start(i2c_inst_t *i2c, const pmic_rail_t *rail, const uint8_t target_vset, margin_design_check_fn design_check,
+                          margin_walk_t *walk) {
+
+    walk_init(walk, rail, design_check, NULL);
+
+    if ((target_vset < vset_lowest_allowed(rail)) || (target_vset > vset_highest_allowed(rail))) {
+        return (MARGIN_ERR_LIMIT);
+    }
+
+    // Start from what the PMIC is set to
+    if (pmic_shadow_read(i2c, rail->shadow, TPS6287X_VSET_OA, &walk->current) != 1) {
+        return (MARGIN_ERR_I2C);
+    }
+    walk->start = walk->current;
+    walk->target = target_vset;
+    walk->phase = MARGIN_WALK_SET;
+
+    return (0);
+}
+
+int margin_restore_start(i2c_inst_t *i2c, const pmic_rail_t *rail, margin_walk_t *walk) {
+
+    walk_init(walk, rail, NULL, NULL);
+
+    if (pmic_shadow_read(i2c, rail->shadow, TPS6287X_VSET_OA, &walk->current) != 1) {
+        return (MARGIN_ERR_I2C);
+    }
+    walk->phase = MARGIN_WALK_RESTORE;
+
+    return (0);
+}
+
+int margin_sweep_start(i2c_inst_t *i2c, const pmic_rail_t *rail, const uint8_t step_lsb, margin_design_check_fn design_check,
+                       margin_shmoo_t *shmoo, margin_walk_t *walk) {
+
+    walk_init(walk, rail, design_check, shmoo);
+    walk->step = (step_lsb < 1) ? 1 : step_lsb;
+
+    shmoo->rail = rail;
+    shmoo->num_points = 0;
+    shmoo->vset_lowest_pass = rail->vset_nominal;
+    shmoo->vset_highest_pass = rail->vset_nominal;
+
+    // Bring the rail to nominal first, next_phase() then checks nominal itself
+    if (pmic_shadow_read(i2c, rail->shadow, TPS6287X_VSET_OA, &walk->current) != 1) {
+        return (MARGIN_ERR_I2C);
+    }
+    walk->phase = MARGIN_WALK_SWEEP_NOMINAL;
+
+    return (0);
+}
+
+int margin_step(i2c_inst_t *i2c, margin_walk_t *walk) {
+
+    int result = 0;
+    uint8_t distance = 0;
+    uint8_t step = 0;
+    uint8_t next = 0;
+
+    if (walk->phase == MARGIN_WALK_DONE) {
+        return (0);
+    }
+
+    // The last write has had its dwell, check it if this part of the walk is checked
+    if (walk->settling) {
+        walk->settling = false;
+        if (phase_checked(walk->phase)) {
+            result = margin_check(i2c, walk->rail, walk->current, walk->design_check, walk->point);
+        }
+    }
+
+    while (true) {
+
+        // Target reached or a failure: on to the next phase until there is somewhere to go
+        while ((result != 0) || (walk->current == walk->target)) {
+            result = next_phase(i2c, walk, result);
+            if (result != MARGIN_BUSY) {
+                return (result);
+            }
+            result = 0;
+        }
+
+        distance = (walk->target > walk->current) ? (walk->target - walk->current) : (walk->current - walk->target);
+        step = (distance > MARGIN_MAX_STEP) ? MARGIN_MAX_STEP : distance;
+        next = (walk->target > walk->current) ? (walk->current + step) : (walk->current - step);
+
+        if (pmic_shadow_write(i2c, walk->rail->shadow, TPS6287X_VSET_OA, next) == 1) {
+            walk->current = next;
+            walk->settling = true;
+            return (MARGIN_BUSY);
+        }
+        result = MARGIN_ERR_I2C;
+    }
+}
+
+void margin_print_shmoo(const margin_shmoo_t *shmoo) {
+
+    const pmic_rail_t *rail = shmoo->rail;
+
+    printf("Shmoo: %s rail (nominal VSET 0x%02x = %u mV)\n", rail->name, rail->vset_nominal, tps6287x_vset_to_mv(rail->ctrl2, rail->vset_nominal));
+    printf("VSET\tmV\tPG\tTemp(C)\tSTATUS\tDesign\tResult\n");
+
+    for (uint8_t index = 0; index < shmoo->num_points; index++) {
+        const margin_point_t *point = &shmoo->points[index];
+        printf("0x%02x\t%u\t%d\t%d.%02d\t0x%02x\t%d\t%s\n", point->vset, point->mv, point->pg,
+               point->temp_c_x16 / 16, ((point->temp_c_x16 < 0 ? -point->temp_c_x16 : point->temp_c_x16) % 16) * 100 / 16,
+               point->status, point->design_ok, (point->pass ? "PASS" : "FAIL"));
+    }
+
+    printf("Passing window: 0x%02x (%u mV) to 0x%02x (%u mV)\n",
+           shmoo->vset_lowest_pass, tps6287x_vset_to_mv(rail->ctrl2, shmoo->vset_lowest_pass),
+           shmoo->vset_highest_pass, tps6287x_vset_to_mv(rail->ctrl2, shmoo->vset_highest_pass));
+}
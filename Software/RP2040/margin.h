@@ -0,0 +1,129 @@
+// Capstone Mainboard Rail Voltage Margining
+// Rate-limited VSET stepping with PG/temperature/STATUS checks and shmoo logging
+
+#ifndef MARGIN_H
+#define MARGIN_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+#include <hardware/i2c.h>
+#include "pmic_shadow.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Margining parameters */
+#define MARGIN_MAX_POINTS 64                                // Shmoo table capacity (points per sweep)
+
+static const uint8_t MARGIN_MAX_STEP        = 2;            // Largest VSET change written in one go (in LSBs), bigger moves are split up
+static const uint16_t MARGIN_STEP_DWELL_MS  = 20;           // Settling time after each VSET write before the checks run (in ms)
+static const int16_t MARGIN_TEMP_LIMIT_C    = 85;           // PMIC region temperature that ends a sweep (in degC)
+static const int MARGIN_BUSY                = 1;            // margin_step(): the rail is still moving, step again after MARGIN_STEP_DWELL_MS
+
+// Margining error codes
+static const int MARGIN_ERR_LIMIT           = -1;           // Requested VSET is outside the rail's allowed window
+static const int MARGIN_ERR_I2C             = -2;           // PMIC or temperature sensor did not respond
+static const int MARGIN_ERR_CHECK           = -3;           // PG, temperature, STATUS or design check failed at a step
+
+/* Types */
+
+// Static description of one TPS6287X rail
+typedef struct {
+    const char *name;                                       // Rail name used by host commands and logs ("1V0")
+    pmic_shadow_t *shadow;                                  // Register shadow of the rail's PMIC (all register access goes through it)
+    uint8_t pg_pin;                                         // PMIC power good GPIO
+    uint8_t temp_addr;                                      // 7-bit address of the TMP1075 next to the PMIC
+    uint8_t ctrl2;                                          // CONTROL2 design value (selects the VSET step size)
+    uint8_t vset_nominal;                                   // VSET design value
+    uint16_t limit_lo_mv;                                   // Lowest voltage margining may request (in mV)
+    uint16_t limit_hi_mv;                                   // Highest voltage margining may request (in mV)
+} pmic_rail_t;
+
+// Result of the checks at one VSET value
+typedef struct {
+    uint8_t vset;                                           // VSET value under test
+    uint16_t mv;                                            // Programmed output voltage (in mV)
+    int16_t temp_c_x16;                                     // Region temperature (in 1/16 degC)
+    uint8_t status;                                         // PMIC STATUS register (cleared by the read)
+    bool pg;                                                // PG pin level
+    bool design_ok;                                         // Result of the design check hook (true if none given)
+    bool pass;                                              // All of the above within limits
+} margin_point_t;
+
+// Shmoo table for one rail
+typedef struct {
+    const pmic_rail_t *rail;                                // Rail that was swept
+    uint8_t num_points;                                     // Valid entries in points[]
+    uint8_t vset_lowest_pass;                               // Lowest VSET that passed every check
+    uint8_t vset_highest_pass;                              // Highest VSET that passed every check
+    margin_point_t points[MARGIN_MAX_POINTS];               // One entry per tested VSET, in test order
+} margin_shmoo_t;
+
+// Optional check of the load itself (e.g. FPGA still configured and passing its self test)
+typedef bool (*margin_design_check_fn)(void);
+
+// Part of a rail move a walk is in
+typedef enum {
+    MARGIN_WALK_DONE = 0,                                   // Not moving
+    MARGIN_WALK_SET,                                        // Checked move to the requested VSET
+    MARGIN_WALK_SET_BACK,                                   // A check failed, unchecked move back to where the rail started
+    MARGIN_WALK_RESTORE,                                    // Unchecked move to nominal
+    MARGIN_WALK_SWEEP_NOMINAL,                              // Sweep: unchecked move to nominal, then nominal is checked
+    MARGIN_WALK_SWEEP_DOWN,                                 // Sweep: checked points below nominal
+    MARGIN_WALK_SWEEP_CENTRE,                               // Sweep: unchecked move back to nominal between the halves
+    MARGIN_WALK_SWEEP_UP,                                   // Sweep: checked points above nominal
+    MARGIN_WALK_SWEEP_END                                   // Sweep: unchecked move back to nominal
+} margin_phase_t;
+
+// One rail move in progress, one VSET write per margin_step()
+typedef struct {
+    const pmic_rail_t *rail;                                // Rail being moved
+    margin_design_check_fn design_check;                    // Run with the other checks (NULL: none)
+    margin_shmoo_t *shmoo;                                  // Sweep results (sweeps only)
+    margin_point_t *point;                                  // Where the checks of the current target go
+    margin_point_t set_point;                               // Checks of a set move, not kept
+    margin_phase_t phase;
+    uint8_t current;                                        // VSET the rail is at
+    uint8_t target;                                         // VSET this phase is heading for
+    uint8_t start;                                          // VSET a set move started from
+    uint8_t step;                                           // Sweep: VSET distance between points
+    bool settling;                                          // The last write is waiting out its dwell, its checks run next step
+    int result;                                             // Failure the walk ends with once the rail is back
+} margin_walk_t;
+
+/* Functions */
+
+/* Read back the PG pin, temperature and STATUS of a rail and decide whether the current VSET is good */
+int margin_check(i2c_inst_t *i2c, const pmic_rail_t *rail, const uint8_t vset, margin_design_check_fn design_check, margin_point_t *point);
+
+/* Rail moves never wait: each start function sets up a walk (0, or MARGIN_ERR_LIMIT/MARGIN_ERR_I2C if it could not),
+then margin_step() writes at most one VSET step per call. It returns MARGIN_BUSY while the rail is still moving, to be
+called again once MARGIN_STEP_DWELL_MS has passed (the checks of the write run then), and the result of the move when
+it is over. walk->rail is set even if the start fails */
+
+/* Move a rail to target_vset in steps of at most MARGIN_MAX_STEP, checking after every step.
+If a check fails the rail is walked back to where it started and the move ends with MARGIN_ERR_CHECK */
+int margin_set_vset_start(i2c_inst_t *i2c, const pmic_rail_t *rail, const uint8_t target_vset, margin_design_check_fn design_check,
+                          margin_walk_t *walk);
+
+/* Walk a rail back to its design value, rate limited but without checks (moving towards nominal is always the safe direction) */
+int margin_restore_start(i2c_inst_t *i2c, const pmic_rail_t *rail, margin_walk_t *walk);
+
+/* Sweep a rail down and then up from its nominal VSET in steps of step_lsb until a check fails or the limit is reached.
+The rail is always returned to nominal. Results go to shmoo */
+int margin_sweep_start(i2c_inst_t *i2c, const pmic_rail_t *rail, const uint8_t step_lsb, margin_design_check_fn design_check,
+                       margin_shmoo_t *shmoo, margin_walk_t *walk);
+
+// One step of a walk started above
+int margin_step(i2c_inst_t *i2c, margin_walk_t *walk);
+
+// Prints a shmoo table over stdio
+void margin_print_shmoo(const margin_shmoo_t *shmoo);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,157 @@
+// Capstone Mainboard Power Good Monitor
+// PIO state machine that ANDs the PG inputs, drives MASTER_PWR_GOOD and drops enables on a PG loss without the CPU
+
+/*
+*  While the rails are up the group C enables belong to the PIO, not to the CPU: the state machine compares every PG
+*  input against the expected levels every 5 cycles and on the first mismatch drops the enables and MASTER_PWR_GOOD
+*  in one instruction, then raises an interrupt. The handler gives the pins back to the CPU at their new levels and
+*  runs the trip callback, which takes down what is left in order. Protection therefore does not depend on what the
+*  cores are busy with, only the orderly part of the shutdown does.
+*
+*  The trip path (interrupt, pin hand-back and the callback's power-down) runs from SRAM and only touches registers,
+*  so a fault is never held up behind an XIP cache miss.
+*
+*  The PG inputs stay ordinary GPIO inputs (the PIO reads pad levels whatever the pin function), so the sequencer
+*  and the margining checks keep reading them as before.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/pio.h>
+#include <hardware/irq.h>
+#include <hardware/structs/iobank0.h>
+#include "pg_monitor.h"
+
+/* Variables */
+static pg_monitor_t *active_monitor = NULL;                 // Monitor served by the PIO interrupt
+
+/* Functions */
+
+// Bit mask of count pins from base
+static uint32_t pin_mask(const uint8_t base, const uint8_t count) {
+    return (((1u << count) - 1) << base);
+}
+
+// Hand a pin back to SIO. gpio_set_function() lives in flash and also rewrites the pad, which is already set up
+static void __no_inline_not_in_flash_func(set_sio_function)(const uint8_t pin) {
+    hw_write_masked(&iobank0_hw->io[pin].ctrl, GPIO_FUNC_SIO << IO_BANK0_GPIO0_CTRL_FUNCSEL_LSB, IO_BANK0_GPIO0_CTRL_FUNCSEL_BITS);
+}
+
+void __not_in_flash_func(pg_monitor_service_trip)(pg_monitor_t *monitor) {
+
+    uint32_t sample = 0;
+
+    pio_interrupt_clear(monitor->pio, monitor->sm);
+
+    // The state machine pushes the sample that tripped it, the pins may have moved on since
+    if (!pio_sm_is_rx_fifo_empty(monitor->pio, monitor->sm)) {
+        sample = pio_sm_get(monitor->pio, monitor->sm);
+    }
+    else {
+        sample = gpio_get_all() >> monitor->pg_base;
+    }
+
+    monitor->pg_lost = (~sample & monitor->expected) << monitor->pg_base;
+    monitor->tripped = true;
+    pg_monitor_release(monitor);
+
+    if (monitor->on_trip != NULL) {
+        monitor->on_trip(monitor->pg_lost);
+    }
+}
+
+// PIO interrupt: the state machine tripped, the enables are already low
+static void __not_in_flash_func(pg_monitor_irq)(void) {
+    if (active_monitor != NULL) {
+        pg_monitor_service_trip(active_monitor);
+    }
+}
+
+int pg_monitor_init(pg_monitor_t *monitor, PIO pio, const uint8_t pg_base, const uint8_t en_base, const uint8_t en_count,
+                    const uint8_t pwr_good_pin, pg_monitor_trip_fn on_trip) {
+
+    const uint irq_num = (pio == pio0) ? PIO0_IRQ_0 : PIO1_IRQ_0;
+    int sm = 0;
+
+    if (!pio_can_add_program(pio, &pg_monitor_program)) {
+        return (PG_MONITOR_ERR_NO_SPACE);
+    }
+    sm = pio_claim_unused_sm(pio, false);
+    if (sm < 0) {
+        return (PG_MONITOR_ERR_NO_SM);
+    }
+
+    monitor->pio = pio;
+    monitor->sm = (uint) sm;
+    monitor->offset = pio_add_program(pio, &pg_monitor_program);
+    monitor->pg_base = pg_base;
+    monitor->en_base = en_base;
+    monitor->en_count = en_count;
+    monitor->pwr_good_pin = pwr_good_pin;
+    monitor->expected = 0;
+    monitor->armed = false;
+    monitor->tripped = false;
+    monitor->pg_lost = 0;
+    monitor->on_trip = on_trip;
+
+    monitor->config = pg_monitor_program_get_default_config(monitor->offset);
+    sm_config_set_in_pins(&monitor->config, pg_base);
+    sm_config_set_in_shift(&monitor->config, false, false, 32);
+    sm_config_set_set_pins(&monitor->config, en_base, en_count);
+    sm_config_set_sideset_pins(&monitor->config, pwr_good_pin);
+
+    // MASTER_PWR_GOOD belongs to the state machine from now on and stays low until the first good sample
+    pio_sm_set_pins_with_mask(pio, monitor->sm, 0, 1u << pwr_good_pin);
+    pio_sm_set_pindirs_with_mask(pio, monitor->sm, 1u << pwr_good_pin, 1u << pwr_good_pin);
+    pio_gpio_init(pio, pwr_good_pin);
+
+    active_monitor = monitor;
+    pio_set_irq0_source_enabled(pio, (enum pio_interrupt_source)(pis_interrupt0 + monitor->sm), true);
+    irq_set_exclusive_handler(irq_num, pg_monitor_irq);
+    irq_set_enabled(irq_num, true);
+
+    return (0);
+}
+
+void pg_monitor_arm(pg_monitor_t *monitor, const uint32_t expected) {
+
+    const uint32_t en_mask = pin_mask(monitor->en_base, monitor->en_count);
+    const uint32_t pwr_good_mask = 1u << monitor->pwr_good_pin;
+
+    monitor->expected = expected & ((1u << PG_MONITOR_PG_COUNT) - 1);
+    monitor->tripped = false;
+    monitor->pg_lost = 0;
+
+    pio_sm_init(monitor->pio, monitor->sm, monitor->offset, &monitor->config);
+
+    // The rails are on: take the enables over at the level the CPU is driving, so nothing glitches. MASTER_PWR_GOOD
+    // stays low until the first good sample (a benchmark or an earlier release may have handed it to SIO)
+    pio_sm_set_pins_with_mask(monitor->pio, monitor->sm, en_mask, en_mask | pwr_good_mask);
+    pio_sm_set_pindirs_with_mask(monitor->pio, monitor->sm, en_mask | pwr_good_mask, en_mask | pwr_good_mask);
+    for (uint8_t pin = monitor->en_base; pin < (monitor->en_base + monitor->en_count); pin++) {
+        pio_gpio_init(monitor->pio, pin);
+    }
+    pio_gpio_init(monitor->pio, monitor->pwr_good_pin);
+
+    pio_sm_put(monitor->pio, monitor->sm, monitor->expected);
+    monitor->armed = true;
+    pio_sm_set_enabled(monitor->pio, monitor->sm, true);
+}
+
+void __not_in_flash_func(pg_monitor_release)(pg_monitor_t *monitor) {
+
+    pio_sm_set_enabled(monitor->pio, monitor->sm, false);
+
+    // SIO takes over at the pad level the PIO left, then the pin function moves back
+    for (uint8_t pin = monitor->en_base; pin < (monitor->en_base + monitor->en_count); pin++) {
+        gpio_put(pin, gpio_get(pin));
+        gpio_set_dir(pin, GPIO_OUT);
+        set_sio_function(pin);
+    }
+    gpio_put(monitor->pwr_good_pin, gpio_get(monitor->pwr_good_pin));
+    gpio_set_dir(monitor->pwr_good_pin, GPIO_OUT);
+    set_sio_function(monitor->pwr_good_pin);
+
+    monitor->armed = false;
+}
@@ -0,0 +1,66 @@
+// Capstone Mainboard Power Good Monitor
+// PIO state machine that ANDs the PG inputs, drives MASTER_PWR_GOOD and drops enables on a PG loss without the CPU
+
+#ifndef PG_MONITOR_H
+#define PG_MONITOR_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+#include <hardware/pio.h>
+#include "pg_monitor.pio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Monitor error codes
+static const int PG_MONITOR_ERR_NO_SPACE    = -1;           // No room in the PIO instruction memory for the program
+static const int PG_MONITOR_ERR_NO_SM       = -2;           // Every state machine of the PIO is in use
+
+/* Types */
+
+// Called from the PIO interrupt after a trip, with the PG pins that were low (gpio_get_all() bit order)
+typedef void (*pg_monitor_trip_fn)(const uint32_t pg_lost);
+
+// One monitor state machine
+typedef struct {
+    PIO pio;
+    uint sm;
+    uint offset;                                            // Program location in the PIO instruction memory
+    pio_sm_config config;
+    uint8_t pg_base;                                        // First PG input (PG_MONITOR_PG_COUNT consecutive pins)
+    uint8_t en_base;                                        // First enable dropped on a trip
+    uint8_t en_count;                                       // Consecutive enables dropped on a trip (1 to 5)
+    uint8_t pwr_good_pin;                                   // MASTER_PWR_GOOD output
+    uint32_t expected;                                      // PG levels that mean good, bit 0 = pg_base
+    bool armed;                                             // Enables and MASTER_PWR_GOOD are driven by the PIO
+    volatile bool tripped;                                  // A PG fell while armed
+    volatile uint32_t pg_lost;                              // PG pins that were low at the trip (gpio_get_all() bit order)
+    pg_monitor_trip_fn on_trip;                             // Run from the interrupt after a trip, may be NULL
+} pg_monitor_t;
+
+/* Functions */
+
+/* Load the program, claim a state machine and drive MASTER_PWR_GOOD low. The enables stay with the CPU until
+pg_monitor_arm(). Only one monitor may exist. Returns 0 or a PG_MONITOR_ERR code */
+int pg_monitor_init(pg_monitor_t *monitor, PIO pio, const uint8_t pg_base, const uint8_t en_base, const uint8_t en_count,
+                    const uint8_t pwr_good_pin, pg_monitor_trip_fn on_trip);
+
+/* Hand the enables to the state machine at their current (high) level and start watching for the expected PG levels.
+Call once every rail is up: MASTER_PWR_GOOD goes high on the first matching sample */
+void pg_monitor_arm(pg_monitor_t *monitor, const uint32_t expected);
+
+/* What the PIO interrupt does after a trip: record the PG pins that were lost, hand the pins back and run on_trip.
+Runs from SRAM. Called directly only by the execution time benchmark, with the monitor not armed */
+void pg_monitor_service_trip(pg_monitor_t *monitor);
+
+/* Stop the state machine and give the enables and MASTER_PWR_GOOD back to the CPU at the level they have now, so the
+software sequencer can carry on from there (after a trip: the dropped enables stay low). Runs from SRAM */
+void pg_monitor_release(pg_monitor_t *monitor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
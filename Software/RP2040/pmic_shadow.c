@@ -0,0 +1,126 @@
+// Capstone Mainboard PMIC Register Shadow
+// RAM copy of every TPS6287X register the firmware owns, with valid/dirty tracking and scrubbing
+
+/*
+*  Everything except STATUS only changes when the firmware writes it, so once a value is written (or read back) the
+*  shadow is the answer and the bus is not touched. The shadow can drift from hardware in two ways: a write that
+*  did not make it (kept dirty and retried) and the PMIC changing under us (SEU, brown-out or reset of the PMIC). The
+*  second is what pmic_shadow_scrub() looks for by reading the whole VSET..CONTROL3 block in one transfer.
+*/
+
+/* Libraries */
+#include <string.h>
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include "i2c_bus.h"
+#include "pmic_shadow.h"
+
+/* Functions */
+
+void pmic_shadow_init(pmic_shadow_t *shadow, const uint8_t address) {
+
+    memset(shadow, 0, sizeof(*shadow));
+    shadow->address = address;
+}
+
+void pmic_shadow_invalidate(pmic_shadow_t *shadow) {
+
+    shadow->valid = 0;
+    shadow->dirty = 0;
+}
+
+void pmic_shadow_load(pmic_shadow_t *shadow, const uint8_t *block, const uint8_t num_regs) {
+
+    for (uint8_t reg = 0; (reg < num_regs) && (reg < PMIC_SHADOW_NUM_REGS); reg++) {
+        if (!(PMIC_SHADOW_VOLATILE & (1 << reg))) {
+            shadow->value[reg] = block[reg];
+            shadow->valid |= (uint8_t)(1 << reg);
+            shadow->dirty &= (uint8_t) ~(1 << reg);
+        }
+    }
+}
+
+int pmic_shadow_write(i2c_inst_t *i2c, pmic_shadow_t *shadow, const uint8_t reg, const uint8_t value) {
+
+    int bytes_written = 0;
+
+    if (reg >= PMIC_SHADOW_NUM_REGS) {
+        return (write_i2c(i2c, shadow->address, reg, &value, 1));
+    }
+
+    shadow->value[reg] = value;
+    shadow->valid |= (uint8_t)(1 << reg);
+
+    bytes_written = write_i2c(i2c, shadow->address, reg, &shadow->value[reg], 1);
+    if (bytes_written == 1) {
+        shadow->dirty &= (uint8_t) ~(1 << reg);
+    }
+    else {
+        shadow->dirty |= (uint8_t)(1 << reg);
+    }
+
+    return (bytes_written);
+}
+
+int pmic_shadow_read(i2c_inst_t *i2c, pmic_shadow_t *shadow, const uint8_t reg, uint8_t *value) {
+
+    int bytes_read = 0;
+
+    if ((reg < PMIC_SHADOW_NUM_REGS) && (shadow->valid & (1 << reg)) && !(PMIC_SHADOW_VOLATILE & (1 << reg))) {
+        *value = shadow->value[reg];
+        return (1);
+    }
+
+    bytes_read = read_i2c(i2c, shadow->address, reg, value, 1);
+    if ((bytes_read == 1) && (reg < PMIC_SHADOW_NUM_REGS) && !(PMIC_SHADOW_VOLATILE & (1 << reg))) {
+        shadow->value[reg] = *value;
+        shadow->valid |= (uint8_t)(1 << reg);
+    }
+
+    return (bytes_read);
+}
+
+uint8_t pmic_shadow_flush(i2c_inst_t *i2c, pmic_shadow_t *shadow) {
+
+    return (pmic_shadow_restore(i2c, shadow, shadow->dirty));
+}
+
+int pmic_shadow_scrub(i2c_inst_t *i2c, pmic_shadow_t *shadow) {
+
+    uint8_t hardware[PMIC_SHADOW_NUM_REGS];
+    uint8_t mismatches = 0;
+    int bytes_read = 0;
+
+    // Pending writes first, a dirty register would otherwise always look like a mismatch
+    pmic_shadow_flush(i2c, shadow);
+
+    bytes_read = read_i2c(i2c, shadow->address, 0x00, hardware, 4);
+    if (bytes_read < 0) {
+        return (bytes_read);
+    }
+    else if (bytes_read != 4) {
+        return (-4);
+    }
+
+    for (uint8_t reg = 0; reg < 4; reg++) {
+        uint8_t bit = (uint8_t)(1 << reg);
+        if ((PMIC_SHADOW_SCRUBBED & bit) && (shadow->valid & bit) && !(shadow->dirty & bit) && (hardware[reg] != shadow->value[reg])) {
+            mismatches |= bit;
+            shadow->scrub_mismatches++;
+        }
+    }
+    shadow->scrub_count++;
+
+    return (mismatches);
+}
+
+uint8_t pmic_shadow_restore(i2c_inst_t *i2c, pmic_shadow_t *shadow, const uint8_t mask) {
+
+    for (uint8_t reg = 0; reg < PMIC_SHADOW_NUM_REGS; reg++) {
+        if ((mask & (1 << reg)) && (shadow->valid & (1 << reg))) {
+            pmic_shadow_write(i2c, shadow, reg, shadow->value[reg]);
+        }
+    }
+
+    return (shadow->dirty);
+}
@@ -0,0 +1,68 @@
+// Capstone Mainboard PMIC Register Shadow
+// RAM copy of every TPS6287X register the firmware owns, with valid/dirty tracking and scrubbing
+
+#ifndef PMIC_SHADOW_H
+#define PMIC_SHADOW_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+#include <hardware/i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Shadow parameters */
+#define PMIC_SHADOW_NUM_REGS 5                              // Registers shadowed per PMIC (VSET through STATUS)
+
+static const uint8_t PMIC_SHADOW_VOLATILE   = (1 << 4);     // Registers that change on their own (STATUS), always read from the bus
+static const uint8_t PMIC_SHADOW_SCRUBBED   = 0b00001111;   // Registers compared against hardware by a scrub (VSET, CONTROL1-3)
+
+/* Types */
+
+// Shadow of one PMIC. Bit n of each mask refers to register offset n
+typedef struct {
+    uint8_t address;                                        // PMIC I2C address
+    uint8_t value[PMIC_SHADOW_NUM_REGS];                    // Last value written to (or read from) each register
+    uint8_t valid;                                          // value[n] is known to match what the firmware wants in register n
+    uint8_t dirty;                                          // value[n] has not made it to the PMIC yet (write failed), flushed on the next write/scrub
+    uint32_t scrub_count;                                   // Number of completed scrubs
+    uint32_t scrub_mismatches;                              // Number of registers found changed behind the firmware's back
+} pmic_shadow_t;
+
+/* Functions */
+
+// Start with nothing known about the PMIC at address
+void pmic_shadow_init(pmic_shadow_t *shadow, const uint8_t address);
+
+// Forget every register value (e.g. after writing the PMIC reset bit)
+void pmic_shadow_invalidate(pmic_shadow_t *shadow);
+
+/* Fill the shadow from a block read starting at register 0 (num_regs values in block). Volatile registers are not kept */
+void pmic_shadow_load(pmic_shadow_t *shadow, const uint8_t *block, const uint8_t num_regs);
+
+/* Write-through: update the shadow and the PMIC. If the bus write fails the register stays dirty for a later flush.
+Returns 1 on success, or the negative write_i2c() error code */
+int pmic_shadow_write(i2c_inst_t *i2c, pmic_shadow_t *shadow, const uint8_t reg, const uint8_t value);
+
+/* Read a register. Valid, non-volatile registers are answered from RAM, everything else goes to the bus and fills the shadow.
+Returns 1 on success, or the negative read_i2c() error code */
+int pmic_shadow_read(i2c_inst_t *i2c, pmic_shadow_t *shadow, const uint8_t reg, uint8_t *value);
+
+/* Retry every dirty register. Returns the number of registers still dirty */
+uint8_t pmic_shadow_flush(i2c_inst_t *i2c, pmic_shadow_t *shadow);
+
+/* Read the scrubbed registers back in one transfer and compare them with the shadow.
+Returns a mask of mismatching registers (0 if all match), or a negative read_i2c() error code.
+Mismatches are not corrected here, see pmic_shadow_restore() */
+int pmic_shadow_scrub(i2c_inst_t *i2c, pmic_shadow_t *shadow);
+
+/* Write the shadow values of the registers in mask back to the PMIC. Returns the number of registers still dirty */
+uint8_t pmic_shadow_restore(i2c_inst_t *i2c, pmic_shadow_t *shadow, const uint8_t mask);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
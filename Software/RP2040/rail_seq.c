@@ -0,0 +1,214 @@
+// Capstone Mainboard Rail Sequencer
+// Brings rails up along a dependency graph, each one as soon as everything it waits for is good
+
+/*
+*  The sequencer polls instead of sleeping: every pass enables the rails whose predecessors are all good, then samples
+*  the PG pins of the rails that are on. Rails that do not depend on each other ramp at the same time, so the power-up
+*  takes as long as the slowest chain through the graph (the critical path), not the sum of every stage.
+*
+*  Because a rail can only wait for rails listed before it, one pass in table order sees a rail's predecessors become
+*  good before it looks at the rail itself, and the enable follows within the same pass.
+*
+*  Each pass is a call to rail_seq_step(), so an event loop task runs one per timer tick instead of holding the core
+*  until every rail is up.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include "fault_log.h"
+#include "rail_seq.h"
+
+/* Functions */
+
+// Bit mask of the first num_rails rails
+static uint32_t all_rails(const size_t num_rails) {
+    return ((num_rails >= 32) ? 0xFFFFFFFF : ((1u << num_rails) - 1));
+}
+
+void rail_seq_init(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state) {
+
+    for (size_t index = 0; index < num_rails; index++) {
+        if (rails[index].en_pin != RAIL_SEQ_NO_PIN) {
+            gpio_init(rails[index].en_pin);
+            gpio_put(rails[index].en_pin, false);
+            gpio_set_dir(rails[index].en_pin, GPIO_OUT);
+        }
+        if (rails[index].pg_pin != RAIL_SEQ_NO_PIN) {
+            gpio_init(rails[index].pg_pin);
+            gpio_set_dir(rails[index].pg_pin, GPIO_IN);
+        }
+        state->enable_us[index] = 0;
+        state->good_us[index] = 0;
+    }
+
+    state->enabled = 0;
+    state->good = 0;
+    state->failed_rail = -1;
+    state->start_us = 0;
+}
+
+int rail_seq_start(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state) {
+
+    if (num_rails > RAIL_SEQ_MAX_RAILS) {
+        return (RAIL_SEQ_ERR_GRAPH);
+    }
+    for (size_t index = 0; index < num_rails; index++) {
+        if ((rails[index].after >> index) != 0) {
+            state->failed_rail = (int) index;
+            return (RAIL_SEQ_ERR_GRAPH);
+        }
+    }
+
+    state->start_us = time_us_64();
+    return (0);
+}
+
+int rail_seq_step(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state) {
+
+    const uint32_t now_us = (uint32_t)(time_us_64() - state->start_us);
+    int result = 0;
+
+    if (state->good == all_rails(num_rails)) {
+        return (0);
+    }
+
+    for (size_t index = 0; index < num_rails; index++) {
+
+        const rail_seq_node_t *rail = &rails[index];
+        const uint32_t bit = 1u << index;
+
+        // Enable as soon as everything it waits for is good
+        if (!(state->enabled & bit)) {
+            if ((rail->after & ~state->good) == 0) {
+                if (rail->en_pin != RAIL_SEQ_NO_PIN) {
+                    gpio_put(rail->en_pin, true);
+                }
+                state->enabled |= bit;
+                state->enable_us[index] = now_us;
+                fault_log_event(FAULT_LOG_SEQ_STAGE, (uint8_t) index, now_us / 1000);
+            }
+            continue;
+        }
+
+        const uint32_t on_us = now_us - state->enable_us[index];
+        const bool pg = (rail->pg_pin == RAIL_SEQ_NO_PIN) || gpio_get(rail->pg_pin);
+
+        if (state->good & bit) {
+            if (!pg) {
+                result = RAIL_SEQ_ERR_PG_LOST;
+            }
+        }
+        else if (pg && (on_us >= ((uint32_t) rail->settle_ms * 1000))) {
+            state->good |= bit;
+            state->good_us[index] = now_us;
+        }
+        else if (on_us >= ((uint32_t) rail->timeout_ms * 1000)) {
+            result = RAIL_SEQ_ERR_TIMEOUT;
+        }
+
+        if (result != 0) {
+            state->failed_rail = (int) index;
+            fault_log_event(FAULT_LOG_SEQ_FAULT, (uint8_t) index, (uint32_t)(-result));
+            break;
+        }
+    }
+
+    if (result != 0) {
+        rail_seq_power_down(rails, num_rails, state);
+        return (result);
+    }
+
+    return ((state->good == all_rails(num_rails)) ? 0 : RAIL_SEQ_BUSY);
+}
+
+// Runs from SRAM: it is the tail of every fault path, and an XIP cache miss here would stretch the shutdown
+void __not_in_flash_func(rail_seq_power_down)(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state) {
+
+    while (state->enabled != 0) {
+
+        uint32_t wave = 0;
+        uint16_t wait_ms = 0;
+
+        // Everything no rail that is still on waits for
+        for (size_t index = 0; index < num_rails; index++) {
+
+            const uint32_t bit = 1u << index;
+            bool needed = false;
+
+            if (!(state->enabled & bit)) {
+                continue;
+            }
+            for (size_t other = index + 1; other < num_rails; other++) {
+                if ((state->enabled & (1u << other)) && (rails[other].after & bit)) {
+                    needed = true;
+                }
+            }
+            if (!needed) {
+                wave |= bit;
+            }
+        }
+
+        for (size_t index = 0; index < num_rails; index++) {
+            if ((wave & (1u << index)) && (rails[index].en_pin != RAIL_SEQ_NO_PIN)) {
+                gpio_put(rails[index].en_pin, false);
+                wait_ms = (rails[index].timeout_ms > wait_ms) ? rails[index].timeout_ms : wait_ms;
+            }
+        }
+        state->enabled &= ~wave;
+        state->good &= ~wave;
+
+        // Let this wave discharge before the rails under it go, but never hang on a PG that stays high
+        // (32-bit time and wait: the 64-bit versions are library calls in flash)
+        const uint32_t start_us = time_us_32();
+        const uint32_t wait_us = (uint32_t) wait_ms * 1000;
+        for (size_t index = 0; index < num_rails; index++) {
+            if ((wave & (1u << index)) && (rails[index].en_pin != RAIL_SEQ_NO_PIN) && (rails[index].pg_pin != RAIL_SEQ_NO_PIN)) {
+                while (gpio_get(rails[index].pg_pin) && ((time_us_32() - start_us) < wait_us)) {
+                    tight_loop_contents();
+                }
+            }
+        }
+    }
+}
+
+void rail_seq_print(const rail_seq_node_t *rails, const size_t num_rails, const rail_seq_state_t *state) {
+
+    size_t path[RAIL_SEQ_MAX_RAILS];
+    size_t path_len = 0;
+    int last = -1;
+
+    for (size_t index = 0; index < num_rails; index++) {
+        const uint32_t bit = 1u << index;
+        if (state->good & bit) {
+            printf("%s\ton at %lu us\tgood at %lu us\n", rails[index].name, (unsigned long) state->enable_us[index], (unsigned long) state->good_us[index]);
+            if ((last < 0) || (state->good_us[index] > state->good_us[last])) {
+                last = (int) index;
+            }
+        }
+        else {
+            printf("%s\t%s\n", rails[index].name, ((int) index == state->failed_rail) ? "FAILED" : "off");
+        }
+    }
+
+    // Walk back from the last rail to come up through whichever predecessor held it up
+    while ((last >= 0) && (path_len < RAIL_SEQ_MAX_RAILS)) {
+        int latest = -1;
+        path[path_len++] = (size_t) last;
+        for (size_t index = 0; index < (size_t) last; index++) {
+            if ((rails[last].after & (1u << index)) && (state->good & (1u << index)) &&
+                ((latest < 0) || (state->good_us[index] > state->good_us[latest]))) {
+                latest = (int) index;
+            }
+        }
+        last = latest;
+    }
+
+    if (path_len > 0) {
+        printf("Critical path:");
+        for (size_t step = path_len; step > 0; step--) {
+            printf(" %s%s", rails[path[step - 1]].name, (step > 1) ? " ->" : "");
+        }
+        printf(" (%lu us)\n", (unsigned long) state->good_us[path[0]]);
+    }
+}
@@ -0,0 +1,73 @@
+// Capstone Mainboard Rail Sequencer
+// Brings rails up along a dependency graph, each one as soon as everything it waits for is good
+
+#ifndef RAIL_SEQ_H
+#define RAIL_SEQ_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Sequencer parameters */
+#define RAIL_SEQ_MAX_RAILS 32                               // Rails per graph (one bit each in the dependency masks)
+
+static const uint8_t RAIL_SEQ_NO_PIN        = 0xFF;         // en_pin/pg_pin value of a rail without that signal
+static const int RAIL_SEQ_BUSY              = 1;            // rail_seq_step(): rails still coming up, step again
+
+// Sequencer error codes
+static const int RAIL_SEQ_ERR_TIMEOUT       = -1;           // A rail's PG did not assert within its timeout
+static const int RAIL_SEQ_ERR_PG_LOST       = -2;           // A rail that was already good dropped its PG
+static const int RAIL_SEQ_ERR_GRAPH         = -3;           // A rail waits for itself or for a rail listed after it
+
+/* Types */
+
+// One node of the sequencing graph
+typedef struct {
+    const char *name;                                       // Rail name used in logs ("1V0")
+    uint8_t en_pin;                                         // Enable GPIO, driven high to turn the rail on (RAIL_SEQ_NO_PIN: always on)
+    uint8_t pg_pin;                                         // Power good GPIO, high when good (RAIL_SEQ_NO_PIN: good once settled)
+    uint32_t after;                                         // Rails (bit per table index) that must be good before this one is enabled
+    uint16_t settle_ms;                                     // Time from enable before the rail can count as good (soft start)
+    uint16_t timeout_ms;                                    // Time from enable by which PG must be high
+} rail_seq_node_t;
+
+// Progress and timing of one power-up
+typedef struct {
+    uint32_t enabled;                                       // Rails whose enable has been driven (bit per table index)
+    uint32_t good;                                          // Rails that are up
+    int failed_rail;                                        // Rail that stopped the sequence, -1 if none
+    uint32_t enable_us[RAIL_SEQ_MAX_RAILS];                 // Enable time of each rail, from the start of the sequence (in us)
+    uint32_t good_us[RAIL_SEQ_MAX_RAILS];                   // Time each rail became good (in us)
+    uint64_t start_us;                                      // Start of the sequence (time_us_64())
+} rail_seq_state_t;
+
+/* Functions */
+
+/* Drive every enable low, make every PG pin an input and clear the state. Call before any rail is touched */
+void rail_seq_init(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state);
+
+/* Power-up, a pass at a time. rail_seq_start() checks the graph (RAIL_SEQ_ERR_GRAPH) and starts the clock, then each
+rail_seq_step() enables every rail whose predecessors are good and samples the PG pins: RAIL_SEQ_BUSY while rails are
+still coming up, 0 once every rail is up. A PG timeout or a PG dropping on a rail that was good powers down whatever is
+on (in reverse order) and returns a RAIL_SEQ_ERR code with state->failed_rail set */
+int rail_seq_start(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state);
+int rail_seq_step(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state);
+
+/* Turn rails off in reverse dependency order: each wave disables every rail nothing that is still on waits for, then
+waits (up to the rails' timeouts) for their PG to drop before the next wave. Runs from SRAM, safe to call from fault
+handlers */
+void rail_seq_power_down(const rail_seq_node_t *rails, const size_t num_rails, rail_seq_state_t *state);
+
+// Prints the enable/good time of every rail and the critical path of the last power-up
+void rail_seq_print(const rail_seq_node_t *rails, const size_t num_rails, const rail_seq_state_t *state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,133 @@
+// Capstone Mainboard Watchdog Recovery
+// Hardware watchdog fed from the protection loop, with boot stage and rail state kept in its scratch registers
+
+/*
+*  The watchdog scratch registers survive a watchdog reset (the SDK and boot ROM only use 4 to 7), so every stage change
+*  and every protection loop tick leaves a record there: the stage, the rails that are enabled and good, and a count of
+*  watchdog resets in a row. A check word keeps a half written or random record from being believed.
+*
+*  The pins do not survive the reset: the runtime init resets the IO bank and the pad pull-downs take the enables low,
+*  so the rails drop with the reset, all at once and not in sequencing order. What the record saves is everything after
+*  that: the firmware waits for the recorded rails to discharge before powering anything, and if the PMICs had already
+*  been programmed it skips discovery and the startup delays and sequences straight away. A board that keeps resetting
+*  stays down after RECOVERY_MAX_RESETS attempts.
+*
+*  Only the protection loop feeds the watchdog once the rails are up. Before that each startup stage feeds it once as
+*  it begins, so a stage that hangs (an I2C loop, a PG that never comes) is caught as well.
+*/
+
+/* Libraries */
+#include <pico/stdlib.h>
+#include <hardware/watchdog.h>
+#include "recovery.h"
+
+/* Parameters */
+#define RECOVERY_SCRATCH_STAGE 0                            // Magic, reset count and stage
+#define RECOVERY_SCRATCH_RAILS 1                            // Good rails (bits 16-31) and enabled rails (bits 0-15)
+#define RECOVERY_SCRATCH_CHECK 2                            // Both words above XOR RECOVERY_CHECK_KEY
+#define RECOVERY_MAGIC 0xCA5Eu
+#define RECOVERY_CHECK_KEY 0x5EC0DE5Au
+
+/* Variables */
+static const char *STAGE_NAMES[] = { "boot", "PMIC scan", "PMIC setup", "sequencing", "running", "aborted", "halted" };
+
+/* Functions */
+
+// Leave a record of the current stage and rails for whatever comes after a reset
+static void save(const recovery_state_t *recovery, const uint32_t enabled, const uint32_t good) {
+
+    const uint32_t word0 = (RECOVERY_MAGIC << 16) | ((uint32_t) recovery->resets << 8) | (uint32_t) recovery->stage;
+    const uint32_t word1 = ((good & 0xFFFF) << 16) | (enabled & 0xFFFF);
+
+    watchdog_hw->scratch[RECOVERY_SCRATCH_STAGE] = word0;
+    watchdog_hw->scratch[RECOVERY_SCRATCH_RAILS] = word1;
+    watchdog_hw->scratch[RECOVERY_SCRATCH_CHECK] = word0 ^ word1 ^ RECOVERY_CHECK_KEY;
+}
+
+void recovery_init(recovery_state_t *recovery) {
+
+    const uint32_t word0 = watchdog_hw->scratch[RECOVERY_SCRATCH_STAGE];
+    const uint32_t word1 = watchdog_hw->scratch[RECOVERY_SCRATCH_RAILS];
+    const uint32_t check = watchdog_hw->scratch[RECOVERY_SCRATCH_CHECK];
+
+    if (watchdog_enable_caused_reboot()) {
+        recovery->cause = RECOVERY_CAUSE_WATCHDOG;
+    }
+    else if (watchdog_caused_reboot()) {
+        recovery->cause = RECOVERY_CAUSE_REBOOT;
+    }
+    else {
+        recovery->cause = RECOVERY_CAUSE_POWER_ON;
+    }
+
+    recovery->saved = (recovery->cause != RECOVERY_CAUSE_POWER_ON) && ((word0 >> 16) == RECOVERY_MAGIC) &&
+                      (check == (word0 ^ word1 ^ RECOVERY_CHECK_KEY)) && ((word0 & 0xFF) <= RECOVERY_STAGE_HALTED);
+    recovery->last_stage = recovery->saved ? (recovery_stage_t)(word0 & 0xFF) : RECOVERY_STAGE_BOOT;
+    recovery->last_enabled = recovery->saved ? (word1 & 0xFFFF) : 0;
+    recovery->last_good = recovery->saved ? (word1 >> 16) : 0;
+    recovery->resets = 0;
+
+    if (recovery->cause == RECOVERY_CAUSE_WATCHDOG) {
+        const uint8_t earlier = recovery->saved ? (uint8_t)((word0 >> 8) & 0xFF) : 0;
+        recovery->resets = (earlier < 0xFF) ? (uint8_t)(earlier + 1) : earlier;
+    }
+
+    if (recovery->cause != RECOVERY_CAUSE_WATCHDOG) {
+        recovery->action = RECOVERY_FULL_BOOT;
+    }
+    else if (recovery->resets > RECOVERY_MAX_RESETS) {
+        recovery->action = RECOVERY_STAY_DOWN;
+    }
+    else if ((recovery->last_stage == RECOVERY_STAGE_SEQUENCING) || (recovery->last_stage == RECOVERY_STAGE_RUNNING)) {
+        recovery->action = RECOVERY_RESUME;
+    }
+    else {
+        recovery->action = RECOVERY_FULL_BOOT;
+    }
+
+    recovery->stage = RECOVERY_STAGE_BOOT;
+    recovery->running_us = 0;
+    save(recovery, 0, 0);
+
+    watchdog_enable(RECOVERY_BOOT_MS, true);
+}
+
+void recovery_stage(recovery_state_t *recovery, const recovery_stage_t stage, const uint32_t enabled, const uint32_t good) {
+
+    recovery->stage = stage;
+    save(recovery, enabled, good);
+
+    if (stage == RECOVERY_STAGE_RUNNING) {
+        recovery->running_us = time_us_32();
+        watchdog_enable(RECOVERY_RUN_MS, true);
+    }
+    else {
+        watchdog_update();
+    }
+}
+
+void recovery_feed(recovery_state_t *recovery, const uint32_t enabled, const uint32_t good) {
+
+    // Long enough up that the resets before were not one fault repeating
+    if ((recovery->resets != 0) && ((time_us_32() - recovery->running_us) >= (RECOVERY_STABLE_MS * 1000))) {
+        recovery->resets = 0;
+    }
+
+    save(recovery, enabled, good);
+    watchdog_update();
+}
+
+void recovery_halt(recovery_state_t *recovery, const recovery_stage_t stage) {
+
+    recovery->stage = stage;
+    save(recovery, 0, 0);
+    watchdog_disable();
+}
+
+uint32_t recovery_boot_data(const recovery_state_t *recovery) {
+    return (((uint32_t) recovery->last_stage << 24) | ((uint32_t) recovery->resets << 16) | (recovery->last_enabled & 0xFFFF));
+}
+
+const char *recovery_stage_name(const recovery_stage_t stage) {
+    return ((stage <= RECOVERY_STAGE_HALTED) ? STAGE_NAMES[stage] : "?");
+}
@@ -0,0 +1,94 @@
+// Capstone Mainboard Watchdog Recovery
+// Hardware watchdog fed from the protection loop, with boot stage and rail state kept in its scratch registers
+
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+*  Running, the watchdog is only fed by the protect task, and no handler is preempted, so RECOVERY_RUN_MS has to cover the
+*  longest handler of any task plus one protect period (10 ms). Rail moves step from timers, which leaves host commands
+*  printing over USB: a full "log" dump takes about 70 ms, and into a stalled USB link stdio waits out
+*  PICO_STDIO_USB_STDOUT_TIMEOUT_US (500 ms by default) before it drops output, 70 + 500 + 10 = 580 ms in all. A host
+*  that reads, but slower than the firmware prints, can stretch a dump past any bound; the watchdog resets the board then.
+*/
+
+/* Recovery parameters */
+static const uint32_t RECOVERY_BOOT_MS      = 8000;         // Watchdog timeout until the rails are up (longest the RP2040 allows, in ms)
+static const uint32_t RECOVERY_RUN_MS       = 5000;         // Watchdog timeout once the protection loop runs, over 8x the 580 ms bound above (in ms)
+static const uint32_t RECOVERY_STABLE_MS    = 60000;        // Time running before earlier watchdog resets are forgiven (in ms)
+static const uint8_t RECOVERY_MAX_RESETS    = 3;            // Consecutive watchdog resets before the board stays down
+
+// Where the firmware got to, in order
+typedef enum {
+    RECOVERY_STAGE_BOOT = 0,                                // Before anything was touched
+    RECOVERY_STAGE_PMIC_SCAN,                               // Finding and checking the PMICs
+    RECOVERY_STAGE_PMIC_SETUP,                              // Programming the PMICs
+    RECOVERY_STAGE_SEQUENCING,                              // Bringing the rails up (PMICs programmed)
+    RECOVERY_STAGE_RUNNING,                                 // Rails up, protection loop running
+    RECOVERY_STAGE_ABORTED,                                 // Startup given up, waiting for the watchdog to retry
+    RECOVERY_STAGE_HALTED                                   // Stopped on purpose with every rail off, watchdog off
+} recovery_stage_t;
+
+// Why the firmware started, the code of the FAULT_LOG_BOOT record
+typedef enum {
+    RECOVERY_CAUSE_POWER_ON = 0,                            // Power-on or RUN pin reset
+    RECOVERY_CAUSE_WATCHDOG,                                // The watchdog ran out
+    RECOVERY_CAUSE_REBOOT                                   // Reboot requested through the watchdog (debugger, bootloader)
+} recovery_cause_t;
+
+// What the startup should do about it
+typedef enum {
+    RECOVERY_FULL_BOOT = 0,                                 // Discover and program the PMICs, then sequence
+    RECOVERY_RESUME,                                        // PMICs were already programmed: skip discovery and the startup delays
+    RECOVERY_STAY_DOWN                                      // Too many watchdog resets in a row: keep every rail off
+} recovery_action_t;
+
+/* Types */
+
+// What the last reset left behind and what to do about it
+typedef struct {
+    recovery_cause_t cause;
+    recovery_action_t action;
+    bool saved;                                             // The scratch registers held a valid record of the last run
+    recovery_stage_t last_stage;                            // Stage at the reset (if saved)
+    uint32_t last_enabled;                                  // Rails enabled at the reset, rail_seq_state_t bits (if saved)
+    uint32_t last_good;                                     // Rails good at the reset (if saved)
+    uint8_t resets;                                         // Consecutive watchdog resets, this one included
+    recovery_stage_t stage;                                 // Current stage
+    uint32_t running_us;                                    // When the protection loop started (time_us_32())
+} recovery_state_t;
+
+/* Functions */
+
+/* Read what the last run left in the scratch registers, decide on the action and start the watchdog with the startup
+timeout. Call first thing in main(), before anything that could hang */
+void recovery_init(recovery_state_t *recovery);
+
+/* Startup made progress: record the stage and rail state and feed the watchdog. Once the stage is RUNNING the
+timeout drops to RECOVERY_RUN_MS */
+void recovery_stage(recovery_state_t *recovery, const recovery_stage_t stage, const uint32_t enabled, const uint32_t good);
+
+/* Protection loop tick: record the rail state and feed the watchdog. Nothing else may feed it once the rails are up */
+void recovery_feed(recovery_state_t *recovery, const uint32_t enabled, const uint32_t good);
+
+/* Stop on purpose with every rail off: record the stage and stop the watchdog, so the board stays down for a human */
+void recovery_halt(recovery_state_t *recovery, const recovery_stage_t stage);
+
+// FAULT_LOG_BOOT data word: stage at the reset (bits 24-31), consecutive resets (16-23) and the rails enabled (0-15)
+uint32_t recovery_boot_data(const recovery_state_t *recovery);
+
+const char *recovery_stage_name(const recovery_stage_t stage);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
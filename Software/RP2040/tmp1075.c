@@ -0,0 +1,28 @@
+// Capstone Mainboard TMP1075 Temperature Sensor Access
+// Temperature readback from the three board sensors on I2C-0
+
+/* Libraries */
+#include <pico/stdlib.h>
+#include <hardware/i2c.h>
+#include "i2c_bus.h"
+#include "tmp1075.h"
+
+/* Functions */
+
+int tmp1075_read_temp(i2c_inst_t *i2c, const uint8_t address, int16_t *temp_c_x16) {
+
+    uint8_t raw[2] = {0x00, 0x00};
+    int bytes_read = 0;
+
+    bytes_read = read_i2c(i2c, address, TMP1075_TEMP_OA, raw, 2);
+    if (bytes_read < 0) {
+        return (bytes_read);
+    }
+    else if (bytes_read != 2) {
+        return (-4);
+    }
+
+    // MSB first, the low nibble of the LSB is always zero
+    *temp_c_x16 = (int16_t)((uint16_t)(raw[0] << 8) | raw[1]) >> 4;
+    return (0);
+}
@@ -0,0 +1,31 @@
+// Capstone Mainboard TMP1075 Temperature Sensor Access
+// Temperature readback from the three board sensors on I2C-0
+
+#ifndef TMP1075_H
+#define TMP1075_H
+
+/* Libraries */
+#include <stdint.h>
+#include <hardware/i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// TMP1075 Register Offset Addresses
+static const uint8_t TMP1075_TEMP_OA        = 0x00;         // TMP1075 temperature result register offset (12-bit, left justified)
+static const uint8_t TMP1075_CFGR_OA        = 0x01;         // TMP1075 configuration register offset
+static const uint8_t TMP1075_LLIM_OA        = 0x02;         // TMP1075 low limit register offset
+static const uint8_t TMP1075_HLIM_OA        = 0x03;         // TMP1075 high limit register offset
+
+/* Functions */
+
+/* Read the temperature of the sensor at the given 7-bit address in 1/16 degC (0.0625 degC per LSB).
+Returns 0 on success, or the negative read_i2c() error code */
+int tmp1075_read_temp(i2c_inst_t *i2c, const uint8_t address, int16_t *temp_c_x16);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,65 @@
+// Capstone Mainboard TPS6287X PMIC Register Map
+// Register offsets and values shared by every TPS6287XQXXXXXQ1 on I2C-0
+
+#ifndef TPS6287X_H
+#define TPS6287X_H
+
+/* Libraries */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// PIMC I2C Default Register Contents
+static const uint8_t TPS6287X_CTRL1_DEF     = 0b00101010;   // TPS6287XQXXXXXQ1 family default CONTROL1 register value
+static const uint8_t TPS6287X_CTRL1_DEF_RST = 0b10101010;   // TPS6287XQXXXXXQ1 family default CONTROL1 register value with reset bit high (use to reset PIMC)
+static const uint8_t TPS6287X_CTRL2_DEF     = 0b00001001;   // TPS6287XQXXXXXQ1 family default CONTROL2 register value
+static const uint8_t TPS6287X_CTRL3_DEF     = 0b00000000;   // TPS6287XQXXXXXQ1 family default CONTROL3 register value
+static const uint8_t TPS6287X_STATUS_INI    = 0b00000010;   // TPS6287XQXXXXXQ1 family default/initial STATUS register value (cleared on read)
+
+// PIMC I2C Register Offset Addresses
+static const uint8_t TPS6287X_VSET_OA       = 0x00;         // TPS6287XQXXXXXQ1 family VSET register offset
+static const uint8_t TPS6287X_CTRL1_OA      = 0x01;         // TPS6287XQXXXXXQ1 family CONTROL1 register offset
+static const uint8_t TPS6287X_CTRL2_OA      = 0x02;         // TPS6287XQXXXXXQ1 family CONTROL2 register offset
+static const uint8_t TPS6287X_CTRL3_OA      = 0x03;         // TPS6287XQXXXXXQ1 family CONTROL2 register offset
+static const uint8_t TPS6287X_STATUS_OA     = 0x04;         // TPS6287XQXXXXXQ1 family STATUS register offset
+
+// PIMC I2C Design Set Values (Family)
+static const uint8_t TPS6287X_CTRL1_SET_EN  = 0b01101000;   // Onboard TPS6287X CONTROL1 register set value with SEN bit high
+static const uint8_t TPS6287X_CTRL1_SET_DIS = 0b01001000;   // Onboard TPS6287X CONTROL1 register set value with SEN bit low
+static const uint8_t TPS6287X_CTRL3_SET     = 0b00000010;   // Onboard TPS6287X CONTROL3 register set value
+
+// PIMC Register Fields
+static const uint8_t TPS6287X_CTRL2_VRANGE  = 0b00001100;   // CONTROL2 VRANGE field: selects the VSET output range and step size
+static const uint8_t TPS6287X_STATUS_FAULT  = (uint8_t)~TPS6287X_STATUS_INI;    // STATUS bits other than the power-on flag, any of them set means the PMIC flagged a problem
+
+#ifdef __cplusplus
+#define TPS6287X_CONSTEXPR constexpr                        // Lets C++ board tables check design values at compile time
+#else
+#define TPS6287X_CONSTEXPR
+#endif
+
+/* Functions */
+
+/* Convert a VSET code to the output voltage in mV for the range selected in CONTROL2
+VRANGE: 00 = 0.4V + 1.25mV/LSB, 01 = 0.4V + 2.5mV/LSB, 10 = 0.4V + 5mV/LSB, 11 = 0.8V + 10mV/LSB */
+static inline TPS6287X_CONSTEXPR uint16_t tps6287x_vset_to_mv(const uint8_t ctrl2, const uint8_t vset) {
+
+    switch ((ctrl2 & TPS6287X_CTRL2_VRANGE) >> 2) {
+        case 0:
+            return ((uint16_t)(400 + ((vset * 5) / 4)));
+        case 1:
+            return ((uint16_t)(400 + ((vset * 5) / 2)));
+        case 2:
+            return ((uint16_t)(400 + (vset * 5)));
+        default:
+            return ((uint16_t)(800 + (vset * 10)));
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
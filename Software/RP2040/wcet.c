@@ -0,0 +1,96 @@
+// Capstone Mainboard Execution Time Benchmark
+// Worst case cycle counts of the fault paths, measured on the target with the SysTick counter
+
+/*
+*  SysTick counts clk_sys cycles down from 2^24 - 1, which covers 134 ms at 125 MHz: far longer than anything on a
+*  fault path should take. Each run is timed with interrupts off, so the figure is the path itself and not whatever
+*  interrupt happened to land on it. The paths under test run from SRAM, so there is no XIP cache state to warm up
+*  or flush: the slowest of WCET_RUNS runs is the worst case up to the data dependent branches the caller exercises.
+*/
+
+/* Libraries */
+#include <stdio.h>
+#include <pico/stdlib.h>
+#include <hardware/clocks.h>
+#include <hardware/sync.h>
+#include <hardware/structs/systick.h>
+#include "wcet.h"
+
+/* Parameters */
+#define WCET_SYSTICK_MAX 0x00FFFFFF                         // SysTick is a 24-bit down counter
+
+/* Variables */
+static uint32_t run_sys_hz = 0;                             // clk_sys of the last benchmark (it moves in idle mode)
+
+/* Functions */
+
+// Reference for the call overhead
+static void __no_inline_not_in_flash_func(wcet_empty)(void *arg) {
+    (void) arg;
+}
+
+// Cycles one call of fn takes, interrupts off
+static uint32_t __no_inline_not_in_flash_func(wcet_time)(wcet_fn fn, void *arg) {
+
+    const uint32_t saved = save_and_disable_interrupts();
+
+    const uint32_t start = systick_hw->cvr;
+    fn(arg);
+    const uint32_t end = systick_hw->cvr;
+
+    restore_interrupts(saved);
+    return ((start - end) & WCET_SYSTICK_MAX);
+}
+
+size_t wcet_run(wcet_path_t *paths, const size_t num_paths) {
+
+    uint32_t overhead = WCET_SYSTICK_MAX;
+    size_t over_budget = 0;
+
+    // Processor clock, no interrupt, full range
+    run_sys_hz = clock_get_hz(clk_sys);
+    systick_hw->rvr = WCET_SYSTICK_MAX;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_CLKSOURCE_BITS | M0PLUS_SYST_CSR_ENABLE_BITS;
+
+    for (uint32_t run = 0; run < WCET_RUNS; run++) {
+        const uint32_t cycles = wcet_time(wcet_empty, NULL);
+        overhead = (cycles < overhead) ? cycles : overhead;
+    }
+
+    for (size_t index = 0; index < num_paths; index++) {
+        wcet_path_t *path = &paths[index];
+        path->max_cycles = 0;
+        path->min_cycles = WCET_SYSTICK_MAX;
+        for (uint32_t run = 0; run < WCET_RUNS; run++) {
+            const uint32_t measured = wcet_time(path->fn, path->arg);
+            const uint32_t cycles = (measured > overhead) ? (measured - overhead) : 0;
+            path->max_cycles = (cycles > path->max_cycles) ? cycles : path->max_cycles;
+            path->min_cycles = (cycles < path->min_cycles) ? cycles : path->min_cycles;
+        }
+        if (path->max_cycles > path->budget_cycles) {
+            over_budget++;
+        }
+    }
+
+    systick_hw->csr = 0;
+    return (over_budget);
+}
+
+void wcet_print(const wcet_path_t *paths, const size_t num_paths) {
+
+    if (run_sys_hz == 0) {
+        printf("No benchmark has been run\n");
+        return;
+    }
+
+    const uint32_t sys_mhz = run_sys_hz / 1000000;
+
+    printf("Path\t\tMin\tMax\tBudget (cycles)\tMax (us)\n");
+    for (size_t index = 0; index < num_paths; index++) {
+        const wcet_path_t *path = &paths[index];
+        printf("%-12s\t%lu\t%lu\t%lu\t\t%lu.%02lu\t%s\n", path->name, (unsigned long) path->min_cycles, (unsigned long) path->max_cycles,
+               (unsigned long) path->budget_cycles, (unsigned long)(path->max_cycles / sys_mhz),
+               (unsigned long)(((path->max_cycles % sys_mhz) * 100) / sys_mhz), (path->max_cycles > path->budget_cycles) ? "OVER BUDGET" : "ok");
+    }
+}
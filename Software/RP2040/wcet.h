@@ -0,0 +1,47 @@
+// Capstone Mainboard Execution Time Benchmark
+// Worst case cycle counts of the fault paths, measured on the target with the SysTick counter
+
+#ifndef WCET_H
+#define WCET_H
+
+/* Libraries */
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Benchmark parameters */
+static const uint32_t WCET_RUNS             = 1000;         // Runs per path, the slowest one counts
+
+/* Types */
+
+// Code under test, called with interrupts off
+typedef void (*wcet_fn)(void *arg);
+
+// One benchmarked path
+typedef struct {
+    const char *name;                                       // Path name used in the report ("pg check")
+    wcet_fn fn;
+    void *arg;
+    uint32_t budget_cycles;                                 // Longest it may take (in clk_sys cycles)
+    uint32_t max_cycles;                                    // Slowest run of the last benchmark
+    uint32_t min_cycles;                                    // Fastest run of the last benchmark
+} wcet_path_t;
+
+/* Functions */
+
+/* Time every path WCET_RUNS times with interrupts off and keep the slowest and fastest run. The benchmark overhead
+(an empty call) is subtracted. Returns the number of paths over budget */
+size_t wcet_run(wcet_path_t *paths, const size_t num_paths);
+
+// Prints every path's measured cycles and time (at the clock it was measured at) against its budget
+void wcet_print(const wcet_path_t *paths, const size_t num_paths);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif